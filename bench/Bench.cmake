@@ -0,0 +1,53 @@
+set(BENCH_DIR ${CMAKE_CURRENT_SOURCE_DIR}/bench)
+set(BENCH_SRC_DIR ${BENCH_DIR}/src)
+
+set(BENCH_SOURCES
+        ${BENCH_SRC_DIR}/main.cpp
+        ${BENCH_SRC_DIR}/BenchUtils.cpp
+        ${BENCH_SRC_DIR}/BenchThread.cpp
+        ${BENCH_SRC_DIR}/BenchIO.cpp
+)
+
+add_executable(${PROJ_NAME}-bench ${BENCH_SOURCES})
+
+target_include_directories(${PROJ_NAME}-bench PRIVATE ${BENCH_SRC_DIR})
+
+target_link_libraries(${PROJ_NAME}-bench PRIVATE
+        ${ZNATIVE_TARGET}
+        ${PLATFORM_LIBS}
+        ${COMMON_LIBS}
+)
+
+# headless gpu bench 以及 golden 图片校验, 需要 EGL/GLES3 (linux 上可以使用 mesa llvmpipe)
+if (ZNATIVE_ENABLE_GL AND ZNATIVE_LINUX_EGL_ENABLE)
+    set(GPU_BENCH_SOURCES
+            ${BENCH_SRC_DIR}/gpu/main.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuBench.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuCases.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuStartup.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuDrawCalls.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuFramebufferPool.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuReadback.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuUpload.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuMailbox.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuFence.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuPacing.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuResolution.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuPresent.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuFusion.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuCompute.cpp
+            ${BENCH_SRC_DIR}/gpu/GpuDamage.cpp
+    )
+
+    add_executable(${PROJ_NAME}-gpu-bench ${GPU_BENCH_SOURCES})
+
+    target_include_directories(${PROJ_NAME}-gpu-bench PRIVATE ${BENCH_SRC_DIR}/gpu)
+
+    target_compile_definitions(${PROJ_NAME}-gpu-bench PRIVATE GPU_BENCH_GOLDEN_DIR="${BENCH_DIR}/goldens")
+
+    target_link_libraries(${PROJ_NAME}-gpu-bench PRIVATE
+            ${ZNATIVE_TARGET}
+            ${PLATFORM_LIBS}
+            ${COMMON_LIBS}
+    )
+endif ()
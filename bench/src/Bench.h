@@ -0,0 +1,130 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "ZNamespace.h"
+#include "common/utils/TimeUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 单个 benchmark case 运行时的状态, case 里面用 while (state.keepRunning()) 包住需要计时的部分
+ */
+class BenchState {
+public:
+    explicit BenchState(int64_t iterations) : m_iterations(iterations) {}
+
+    bool keepRunning() {
+        if (m_done == 0 && !m_started) {
+            m_started = true;
+            resumeTiming();
+            return true;
+        }
+        m_done += 1;
+        if (m_done < m_iterations) {
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    /**
+     * 不计入耗时的准备工作放在 pauseTiming/resumeTiming 之间
+     */
+    void pauseTiming() {
+        if (m_running) {
+            m_elapsed_ns += nowNs() - m_start_ns;
+            m_running = false;
+        }
+    }
+
+    void resumeTiming() {
+        if (!m_running) {
+            m_start_ns = nowNs();
+            m_running = true;
+        }
+    }
+
+    /**
+     * 每次迭代处理的字节数 / 元素个数, 用来计算吞吐量
+     */
+    void setBytesPerOp(int64_t bytes) { m_bytes_per_op = bytes; }
+
+    void setItemsPerOp(int64_t items) { m_items_per_op = items; }
+
+    void skip(const std::string &reason) { m_skip_reason = reason; }
+
+    int64_t iterations() const { return m_iterations; }
+
+    int64_t elapsedNs() const { return m_elapsed_ns; }
+
+    int64_t bytesPerOp() const { return m_bytes_per_op; }
+
+    int64_t itemsPerOp() const { return m_items_per_op; }
+
+    const std::string &skipReason() const { return m_skip_reason; }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    const int64_t m_iterations;
+    int64_t m_done = 0;
+    bool m_started = false;
+
+    bool m_running = false;
+    int64_t m_start_ns = 0;
+    int64_t m_elapsed_ns = 0;
+
+    int64_t m_bytes_per_op = 0;
+    int64_t m_items_per_op = 0;
+    std::string m_skip_reason;
+};
+
+typedef std::function<void(BenchState &)> BenchFunc;
+
+struct BenchCase {
+    std::string name;
+    BenchFunc func;
+};
+
+class BenchRegistry {
+public:
+    static BenchRegistry &instance() {
+        static BenchRegistry registry;
+        return registry;
+    }
+
+    void add(const std::string &name, const BenchFunc &func) { m_cases.push_back({name, func}); }
+
+    const std::vector<BenchCase> &cases() const { return m_cases; }
+
+private:
+    std::vector<BenchCase> m_cases;
+};
+
+/**
+ * 注册一组 benchmark case, 函数体内调用 BenchRegistry::instance().add(...)
+ *
+ * BENCH_REGISTER(yuv) {
+ *     BenchRegistry::instance().add("yuv/rgba_to_nv21", [](BenchState &state) { ... });
+ * }
+ */
+#define BENCH_REGISTER(id)                                                                                             \
+    static void __bench_register_##id();                                                                               \
+    static const int __bench_registered_##id = (__bench_register_##id(), 0);                                           \
+    static void __bench_register_##id()
+
+NAMESPACE_END
@@ -0,0 +1,128 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "Bench.h"
+
+#include "common/net/TCPClient.h"
+#include "common/net/TCPServer.h"
+#include "common/utils/FileUtils.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace znative;
+
+namespace {
+
+const char *kBenchFile = "znative_bench_file.bin";
+
+const int kTcpPort = 39217;
+
+class CountingServerListener : public TCPServerListener {
+public:
+    void onAccept(TCPServerConnection &) override {}
+
+    void onRecv(TCPServerConnection &, const uint8_t *, const int len) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_received += len;
+        m_cond.notify_all();
+    }
+
+    void onClose(TCPServerConnection &) override {}
+
+    bool waitFor(int64_t bytes, int timeoutMs) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() { return m_received >= bytes; });
+    }
+
+    int64_t received() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_received;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    int64_t m_received = 0;
+};
+
+class NoopClientListener : public TCPClientListener {
+public:
+    void onConnect(TCPClient &) override {}
+
+    void onRecv(TCPClient &, const uint8_t *, const int) override {}
+
+    void onDisconnect(TCPClient &) override {}
+};
+
+} // namespace
+
+BENCH_REGISTER(file) {
+    auto &r = BenchRegistry::instance();
+    for (size_t size : {4 * 1024, 1024 * 1024}) {
+        std::string suffix = size >= 1024 * 1024 ? "1m" : "4k";
+        r.add("file/write_" + suffix, [size](BenchState &state) {
+            std::vector<uint8_t> data(size, 0x5A);
+            state.setBytesPerOp((int64_t)size);
+            while (state.keepRunning()) {
+                FileUtils::write(kBenchFile, data.data(), data.size());
+            }
+            FileUtils::deleteFile(kBenchFile);
+        });
+        r.add("file/read_" + suffix, [size](BenchState &state) {
+            std::vector<uint8_t> data(size, 0x5A);
+            FileUtils::write(kBenchFile, data.data(), data.size());
+            state.setBytesPerOp((int64_t)size);
+            while (state.keepRunning()) {
+                RawData d = FileUtils::read(kBenchFile);
+            }
+            FileUtils::deleteFile(kBenchFile);
+        });
+    }
+}
+
+BENCH_REGISTER(tcp) {
+    BenchRegistry::instance().add("tcp/loopback_1m", [](BenchState &state) {
+        const int chunk = 64 * 1024;
+        const int chunks = 16;
+
+        CountingServerListener serverListener;
+        TCPServer server;
+        server.setListener(&serverListener);
+        if (!server.start("127.0.0.1", kTcpPort)) {
+            state.skip("tcp server start failed");
+            return;
+        }
+
+        NoopClientListener clientListener;
+        TCPClient client;
+        client.setListener(&clientListener);
+        client.connect("127.0.0.1", kTcpPort);
+        for (int i = 0; i < 300 && !client.isConnected(); ++i) {
+            TimeUtils::sleepMs(10);
+        }
+        if (!client.isConnected()) {
+            state.skip("tcp client connect failed");
+            server.stop();
+            return;
+        }
+
+        std::vector<uint8_t> data(chunk, 0xA5);
+        int64_t expected = 0;
+        state.setBytesPerOp((int64_t)chunk * chunks);
+        while (state.keepRunning()) {
+            for (int i = 0; i < chunks; ++i) {
+                client.send(data.data(), chunk);
+            }
+            expected += (int64_t)chunk * chunks;
+            if (!serverListener.waitFor(expected, 5000)) {
+                state.skip("tcp loopback timeout");
+                break;
+            }
+        }
+        client.disconnect();
+        server.stop();
+    });
+}
@@ -0,0 +1,122 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "Bench.h"
+
+#include "common/utils/CallbackMgr.h"
+#include "common/utils/EventThread.h"
+#include "common/utils/ThreadPool.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace znative;
+
+namespace {
+
+class BenchHost {
+public:
+    int64_t sum = 0;
+};
+
+void benchCallback(BenchHost &host, int v) { host.sum += v; }
+
+void benchCallback2(BenchHost &host, int v) { host.sum -= v / 2; }
+
+} // namespace
+
+BENCH_REGISTER(thread_pool) {
+    auto &r = BenchRegistry::instance();
+    r.add("thread_pool/enqueue_get", [](BenchState &state) {
+        ThreadPool pool(4);
+        while (state.keepRunning()) {
+            pool.enqueue([]() { return 1; }).get();
+        }
+    });
+    r.add("thread_pool/enqueue_batch_1000", [](BenchState &state) {
+        ThreadPool pool(4);
+        std::vector<std::future<int>> futures;
+        futures.reserve(1000);
+        state.setItemsPerOp(1000);
+        while (state.keepRunning()) {
+            for (int i = 0; i < 1000; ++i) {
+                futures.push_back(pool.enqueue([i]() { return i; }));
+            }
+            for (auto &f : futures) {
+                f.get();
+            }
+            futures.clear();
+        }
+    });
+}
+
+BENCH_REGISTER(event_thread) {
+    auto &r = BenchRegistry::instance();
+    r.add("event_thread/post_1000_then_sync", [](BenchState &state) {
+        EventThread thread("bench_post");
+        std::atomic<int64_t> counter(0);
+        state.setItemsPerOp(1000);
+        while (state.keepRunning()) {
+            for (int i = 0; i < 1000; ++i) {
+                thread.post([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+            }
+            thread.sync([]() {});
+        }
+        thread.quit();
+    });
+    r.add("event_thread/sync_roundtrip", [](BenchState &state) {
+        EventThread thread("bench_sync");
+        int64_t counter = 0;
+        while (state.keepRunning()) {
+            thread.sync([&counter]() { counter += 1; });
+        }
+        thread.quit();
+    });
+    r.add("event_thread/send_event", [](BenchState &state) {
+        EventThread thread("bench_event");
+        std::atomic<int64_t> counter(0);
+        thread.listenEvent(1, [&counter](int) { counter.fetch_add(1, std::memory_order_relaxed); });
+        state.setItemsPerOp(1000);
+        while (state.keepRunning()) {
+            for (int i = 0; i < 1000; ++i) {
+                thread.send(1);
+            }
+            thread.sync([]() {});
+        }
+        thread.quit();
+    });
+}
+
+BENCH_REGISTER(callback_mgr) {
+    auto &r = BenchRegistry::instance();
+    r.add("callback_mgr/find_dispatch_64keys", [](BenchState &state) {
+        CallbackMgr<BenchHost, void(BenchHost &, int)> mgr;
+        BenchHost host;
+        int keys[64];
+        for (int &k : keys) {
+            mgr.addCallback(&k, host, benchCallback);
+            mgr.addCallback(&k, host, benchCallback2);
+        }
+        int i = 0;
+        while (state.keepRunning()) {
+            auto *callbacks = mgr.findCallback(&keys[i++ & 63]);
+            if (callbacks) {
+                for (auto &it : *callbacks) {
+                    it.second(it.first, i);
+                }
+            }
+        }
+    });
+    r.add("callback_mgr/add_remove", [](BenchState &state) {
+        CallbackMgr<BenchHost, void(BenchHost &, int)> mgr;
+        BenchHost host;
+        int key = 0;
+        while (state.keepRunning()) {
+            mgr.addCallback(&key, host, benchCallback);
+            mgr.addCallback(&key, host, benchCallback2);
+            mgr.removeCallback(&key, benchCallback);
+            mgr.removeCallback(&key, benchCallback2);
+        }
+    });
+}
@@ -0,0 +1,143 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "Bench.h"
+
+#include "common/media/img/ZImage.h"
+#include "common/utils/Array.h"
+#include "common/utils/RawData.h"
+#include "common/utils/YuvUtils.h"
+
+#include <vector>
+
+using namespace znative;
+
+namespace {
+
+struct Size {
+    int w;
+    int h;
+    const char *name;
+};
+
+const Size kSizes[] = {
+    {640, 480, "480p"},
+    {1280, 720, "720p"},
+    {1920, 1080, "1080p"},
+};
+
+std::vector<uint8_t> patternData(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (uint8_t)((i * 131 + (i >> 10) * 7) & 0xFF);
+    }
+    return data;
+}
+
+} // namespace
+
+BENCH_REGISTER(yuv) {
+    auto &r = BenchRegistry::instance();
+    for (const Size &s : kSizes) {
+        int w = s.w, h = s.h;
+        r.add(std::string("yuv/rgba_to_nv21/") + s.name, [w, h](BenchState &state) {
+            std::vector<uint8_t> src = patternData((size_t)w * h * 4);
+            std::vector<uint8_t> dst((size_t)w * h * 3 / 2);
+            state.setBytesPerOp((int64_t)src.size());
+            while (state.keepRunning()) {
+                YuvUtils::rgbaToNV21(src.data(), w, h, dst.data());
+            }
+        });
+        r.add(std::string("yuv/bgr_to_nv21/") + s.name, [w, h](BenchState &state) {
+            std::vector<uint8_t> src = patternData((size_t)w * h * 3);
+            std::vector<uint8_t> dst((size_t)w * h * 3 / 2);
+            state.setBytesPerOp((int64_t)src.size());
+            while (state.keepRunning()) {
+                YuvUtils::bgrToNV21(src.data(), w, h, dst.data());
+            }
+        });
+        r.add(std::string("yuv/scale_nv21_half/") + s.name, [w, h](BenchState &state) {
+            std::vector<uint8_t> src = patternData((size_t)w * h * 3 / 2);
+            NV21Image dst;
+            state.setBytesPerOp((int64_t)src.size());
+            while (state.keepRunning()) {
+                dst.scaleFrom(src.data(), w, h, w / 2, h / 2);
+            }
+            dst.release();
+        });
+    }
+}
+
+BENCH_REGISTER(zimage) {
+    auto &r = BenchRegistry::instance();
+    r.add("zimage/create_1080p_rgba", [](BenchState &state) {
+        while (state.keepRunning()) {
+            ZImage img;
+            img.create(1920, 1080, F_RGBA);
+        }
+    });
+    r.add("zimage/put_1080p_rgba", [](BenchState &state) {
+        std::vector<uint8_t> src = patternData(1920 * 1080 * 4);
+        state.setBytesPerOp((int64_t)src.size());
+        ZImage img;
+        while (state.keepRunning()) {
+            img.put(src.data(), 1920, 1080, F_RGBA);
+        }
+    });
+    r.add("zimage/copy_ref", [](BenchState &state) {
+        ZImage img;
+        img.create(1920, 1080, F_RGBA);
+        while (state.keepRunning()) {
+            ZImage copy(img);
+            ZImage assigned;
+            assigned = copy;
+        }
+    });
+}
+
+BENCH_REGISTER(array) {
+    auto &r = BenchRegistry::instance();
+    r.add("array/put_reuse_64k", [](BenchState &state) {
+        std::vector<uint8_t> src = patternData(64 * 1024);
+        state.setBytesPerOp((int64_t)src.size());
+        Array array;
+        while (state.keepRunning()) {
+            array.put(src.data(), src.size());
+        }
+        array.free();
+    });
+    r.add("array/put_strict_churn", [](BenchState &state) {
+        // 严格模式下 size 变化就会重新分配
+        std::vector<uint8_t> src = patternData(64 * 1024);
+        Array array;
+        size_t sizes[] = {16 * 1024, 64 * 1024, 32 * 1024, 48 * 1024};
+        int i = 0;
+        while (state.keepRunning()) {
+            array.put(src.data(), sizes[i++ & 3], true);
+        }
+        array.free();
+    });
+    r.add("array/flex_obtain_grow", [](BenchState &state) {
+        while (state.keepRunning()) {
+            FlexArray<uint8_t> array;
+            for (size_t s = 1024; s <= 256 * 1024; s *= 2) {
+                array.obtain(s);
+            }
+        }
+    });
+    r.add("rawdata/alloc_64k", [](BenchState &state) {
+        state.setBytesPerOp(64 * 1024);
+        while (state.keepRunning()) {
+            RawData data(64 * 1024);
+        }
+    });
+    r.add("rawdata/copy_ref", [](BenchState &state) {
+        RawData data(64 * 1024);
+        while (state.keepRunning()) {
+            RawData copy(data);
+            RawData assigned;
+            assigned = copy;
+        }
+    });
+}
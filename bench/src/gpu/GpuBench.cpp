@@ -0,0 +1,137 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/utils/YuvUtils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+NAMESPACE_DEFAULT
+
+bool GpuImage::writePam(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "wb");
+    _ERROR_RETURN_IF(file == nullptr, false, "GpuImage: open %s failed", path);
+    fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+    size_t written = fwrite(pixels.data(), 1, pixels.size(), file);
+    fclose(file);
+    return written == pixels.size();
+}
+
+bool GpuImage::readPam(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    int w = 0, h = 0, depth = 0, maxval = 0;
+    char line[128];
+    bool header = fgets(line, sizeof(line), file) && std::string(line) == "P7\n";
+    while (header && fgets(line, sizeof(line), file)) {
+        std::string l(line);
+        if (l == "ENDHDR\n") {
+            break;
+        }
+        sscanf(line, "WIDTH %d", &w);
+        sscanf(line, "HEIGHT %d", &h);
+        sscanf(line, "DEPTH %d", &depth);
+        sscanf(line, "MAXVAL %d", &maxval);
+    }
+    if (!header || w <= 0 || h <= 0 || depth != 4 || maxval != 255) {
+        _ERROR("GpuImage: invalid pam file: %s", path);
+        fclose(file);
+        return false;
+    }
+
+    width = w;
+    height = h;
+    pixels.resize((size_t)w * h * 4);
+    size_t read = fread(pixels.data(), 1, pixels.size(), file);
+    fclose(file);
+    return read == pixels.size();
+}
+
+GpuImageDiff compareImage(const GpuImage &a, const GpuImage &b, int tolerance) {
+    GpuImageDiff diff;
+    if (a.width != b.width || a.height != b.height || a.pixels.size() != b.pixels.size()) {
+        diff.maxDiff = 255;
+        diff.meanDiff = 255;
+        diff.badPixels = (int64_t)a.width * a.height;
+        return diff;
+    }
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < a.pixels.size(); i += 4) {
+        int pixelMax = 0;
+        for (int c = 0; c < 4; ++c) {
+            int d = std::abs((int)a.pixels[i + c] - (int)b.pixels[i + c]);
+            pixelMax = std::max(pixelMax, d);
+            sum += d;
+        }
+        diff.maxDiff = std::max(diff.maxDiff, pixelMax);
+        if (pixelMax > tolerance) {
+            diff.badPixels += 1;
+        }
+    }
+    diff.meanDiff = a.pixels.empty() ? 0 : (double)sum / (double)a.pixels.size();
+    return diff;
+}
+
+void GpuInput::generate(int w, int h) {
+    width = w;
+    height = h;
+
+    // 渐变 + 棋盘格 + 圆环, 同时包含平滑区域和锐利的边缘
+    rgba.resize((size_t)w * h * 4);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float fx = (float)x / (float)w;
+            float fy = (float)y / (float)h;
+            bool checker = ((x * 8 / w) + (y * 8 / h)) % 2 == 0;
+            float dx = fx - 0.5f, dy = (fy - 0.5f) * (float)h / (float)w;
+            float ring = 0.5f + 0.5f * std::cos(std::sqrt(dx * dx + dy * dy) * 60.0f);
+
+            uint8_t *p = &rgba[((size_t)y * w + x) * 4];
+            p[0] = (uint8_t)(fx * 255.0f);
+            p[1] = (uint8_t)(fy * 255.0f);
+            p[2] = (uint8_t)(ring * (checker ? 255.0f : 128.0f));
+            p[3] = 255;
+        }
+    }
+
+    int ySize = w * h;
+    nv21.resize((size_t)ySize * 3 / 2);
+    YuvUtils::rgbaToNV21(rgba.data(), w, h, nv21.data());
+
+    // NV21 的 uv 为 VUVU..., NV12 为 UVUV..., I420 为 YYYY..UU..VV..
+    nv12 = nv21;
+    i420.resize(nv21.size());
+    memcpy(i420.data(), nv21.data(), ySize);
+    int uvCount = ySize / 4;
+    for (int i = 0; i < uvCount; ++i) {
+        uint8_t v = nv21[ySize + i * 2];
+        uint8_t u = nv21[ySize + i * 2 + 1];
+        nv12[ySize + i * 2] = u;
+        nv12[ySize + i * 2 + 1] = v;
+        i420[ySize + i] = u;
+        i420[ySize + uvCount + i] = v;
+    }
+}
+
+void GpuInput::createTexture() {
+    release();
+    rgbaTexture = new Texture2D(width, height);
+    rgbaTexture->update(rgba.data());
+}
+
+void GpuInput::release() {
+    if (rgbaTexture) {
+        rgbaTexture->release();
+    }
+    DELETE_TO_NULL(rgbaTexture);
+}
+
+NAMESPACE_END
@@ -0,0 +1,469 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "common/egl/EGLCtx.h"
+#include "common/gles/Framebuffer.h"
+#include "common/gles/Texture.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * RGBA8 图像, golden 图片以 PAM (P7, TUPLTYPE RGB_ALPHA) 格式存储, 便于直接用图片工具查看
+ */
+struct GpuImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    bool empty() const { return pixels.empty(); }
+
+    bool writePam(const std::string &path) const;
+
+    bool readPam(const std::string &path);
+};
+
+struct GpuImageDiff {
+    int maxDiff = 0;
+    double meanDiff = 0;
+    // 超过容差的像素个数
+    int64_t badPixels = 0;
+};
+
+/**
+ * 按通道比较两张图片, 尺寸不一致时 maxDiff = 255
+ */
+GpuImageDiff compareImage(const GpuImage &a, const GpuImage &b, int tolerance);
+
+/**
+ * 所有 case 共用的输入, 由同一张程序生成的 RGBA 图片转换出 NV21/NV12/I420
+ */
+struct GpuInput {
+    int width = 0;
+    int height = 0;
+
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> nv21;
+    std::vector<uint8_t> nv12;
+    std::vector<uint8_t> i420;
+
+    // 需要在 GL 线程创建和释放
+    Texture2D *rgbaTexture = nullptr;
+
+    void generate(int w, int h);
+
+    void createTexture();
+
+    void release();
+};
+
+class GpuCase {
+public:
+    virtual ~GpuCase() = default;
+
+    virtual std::string name() const = 0;
+
+    /**
+     * 以下都在 GL 线程调用, 每个分辨率会重新 setup 一次
+     */
+    virtual void setup(GpuInput &input) = 0;
+
+    virtual void render(GpuInput &input, Framebuffer &output) = 0;
+
+    virtual void release() = 0;
+
+    /**
+     * 每帧中间结果的读写字节数 (每个中间 Framebuffer 写一次读一次), 用于对比不同格式的带宽
+     */
+    virtual int64_t intermediateBytes() const { return 0; }
+};
+
+std::vector<std::shared_ptr<GpuCase>> createGpuCases();
+
+struct GpuStartupResult {
+    // 从创建 GLEngine 到第一帧完成, 允许使用直通滤镜
+    double firstFrameMs = 0;
+    // 从创建 GLEngine 到所有滤镜都生效的第一帧完成
+    double fullFrameMs = 0;
+    // 所有滤镜都生效的第一帧在渲染线程上提交的耗时 (不含 glFinish), 没有预编译时包含编译 program
+    double fullFrameRenderMs = 0;
+    // 使用直通滤镜代替的帧数
+    int passthroughFrames = 0;
+};
+
+/**
+ * 冷启动的首帧耗时: 新建 GLEngine, 渲染 纹理 -> 调色 -> 锐化 -> 纹理输出,
+ * warmUp 时预编译调色和锐化, 没有就绪的滤镜直接跳过
+ */
+GpuStartupResult runStartup(EGLSurfaceMode mode, bool warmUp, GpuInput &input);
+
+struct GpuDrawCallResult {
+    bool uniformBlock = false;
+    // 每次绘制都修改参数
+    bool animate = false;
+    int draws = 0;
+    // render() 的 CPU 耗时, 不包含 glFinish
+    double cpuUsPerDraw = 0;
+    // Program 发出的 GL 调用
+    double glCallsPerDraw = 0;
+    double uniformUploadsPerDraw = 0;
+    double uniformSkipsPerDraw = 0;
+    double blockUploadsPerDraw = 0;
+};
+
+/**
+ * 调色滤镜单次绘制的 CPU 开销和 GL 调用次数, 对比 glUniform 与 uniform block, 参数不变与每次都变.
+ * 需要在 GL 线程调用
+ */
+GpuDrawCallResult runDrawCalls(bool uniformBlock, bool animate, int draws);
+
+struct GpuPoolResult {
+    // 同时使用 FramebufferPool 的共享 context 线程数
+    int threads = 0;
+    int maxCacheMb = 0;
+    int frames = 0;
+    int obtainsPerFrame = 0;
+    // 单次 obtain 的 CPU 耗时, 包含未命中时创建 Framebuffer
+    double obtainUs = 0;
+    double hitRate = 0;
+    int64_t evictions = 0;
+    double peakMb = 0;
+};
+
+class GLEngine;
+
+/**
+ * 金字塔式的链路, 每一级尺寸都不同, 前一级的结果用完马上归还, 每个线程在自己的共享 context 上渲染,
+ * 上一帧的结果交给下一个线程归还. 在调用线程运行, engine 之外的线程使用与它共享的 context
+ */
+GpuPoolResult runFramebufferPool(GLEngine &engine, int threads, int maxCacheMb, int frames, int width, int height);
+
+enum GpuReadbackMode {
+    // Framebuffer::readPixels, 同步等待 GPU
+    READBACK_SYNC = 0,
+    // Framebuffer::fastReadPixels, 两个 PBO 交替, 同步映射上一帧
+    READBACK_PING_PONG,
+    // Framebuffer::readPixelsAsync, PBO 环 + fence, 工作线程复制
+    READBACK_ASYNC,
+};
+
+const char *readbackModeName(int mode);
+
+struct GpuReadbackResult {
+    int mode = READBACK_SYNC;
+    int format = 0;
+    // PBO 环的深度, 只对 READBACK_ASYNC 有效
+    int depth = 0;
+    int frames = 0;
+    // 读取区域的尺寸
+    int width = 0;
+    int height = 0;
+    // 渲染线程每帧的 CPU 耗时: 渲染 + 读取
+    double cpuMsPerFrame = 0;
+    // 从提交读取到回调的平均耗时, 只对 READBACK_ASYNC 有效
+    double latencyMs = 0;
+    int64_t received = 0;
+    int64_t dropped = 0;
+};
+
+/**
+ * 每帧渲染一次全屏纹理后读回, 对比三种读取方式渲染线程的开销. subRect 时只读取中间 1/4 的区域.
+ * 需要在 GL 线程调用
+ */
+GpuReadbackResult runReadback(int mode, FramebufferFormat format, int depth, int frames, int width, int height,
+                              bool subRect);
+
+struct GpuYuvReadbackResult {
+    // true: RGBAToYUVFilter 转换后读回, false: 读回 RGBA 后 YuvUtils 转换
+    bool gpu = false;
+    int layout = 0;
+    // GPU 转换输出的 Framebuffer 格式, FB_FORMAT_RGBA8 (4 字节打包) 或 FB_FORMAT_R8
+    FramebufferFormat format = FB_FORMAT_RGBA8;
+    int frames = 0;
+    int width = 0;
+    int height = 0;
+    // 渲染结果到 YUV 内存的耗时, 包含转换和读回
+    double msPerFrame = 0;
+    int64_t bytesRead = 0;
+    // 与 YuvUtils 同一格式转换结果的最大差值
+    int maxDiff = 0;
+};
+
+/**
+ * 与 YuvUtils 的最大差值超过这个值时 bench 失败
+ */
+const int kYuvReadbackTolerance = 2;
+
+const char *yuvLayoutName(int layout);
+
+/**
+ * 渲染结果转换为 NV21/NV12/I420 (BT601 limited range) 并读回到内存. 需要在 GL 线程调用
+ * @param layout YuvLayout
+ */
+GpuYuvReadbackResult runYuvReadback(bool gpu, int layout, FramebufferFormat format, int frames, int width, int height);
+
+enum GpuUploadMode {
+    // 整理到紧密排列的缓存后上传, 和旧的 putData 一致
+    UPLOAD_STAGED = 0,
+    // 直接从内存 glTexSubImage2D, GL_UNPACK_ROW_LENGTH 处理填充
+    UPLOAD_DIRECT,
+    // 经过两个交替的 pixel unpack buffer
+    UPLOAD_PBO,
+};
+
+const char *uploadModeName(int mode);
+
+struct GpuUploadResult {
+    int mode = UPLOAD_STAGED;
+    // 每行末尾的填充字节数
+    int padding = 0;
+    int frames = 0;
+    int width = 0;
+    int height = 0;
+    // 上传调用返回前的耗时
+    double cpuMsPerFrame = 0;
+    // 包含 glFinish 的耗时
+    double wallMsPerFrame = 0;
+};
+
+/**
+ * 每帧上传一次 NV21 的 Y 和 VU 平面到 PlaneTexture. 需要在 GL 线程调用
+ */
+GpuUploadResult runYuvUpload(int mode, int padding, int frames, int width, int height);
+
+struct GpuHitchResult {
+    // true: TextureUploader 在后台上传, false: ImageTexture 在渲染线程上传
+    bool async = false;
+    int frames = 0;
+    int width = 0;
+    int height = 0;
+    // 请求上传之前渲染线程单帧的最大耗时
+    double baselineMs = 0;
+    // 渲染线程单帧的最大耗时
+    double maxFrameMs = 0;
+    // 请求上传后第几帧可以使用, -1 为没有完成
+    int readyFrame = -1;
+    // 异步上传从请求到 ready 的耗时
+    double latencyMs = 0;
+};
+
+/**
+ * 渲染线程逐帧渲染, 中途请求上传一张大图, 统计渲染线程的卡顿. 在调用线程运行
+ */
+GpuHitchResult runTextureHitch(GLEngine &engine, bool async, int frames, int width, int height);
+
+struct GpuMailboxResult {
+    // true: FrameMailbox, false: ShareFramebuffer
+    bool mailbox = false;
+    int frames = 0;
+    int width = 0;
+    int height = 0;
+    // 消费者每帧额外占用的时间
+    int consumerMs = 0;
+    // 生产者的帧率
+    double producerFps = 0;
+    // 消费者拿到的新帧数
+    int64_t consumed = 0;
+    int64_t dropped = 0;
+    // 消费者读到的内容与帧序号不一致的次数
+    int64_t mismatches = 0;
+};
+
+/**
+ * 生产者 (engine) 和共享 context 上的消费者之间传递帧, 消费者比生产者慢. 在调用线程运行
+ */
+GpuMailboxResult runMailbox(GLEngine &engine, bool mailbox, int frames, int width, int height, int consumerMs);
+
+struct GpuFenceResult {
+    // 支持 EGL_ANDROID_native_fence_sync
+    bool native = false;
+    int iterations = 0;
+    // 渲染还没完成时 poll() 的平均耗时
+    double pollUs = 0;
+    // 第一次 poll() 时还没完成的次数
+    int pendingPolls = 0;
+    // waitFor(1ms) 超时返回的次数
+    int boundedTimeouts = 0;
+    // 从插入 fence 到完成的平均耗时
+    double signalMs = 0;
+    // 消费者 context 用 waitServer 等待后读到的内容与生产者不一致的次数
+    int serverWaitMismatches = 0;
+    // 导出/导入 fd 后等待成功; 不支持 native fence 时用 pipe 验证 fd 在 CPU 上等待的退路
+    bool fdRoundTrip = false;
+};
+
+/**
+ * EGLFence 的非阻塞查询、带超时等待、跨 context 的 GPU 等待和 fd 导出导入. 在调用线程运行
+ */
+GpuFenceResult runFence(GLEngine &engine, int iterations, int width, int height);
+
+enum PacingMode {
+    // postRender, 每个请求都排队渲染
+    PACING_QUEUE = 0,
+    // requestRender, 只渲染最新的请求
+    PACING_LATEST,
+    // requestRender + 目标帧率
+    PACING_FPS,
+};
+
+const char *pacingModeName(int mode);
+
+struct GpuPacingResult {
+    int mode = PACING_QUEUE;
+    float fps = 0;
+    int64_t requested = 0;
+    int64_t rendered = 0;
+    int64_t coalesced = 0;
+    int64_t missed = 0;
+    double avgLatencyMs = 0;
+    double maxLatencyMs = 0;
+};
+
+/**
+ * 生产者每 requestIntervalMs 请求一次渲染, 每帧渲染需要 renderMs, 生产者比渲染快时统计请求到渲染完成的延迟.
+ * 在调用线程运行
+ */
+GpuPacingResult runPacing(GLEngine &engine, int mode, float fps, int durationMs, int requestIntervalMs, int renderMs);
+
+struct GpuResolutionResult {
+    bool dynamic = false;
+    int width = 0;
+    int height = 0;
+    float targetMs = 0;
+    // 重负载阶段结束时的比例和最后几帧的平均耗时
+    float heavyScale = 1.0f;
+    double heavyMs = 0;
+    // 轻负载阶段结束时
+    float lightScale = 1.0f;
+    double lightMs = 0;
+    int changes = 0;
+    // 比例变化方向反转的次数, 同一个负载阶段内反转说明在振荡
+    int reversals = 0;
+    // RenderGraph 创建中间 Framebuffer 的次数, 比例变化时优先复用备用的
+    int64_t allocations = 0;
+};
+
+/**
+ * RenderGraph 链路先重负载 (heavyPasses 个锐化 pass) 再轻负载 (1 个), 各 frames 帧, 通过 GLEngine::syncRender 渲染.
+ * dynamic 为 true 时开启动态分辨率. 在调用线程运行
+ */
+GpuResolutionResult runDynamicResolution(GLEngine &engine, bool dynamic, int frames, int width, int height,
+                                         int heavyPasses, float targetMs);
+
+struct GpuPresentResult {
+    // true: 一个 GLEngine 渲染一次后输出到所有 surface; false: 每个 surface 一个 GLEngine, 各自渲染滤镜链
+    bool renderOnce = false;
+    int frames = 0;
+    int surfaces = 0;
+    // 每帧所有 surface 的总耗时
+    double avgFrameMs = 0;
+    // 各个 surface 输出的帧数
+    std::vector<int64_t> presented;
+    // 各个 surface 1/4 处的 R/G 与源图旋转后对应位置的最大差异
+    int maxSampleDiff = 0;
+};
+
+/**
+ * 1280x720 的输入经过 缩放 -> 锐化 -> 锐化 输出到 3 个 pbuffer surface:
+ * 640x360 每帧, 720x1280 旋转 90 度 30fps, 320x180 15fps, 帧时间按 60fps. 在调用线程运行
+ */
+GpuPresentResult runMultiPresent(bool renderOnce, int frames);
+
+struct GpuFusionResult {
+    bool fused = false;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    // 每帧的全屏 pass 数
+    int passes = 0;
+    // 每帧中间 Framebuffer 的读写字节数
+    int64_t intermediateBytes = 0;
+    // 渲染 + glFinish 的平均耗时
+    double avgFrameMs = 0;
+    // 融合时: 每帧在 锐化 -> 调色 -> 纹理 和 锐化 -> 调色 两条链之间切换的平均耗时, 以及缓存的 program 数
+    double switchFrameMs = 0;
+    int programs = 0;
+    // 与三个 pass 的输出比较
+    int maxDiff = 0;
+    double meanDiff = 0;
+};
+
+/**
+ * 锐化 -> 调色 -> 纹理输出, 三个 pass 或者用 FusedFilter 融合为一个 pass. 在调用线程运行
+ */
+GpuFusionResult runFilterFusion(GLEngine &engine, bool fused, int frames, int width, int height);
+
+/**
+ * 融合与三个 pass 的差值超过这些值时 bench 失败. 三个 pass 的中间结果量化为 RGBA8, 再被锐化和对比度放大,
+ * 少数边缘像素的差值会到 20 多 (实测最大 23, 平均 0.15); 融合的 shader 出错时平均差值会大得多
+ */
+const int kFusionMaxDiffTolerance = 32;
+const double kFusionMeanDiffTolerance = 0.5;
+
+enum ComputeMode {
+    COMPUTE_OFF = 0,
+    // 每个像素直接采样
+    COMPUTE_DIRECT,
+    // shared memory 分块
+    COMPUTE_TILED,
+};
+
+const char *computeModeName(int mode);
+
+struct GpuComputeResult {
+    int mode = COMPUTE_OFF;
+    // 实际是否使用了 compute shader
+    bool usedCompute = false;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    // dispatch/绘制 + glFinish 的平均耗时
+    double avgFrameMs = 0;
+    // 每个输出像素读取的 texel 数 (双线性采样按 4 个计算), 按 shader 的访问模式计算
+    double texelsPerPixel = 0;
+    // 与 fragment shader 的输出比较
+    int maxDiff = 0;
+};
+
+/**
+ * 锐化 width x height 的输入, fragment shader 或 compute shader. 在调用线程运行
+ */
+GpuComputeResult runComputeSharpen(GLEngine &engine, int mode, int frames, int width, int height);
+
+/**
+ * compute shader 与 fragment shader 的最大差值超过这个值时 bench 失败, 两者的插值/舍入不同, 实测为 1
+ */
+const int kComputeTolerance = 1;
+
+struct GpuDamageResult {
+    bool damage = false;
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    // 每帧变化的方块边长
+    int rectSize = 0;
+    // 上传 + 执行 + glFinish 的平均耗时
+    double avgFrameMs = 0;
+    // 平均每帧所有 pass 更新的像素数
+    double renderedPixels = 0;
+    // 每秒输出的完整帧像素数
+    double mpixPerSec = 0;
+    int64_t graphBytes = 0;
+    // 与整帧渲染的结果比较
+    int maxDiff = 0;
+};
+
+/**
+ * 输入中每帧只有一个 rectSize 大小的方块移动, 通过 RenderGraph 渲染 texture -> color -> sharpen -> sharpen,
+ * 整帧渲染或者只渲染变化的区域. 在调用线程运行
+ */
+GpuDamageResult runDamageRender(GLEngine &engine, bool damage, int frames, int width, int height, int rectSize);
+
+NAMESPACE_END
@@ -0,0 +1,735 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/gles/RenderGraph.h"
+#include "common/gles/filter/ColorAdjustFilter.h"
+#include "common/gles/filter/FusedFilter.h"
+#include "common/gles/filter/NV12Filter.h"
+#include "common/gles/filter/NV21Filter.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+#include "common/gles/filter/YUVFilter.h"
+
+#include <cstring>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+void renderTexture(TextureFilter &filter, const Texture &input, Framebuffer &output) {
+    filter.viewport().set(output.texWidth(), output.texHeight()).enableClearColor(0, 0, 0, 1);
+    filter.setFullTextureCoord().setFullVertexCoord();
+    filter.inputTexture(input).blend(false).render(&output);
+}
+
+void renderSharpen(SharpenFilter &filter, const Texture &input, Framebuffer &output) {
+    filter.setViewport(output.texWidth(), output.texHeight());
+    filter.setResolution((float)input.width(), (float)input.height());
+    filter.inputTexture(input.id());
+    filter.render(&output);
+}
+
+void renderColorAdjust(ColorAdjustFilter &filter, const Texture &input, Framebuffer &output) {
+    filter.setViewport(output.texWidth(), output.texHeight());
+    filter.inputTexture(input.id());
+    filter.render(&output);
+}
+
+void setupColorAdjust(ColorAdjustFilter &filter) {
+    filter.setBrightness(0.2f);
+    filter.setContrast(0.3f);
+    filter.setSaturation(0.4f);
+}
+
+class TextureCase : public GpuCase {
+public:
+    std::string name() const override { return "texture"; }
+
+    void setup(GpuInput &) override { m_filter.reset(new TextureFilter()); }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderTexture(*m_filter, *input.rgbaTexture, output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    std::unique_ptr<TextureFilter> m_filter;
+};
+
+class SharpenCase : public GpuCase {
+public:
+    std::string name() const override { return "sharpen"; }
+
+    void setup(GpuInput &) override {
+        m_filter.reset(new SharpenFilter());
+        m_filter->setStrength(0.8f);
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderSharpen(*m_filter, *input.rgbaTexture, output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    std::unique_ptr<SharpenFilter> m_filter;
+};
+
+/**
+ * 锐化走 compute shader, 输出需要和 sharpen 一致. 不支持 compute 的 context 上回退到 fragment shader
+ */
+class SharpenComputeCase : public GpuCase {
+public:
+    explicit SharpenComputeCase(bool tiled = false) : m_tiled(tiled) {}
+
+    std::string name() const override { return m_tiled ? "sharpen_compute_tiled" : "sharpen_compute"; }
+
+    void setup(GpuInput &input) override {
+        m_filter.reset(new SharpenFilter());
+        m_filter->setStrength(0.8f);
+        m_filter->setComputeEnabled(true);
+        m_filter->setComputeTiled(m_tiled);
+        m_texture.reset(new TextureFilter());
+        m_image.create(input.width, input.height, FB_FORMAT_RGBA8_IMAGE);
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderSharpen(*m_filter, *input.rgbaTexture, m_image);
+        renderTexture(*m_texture, m_image.textureNonnull(), output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_texture->release();
+        m_filter.reset();
+        m_texture.reset();
+        m_image.release();
+    }
+
+private:
+    const bool m_tiled;
+    std::unique_ptr<SharpenFilter> m_filter;
+    std::unique_ptr<TextureFilter> m_texture;
+    Framebuffer m_image;
+};
+
+class ColorAdjustCase : public GpuCase {
+public:
+    std::string name() const override { return "color_adjust"; }
+
+    void setup(GpuInput &) override {
+        m_filter.reset(new ColorAdjustFilter());
+        setupColorAdjust(*m_filter);
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderColorAdjust(*m_filter, *input.rgbaTexture, output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    std::unique_ptr<ColorAdjustFilter> m_filter;
+};
+
+/**
+ * 参数放在 uniform block 中, 输出需要和 color_adjust 一致
+ */
+class ColorAdjustBlockCase : public GpuCase {
+public:
+    std::string name() const override { return "color_adjust_ubo"; }
+
+    void setup(GpuInput &) override {
+        m_filter.reset(new ColorAdjustFilter(true));
+        setupColorAdjust(*m_filter);
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderColorAdjust(*m_filter, *input.rgbaTexture, output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    std::unique_ptr<ColorAdjustFilter> m_filter;
+};
+
+// YUV 数据的上传方式
+enum YuvUploadMode {
+    // putData: 复制到滤镜内部的缓存, 渲染时上传
+    YUV_UPLOAD_PUT = 0,
+    // uploadData: 直接从内存经过 PBO 上传
+    YUV_UPLOAD_PBO,
+    // uploadData: 关闭 PBO, 直接 glTexSubImage2D
+    YUV_UPLOAD_DIRECT,
+};
+
+const char *uploadSuffix(YuvUploadMode mode, int padding) {
+    if (mode == YUV_UPLOAD_PUT) {
+        return "";
+    }
+    if (padding > 0) {
+        return mode == YUV_UPLOAD_PBO ? "_stride_pbo" : "_stride_direct";
+    }
+    return mode == YUV_UPLOAD_PBO ? "_upload_pbo" : "_upload_direct";
+}
+
+/**
+ * 每行末尾补上 padding 个字节, 模拟相机按对齐后的 stride 输出的平面
+ */
+void padPlane(const uint8_t *src, int rowBytes, int rows, int padding, std::vector<uint8_t> &dst) {
+    int stride = rowBytes + padding;
+    dst.assign((size_t)stride * rows, 0xA5);
+    for (int row = 0; row < rows; ++row) {
+        memcpy(dst.data() + (size_t)row * stride, src + (size_t)row * rowBytes, rowBytes);
+    }
+}
+
+/**
+ * YUV 滤镜的 case, 每帧都重新上传数据, 和相机预览的用法一致
+ */
+class NV21Case : public GpuCase {
+public:
+    explicit NV21Case(YuvUploadMode mode = YUV_UPLOAD_PUT, int padding = 0) : m_mode(mode), m_padding(padding) {}
+
+    std::string name() const override { return std::string("nv21") + uploadSuffix(m_mode, m_padding); }
+
+    void setup(GpuInput &input) override {
+        m_filter.reset(new NV21Filter());
+        m_filter->setPboEnabled(m_mode == YUV_UPLOAD_PBO);
+        if (m_padding > 0) {
+            padPlane(input.nv21.data(), input.width, input.height, m_padding, m_y);
+            padPlane(input.nv21.data() + input.width * input.height, input.width, input.height / 2, m_padding, m_uv);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        if (m_mode == YUV_UPLOAD_PUT) {
+            m_filter->putData(input.nv21.data(), input.width, input.height);
+        } else if (m_padding > 0) {
+            int stride = input.width + m_padding;
+            m_filter->uploadData(m_y.data(), stride, m_uv.data(), stride, input.width, input.height);
+        } else {
+            const uint8_t *y = input.nv21.data();
+            m_filter->uploadData(y, input.width, y + input.width * input.height, input.width, input.width,
+                                 input.height);
+        }
+        m_filter->setViewport(output.texWidth(), output.texHeight());
+        m_filter->render(&output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    const YuvUploadMode m_mode;
+    const int m_padding;
+    std::vector<uint8_t> m_y;
+    std::vector<uint8_t> m_uv;
+    std::unique_ptr<NV21Filter> m_filter;
+};
+
+class NV12Case : public GpuCase {
+public:
+    std::string name() const override { return "nv12"; }
+
+    void setup(GpuInput &) override { m_filter.reset(new NV12Filter()); }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        m_filter->putData(input.nv12.data(), input.width, input.height);
+        m_filter->setViewport(output.texWidth(), output.texHeight());
+        m_filter->render(&output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    std::unique_ptr<NV12Filter> m_filter;
+};
+
+class YUVCase : public GpuCase {
+public:
+    explicit YUVCase(YuvUploadMode mode = YUV_UPLOAD_PUT, int padding = 0) : m_mode(mode), m_padding(padding) {}
+
+    std::string name() const override { return std::string("yuv") + uploadSuffix(m_mode, m_padding); }
+
+    void setup(GpuInput &input) override {
+        m_filter.reset(new YUVFilter());
+        m_filter->setPboEnabled(m_mode == YUV_UPLOAD_PBO);
+        if (m_padding > 0) {
+            const uint8_t *y = input.i420.data();
+            const uint8_t *u = y + input.width * input.height;
+            const uint8_t *v = u + input.width * input.height / 4;
+            padPlane(y, input.width, input.height, m_padding, m_y);
+            padPlane(u, input.width / 2, input.height / 2, m_padding, m_u);
+            padPlane(v, input.width / 2, input.height / 2, m_padding, m_v);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        const uint8_t *y = input.i420.data();
+        const uint8_t *u = y + input.width * input.height;
+        const uint8_t *v = u + input.width * input.height / 4;
+        if (m_mode == YUV_UPLOAD_PUT) {
+            m_filter->putData(y, u, v, input.width, input.height);
+        } else if (m_padding > 0) {
+            int stride = input.width + m_padding, chromaStride = input.width / 2 + m_padding;
+            m_filter->uploadData(m_y.data(), stride, m_u.data(), chromaStride, m_v.data(), chromaStride, input.width,
+                                 input.height);
+        } else {
+            m_filter->uploadData(y, input.width, u, input.width / 2, v, input.width / 2, input.width, input.height);
+        }
+        m_filter->setViewport(output.texWidth(), output.texHeight());
+        m_filter->render(&output);
+    }
+
+    void release() override {
+        m_filter->release();
+        m_filter.reset();
+    }
+
+private:
+    const YuvUploadMode m_mode;
+    const int m_padding;
+    std::vector<uint8_t> m_y;
+    std::vector<uint8_t> m_u;
+    std::vector<uint8_t> m_v;
+    std::unique_ptr<YUVFilter> m_filter;
+};
+
+/**
+ * 相机预览常见的链路: nv21 -> 调色 -> 锐化
+ */
+class NV21ChainCase : public GpuCase {
+public:
+    std::string name() const override { return "chain_nv21_color_sharpen"; }
+
+    void setup(GpuInput &input) override {
+        m_nv21.reset(new NV21Filter());
+        m_color.reset(new ColorAdjustFilter());
+        m_sharpen.reset(new SharpenFilter());
+        setupColorAdjust(*m_color);
+        m_sharpen->setStrength(0.8f);
+        for (auto &fb : m_fb) {
+            fb.create(input.width, input.height);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        m_nv21->putData(input.nv21.data(), input.width, input.height);
+        m_nv21->setViewport(input.width, input.height);
+        m_nv21->render(&m_fb[0]);
+        renderColorAdjust(*m_color, m_fb[0].textureNonnull(), m_fb[1]);
+        renderSharpen(*m_sharpen, m_fb[1].textureNonnull(), output);
+    }
+
+    void release() override {
+        m_nv21->release();
+        m_color->release();
+        m_sharpen->release();
+        m_nv21.reset();
+        m_color.reset();
+        m_sharpen.reset();
+        for (auto &fb : m_fb) {
+            fb.release();
+        }
+    }
+
+private:
+    std::unique_ptr<NV21Filter> m_nv21;
+    std::unique_ptr<ColorAdjustFilter> m_color;
+    std::unique_ptr<SharpenFilter> m_sharpen;
+    Framebuffer m_fb[2];
+};
+
+int64_t framebufferTraffic(const Framebuffer *fbs, int count) {
+    int64_t bytes = 0;
+    for (int i = 0; i < count; ++i) {
+        bytes += fbs[i].byteSize() * 2;
+    }
+    return bytes;
+}
+
+/**
+ * 图片编辑常见的链路: 纹理 -> 调色 -> 锐化 -> 纹理输出, 中间结果可以使用更高精度的格式
+ */
+class TextureChainCase : public GpuCase {
+public:
+    explicit TextureChainCase(FramebufferFormat format = FB_FORMAT_RGBA8) : m_format(format) {}
+
+    std::string name() const override {
+        std::string name = "chain_texture_color_sharpen_texture";
+        if (m_format == FB_FORMAT_RGBA16F) {
+            name += "_rgba16f";
+        } else if (m_format == FB_FORMAT_RGB10_A2) {
+            name += "_rgb10a2";
+        }
+        return name;
+    }
+
+    void setup(GpuInput &input) override {
+        m_texture.reset(new TextureFilter());
+        m_color.reset(new ColorAdjustFilter());
+        m_sharpen.reset(new SharpenFilter());
+        setupColorAdjust(*m_color);
+        m_sharpen->setStrength(0.5f);
+        for (auto &fb : m_fb) {
+            fb.create(input.width, input.height, m_format);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderTexture(*m_texture, *input.rgbaTexture, m_fb[0]);
+        renderColorAdjust(*m_color, m_fb[0].textureNonnull(), m_fb[1]);
+        renderSharpen(*m_sharpen, m_fb[1].textureNonnull(), m_fb[2]);
+        renderTexture(*m_texture, m_fb[2].textureNonnull(), output);
+    }
+
+    void release() override {
+        m_texture->release();
+        m_color->release();
+        m_sharpen->release();
+        m_texture.reset();
+        m_color.reset();
+        m_sharpen.reset();
+        for (auto &fb : m_fb) {
+            fb.release();
+        }
+    }
+
+private:
+    std::unique_ptr<TextureFilter> m_texture;
+    std::unique_ptr<ColorAdjustFilter> m_color;
+    std::unique_ptr<SharpenFilter> m_sharpen;
+    Framebuffer m_fb[3];
+    const FramebufferFormat m_format;
+
+public:
+    int64_t intermediateBytes() const override { return framebufferTraffic(m_fb, 3); }
+};
+
+/**
+ * 锐化 -> 调色 -> 纹理输出, 三个 pass, 与 FusedChainCase 对比
+ */
+class SharpenChainCase : public GpuCase {
+public:
+    std::string name() const override { return "chain_sharpen_color_texture"; }
+
+    void setup(GpuInput &input) override {
+        m_sharpen.reset(new SharpenFilter());
+        m_color.reset(new ColorAdjustFilter());
+        m_texture.reset(new TextureFilter());
+        m_sharpen->setStrength(0.5f);
+        setupColorAdjust(*m_color);
+        for (auto &fb : m_fb) {
+            fb.create(input.width, input.height);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        renderSharpen(*m_sharpen, *input.rgbaTexture, m_fb[0]);
+        renderColorAdjust(*m_color, m_fb[0].textureNonnull(), m_fb[1]);
+        renderTexture(*m_texture, m_fb[1].textureNonnull(), output);
+    }
+
+    void release() override {
+        m_sharpen->release();
+        m_color->release();
+        m_texture->release();
+        m_sharpen.reset();
+        m_color.reset();
+        m_texture.reset();
+        for (auto &fb : m_fb) {
+            fb.release();
+        }
+    }
+
+private:
+    std::unique_ptr<SharpenFilter> m_sharpen;
+    std::unique_ptr<ColorAdjustFilter> m_color;
+    std::unique_ptr<TextureFilter> m_texture;
+    Framebuffer m_fb[2];
+
+public:
+    int64_t intermediateBytes() const override { return framebufferTraffic(m_fb, 2); }
+};
+
+/**
+ * 与 SharpenChainCase 相同的链, 融合为一个 pass
+ */
+class FusedChainCase : public GpuCase {
+public:
+    std::string name() const override { return "fused_sharpen_color_texture"; }
+
+    void setup(GpuInput &) override {
+        m_sharpen.reset(new SharpenFilter());
+        m_color.reset(new ColorAdjustFilter());
+        m_texture.reset(new TextureFilter());
+        m_fused.reset(new FusedFilter());
+        m_sharpen->setStrength(0.5f);
+        setupColorAdjust(*m_color);
+        m_fused->setChain({m_sharpen.get(), m_color.get(), m_texture.get()});
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        m_sharpen->setResolution((float)input.width, (float)input.height);
+        m_fused->viewport().set(output.texWidth(), output.texHeight());
+        m_fused->setFullTextureCoord().setFullVertexCoord();
+        m_fused->inputTexture(*input.rgbaTexture).render(&output);
+    }
+
+    void release() override {
+        m_fused->release();
+        m_fused.reset();
+        m_sharpen.reset();
+        m_color.reset();
+        m_texture.reset();
+    }
+
+private:
+    std::unique_ptr<SharpenFilter> m_sharpen;
+    std::unique_ptr<ColorAdjustFilter> m_color;
+    std::unique_ptr<TextureFilter> m_texture;
+    std::unique_ptr<FusedFilter> m_fused;
+};
+
+/**
+ * 只处理亮度的滤镜: 提取亮度, 亮度上的 3x3 十字模糊, 亮度展开为灰度 RGBA.
+ * 只读写 r 通道, 中间结果可以是 R8
+ */
+class LumaFilter : public BaseFilter {
+public:
+    enum Mode { MODE_EXTRACT, MODE_BLUR, MODE_EXPAND };
+
+    explicit LumaFilter(Mode mode) : BaseFilter("luma"), m_mode(mode) {
+        defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
+        defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
+        m_input_texture = defUniform("inputImageTexture", DataType::SAMPLER_2D);
+        m_texel = defUniform("texel", DataType::FVEC2);
+    }
+
+    void render(const Texture &input, Framebuffer &output) {
+        setViewport(output.texWidth(), output.texHeight());
+        m_input_texture->set((int)input.id());
+        m_texel->set(1.0f / (float)input.width(), 1.0f / (float)input.height());
+        BaseFilter::render(&output);
+    }
+
+protected:
+    std::string vertexShader() override {
+        std::string vs = R"(
+attribute vec4 position;
+attribute vec2 inputTextureCoordinate;
+varying highp vec2 textureCoordinate;
+void main() {
+    gl_Position = position;
+    textureCoordinate = inputTextureCoordinate;
+})";
+        return CORRECT_VERTEX_SHADER(vs);
+    }
+
+    std::string fragmentShader() override {
+        std::string body;
+        if (m_mode == MODE_EXTRACT) {
+            body = "highp float y = dot(texture2D(inputImageTexture, textureCoordinate).rgb, vec3(0.299, 0.587, 0.114));";
+        } else if (m_mode == MODE_BLUR) {
+            body = "highp float y = texture2D(inputImageTexture, textureCoordinate).r * 0.4"
+                   " + texture2D(inputImageTexture, textureCoordinate + vec2(texel.x, 0.0)).r * 0.15"
+                   " + texture2D(inputImageTexture, textureCoordinate - vec2(texel.x, 0.0)).r * 0.15"
+                   " + texture2D(inputImageTexture, textureCoordinate + vec2(0.0, texel.y)).r * 0.15"
+                   " + texture2D(inputImageTexture, textureCoordinate - vec2(0.0, texel.y)).r * 0.15;";
+        } else {
+            body = "highp float y = texture2D(inputImageTexture, textureCoordinate).r;";
+        }
+        std::string fs = R"(
+varying highp vec2 textureCoordinate;
+uniform sampler2D inputImageTexture;
+uniform highp vec2 texel;
+void main() {
+    )" + body + R"(
+    gl_FragColor = vec4(y, y, y, 1.0);
+})";
+        return CORRECT_FRAGMENT_SHADER(fs);
+    }
+
+private:
+    const Mode m_mode;
+    Uniform *m_input_texture = nullptr;
+    Uniform *m_texel = nullptr;
+};
+
+/**
+ * 亮度链路: 提取 -> 模糊 -> 模糊 -> 展开, 对比 RGBA8 与 R8 中间结果的带宽, 两者输出一致
+ */
+class LumaChainCase : public GpuCase {
+public:
+    explicit LumaChainCase(FramebufferFormat format) : m_format(format) {}
+
+    std::string name() const override {
+        return m_format == FB_FORMAT_R8 ? "chain_luma_r8" : "chain_luma_rgba8";
+    }
+
+    void setup(GpuInput &input) override {
+        m_extract.reset(new LumaFilter(LumaFilter::MODE_EXTRACT));
+        m_blur.reset(new LumaFilter(LumaFilter::MODE_BLUR));
+        m_expand.reset(new LumaFilter(LumaFilter::MODE_EXPAND));
+        for (auto &fb : m_fb) {
+            fb.create(input.width, input.height, m_format);
+        }
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        m_extract->render(*input.rgbaTexture, m_fb[0]);
+        m_blur->render(m_fb[0].textureNonnull(), m_fb[1]);
+        m_blur->render(m_fb[1].textureNonnull(), m_fb[0]);
+        m_expand->render(m_fb[0].textureNonnull(), output);
+    }
+
+    void release() override {
+        m_extract->release();
+        m_blur->release();
+        m_expand->release();
+        m_extract.reset();
+        m_blur.reset();
+        m_expand.reset();
+        for (auto &fb : m_fb) {
+            fb.release();
+        }
+    }
+
+    // fb[0] 写两次读两次, fb[1] 写一次读一次
+    int64_t intermediateBytes() const override { return m_fb[0].byteSize() * 4 + m_fb[1].byteSize() * 2; }
+
+private:
+    std::unique_ptr<LumaFilter> m_extract;
+    std::unique_ptr<LumaFilter> m_blur;
+    std::unique_ptr<LumaFilter> m_expand;
+    Framebuffer m_fb[2];
+    const FramebufferFormat m_format;
+};
+
+/**
+ * 和 TextureChainCase 相同的链路, 由 RenderGraph 分配中间结果, 另外挂一个没有被输出用到的分支
+ * 中间结果只需要 2 个 Framebuffer, 无用分支不会执行
+ */
+class GraphChainCase : public GpuCase {
+public:
+    std::string name() const override { return "graph_texture_color_sharpen_texture"; }
+
+    void setup(GpuInput &) override {
+        m_texture.reset(new TextureFilter());
+        m_color.reset(new ColorAdjustFilter());
+        m_sharpen.reset(new SharpenFilter());
+        m_unused.reset(new SharpenFilter());
+        m_graph.reset(new RenderGraph("graph_chain"));
+        setupColorAdjust(*m_color);
+        m_sharpen->setStrength(0.5f);
+
+        TextureFilter &texture = *m_texture;
+        ColorAdjustFilter &color = *m_color;
+        SharpenFilter &sharpen = *m_sharpen;
+        auto bindTexture = [&texture](const std::vector<const Texture2D *> &in, int w, int h) {
+            texture.viewport().set(w, h).enableClearColor(0, 0, 0, 1);
+            texture.setFullTextureCoord().setFullVertexCoord();
+            texture.inputTexture(*in[0]).blend(false);
+        };
+        auto bindSharpen = [&sharpen](const std::vector<const Texture2D *> &in, int w, int h) {
+            sharpen.setViewport(w, h);
+            sharpen.setResolution((float)in[0]->width(), (float)in[0]->height());
+            sharpen.inputTexture(in[0]->id());
+        };
+
+        m_source = m_graph->importTexture("source");
+        RenderGraph::ResId copied = m_graph->addPass("texture_in", m_texture.get(), {m_source}, bindTexture);
+        RenderGraph::ResId colored = m_graph->addPass("color", m_color.get(), {copied},
+            [&color](const std::vector<const Texture2D *> &in, int w, int h) {
+                color.setViewport(w, h);
+                color.inputTexture(in[0]->id());
+            });
+        RenderGraph::ResId sharpened = m_graph->addPass("sharpen", m_sharpen.get(), {colored}, bindSharpen);
+        m_output = m_graph->addPass("texture_out", m_texture.get(), {sharpened}, bindTexture);
+        m_graph->addPass("unused_preview", m_unused.get(), {copied}, bindSharpen, 0.5f);
+    }
+
+    void render(GpuInput &input, Framebuffer &output) override {
+        m_graph->setImport(m_source, input.rgbaTexture);
+        m_graph->setOutput(m_output, &output);
+        m_graph->execute();
+    }
+
+    void release() override {
+        m_graph->release();
+        m_texture->release();
+        m_color->release();
+        m_sharpen->release();
+        m_unused->release();
+        m_graph.reset();
+        m_texture.reset();
+        m_color.reset();
+        m_sharpen.reset();
+        m_unused.reset();
+    }
+
+private:
+    std::unique_ptr<RenderGraph> m_graph;
+    RenderGraph::ResId m_source = RenderGraph::INVALID_RES;
+    RenderGraph::ResId m_output = RenderGraph::INVALID_RES;
+
+    std::unique_ptr<TextureFilter> m_texture;
+    std::unique_ptr<ColorAdjustFilter> m_color;
+    std::unique_ptr<SharpenFilter> m_sharpen;
+    std::unique_ptr<SharpenFilter> m_unused;
+};
+
+} // namespace
+
+std::vector<std::shared_ptr<GpuCase>> createGpuCases() {
+    return {
+        std::make_shared<TextureCase>(),
+        std::make_shared<SharpenCase>(),
+        std::make_shared<SharpenComputeCase>(),
+        std::make_shared<SharpenComputeCase>(true),
+        std::make_shared<ColorAdjustCase>(),
+        std::make_shared<ColorAdjustBlockCase>(),
+        std::make_shared<NV21Case>(),
+        std::make_shared<NV21Case>(YUV_UPLOAD_PBO),
+        std::make_shared<NV21Case>(YUV_UPLOAD_DIRECT),
+        std::make_shared<NV21Case>(YUV_UPLOAD_PBO, 64),
+        std::make_shared<NV21Case>(YUV_UPLOAD_DIRECT, 64),
+        std::make_shared<NV12Case>(),
+        std::make_shared<YUVCase>(),
+        std::make_shared<YUVCase>(YUV_UPLOAD_PBO, 64),
+        std::make_shared<NV21ChainCase>(),
+        std::make_shared<TextureChainCase>(),
+        std::make_shared<TextureChainCase>(FB_FORMAT_RGBA16F),
+        std::make_shared<TextureChainCase>(FB_FORMAT_RGB10_A2),
+        std::make_shared<GraphChainCase>(),
+        std::make_shared<SharpenChainCase>(),
+        std::make_shared<FusedChainCase>(),
+        std::make_shared<LumaChainCase>(FB_FORMAT_RGBA8),
+        std::make_shared<LumaChainCase>(FB_FORMAT_R8),
+    };
+}
+
+NAMESPACE_END
@@ -0,0 +1,102 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/SharpenFilter.h"
+
+#include <chrono>
+#include <cstdlib>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+const char *computeModeName(int mode) {
+    switch (mode) {
+        case COMPUTE_OFF: return "fragment";
+        case COMPUTE_DIRECT: return "compute";
+        case COMPUTE_TILED: return "tiled";
+        default: return "unknown";
+    }
+}
+
+GpuComputeResult runComputeSharpen(GLEngine &engine, int mode, int frames, int width, int height) {
+    GpuComputeResult result;
+    result.mode = mode;
+    result.width = width;
+    result.height = height;
+    result.frames = frames;
+
+    GpuInput input;
+    input.generate(width, height);
+    SharpenFilter fragment, filter;
+    Framebuffer expect, output;
+
+    auto render = [&](SharpenFilter &f, Framebuffer &fb) {
+        f.setViewport(width, height);
+        f.setResolution((float)width, (float)height);
+        f.inputTexture(input.rgbaTexture->id());
+        f.render(&fb);
+    };
+
+    engine.sync([&]() {
+        input.createTexture();
+        fragment.setStrength(0.8f);
+        filter.setStrength(0.8f);
+        filter.setComputeEnabled(mode != COMPUTE_OFF);
+        filter.setComputeTiled(mode == COMPUTE_TILED);
+        expect.create(width, height);
+        output.create(width, height, FB_FORMAT_RGBA8_IMAGE);
+
+        render(fragment, expect);
+        render(filter, output);
+        glFinish();
+        result.usedCompute = filter.lastRenderCompute();
+
+        int64_t start = nowNs();
+        for (int i = 0; i < frames; ++i) {
+            render(filter, output);
+            glFinish();
+        }
+        result.avgFrameMs = frames > 0 ? (double)(nowNs() - start) / frames / 1e6 : 0;
+
+        if (result.usedCompute && mode == COMPUTE_TILED) {
+            // 每个 16x16 的工作组读取 20x20 个 texel
+            result.texelsPerPixel = 20.0 * 20.0 / (16.0 * 16.0);
+        } else {
+            // 中心 1 个 texel + 4 次双线性采样
+            result.texelsPerPixel = 1 + 4 * 4;
+        }
+
+        uint8_t *a = expect.readPixels();
+        uint8_t *b = output.readPixels();
+        if (a && b) {
+            for (size_t i = 0; i < (size_t)width * height * 4; ++i) {
+                result.maxDiff = std::max(result.maxDiff, std::abs((int)a[i] - (int)b[i]));
+            }
+        } else {
+            result.maxDiff = 255;
+        }
+        delete[] a;
+        delete[] b;
+
+        fragment.release();
+        filter.release();
+        expect.release();
+        output.release();
+        input.release();
+    });
+    return result;
+}
+
+NAMESPACE_END
@@ -0,0 +1,163 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/RenderGraph.h"
+#include "common/gles/filter/ColorAdjustFilter.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 第 frame 帧方块的位置, 沿对角线移动
+ */
+DirtyRect squareAt(int frame, int width, int height, int size) {
+    int x = (frame * 7) % std::max(1, width - size);
+    int y = (frame * 5) % std::max(1, height - size);
+    return DirtyRect(x, y, size, size);
+}
+
+/**
+ * 上传 rect 区域: 方块内为纯色, 方块外为原图
+ */
+void uploadRect(const Texture2D &texture, const GpuInput &input, const DirtyRect &rect, bool square,
+                std::vector<uint8_t> &buffer) {
+    buffer.resize((size_t)rect.width * rect.height * 4);
+    for (int row = 0; row < rect.height; ++row) {
+        uint8_t *dst = buffer.data() + (size_t)row * rect.width * 4;
+        if (square) {
+            for (int col = 0; col < rect.width; ++col) {
+                dst[col * 4 + 0] = 240;
+                dst[col * 4 + 1] = 32;
+                dst[col * 4 + 2] = (uint8_t)(col * 255 / std::max(1, rect.width - 1));
+                dst[col * 4 + 3] = 255;
+            }
+        } else {
+            const uint8_t *src = input.rgba.data() + ((size_t)(rect.y + row) * input.width + rect.x) * 4;
+            memcpy(dst, src, (size_t)rect.width * 4);
+        }
+    }
+    GLStateCache::bindTexture2D(texture.id());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    buffer.data());
+}
+
+} // namespace
+
+GpuDamageResult runDamageRender(GLEngine &engine, bool damage, int frames, int width, int height, int rectSize) {
+    GpuDamageResult result;
+    result.damage = damage;
+    result.width = width;
+    result.height = height;
+    result.frames = frames;
+    result.rectSize = rectSize;
+
+    GpuInput input;
+    input.generate(width, height);
+    TextureFilter texture;
+    ColorAdjustFilter color;
+    SharpenFilter sharpen;
+    RenderGraph graph("damage");
+    Framebuffer output;
+    RenderGraph::ResId source = RenderGraph::INVALID_RES;
+    std::vector<uint8_t> buffer;
+
+    auto bindTexture = [&texture](const std::vector<const Texture2D *> &in, int w, int h) {
+        texture.viewport().set(w, h).enableClearColor(0, 0, 0, 1);
+        texture.setFullTextureCoord().setFullVertexCoord();
+        texture.inputTexture(*in[0]).blend(false);
+    };
+    auto bindColor = [&color](const std::vector<const Texture2D *> &in, int w, int h) {
+        color.setViewport(w, h);
+        color.inputTexture(in[0]->id());
+    };
+    auto bindSharpen = [&sharpen](const std::vector<const Texture2D *> &in, int w, int h) {
+        sharpen.setViewport(w, h);
+        sharpen.setResolution((float)in[0]->width(), (float)in[0]->height());
+        sharpen.inputTexture(in[0]->id());
+    };
+
+    engine.sync([&]() {
+        input.createTexture();
+        output.create(width, height);
+        color.setBrightness(0.1f);
+        color.setContrast(0.2f);
+        color.setSaturation(0.3f);
+        sharpen.setStrength(0.5f);
+        source = graph.importTexture("source");
+        RenderGraph::ResId last = graph.addPass("texture_in", &texture, {source}, bindTexture);
+        last = graph.addPass("color", &color, {last}, bindColor);
+        last = graph.addPass("sharpen0", &sharpen, {last}, bindSharpen);
+        last = graph.addPass("sharpen1", &sharpen, {last}, bindSharpen);
+        graph.setOutput(last, &output);
+        graph.setDamageTracking(damage);
+
+        // 第一帧整帧渲染
+        graph.setImport(source, input.rgbaTexture);
+        graph.execute();
+        glFinish();
+
+        int64_t rendered = 0;
+        DirtyRect previous;
+        int64_t start = nowNs();
+        for (int i = 0; i < frames; ++i) {
+            DirtyRect current = squareAt(i, width, height, rectSize);
+            if (!previous.empty()) {
+                uploadRect(*input.rgbaTexture, input, previous, false, buffer);
+            }
+            uploadRect(*input.rgbaTexture, input, current, true, buffer);
+            graph.setImport(source, input.rgbaTexture);
+            graph.setImportDamage(source, DirtyRect(previous).unite(current));
+            graph.execute();
+            glFinish();
+            rendered += graph.renderedPixels();
+            previous = current;
+        }
+        int64_t elapsed = nowNs() - start;
+        result.avgFrameMs = frames > 0 ? (double)elapsed / frames / 1e6 : 0;
+        result.renderedPixels = frames > 0 ? (double)rendered / frames : 0;
+        result.mpixPerSec = elapsed > 0 ? (double)width * height * frames / ((double)elapsed / 1e9) / 1e6 : 0;
+        result.graphBytes = graph.memBytes();
+
+        // 与整帧渲染的结果比较
+        uint8_t *actual = output.readPixels();
+        graph.invalidateDamage();
+        graph.setImport(source, input.rgbaTexture);
+        graph.execute();
+        uint8_t *expect = output.readPixels();
+        if (actual && expect) {
+            for (size_t i = 0; i < (size_t)width * height * 4; ++i) {
+                result.maxDiff = std::max(result.maxDiff, std::abs((int)actual[i] - (int)expect[i]));
+            }
+        } else {
+            result.maxDiff = 255;
+        }
+        delete[] actual;
+        delete[] expect;
+
+        graph.release();
+        texture.release();
+        color.release();
+        sharpen.release();
+        output.release();
+        input.release();
+    });
+    return result;
+}
+
+NAMESPACE_END
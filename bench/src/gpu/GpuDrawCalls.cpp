@@ -0,0 +1,68 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/gles/filter/ColorAdjustFilter.h"
+
+#include <chrono>
+
+NAMESPACE_DEFAULT
+
+GpuDrawCallResult runDrawCalls(bool uniformBlock, bool animate, int draws) {
+    GpuDrawCallResult result;
+    result.uniformBlock = uniformBlock;
+    result.animate = animate;
+    result.draws = draws;
+
+    // 很小的输出, 让耗时集中在 CPU 提交上
+    const int size = 16;
+    TexParams params;
+    Texture2D input(size, size, params);
+    std::vector<uint8_t> pixels(size * size * 4, 128);
+    input.update(pixels.data());
+    Framebuffer output;
+    output.create(size, size);
+
+    ColorAdjustFilter filter(uniformBlock);
+    filter.setBrightness(0.2f);
+    filter.setContrast(0.3f);
+    filter.setSaturation(0.4f);
+    filter.setViewport(size, size);
+    filter.inputTexture((int)input.id());
+
+    auto draw = [&](int i) {
+        if (animate) {
+            // 滑杆拖动时的场景, 每次绘制都有参数变化
+            filter.setBrightness((float)(i % 100) / 100.0f);
+            filter.setShadowTintColor(1.0f, (float)(i % 10) / 10.0f, 1.0f);
+        }
+        filter.render(&output);
+    };
+    // 第一次绘制包含编译和查询 location 的耗时, 不统计
+    draw(0);
+    glFinish();
+
+    ProgramCallStat before = ProgramCallStat::current();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 1; i <= draws; ++i) {
+        draw(i);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    glFinish();
+    ProgramCallStat after = ProgramCallStat::current();
+
+    result.cpuUsPerDraw = us / draws;
+    result.glCallsPerDraw = (double)(after.glCalls - before.glCalls) / draws;
+    result.uniformUploadsPerDraw = (double)(after.uniformUploads - before.uniformUploads) / draws;
+    result.uniformSkipsPerDraw = (double)(after.uniformSkips - before.uniformSkips) / draws;
+    result.blockUploadsPerDraw = (double)(after.blockUploads - before.blockUploads) / draws;
+
+    filter.release();
+    output.release();
+    input.release();
+    return result;
+}
+
+NAMESPACE_END
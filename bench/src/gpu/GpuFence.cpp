@@ -0,0 +1,146 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/EGLFence.h"
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+#include <unistd.h>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+GpuFenceResult runFence(GLEngine &engine, int iterations, int width, int height) {
+    GpuFenceResult result;
+    result.iterations = iterations;
+
+    // 生产者每次把输入纹理画 kDraws 遍, 让 GPU 有足够的工作, fence 插入后不会立即完成
+    const int kDraws = 2;
+    const int kCheckSize = 16;
+    TextureFilter producerFilter, consumerFilter;
+    Framebuffer output, check;
+    Texture2D *input = nullptr;
+    engine.sync([&]() {
+        result.native = EGLFence::nativeSupported();
+        output.create(width, height);
+        input = new Texture2D(width, height);
+        std::vector<uint8_t> pixels((size_t)width * height * 4);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = (uint8_t)(i * 7);
+        }
+        input->update(pixels.data());
+    });
+    std::unique_ptr<GLEngine> consumer(new GLEngine((engine.name() + "_fence").c_str(), engine));
+    consumer->sync([&]() { check.create(kCheckSize, kCheckSize); });
+
+    // 画完后用帧序号清除中心区域, 消费者缩小到 kCheckSize 后中心像素落在这个区域内
+    auto renderFrame = [&](int seq) {
+        for (int d = 0; d < kDraws; ++d) {
+            producerFilter.viewport().set(width, height);
+            producerFilter.setFullTextureCoord().setFullVertexCoord();
+            producerFilter.inputTexture(*input).blend(false).render(&output);
+        }
+        const int kMarker = 128;
+        output.bind();
+        GLStateCache::setCapability(GL_SCISSOR_TEST, true);
+        GLStateCache::scissor((width - kMarker) / 2, (height - kMarker) / 2, kMarker, kMarker);
+        glClearColor((float)(seq % 256) / 255.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        GLStateCache::setCapability(GL_SCISSOR_TEST, false);
+        output.unbind();
+    };
+
+    double pollNs = 0, signalNs = 0;
+    for (int i = 1; i <= iterations; ++i) {
+        EGLFence fence;
+        engine.sync([&]() {
+            renderFrame(i);
+            int64_t start = nowNs();
+            fence.create();
+            int64_t pollStart = nowNs();
+            FenceStatus status = fence.poll();
+            pollNs += (double)(nowNs() - pollStart);
+            if (status == FENCE_PENDING) {
+                result.pendingPolls += 1;
+                if (fence.waitFor(1000000) == FENCE_PENDING) {
+                    result.boundedTimeouts += 1;
+                }
+                while (fence.waitFor(100000) == FENCE_PENDING) {
+                }
+            }
+            signalNs += (double)(nowNs() - start);
+            fence.release();
+
+            // 不等待完成, 由消费者 context 在 GPU 上等待
+            renderFrame(i + 1);
+            fence.create();
+        });
+        consumer->sync([&]() {
+            fence.waitServer();
+            consumerFilter.viewport().set(kCheckSize, kCheckSize);
+            consumerFilter.setFullTextureCoord().setFullVertexCoord();
+            consumerFilter.inputTexture(output.textureNonnull()).blend(false).render(&check);
+            uint8_t pixel[4] = {0};
+            check.bind();
+            glReadPixels(kCheckSize / 2, kCheckSize / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+            check.unbind();
+            if (pixel[0] != (i + 1) % 256) {
+                result.serverWaitMismatches += 1;
+            }
+        });
+        engine.sync([&]() { fence.release(); });
+    }
+    result.pollUs = iterations > 0 ? pollNs / iterations / 1000.0 : 0;
+    result.signalMs = iterations > 0 ? signalNs / iterations / 1e6 : 0;
+
+    // 导出 fd 后在另一个 context 导入等待; 不支持 native fence 时用 pipe 代替 sync file, 写入后变为可读
+    consumer->sync([&]() {
+        EGLFence imported;
+        if (result.native) {
+            int fd = -1;
+            engine.sync([&]() {
+                EGLFence fence;
+                fence.create();
+                fd = fence.dupNativeFd();
+                fence.release();
+            });
+            result.fdRoundTrip = fd >= 0 && imported.importNativeFd(fd) && imported.waitFor(1000000000) == FENCE_SIGNALED;
+        } else {
+            int fds[2];
+            if (pipe(fds) == 0) {
+                bool pendingBefore = imported.importNativeFd(fds[0]) && imported.poll() == FENCE_PENDING;
+                char c = 1;
+                bool written = write(fds[1], &c, 1) == 1;
+                result.fdRoundTrip = pendingBefore && written && imported.waitFor(1000000000) == FENCE_SIGNALED;
+                close(fds[1]);
+            }
+        }
+        imported.release();
+        check.release();
+        consumerFilter.release();
+    });
+    consumer->destroy();
+    consumer.reset();
+
+    engine.sync([&]() {
+        input->release();
+        delete input;
+        output.release();
+        producerFilter.release();
+    });
+    return result;
+}
+
+NAMESPACE_END
@@ -0,0 +1,145 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/FramebufferPool.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+// 每一级相对输入的缩放, 和模糊/辉光的降采样-升采样类似
+const float kScales[] = {1.0f, 0.5f, 0.25f, 0.125f, 0.25f, 0.5f, 1.0f, 0.75f};
+const int kLevels = (int)(sizeof(kScales) / sizeof(kScales[0]));
+
+struct PoolWorker {
+    std::unique_ptr<GLEngine> ownEngine;
+    GLEngine *engine = nullptr;
+    std::unique_ptr<TextureFilter> filter;
+    std::unique_ptr<Texture2D> source;
+    // 上一帧的最终结果, 由下一个线程归还
+    FramebufferRef last;
+    int64_t obtainNs = 0;
+    int obtains = 0;
+    int64_t peakBytes = 0;
+
+    void setup(int width, int height) {
+        filter.reset(new TextureFilter());
+        source.reset(new Texture2D(width, height));
+        std::vector<uint8_t> pixels((size_t)width * height * 4, 96);
+        source->update(pixels.data());
+    }
+
+    FramebufferRef frame(FramebufferPool &pool, int width, int height) {
+        const Texture2D *input = source.get();
+        FramebufferRef prev;
+        for (float scale : kScales) {
+            int w = std::max(1, (int)((float)width * scale));
+            int h = std::max(1, (int)((float)height * scale));
+            auto start = std::chrono::steady_clock::now();
+            FramebufferRef out = pool.obtain(w, h);
+            obtainNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                            .count();
+            obtains += 1;
+            peakBytes = std::max(peakBytes, pool.stat().bytes);
+
+            filter->viewport().set(w, h).enableClearColor(0, 0, 0, 1);
+            filter->setFullTextureCoord().setFullVertexCoord();
+            filter->inputTexture(*input).blend(false).render(out.get());
+            input = out->texture();
+            prev = out;
+        }
+        return prev;
+    }
+
+    void release(FramebufferPool &pool) {
+        last.free();
+        pool.release();
+        filter->release();
+        source->release();
+        filter.reset();
+        source.reset();
+    }
+};
+
+} // namespace
+
+GpuPoolResult runFramebufferPool(GLEngine &engine, int threads, int maxCacheMb, int frames, int width, int height) {
+    GpuPoolResult result;
+    result.threads = threads;
+    result.maxCacheMb = maxCacheMb;
+    result.frames = frames;
+    result.obtainsPerFrame = kLevels;
+
+    FramebufferPool pool(maxCacheMb);
+    std::vector<PoolWorker> workers(threads);
+    for (int i = 0; i < threads; ++i) {
+        PoolWorker &w = workers[i];
+        if (i == 0) {
+            w.engine = &engine;
+        } else {
+            w.ownEngine.reset(new GLEngine(tfm::format("pool_worker_%d", i).c_str(), engine));
+            w.engine = w.ownEngine.get();
+        }
+        w.engine->sync([&w, width, height]() { w.setup(width, height); });
+    }
+
+    // 第一帧之后池中已经有了所有尺寸, 之后的帧不应该再创建 Framebuffer (内存上限足够时)
+    std::mutex handoff;
+    std::vector<std::thread> runners;
+    for (int i = 0; i < threads; ++i) {
+        runners.emplace_back([&, i]() {
+            PoolWorker &w = workers[i];
+            PoolWorker &next = workers[(i + 1) % threads];
+            w.engine->sync([&]() {
+                for (int f = 0; f < frames; ++f) {
+                    {
+                        // 上一个线程交过来的结果在这个线程归还
+                        std::lock_guard<std::mutex> lock(handoff);
+                        w.last.free();
+                    }
+                    FramebufferRef out = w.frame(pool, width, height);
+                    glFlush();
+                    // 交给下一个线程持有
+                    std::lock_guard<std::mutex> lock(handoff);
+                    next.last = out;
+                }
+                glFinish();
+            });
+        });
+    }
+    for (auto &t : runners) {
+        t.join();
+    }
+
+    FramebufferPoolStat stat = pool.stat();
+    int64_t obtainNs = 0;
+    int obtains = 0;
+    for (auto &w : workers) {
+        obtainNs += w.obtainNs;
+        obtains += w.obtains;
+        result.peakMb = std::max(result.peakMb, (double)w.peakBytes / 1024.0 / 1024.0);
+        w.engine->sync([&w, &pool]() { w.release(pool); });
+    }
+    for (auto &w : workers) {
+        if (w.ownEngine) {
+            w.ownEngine->destroy();
+        }
+    }
+
+    result.obtainUs = obtains > 0 ? (double)obtainNs / 1000.0 / obtains : 0;
+    result.hitRate = stat.hits + stat.misses > 0 ? (double)stat.hits / (double)(stat.hits + stat.misses) : 0;
+    result.evictions = stat.evictions;
+    return result;
+}
+
+NAMESPACE_END
@@ -0,0 +1,135 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/ColorAdjustFilter.h"
+#include "common/gles/filter/FusedFilter.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+#include <cstdlib>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+GpuFusionResult runFilterFusion(GLEngine &engine, bool fused, int frames, int width, int height) {
+    GpuFusionResult result;
+    result.fused = fused;
+    result.width = width;
+    result.height = height;
+    result.frames = frames;
+    result.passes = fused ? 1 : 3;
+
+    GpuInput input;
+    input.generate(width, height);
+    SharpenFilter sharpen;
+    ColorAdjustFilter color;
+    TextureFilter texture;
+    FusedFilter fusedFilter;
+    Framebuffer fb[2], output;
+
+    // 三个 pass: 锐化 -> fb[0] -> 调色 -> fb[1] -> 纹理 -> output
+    auto renderPasses = [&]() {
+        sharpen.setViewport(width, height);
+        sharpen.inputTexture(input.rgbaTexture->id());
+        sharpen.render(&fb[0]);
+        color.setViewport(width, height);
+        color.inputTexture(fb[0].texID());
+        color.render(&fb[1]);
+        texture.viewport().set(width, height).enableClearColor(0, 0, 0, 1);
+        texture.setFullTextureCoord().setFullVertexCoord();
+        texture.inputTexture(fb[1].textureNonnull()).blend(false).render(&output);
+    };
+    auto renderFused = [&]() {
+        fusedFilter.viewport().set(width, height);
+        fusedFilter.setFullTextureCoord().setFullVertexCoord();
+        fusedFilter.inputTexture(*input.rgbaTexture).render(&output);
+    };
+    auto timeFrames = [&](const std::function<void(int)> &frame) {
+        frame(0);
+        glFinish();
+        int64_t start = nowNs();
+        for (int i = 0; i < frames; ++i) {
+            frame(i);
+            glFinish();
+        }
+        return frames > 0 ? (double)(nowNs() - start) / frames / 1e6 : 0;
+    };
+
+    engine.sync([&]() {
+        input.createTexture();
+        sharpen.setStrength(0.5f);
+        sharpen.setResolution((float)width, (float)height);
+        color.setBrightness(0.2f);
+        color.setContrast(0.3f);
+        color.setSaturation(0.4f);
+        output.create(width, height);
+        fb[0].create(width, height);
+        fb[1].create(width, height);
+
+        renderPasses();
+        uint8_t *pixels = output.readPixels();
+        std::vector<uint8_t> expect(pixels, pixels + (size_t)width * height * 4);
+        delete[] pixels;
+
+        if (fused) {
+            // 中间结果不需要 Framebuffer
+            fb[0].release();
+            fb[1].release();
+            fusedFilter.setChain({&sharpen, &color, &texture});
+            result.avgFrameMs = timeFrames([&](int) { renderFused(); });
+
+            fusedFilter.setChain({&sharpen, &color, &texture});
+            renderFused();
+            pixels = output.readPixels();
+            int64_t sum = 0;
+            for (size_t i = 0; i < expect.size(); ++i) {
+                int diff = std::abs((int)pixels[i] - (int)expect[i]);
+                result.maxDiff = std::max(result.maxDiff, diff);
+                sum += diff;
+            }
+            delete[] pixels;
+            result.meanDiff = expect.empty() ? 0 : (double)sum / (double)expect.size();
+
+            // 切换链时使用缓存的 program, 只有第一次切换需要编译
+            fusedFilter.setChain({&sharpen, &color});
+            renderFused();
+            result.switchFrameMs = timeFrames([&](int i) {
+                if (i % 2 == 0) {
+                    fusedFilter.setChain({&sharpen, &color, &texture});
+                } else {
+                    fusedFilter.setChain({&sharpen, &color});
+                }
+                renderFused();
+            });
+            result.programs = fusedFilter.programCount();
+        } else {
+            result.intermediateBytes = (fb[0].byteSize() + fb[1].byteSize()) * 2;
+            result.avgFrameMs = timeFrames([&](int) { renderPasses(); });
+        }
+
+        fusedFilter.release();
+        sharpen.release();
+        color.release();
+        texture.release();
+        fb[0].release();
+        fb[1].release();
+        output.release();
+        input.release();
+    });
+    return result;
+}
+
+NAMESPACE_END
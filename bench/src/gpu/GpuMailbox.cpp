@@ -0,0 +1,145 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/FrameMailbox.h"
+#include "common/gles/ShareFramebuffer.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 帧序号编码到清屏颜色的 r/g 通道
+ */
+void clearWithSeq(Framebuffer &fb, uint64_t seq) {
+    fb.bind();
+    GLStateCache::viewport(0, 0, fb.texWidth(), fb.texHeight());
+    glClearColor((float)(seq % 256) / 255.0f, (float)((seq / 256) % 256) / 255.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    fb.unbind();
+}
+
+} // namespace
+
+GpuMailboxResult runMailbox(GLEngine &engine, bool mailbox, int frames, int width, int height, int consumerMs) {
+    GpuMailboxResult result;
+    result.mailbox = mailbox;
+    result.frames = frames;
+    result.width = width;
+    result.height = height;
+    result.consumerMs = consumerMs;
+
+    FrameMailbox box;
+    ShareFramebuffer share;
+    std::atomic<uint64_t> shareSeq{0};
+    std::unique_ptr<GLEngine> consumer(new GLEngine((engine.name() + "_consumer").c_str(), engine));
+
+    // 消费者把拿到的帧画到自己的小 framebuffer 上, 读回一个像素检查内容是否与帧序号一致
+    const int kCheckSize = 16;
+    TextureFilter filter;
+    Framebuffer check;
+    auto consume = [&](const Texture &texture, uint64_t seq) {
+        filter.viewport().set(kCheckSize, kCheckSize).enableClearColor(0, 0, 0, 1);
+        filter.setFullTextureCoord().setFullVertexCoord();
+        filter.inputTexture(texture).blend(false).render(&check);
+        uint8_t pixel[4] = {0};
+        check.bind();
+        glReadPixels(kCheckSize / 2, kCheckSize / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        check.unbind();
+        if (pixel[0] != seq % 256 || pixel[1] != (seq / 256) % 256) {
+            result.mismatches += 1;
+        }
+        result.consumed += 1;
+    };
+    consumer->sync([&]() { check.create(kCheckSize, kCheckSize); });
+
+    std::atomic<bool> producing{true};
+    std::thread consumerThread([&]() {
+        uint64_t lastSeq = 0;
+        while (producing.load()) {
+            bool fresh = false;
+            consumer->sync([&]() {
+                if (mailbox) {
+                    const Texture2D *texture = box.acquire();
+                    if (texture != nullptr && box.frameSeq() != lastSeq) {
+                        lastSeq = box.frameSeq();
+                        consume(*texture, lastSeq);
+                        fresh = true;
+                    }
+                } else {
+                    Framebuffer *fb = share.obtainLock(true);
+                    if (fb != nullptr) {
+                        consume(fb->textureNonnull(), shareSeq.load());
+                        fresh = true;
+                    }
+                    // 消费者使用帧的期间一直持有锁
+                    if (fresh && consumerMs > 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(consumerMs));
+                    }
+                    share.obtainUnlock();
+                }
+            });
+            // 邮箱的消费者持有当前帧期间不影响生产者
+            if (mailbox && fresh && consumerMs > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(consumerMs));
+            } else if (!fresh) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        consumer->sync([&]() {
+            box.releaseRead();
+            check.release();
+            filter.release();
+        });
+    });
+
+    int64_t start = nowNs();
+    for (int i = 1; i <= frames; ++i) {
+        engine.sync([&]() {
+            if (mailbox) {
+                Framebuffer *fb = box.beginWrite(width, height);
+                if (fb != nullptr) {
+                    clearWithSeq(*fb, (uint64_t)i);
+                    box.endWrite();
+                }
+            } else {
+                Framebuffer &fb = share.updateLock();
+                fb.create(width, height);
+                clearWithSeq(fb, (uint64_t)i);
+                shareSeq.store((uint64_t)i);
+                share.updateUnlock(true);
+            }
+        });
+    }
+    // 生产者提交的命令执行完才算完成
+    engine.sync([]() { glFinish(); });
+    double seconds = (double)(nowNs() - start) / 1e9;
+    producing.store(false);
+    consumerThread.join();
+    consumer->destroy();
+    consumer.reset();
+
+    engine.sync([&]() {
+        box.release();
+        share.release();
+    });
+    result.producerFps = seconds > 0 ? frames / seconds : 0;
+    result.dropped = mailbox ? box.stat().dropped : frames - result.consumed;
+    return result;
+}
+
+NAMESPACE_END
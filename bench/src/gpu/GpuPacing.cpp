@@ -0,0 +1,108 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+NAMESPACE_DEFAULT
+
+const char *pacingModeName(int mode) {
+    switch (mode) {
+        case PACING_QUEUE: return "queue";
+        case PACING_LATEST: return "latest";
+        case PACING_FPS: return "fps";
+        default: return "unknown";
+    }
+}
+
+GpuPacingResult runPacing(GLEngine &engine, int mode, float fps, int durationMs, int requestIntervalMs, int renderMs) {
+    GpuPacingResult result;
+    result.mode = mode;
+    result.fps = mode == PACING_FPS ? fps : 0;
+
+    const int kOutputW = 640, kOutputH = 360;
+    TextureFilter filter;
+    Framebuffer output;
+    Texture2D *input = nullptr;
+    engine.sync([&]() {
+        output.create(kOutputW, kOutputH);
+        input = new Texture2D(64, 64);
+        std::vector<uint8_t> gray(64 * 64 * 4, 128);
+        input->update(gray.data());
+    });
+
+    // 渲染一帧: 一次绘制 + glFinish, 不足 renderMs 的部分 sleep 补齐, 模拟负载较重的滤镜链
+    auto renderFrame = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        filter.viewport().set(kOutputW, kOutputH).enableClearColor(0, 0, 0, 1);
+        filter.setFullTextureCoord().setFullVertexCoord();
+        filter.inputTexture(*input).blend(false).render(&output);
+        glFinish();
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(renderMs));
+    };
+
+    std::mutex statMutex;
+    double latencySum = 0;
+    engine.setFrameRate(result.fps);
+    engine.resetFramePacingStat();
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(durationMs);
+    while (std::chrono::steady_clock::now() < end) {
+        if (mode == PACING_QUEUE) {
+            int64_t requestUs = TimeUtils::nowUs();
+            engine.postRender([&, requestUs](int, int) {
+                renderFrame();
+                double latencyMs = (double)(TimeUtils::nowUs() - requestUs) / 1000.0;
+                std::lock_guard<std::mutex> lock(statMutex);
+                result.rendered += 1;
+                latencySum += latencyMs;
+                result.maxLatencyMs = std::max(result.maxLatencyMs, latencyMs);
+                return false;
+            });
+            result.requested += 1;
+        } else {
+            engine.requestRender([&](int, int) {
+                renderFrame();
+                return false;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(requestIntervalMs));
+    }
+
+    if (mode == PACING_QUEUE) {
+        // 排队的请求全部渲染完
+        engine.sync([]() {});
+        result.avgLatencyMs = result.rendered > 0 ? latencySum / (double)result.rendered : 0;
+    } else {
+        // 等最后一个请求渲染完成
+        std::this_thread::sleep_for(std::chrono::milliseconds(renderMs * 2 + (fps > 0 ? (int)(2000 / fps) : 0)));
+        engine.sync([]() {});
+        FramePacingStat stat = engine.framePacingStat();
+        result.requested = stat.requested;
+        result.rendered = stat.rendered;
+        result.coalesced = stat.coalesced;
+        result.missed = stat.missed;
+        result.avgLatencyMs = stat.avgLatencyMs;
+        result.maxLatencyMs = stat.maxLatencyMs;
+    }
+    engine.setFrameRate(0);
+
+    engine.sync([&]() {
+        input->release();
+        delete input;
+        output.release();
+        filter.release();
+    });
+    return result;
+}
+
+NAMESPACE_END
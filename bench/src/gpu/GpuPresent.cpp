@@ -0,0 +1,191 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+#include <cstdlib>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 缩放 -> 锐化 -> 锐化, 每个 GL context 一份
+ */
+struct PresentChain {
+    TextureFilter texture;
+    SharpenFilter sharpen;
+    Framebuffer a, b;
+
+    const Texture2D *render(const Texture2D &input, int width, int height) {
+        a.create(width, height);
+        b.create(width, height);
+        texture.viewport().set(width, height).enableClearColor(0, 0, 0, 1);
+        texture.setFullTextureCoord().setFullVertexCoord();
+        texture.inputTexture(input).blend(false).render(&a);
+        sharpen.setStrength(0.5f);
+        sharpen.setViewport(width, height);
+        sharpen.setResolution((float)width, (float)height);
+        sharpen.inputTexture(a.texID());
+        sharpen.render(&b);
+        sharpen.inputTexture(b.texID());
+        sharpen.render(&a);
+        return a.texture();
+    }
+
+    /**
+     * 绘制到当前 surface 的默认帧缓冲
+     */
+    void present(const Texture2D &input, int width, int height, int rotation) {
+        GLStateCache::bindFramebuffer(0);
+        texture.viewport().set(width, height).enableClearColor(0, 0, 0, 1);
+        texture.setTextureCoord(rotation, false, false).setFullVertexCoord();
+        texture.inputTexture(input).blend(false).render();
+    }
+
+    void release() {
+        texture.release();
+        sharpen.release();
+        a.release();
+        b.release();
+    }
+};
+
+struct PresentTarget {
+    int width;
+    int height;
+    int rotation;
+    // 60fps 的帧中每 divisor 帧输出一次
+    int divisor;
+};
+
+const PresentTarget kTargets[] = {
+    {640, 360, 0, 1},
+    {720, 1280, 90, 2},
+    {320, 180, 0, 4},
+};
+
+const int kSourceW = 1280, kSourceH = 720;
+const int64_t kFrameUs = 16667;
+
+/**
+ * 在输出的 1/4 处取样, 与源图在旋转后对应位置的 R/G 渐变比较. B 通道有锐利的棋盘格边缘, 锐化后差异较大, 不参与比较
+ */
+int sampleDiff(const std::vector<uint8_t> &pixels, const PresentTarget &target) {
+    if (pixels.empty()) {
+        return 255;
+    }
+    int x = target.width / 4, y = target.height / 4;
+    const uint8_t *out = pixels.data() + ((size_t)y * target.width + x) * 4;
+    float fx = (float)x / (float)target.width, fy = (float)y / (float)target.height;
+    // 源图的 R = 255 * fx, G = 255 * fy. 旋转 90 度时输出的 x 对应源图的 y, 输出的 y 对应源图的 1 - x
+    float srcX = target.rotation == 90 ? 1.0f - fy : fx;
+    float srcY = target.rotation == 90 ? fx : fy;
+    int diffR = std::abs((int)out[0] - (int)(srcX * 255.0f));
+    int diffG = std::abs((int)out[1] - (int)(srcY * 255.0f));
+    return std::max(diffR, diffG);
+}
+
+} // namespace
+
+GpuPresentResult runMultiPresent(bool renderOnce, int frames) {
+    GpuPresentResult result;
+    result.renderOnce = renderOnce;
+    result.frames = frames;
+    result.surfaces = (int)(sizeof(kTargets) / sizeof(kTargets[0]));
+    result.presented.assign(result.surfaces, 0);
+
+    // 输出 surface 需要 pbuffer 的 config, 与 --egl 无关
+    GLEngine engine("multi_present", 3, SURFACE_PBUFFER);
+    GpuInput input;
+    input.generate(kSourceW, kSourceH);
+    engine.sync([&]() { input.createTexture(); });
+
+    int64_t totalNs = 0;
+    if (renderOnce) {
+        PresentChain chain;
+        std::vector<int> ids;
+        for (const PresentTarget &target : kTargets) {
+            OutputSurfaceConfig config;
+            config.width = target.width;
+            config.height = target.height;
+            config.rotation = target.rotation;
+            config.maxFps = 60.0f / (float)target.divisor;
+            ids.push_back(engine.addOutputSurface(config));
+        }
+        for (int i = 0; i < frames; ++i) {
+            int64_t start = nowNs();
+            engine.syncRenderOutputs([&]() { return chain.render(*input.rgbaTexture, kSourceW, kSourceH); },
+                                     (int64_t)i * kFrameUs);
+            totalNs += nowNs() - start;
+        }
+        for (int k = 0; k < result.surfaces; ++k) {
+            OutputSurfaceStat stat;
+            if (ids[k] >= 0 && engine.outputSurfaceStat(ids[k], stat)) {
+                result.presented[k] = stat.presented;
+            }
+            std::vector<uint8_t> pixels;
+            engine.readOutputPixels(ids[k], pixels);
+            result.maxSampleDiff = std::max(result.maxSampleDiff,
+                                            sampleDiff(pixels, kTargets[k]));
+            engine.removeOutputSurface(ids[k]);
+        }
+        engine.sync([&]() { chain.release(); });
+    } else {
+        // 每个 surface 一个共享 context 的 GLEngine, 各自在源分辨率上渲染整条链路后输出
+        std::vector<std::unique_ptr<GLEngine>> engines;
+        std::vector<std::unique_ptr<PresentChain>> chains;
+        for (int k = 0; k < result.surfaces; ++k) {
+            std::string name = "multi_present_" + std::to_string(k);
+            engines.emplace_back(new GLEngine(name.c_str(), engine));
+            engines[k]->updateOffscreenSize(kTargets[k].width, kTargets[k].height);
+            chains.emplace_back(new PresentChain());
+        }
+        for (int i = 0; i < frames; ++i) {
+            int64_t start = nowNs();
+            for (int k = 0; k < result.surfaces; ++k) {
+                const PresentTarget &target = kTargets[k];
+                if (i % target.divisor != 0) {
+                    continue;
+                }
+                PresentChain &chain = *chains[k];
+                engines[k]->syncRender([&](int width, int height) {
+                    const Texture2D *tex = chain.render(*input.rgbaTexture, kSourceW, kSourceH);
+                    chain.present(*tex, width, height, target.rotation);
+                    return true;
+                });
+                result.presented[k] += 1;
+            }
+            totalNs += nowNs() - start;
+        }
+        for (int k = 0; k < result.surfaces; ++k) {
+            std::vector<uint8_t> pixels((size_t)kTargets[k].width * kTargets[k].height * 4);
+            engines[k]->sync([&]() {
+                GLStateCache::bindFramebuffer(0);
+                glReadPixels(0, 0, kTargets[k].width, kTargets[k].height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                chains[k]->release();
+            });
+            result.maxSampleDiff = std::max(result.maxSampleDiff,
+                                            sampleDiff(pixels, kTargets[k]));
+            engines[k]->destroy();
+        }
+    }
+    result.avgFrameMs = frames > 0 ? (double)totalNs / frames / 1e6 : 0;
+
+    engine.sync([&]() { input.release(); });
+    engine.destroy();
+    return result;
+}
+
+NAMESPACE_END
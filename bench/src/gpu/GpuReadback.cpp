@@ -0,0 +1,207 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/gles/Framebuffer.h"
+#include "common/gles/GLReader.h"
+#include "common/gles/filter/RGBAToYUVFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void cpuToYuv(int layout, const uint8_t *rgba, int width, int height, uint8_t *dst) {
+    switch (layout) {
+        case YUV_LAYOUT_NV12: YuvUtils::rgbaToNV12(rgba, width, height, dst); break;
+        case YUV_LAYOUT_I420: YuvUtils::rgbaToI420(rgba, width, height, dst); break;
+        default: YuvUtils::rgbaToNV21(rgba, width, height, dst); break;
+    }
+}
+
+} // namespace
+
+const char *yuvLayoutName(int layout) {
+    switch (layout) {
+        case YUV_LAYOUT_NV21: return "nv21";
+        case YUV_LAYOUT_NV12: return "nv12";
+        case YUV_LAYOUT_I420: return "i420";
+        default: return "unknown";
+    }
+}
+
+const char *readbackModeName(int mode) {
+    switch (mode) {
+        case READBACK_SYNC: return "sync";
+        case READBACK_PING_PONG: return "ping_pong";
+        case READBACK_ASYNC: return "async";
+        default: return "unknown";
+    }
+}
+
+GpuReadbackResult runReadback(int mode, FramebufferFormat format, int depth, int frames, int width, int height,
+                              bool subRect) {
+    GpuReadbackResult result;
+    result.mode = mode;
+    result.format = format;
+    result.depth = mode == READBACK_ASYNC ? depth : 0;
+    result.frames = frames;
+    result.width = subRect ? width / 2 : width;
+    result.height = subRect ? height / 2 : height;
+
+    TextureFilter filter;
+    Texture2D source(width, height);
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = (uint8_t)(i * 7);
+    }
+    source.update(pixels.data());
+    Framebuffer fb;
+    fb.create(width, height, format);
+    GLReader reader(depth);
+
+    std::atomic<int64_t> received{0};
+    std::atomic<int64_t> latencyUs{0};
+    std::atomic<int64_t> checksum{0};
+    GLReadCallback callback = [&](const GLReadFrame &frame) {
+        latencyUs += frame.latencyUs;
+        checksum += frame.pixels()[0];
+        received += 1;
+    };
+
+    int64_t cpuNs = 0;
+    for (int i = 0; i < frames; ++i) {
+        int64_t start = nowNs();
+        filter.viewport().set(width, height).enableClearColor(0, 0, 0, 1);
+        filter.setFullTextureCoord().setFullVertexCoord();
+        filter.inputTexture(source).blend(false).render(&fb);
+        if (mode == READBACK_SYNC) {
+            uint8_t *out = fb.readPixels();
+            checksum += out[0];
+            received += 1;
+            delete[] out;
+        } else if (mode == READBACK_PING_PONG) {
+            fb.fastReadPixels(reader, [&](GLubyte *out, int, int) {
+                checksum += out[0];
+                received += 1;
+            });
+        } else {
+            reader.poll();
+            if (subRect) {
+                fb.readPixelsAsync(reader, width / 4, height / 4, width / 2, height / 2, callback);
+            } else {
+                fb.readPixelsAsync(reader, callback);
+            }
+        }
+        cpuNs += nowNs() - start;
+    }
+    reader.flush();
+    GLReaderStat stat = reader.stat();
+    reader.release();
+    fb.release();
+    source.release();
+    filter.release();
+
+    result.cpuMsPerFrame = (double)cpuNs / 1e6 / frames;
+    result.received = received.load();
+    result.dropped = stat.dropped;
+    if (mode == READBACK_ASYNC && result.received > 0) {
+        result.latencyMs = (double)latencyUs.load() / 1000.0 / (double)result.received;
+    }
+    return result;
+}
+
+GpuYuvReadbackResult runYuvReadback(bool gpu, int layout, FramebufferFormat format, int frames, int width, int height) {
+    GpuYuvReadbackResult result;
+    result.gpu = gpu;
+    result.layout = layout;
+    result.format = format;
+    result.frames = frames;
+    result.width = width;
+    result.height = height;
+
+    Texture2D source(width, height);
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t *p = &pixels[((size_t)y * width + x) * 4];
+            p[0] = (uint8_t)(x * 255 / width);
+            p[1] = (uint8_t)(y * 255 / height);
+            p[2] = (uint8_t)((x ^ y) & 0xFF);
+            p[3] = 255;
+        }
+    }
+    source.update(pixels.data());
+    TextureFilter filter;
+    Framebuffer rgba;
+    rgba.create(width, height);
+    RGBAToYUVFilter yuvFilter;
+    yuvFilter.setLayout((YuvLayout)layout).setStandard(BT601, false);
+    Framebuffer yuv;
+    yuv.create(RGBAToYUVFilter::outputWidth(width, format), RGBAToYUVFilter::outputHeight(height), format);
+    // R8 用 GL_RED 读取, 每行的字节数与宽度相同, 需要 1 字节对齐
+    bool r8 = yuv.format() == FB_FORMAT_R8;
+
+    std::vector<uint8_t> yuvData((size_t)width * height * 3 / 2);
+    // 编译 program 不计入耗时
+    yuvFilter.convert(source, yuv);
+    glFinish();
+    int64_t totalNs = 0;
+    for (int i = 0; i < frames; ++i) {
+        filter.viewport().set(width, height).enableClearColor(0, 0, 0, 1);
+        filter.setFullTextureCoord().setFullVertexCoord();
+        filter.inputTexture(source).blend(false).render(&rgba);
+        glFinish();
+
+        int64_t start = nowNs();
+        if (gpu) {
+            yuvFilter.convert(*rgba.texture(), yuv);
+            yuv.bind();
+            if (r8) {
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glReadPixels(0, 0, yuv.texWidth(), yuv.texHeight(), GL_RED, GL_UNSIGNED_BYTE, yuvData.data());
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            } else {
+                glReadPixels(0, 0, yuv.texWidth(), yuv.texHeight(), GL_RGBA, GL_UNSIGNED_BYTE, yuvData.data());
+            }
+            yuv.unbind();
+            result.bytesRead = (int64_t)yuv.texWidth() * yuv.texHeight() * (r8 ? 1 : 4);
+        } else {
+            uint8_t *out = rgba.readPixels();
+            cpuToYuv(layout, out, width, height, yuvData.data());
+            delete[] out;
+            result.bytesRead = (int64_t)width * height * 4;
+        }
+        totalNs += nowNs() - start;
+    }
+
+    // 与 CPU 转换比较最后一帧, rgba 的第 0 行与纹理的第 0 行一致
+    uint8_t *out = rgba.readPixels();
+    std::vector<uint8_t> expect(yuvData.size());
+    cpuToYuv(layout, out, width, height, expect.data());
+    delete[] out;
+    for (size_t i = 0; i < yuvData.size(); ++i) {
+        result.maxDiff = std::max(result.maxDiff, std::abs((int)yuvData[i] - (int)expect[i]));
+    }
+
+    yuv.release();
+    yuvFilter.release();
+    rgba.release();
+    filter.release();
+    source.release();
+    result.msPerFrame = (double)totalNs / 1e6 / frames;
+    return result;
+}
+
+NAMESPACE_END
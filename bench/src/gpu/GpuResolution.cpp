@@ -0,0 +1,125 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/RenderGraph.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+
+NAMESPACE_DEFAULT
+
+GpuResolutionResult runDynamicResolution(GLEngine &engine, bool dynamic, int frames, int width, int height,
+                                         int heavyPasses, float targetMs) {
+    GpuResolutionResult result;
+    result.dynamic = dynamic;
+    result.width = width;
+    result.height = height;
+    result.targetMs = targetMs;
+
+    GpuInput input;
+    input.generate(width, height);
+    TextureFilter texture;
+    SharpenFilter sharpen;
+    RenderGraph graph("dynamic_resolution");
+    Framebuffer output;
+    RenderGraph::ResId source = RenderGraph::INVALID_RES, outputId = RenderGraph::INVALID_RES;
+    // 第 0 个锐化 pass 一直开启, 其余的只在重负载阶段开启
+    std::vector<RenderGraph::ResId> extra;
+
+    auto bindTexture = [&texture](const std::vector<const Texture2D *> &in, int w, int h) {
+        texture.viewport().set(w, h).enableClearColor(0, 0, 0, 1);
+        texture.setFullTextureCoord().setFullVertexCoord();
+        texture.inputTexture(*in[0]).blend(false);
+    };
+    auto bindSharpen = [&sharpen](const std::vector<const Texture2D *> &in, int w, int h) {
+        sharpen.setViewport(w, h);
+        sharpen.setResolution((float)in[0]->width(), (float)in[0]->height());
+        sharpen.inputTexture(in[0]->id());
+    };
+    engine.sync([&]() {
+        input.createTexture();
+        output.create(width, height);
+        sharpen.setStrength(0.5f);
+        // 第一个 pass 缩小到渲染分辨率, 最后一个 pass 输出到 output 时放大
+        source = graph.importTexture("source");
+        RenderGraph::ResId last = graph.addPass("texture_in", &texture, {source}, bindTexture);
+        for (int i = 0; i < std::max(heavyPasses, 1); ++i) {
+            last = graph.addPass("sharpen", &sharpen, {last}, bindSharpen);
+            if (i > 0) {
+                extra.push_back(last);
+            }
+        }
+        outputId = graph.addPass("texture_out", &texture, {last}, bindTexture);
+        graph.setOutput(outputId, &output);
+    });
+
+    DynamicResolutionConfig config;
+    config.targetMs = targetMs;
+    engine.setDynamicResolution(dynamic, config);
+
+    const int kTail = 10;
+    float lastScale = engine.renderScale();
+    for (int phase = 0; phase < 2; ++phase) {
+        bool heavy = phase == 0;
+        // 两个阶段之间的反转是正常的调整, 只统计阶段内的
+        int lastDirection = 0;
+        engine.sync([&]() {
+            for (RenderGraph::ResId id : extra) {
+                graph.setPassEnabled(id, heavy);
+            }
+        });
+        double tailMs = 0;
+        for (int i = 0; i < frames; ++i) {
+            double frameMs = 0;
+            engine.syncRender([&](int, int) {
+                auto start = std::chrono::steady_clock::now();
+                graph.setRenderScale(engine.renderScale());
+                graph.setImport(source, input.rgbaTexture);
+                graph.execute();
+                // llvmpipe 没有 GPU 计时, glFinish 让 CPU 耗时包含 GPU 的执行时间
+                glFinish();
+                frameMs = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - start).count() / 1000.0;
+                return false;
+            });
+            if (i >= frames - kTail) {
+                tailMs += frameMs;
+            }
+            float scale = engine.renderScale();
+            if (scale != lastScale) {
+                int direction = scale > lastScale ? 1 : -1;
+                if (lastDirection != 0 && direction != lastDirection) {
+                    result.reversals += 1;
+                }
+                lastDirection = direction;
+                lastScale = scale;
+            }
+        }
+        if (heavy) {
+            result.heavyScale = lastScale;
+            result.heavyMs = tailMs / kTail;
+        } else {
+            result.lightScale = lastScale;
+            result.lightMs = tailMs / kTail;
+        }
+    }
+
+    engine.sync([&]() {
+        result.changes = engine.renderScaleChanges();
+        result.allocations = graph.framebufferAllocations();
+        graph.release();
+        texture.release();
+        sharpen.release();
+        output.release();
+        input.release();
+    });
+    engine.setDynamicResolution(false);
+    return result;
+}
+
+NAMESPACE_END
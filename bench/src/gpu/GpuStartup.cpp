@@ -0,0 +1,101 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/GLEngine.h"
+#include "common/gles/filter/ColorAdjustFilter.h"
+#include "common/gles/filter/SharpenFilter.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <chrono>
+
+NAMESPACE_DEFAULT
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+GpuStartupResult runStartup(EGLSurfaceMode mode, bool warmUp, GpuInput &input) {
+    const int maxFrames = 1000;
+    GpuStartupResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    TextureFilter passthrough;
+    ColorAdjustFilter color;
+    SharpenFilter sharpen;
+    color.setBrightness(0.2f);
+    color.setContrast(0.3f);
+    color.setSaturation(0.4f);
+    sharpen.setStrength(0.5f);
+
+    GLEngine engine("gpu_startup", 3, mode);
+    if (warmUp) {
+        engine.warmUp({&color, &sharpen});
+    }
+
+    Framebuffer fb[2], output;
+    engine.sync([&]() {
+        input.createTexture();
+        for (auto &f : fb) {
+            f.create(input.width, input.height);
+        }
+        output.create(input.width, input.height);
+    });
+
+    for (int i = 0; i < maxFrames && result.fullFrameMs == 0; ++i) {
+        engine.sync([&]() {
+            auto frameStart = std::chrono::steady_clock::now();
+            const Texture2D *tex = input.rgbaTexture;
+            bool full = true;
+            if (!warmUp || color.programReady()) {
+                color.setViewport(input.width, input.height);
+                color.inputTexture(tex->id());
+                color.render(&fb[0]);
+                tex = fb[0].texture();
+            } else {
+                full = false;
+            }
+            if (!warmUp || sharpen.programReady()) {
+                sharpen.setViewport(input.width, input.height);
+                sharpen.setResolution((float)input.width, (float)input.height);
+                sharpen.inputTexture(tex->id());
+                sharpen.render(&fb[1]);
+                tex = fb[1].texture();
+            } else {
+                full = false;
+            }
+            passthrough.viewport().set(input.width, input.height);
+            passthrough.inputTexture(*tex).blend(false).render(&output);
+            double renderMs = elapsedMs(frameStart);
+            glFinish();
+
+            double ms = elapsedMs(start);
+            if (i == 0) {
+                result.firstFrameMs = ms;
+            }
+            if (full) {
+                result.fullFrameMs = ms;
+                result.fullFrameRenderMs = renderMs;
+            } else {
+                result.passthroughFrames += 1;
+            }
+        });
+    }
+
+    engine.sync([&]() {
+        passthrough.release();
+        color.release();
+        sharpen.release();
+        for (auto &f : fb) {
+            f.release();
+        }
+        output.release();
+        input.release();
+    });
+    engine.destroy();
+    return result;
+}
+
+NAMESPACE_END
@@ -0,0 +1,181 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/egl/TextureUploader.h"
+#include "common/gles/PlaneTexture.h"
+#include "common/gles/filter/TextureFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+const char *uploadModeName(int mode) {
+    switch (mode) {
+        case UPLOAD_STAGED: return "staged";
+        case UPLOAD_DIRECT: return "direct";
+        case UPLOAD_PBO: return "pbo";
+        default: return "unknown";
+    }
+}
+
+GpuUploadResult runYuvUpload(int mode, int padding, int frames, int width, int height) {
+    GpuUploadResult result;
+    result.mode = mode;
+    result.padding = padding;
+    result.frames = frames;
+    result.width = width;
+    result.height = height;
+
+    // NV21 的两个平面, 每行末尾有 padding 个字节
+    int stride = width + padding;
+    std::vector<uint8_t> y((size_t)stride * height), uv((size_t)stride * height / 2);
+    for (size_t i = 0; i < y.size(); ++i) {
+        y[i] = (uint8_t)(i * 3);
+    }
+    for (size_t i = 0; i < uv.size(); ++i) {
+        uv[i] = (uint8_t)(i * 5);
+    }
+    // 旧的 putData 路径: 先整理到紧密排列的缓存, 再上传
+    std::vector<uint8_t> staging((size_t)width * height * 3 / 2);
+
+    PlaneTexture yPlane(1), uvPlane(2);
+    yPlane.setPboEnabled(mode == UPLOAD_PBO);
+    uvPlane.setPboEnabled(mode == UPLOAD_PBO);
+
+    int64_t cpuNs = 0, wallNs = 0;
+    for (int i = -1; i < frames; ++i) {
+        int64_t start = nowNs();
+        if (mode == UPLOAD_STAGED) {
+            for (int row = 0; row < height; ++row) {
+                memcpy(staging.data() + (size_t)row * width, y.data() + (size_t)row * stride, width);
+            }
+            uint8_t *dstUV = staging.data() + (size_t)width * height;
+            for (int row = 0; row < height / 2; ++row) {
+                memcpy(dstUV + (size_t)row * width, uv.data() + (size_t)row * stride, width);
+            }
+            yPlane.upload(staging.data(), width, width, height);
+            uvPlane.upload(dstUV, width, width / 2, height / 2);
+        } else {
+            yPlane.upload(y.data(), stride, width, height);
+            uvPlane.upload(uv.data(), stride, width / 2, height / 2);
+        }
+        int64_t submitted = nowNs();
+        glFinish();
+        // 第一帧包含创建纹理, 不计入
+        if (i >= 0) {
+            cpuNs += submitted - start;
+            wallNs += nowNs() - start;
+        }
+    }
+    yPlane.release();
+    uvPlane.release();
+
+    result.cpuMsPerFrame = (double)cpuNs / 1e6 / frames;
+    result.wallMsPerFrame = (double)wallNs / 1e6 / frames;
+    return result;
+}
+
+GpuHitchResult runTextureHitch(GLEngine &engine, bool async, int frames, int width, int height) {
+    GpuHitchResult result;
+    result.async = async;
+    result.frames = frames;
+    result.width = width;
+    result.height = height;
+
+    auto pixels = std::make_shared<std::vector<uint8_t>>((size_t)width * height * 4);
+    for (size_t i = 0; i < pixels->size(); ++i) {
+        (*pixels)[i] = (uint8_t)(i * 31);
+    }
+
+    // 渲染线程每帧把当前纹理画到 640x360 的输出, 第 kRequestFrame 帧请求上传大图
+    const int kRequestFrame = 5;
+    const int kOutputW = 640, kOutputH = 360;
+    TextureFilter filter;
+    Framebuffer output;
+    Texture2D *placeholder = nullptr;
+    ImageTexture image;
+    engine.sync([&]() {
+        output.create(kOutputW, kOutputH);
+        placeholder = new Texture2D(64, 64);
+        std::vector<uint8_t> gray(64 * 64 * 4, 128);
+        placeholder->update(gray.data());
+    });
+
+    std::unique_ptr<TextureUploader> uploader;
+    if (async) {
+        uploader.reset(new TextureUploader(engine));
+    }
+    std::shared_ptr<AsyncTexture> asyncTex;
+    std::vector<double> frameMs;
+    for (int i = 0; i < frames; ++i) {
+        engine.sync([&]() {
+            int64_t start = nowNs();
+            const Texture *input = placeholder;
+            if (i >= kRequestFrame) {
+                if (!async) {
+                    if (i == kRequestFrame) {
+                        image.set(pixels->data(), width, height);
+                    }
+                    input = image.texture();
+                    if (result.readyFrame < 0) {
+                        result.readyFrame = i - kRequestFrame;
+                    }
+                } else {
+                    if (i == kRequestFrame) {
+                        asyncTex = uploader->upload(pixels, width, height);
+                    }
+                    if (asyncTex->ready()) {
+                        input = asyncTex->texture();
+                        if (result.readyFrame < 0) {
+                            result.readyFrame = i - kRequestFrame;
+                            result.latencyMs = (double)asyncTex->latencyUs() / 1000.0;
+                        }
+                    }
+                }
+            }
+            filter.viewport().set(kOutputW, kOutputH).enableClearColor(0, 0, 0, 1);
+            filter.setFullTextureCoord().setFullVertexCoord();
+            filter.inputTexture(*input).blend(false).render(&output);
+            glFinish();
+            frameMs.push_back((double)(nowNs() - start) / 1e6);
+        });
+        // 按 60fps 的节奏出帧, 后台上传有时间进行
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+
+    engine.sync([&]() {
+        if (asyncTex) {
+            asyncTex->release();
+        }
+        image.release();
+        placeholder->release();
+        delete placeholder;
+        output.release();
+        filter.release();
+    });
+    if (uploader) {
+        uploader->destroy();
+    }
+
+    std::vector<double> before(frameMs.begin(), frameMs.begin() + std::min(kRequestFrame, (int)frameMs.size()));
+    result.baselineMs = before.empty() ? 0 : *std::max_element(before.begin(), before.end());
+    result.maxFrameMs = *std::max_element(frameMs.begin(), frameMs.end());
+    return result;
+}
+
+NAMESPACE_END
@@ -0,0 +1,824 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "GpuBench.h"
+
+#include "common/Log.h"
+#include "common/egl/GLEngine.h"
+#include "common/gles/GLProgramCache.h"
+#include "common/gles/GLStateCache.h"
+#include "common/gles/filter/RGBAToYUVFilter.h"
+#include "common/utils/FileUtils.h"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifndef GPU_BENCH_GOLDEN_DIR
+#define GPU_BENCH_GOLDEN_DIR "goldens"
+#endif
+
+using namespace znative;
+
+struct GpuBenchOptions {
+    std::string filter;
+    std::string out;
+    std::string log;
+    std::string goldenDir = GPU_BENCH_GOLDEN_DIR;
+    std::string actualDir;
+    std::string programCacheDir;
+    std::vector<std::pair<int, int>> sizes = {{640, 480}, {1280, 720}, {1920, 1080}};
+    int goldenWidth = 128;
+    int goldenHeight = 72;
+    int frames = 30;
+    int warmup = 5;
+    int tolerance = 3;
+    EGLSurfaceMode eglMode = SURFACE_SURFACELESS;
+    bool updateGoldens = false;
+    bool skipPerf = false;
+    int startupRuns = 3;
+    int drawCalls = 2000;
+};
+
+static void printUsage() {
+    fprintf(stderr, "usage: znative-gpu-bench [--filter=<substr>] [--frames=30] [--warmup=5] [--sizes=640x480,1280x720]\n"
+                    "                         [--golden-dir=<dir>] [--update-goldens] [--tolerance=3]\n"
+                    "                         [--actual-dir=<dir>] [--skip-perf] [--out=<file.json>] [--log=<file>]\n"
+                    "                         [--egl=surfaceless|pbuffer] [--program-cache=<dir>]\n"
+                    "                         [--startup-runs=3] [--draw-calls=2000]\n");
+}
+
+static bool parseSizes(const std::string &str, std::vector<std::pair<int, int>> &sizes) {
+    sizes.clear();
+    size_t pos = 0;
+    while (pos < str.size()) {
+        size_t end = str.find(',', pos);
+        std::string item = str.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        int w = 0, h = 0;
+        if (sscanf(item.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) {
+            return false;
+        }
+        sizes.emplace_back(w, h);
+        if (end == std::string::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return !sizes.empty();
+}
+
+static bool parseArgs(int argc, char **argv, GpuBenchOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char *key) -> const char * {
+            size_t len = strlen(key);
+            if (arg.compare(0, len, key) == 0 && arg.size() > len && arg[len] == '=') {
+                return arg.c_str() + len + 1;
+            }
+            return nullptr;
+        };
+
+        const char *v;
+        if ((v = value("--filter"))) {
+            opt.filter = v;
+        } else if ((v = value("--out"))) {
+            opt.out = v;
+        } else if ((v = value("--log"))) {
+            opt.log = v;
+        } else if ((v = value("--golden-dir"))) {
+            opt.goldenDir = v;
+        } else if ((v = value("--program-cache"))) {
+            opt.programCacheDir = v;
+        } else if ((v = value("--actual-dir"))) {
+            opt.actualDir = v;
+        } else if ((v = value("--sizes"))) {
+            if (!parseSizes(v, opt.sizes)) {
+                return false;
+            }
+        } else if ((v = value("--frames"))) {
+            opt.frames = std::max(1, atoi(v));
+        } else if ((v = value("--warmup"))) {
+            opt.warmup = std::max(0, atoi(v));
+        } else if ((v = value("--startup-runs"))) {
+            opt.startupRuns = std::max(0, atoi(v));
+        } else if ((v = value("--draw-calls"))) {
+            opt.drawCalls = std::max(0, atoi(v));
+        } else if ((v = value("--tolerance"))) {
+            opt.tolerance = std::max(0, atoi(v));
+        } else if ((v = value("--egl"))) {
+            if (strcmp(v, "surfaceless") == 0) {
+                opt.eglMode = SURFACE_SURFACELESS;
+            } else if (strcmp(v, "pbuffer") == 0) {
+                opt.eglMode = SURFACE_PBUFFER;
+            } else {
+                return false;
+            }
+        } else if (arg == "--update-goldens") {
+            opt.updateGoldens = true;
+        } else if (arg == "--skip-perf") {
+            opt.skipPerf = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 在 golden 分辨率渲染一帧并和 golden 图片比较, --update-goldens 时覆盖 golden
+ */
+static nlohmann::json checkGolden(GLEngine &engine, GpuCase &c, GpuInput &input, const GpuBenchOptions &opt,
+                                  bool &failed) {
+    GpuImage actual;
+    engine.sync([&]() {
+        input.createTexture();
+        c.setup(input);
+        Framebuffer output;
+        output.create(input.width, input.height);
+        c.render(input, output);
+        uint8_t *pixels = output.readPixels();
+        if (pixels) {
+            actual.width = input.width;
+            actual.height = input.height;
+            actual.pixels.assign(pixels, pixels + (size_t)input.width * input.height * 4);
+            delete[] pixels;
+        }
+        output.release();
+        c.release();
+        input.release();
+    });
+
+    nlohmann::json result = {{"name", c.name()}};
+    std::string goldenPath = opt.goldenDir + "/" + c.name() + ".pam";
+    if (actual.empty()) {
+        result["status"] = "render_failed";
+        failed = true;
+        return result;
+    }
+    if (opt.updateGoldens) {
+        result["status"] = actual.writePam(goldenPath) ? "updated" : "write_failed";
+        return result;
+    }
+
+    GpuImage golden;
+    if (!golden.readPam(goldenPath)) {
+        result["status"] = "missing";
+        failed = true;
+        return result;
+    }
+
+    GpuImageDiff diff = compareImage(actual, golden, opt.tolerance);
+    bool pass = diff.maxDiff <= opt.tolerance;
+    result["status"] = pass ? "pass" : "fail";
+    result["max_diff"] = diff.maxDiff;
+    result["mean_diff"] = diff.meanDiff;
+    result["bad_pixels"] = diff.badPixels;
+    if (!pass) {
+        failed = true;
+        if (!opt.actualDir.empty()) {
+            FileUtils::mkDir(opt.actualDir.c_str());
+            actual.writePam(opt.actualDir + "/" + c.name() + ".pam");
+        }
+    }
+    return result;
+}
+
+static nlohmann::json runPerf(GLEngine &engine, GpuCase &c, GpuInput &input, const GpuBenchOptions &opt) {
+    std::string key = tfm::format("%s@%dx%d", c.name(), input.width, input.height);
+    Framebuffer output;
+    // case 自己持有的纹理 (中间 Framebuffer 等) 占用的显存, 在第一帧之后统计
+    int64_t baseTexBytes = 0, caseTexBytes = 0;
+    // 中间结果每帧的读写量, 在 release 之前统计
+    int64_t intermediateBytes = 0;
+    // 第一帧包含 shader 编译 (或者从 program cache 加载) 的耗时
+    int64_t firstFrameStart = nowNs();
+    double firstFrameMs = 0;
+    engine.sync([&]() {
+        input.createTexture();
+        output.create(input.width, input.height);
+        baseTexBytes = GLResTracker::instance().stat(RES_TEXTURE).bytes;
+        c.setup(input);
+    });
+
+    std::vector<double> cpuMs;
+    std::vector<double> wallMs;
+    // Program 在测量帧中发出的 GL 调用, 统计在 GL 线程上
+    ProgramCallStat calls;
+    GLStateStat states;
+    for (int i = 0; i < opt.warmup + opt.frames; ++i) {
+        bool measure = i >= opt.warmup;
+        engine.syncRender([&](int, int) {
+            ProgramCallStat before = ProgramCallStat::current();
+            GLStateStat stateBefore = GLStateCache::current()->stat();
+            int64_t start = nowNs();
+            {
+                GLGpuTimerScope scope(measure ? key : "warmup");
+                c.render(input, output);
+            }
+            int64_t submitted = nowNs();
+            glFinish();
+            int64_t finished = nowNs();
+            if (i == 0) {
+                firstFrameMs = (double)(finished - firstFrameStart) / 1e6;
+                caseTexBytes = GLResTracker::instance().stat(RES_TEXTURE).bytes - baseTexBytes;
+                intermediateBytes = c.intermediateBytes();
+            }
+            if (measure) {
+                cpuMs.push_back((double)(submitted - start) / 1e6);
+                wallMs.push_back((double)(finished - start) / 1e6);
+                const ProgramCallStat &after = ProgramCallStat::current();
+                calls.glCalls += after.glCalls - before.glCalls;
+                calls.uniformUploads += after.uniformUploads - before.uniformUploads;
+                calls.uniformSkips += after.uniformSkips - before.uniformSkips;
+                calls.blockUploads += after.blockUploads - before.blockUploads;
+                calls.vertexUploads += after.vertexUploads - before.vertexUploads;
+                const GLStateStat &stateAfter = GLStateCache::current()->stat();
+                states.issued += stateAfter.issued - stateBefore.issued;
+                states.redundant += stateAfter.redundant - stateBefore.redundant;
+                states.deferred += stateAfter.deferred - stateBefore.deferred;
+            }
+            return false;
+        });
+    }
+
+    engine.sync([&]() {
+        glFinish();
+        if (GLGpuTimer::current()) {
+            GLGpuTimer::current()->collect();
+        }
+        output.release();
+        c.release();
+        input.release();
+    });
+
+    auto summary = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        double sum = 0;
+        for (double d : v) {
+            sum += d;
+        }
+        return nlohmann::json{
+            {"avg", sum / (double)v.size()}, {"p50", v[v.size() / 2]}, {"min", v.front()}, {"max", v.back()}};
+    };
+
+    nlohmann::json result = {
+        {"name", c.name()},
+        {"width", input.width},
+        {"height", input.height},
+        {"frames", opt.frames},
+        {"texture_bytes", caseTexBytes},
+        {"intermediate_mb_per_frame", (double)intermediateBytes / 1024.0 / 1024.0},
+        {"first_frame_ms", firstFrameMs},
+        {"cpu_ms", summary(cpuMs)},
+        {"wall_ms", summary(wallMs)},
+        {"gl_calls_per_frame",
+         {{"program", (double)calls.glCalls / opt.frames},
+          {"uniform_uploads", (double)calls.uniformUploads / opt.frames},
+          {"uniform_skips", (double)calls.uniformSkips / opt.frames},
+          {"block_uploads", (double)calls.blockUploads / opt.frames},
+          {"vertex_uploads", (double)calls.vertexUploads / opt.frames},
+          {"state_issued", (double)states.issued / opt.frames},
+          {"state_redundant", (double)states.redundant / opt.frames},
+          {"state_deferred", (double)states.deferred / opt.frames}}},
+    };
+    GpuTimeStat gpu;
+    if (engine.gpuTimeStat(key, gpu)) {
+        result["gpu_ms"] = {{"avg", gpu.avgMs}, {"min", gpu.minMs}, {"max", gpu.maxMs}, {"samples", gpu.count}};
+    }
+    return result;
+}
+
+/**
+ * 关闭和开启 GLStateCache 时每帧发出的状态调用 (绑定, viewport, 开关等), 关闭时的 redundant 即可以省掉的调用.
+ * 开启时同时开启延迟解绑
+ */
+static nlohmann::json runStateCalls(GLEngine &engine, GpuCase &c, GpuInput &input, const GpuBenchOptions &opt) {
+    nlohmann::json result = {{"name", c.name()}, {"width", input.width}, {"height", input.height}};
+    for (int enabled = 0; enabled < 2; ++enabled) {
+        engine.setStateCacheEnabled(enabled == 1);
+        engine.setDeferUnbind(enabled == 1);
+        Framebuffer output;
+        engine.sync([&]() {
+            input.createTexture();
+            output.create(input.width, input.height);
+            c.setup(input);
+        });
+        GLStateStat stat;
+        for (int i = 0; i < opt.warmup + opt.frames; ++i) {
+            engine.syncRender([&](int, int) {
+                GLStateStat before = GLStateCache::current()->stat();
+                c.render(input, output);
+                if (i >= opt.warmup) {
+                    const GLStateStat &after = GLStateCache::current()->stat();
+                    stat.issued += after.issued - before.issued;
+                    stat.redundant += after.redundant - before.redundant;
+                    stat.deferred += after.deferred - before.deferred;
+                }
+                return false;
+            });
+        }
+        engine.sync([&]() {
+            glFinish();
+            output.release();
+            c.release();
+            input.release();
+        });
+        result[enabled == 1 ? "cache_on" : "cache_off"] = {{"issued", (double)stat.issued / opt.frames},
+                                                            {"redundant", (double)stat.redundant / opt.frames},
+                                                            {"deferred", (double)stat.deferred / opt.frames}};
+    }
+    engine.setStateCacheEnabled(true);
+    engine.setDeferUnbind(false);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    GpuBenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+
+    if (!opt.log.empty()) {
+        setLogFile(opt.log.c_str());
+    } else if (opt.out.empty()) {
+        setLogFile("/dev/null");
+    }
+
+    std::vector<std::shared_ptr<GpuCase>> cases;
+    for (auto &c : createGpuCases()) {
+        if (opt.filter.empty() || c->name().find(opt.filter) != std::string::npos) {
+            cases.push_back(c);
+        }
+    }
+
+    // 离屏模式不依赖窗口系统, mesa 上会使用 surfaceless 平台, 可以直接跑在 llvmpipe 上
+    if (!opt.programCacheDir.empty()) {
+        GLProgramCache::instance().setCacheDir(opt.programCacheDir);
+    }
+
+    GLEngine engine("gpu_bench", 3, opt.eglMode);
+    if (opt.eglMode == SURFACE_PBUFFER) {
+        engine.updateOffscreenSize(opt.goldenWidth, opt.goldenHeight);
+    }
+    engine.setGpuTimerEnabled(true);
+
+    nlohmann::json root;
+    std::string renderer;
+    engine.sync([&renderer]() {
+        renderer = tfm::format("%s / %s", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+    });
+    root["context"] = {{"renderer", renderer}, {"egl_mode", opt.eglMode}, {"frames", opt.frames}, {"warmup", opt.warmup},
+                       {"tolerance", opt.tolerance}, {"golden_dir", opt.goldenDir}};
+
+    bool failed = false;
+    root["goldens"] = nlohmann::json::array();
+    GpuInput goldenInput;
+    goldenInput.generate(opt.goldenWidth, opt.goldenHeight);
+    for (auto &c : cases) {
+        nlohmann::json r = checkGolden(engine, *c, goldenInput, opt, failed);
+        fprintf(stderr, "golden %-40s %s\n", c->name().c_str(), r["status"].get<std::string>().c_str());
+        root["goldens"].push_back(r);
+    }
+
+    root["benchmarks"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        for (auto &size : opt.sizes) {
+            GpuInput input;
+            input.generate(size.first, size.second);
+            for (auto &c : cases) {
+                nlohmann::json r = runPerf(engine, *c, input, opt);
+                fprintf(stderr, "perf   %-40s %4dx%-4d cpu %8.3f ms  wall %8.3f ms  gpu %8.3f ms  tex %6.2f mb\n",
+                        c->name().c_str(), size.first, size.second, r["cpu_ms"]["avg"].get<double>(),
+                        r["wall_ms"]["avg"].get<double>(),
+                        r.contains("gpu_ms") ? r["gpu_ms"]["avg"].get<double>() : -1.0,
+                        (double)r["texture_bytes"].get<int64_t>() / 1024.0 / 1024.0);
+                root["benchmarks"].push_back(r);
+            }
+        }
+    }
+
+    // 滤镜链的状态调用, 关闭/开启 GLStateCache 对比
+    root["state_calls"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        GpuInput input;
+        input.generate(opt.sizes.front().first, opt.sizes.front().second);
+        for (auto &c : cases) {
+            if (c->name().find("chain") == std::string::npos) {
+                continue;
+            }
+            nlohmann::json r = runStateCalls(engine, *c, input, opt);
+            fprintf(stderr, "state  %-40s off: issued %5.1f redundant %5.1f  on: issued %5.1f skipped %5.1f\n",
+                    c->name().c_str(), r["cache_off"]["issued"].get<double>(),
+                    r["cache_off"]["redundant"].get<double>(), r["cache_on"]["issued"].get<double>(),
+                    r["cache_on"]["redundant"].get<double>() + r["cache_on"]["deferred"].get<double>());
+            root["state_calls"].push_back(r);
+        }
+    }
+
+    // FramebufferPool 在频繁申请/归还不同尺寸时的开销, 单线程/多个共享 context 线程, 内存充足/紧张
+    root["framebuffer_pool"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        int w = opt.sizes.front().first, h = opt.sizes.front().second;
+        for (int threads : {1, 2}) {
+            for (int cacheMb : {50, 1}) {
+                GpuPoolResult r = runFramebufferPool(engine, threads, cacheMb, opt.frames, w, h);
+                fprintf(stderr, "pool   threads=%d cache=%2d mb %4dx%-4d obtain %7.2f us  hit rate %5.1f%%  evictions %5lld"
+                                "  peak %6.2f mb\n",
+                        threads, cacheMb, w, h, r.obtainUs, r.hitRate * 100, (long long)r.evictions, r.peakMb);
+                root["framebuffer_pool"].push_back({{"threads", r.threads},
+                                                    {"max_cache_mb", r.maxCacheMb},
+                                                    {"width", w},
+                                                    {"height", h},
+                                                    {"frames", r.frames},
+                                                    {"obtains_per_frame", r.obtainsPerFrame},
+                                                    {"obtain_us", r.obtainUs},
+                                                    {"hit_rate", r.hitRate},
+                                                    {"evictions", r.evictions},
+                                                    {"peak_mb", r.peakMb}});
+            }
+        }
+    }
+
+    // 读回: 同步 readPixels / 双 PBO / PBO 环 + fence, RGBA 全图和 R8 子区域
+    root["readback"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        int w = opt.sizes.front().first, h = opt.sizes.front().second;
+        struct ReadbackRun {
+            int mode;
+            FramebufferFormat format;
+            bool subRect;
+        };
+        const ReadbackRun runs[] = {{READBACK_SYNC, FB_FORMAT_RGBA8, false},
+                                    {READBACK_PING_PONG, FB_FORMAT_RGBA8, false},
+                                    {READBACK_ASYNC, FB_FORMAT_RGBA8, false},
+                                    {READBACK_SYNC, FB_FORMAT_R8, false},
+                                    {READBACK_ASYNC, FB_FORMAT_R8, true}};
+        for (auto &run : runs) {
+            GpuReadbackResult r;
+            engine.sync([&]() { r = runReadback(run.mode, run.format, 3, opt.frames, w, h, run.subRect); });
+            fprintf(stderr, "read   %-9s %-7s %4dx%-4d cpu %7.3f ms/frame  latency %6.2f ms  received %4lld  dropped %3lld\n",
+                    readbackModeName(r.mode), Framebuffer::formatName(run.format), r.width, r.height, r.cpuMsPerFrame,
+                    r.latencyMs, (long long)r.received, (long long)r.dropped);
+            root["readback"].push_back({{"mode", readbackModeName(r.mode)},
+                                        {"format", Framebuffer::formatName(run.format)},
+                                        {"depth", r.depth},
+                                        {"width", r.width},
+                                        {"height", r.height},
+                                        {"frames", r.frames},
+                                        {"cpu_ms_per_frame", r.cpuMsPerFrame},
+                                        {"latency_ms", r.latencyMs},
+                                        {"received", r.received},
+                                        {"dropped", r.dropped}});
+        }
+    }
+
+    // NV21 上传: 整理到缓存后上传 / 直接上传 / 经过 PBO, 紧密排列和每行有填充
+    root["yuv_upload"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        for (auto &size : opt.sizes) {
+            for (int padding : {0, 64}) {
+                for (int mode : {UPLOAD_STAGED, UPLOAD_DIRECT, UPLOAD_PBO}) {
+                    GpuUploadResult r;
+                    engine.sync([&]() { r = runYuvUpload(mode, padding, opt.frames, size.first, size.second); });
+                    fprintf(stderr, "upload %-6s padding=%-2d %4dx%-4d cpu %7.3f ms/frame  wall %7.3f ms/frame\n",
+                            uploadModeName(r.mode), r.padding, r.width, r.height, r.cpuMsPerFrame, r.wallMsPerFrame);
+                    root["yuv_upload"].push_back({{"mode", uploadModeName(r.mode)},
+                                                  {"format", "nv21"},
+                                                  {"padding", r.padding},
+                                                  {"width", r.width},
+                                                  {"height", r.height},
+                                                  {"frames", r.frames},
+                                                  {"cpu_ms_per_frame", r.cpuMsPerFrame},
+                                                  {"wall_ms_per_frame", r.wallMsPerFrame}});
+                }
+            }
+        }
+    }
+
+    // 生产者 250Hz 请求渲染, 每帧渲染 10ms: postRender 排队 / requestRender 只渲染最新 / requestRender + 60fps
+    root["frame_pacing"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        for (int mode = PACING_QUEUE; mode <= PACING_FPS; ++mode) {
+            GpuPacingResult r = runPacing(engine, mode, 60, 1000, 4, 10);
+            fprintf(stderr, "pacing %-6s fps %4.0f  requested %4lld  rendered %4lld  coalesced %4lld  missed %3lld"
+                            "  latency avg %8.2f ms  max %8.2f ms\n",
+                    pacingModeName(r.mode), r.fps, (long long)r.requested, (long long)r.rendered,
+                    (long long)r.coalesced, (long long)r.missed, r.avgLatencyMs, r.maxLatencyMs);
+            root["frame_pacing"].push_back({{"mode", pacingModeName(r.mode)},
+                                            {"fps", r.fps},
+                                            {"requested", r.requested},
+                                            {"rendered", r.rendered},
+                                            {"coalesced", r.coalesced},
+                                            {"missed", r.missed},
+                                            {"avg_latency_ms", r.avgLatencyMs},
+                                            {"max_latency_ms", r.maxLatencyMs}});
+        }
+    }
+
+    // 动态分辨率: 640x360 的链路先 6 个锐化 pass 再 1 个. 先以固定分辨率测出两种负载的耗时,
+    // 目标取两者的几何平均, 重负载需要降低分辨率, 轻负载可以回到原始分辨率
+    root["dynamic_resolution"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        float targetMs = 0;
+        for (int dynamic = 0; dynamic < 2; ++dynamic) {
+            GpuResolutionResult r = runDynamicResolution(engine, dynamic == 1, 100, 640, 360, 6, targetMs);
+            fprintf(stderr, "resolution %-7s target %6.1f ms  heavy scale %.2f %7.2f ms  light scale %.2f %7.2f ms"
+                            "  changes %2d  reversals %d  allocations %2lld\n",
+                    r.dynamic ? "dynamic" : "fixed", r.targetMs, r.heavyScale, r.heavyMs, r.lightScale, r.lightMs,
+                    r.changes, r.reversals, (long long)r.allocations);
+            root["dynamic_resolution"].push_back({{"dynamic", r.dynamic},
+                                                  {"width", r.width},
+                                                  {"height", r.height},
+                                                  {"target_ms", r.targetMs},
+                                                  {"heavy_scale", r.heavyScale},
+                                                  {"heavy_ms", r.heavyMs},
+                                                  {"light_scale", r.lightScale},
+                                                  {"light_ms", r.lightMs},
+                                                  {"changes", r.changes},
+                                                  {"reversals", r.reversals},
+                                                  {"allocations", r.allocations}});
+            targetMs = (float)std::sqrt(r.heavyMs * r.lightMs);
+        }
+    }
+
+    // 滤镜融合: 锐化 -> 调色 -> 纹理输出, 三个 pass / 融合为一个 pass, 与三个 pass 的差值超出容差时失败
+    root["filter_fusion"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        int w = opt.sizes.front().first, h = opt.sizes.front().second;
+        for (int fused = 0; fused < 2; ++fused) {
+            GpuFusionResult r = runFilterFusion(engine, fused == 1, opt.frames, w, h);
+            bool pass = r.maxDiff <= kFusionMaxDiffTolerance && r.meanDiff <= kFusionMeanDiffTolerance;
+            failed = failed || !pass;
+            fprintf(stderr, "fusion %-7s %4dx%-4d passes %d  frame %7.2f ms  intermediate %6.2f mb  switch %7.2f ms"
+                            "  programs %d  diff max %d mean %.3f  %s\n",
+                    r.fused ? "fused" : "passes", w, h, r.passes, r.avgFrameMs,
+                    (double)r.intermediateBytes / 1024.0 / 1024.0, r.switchFrameMs, r.programs, r.maxDiff, r.meanDiff,
+                    pass ? "pass" : "FAIL");
+            root["filter_fusion"].push_back({{"fused", r.fused},
+                                             {"width", r.width},
+                                             {"height", r.height},
+                                             {"frames", r.frames},
+                                             {"passes", r.passes},
+                                             {"intermediate_bytes", r.intermediateBytes},
+                                             {"avg_frame_ms", r.avgFrameMs},
+                                             {"switch_frame_ms", r.switchFrameMs},
+                                             {"programs", r.programs},
+                                             {"max_diff", r.maxDiff},
+                                             {"mean_diff", r.meanDiff},
+                                             {"tolerance", {{"max", kFusionMaxDiffTolerance},
+                                                            {"mean", kFusionMeanDiffTolerance}}},
+                                             {"pass", pass}});
+        }
+    }
+
+    // compute shader: 锐化 fragment shader / compute shader 直接采样 / shared memory 分块, 与 fragment shader 的差值超出容差时失败
+    root["compute"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        int w = opt.sizes.front().first, h = opt.sizes.front().second;
+        for (int mode : {COMPUTE_OFF, COMPUTE_DIRECT, COMPUTE_TILED}) {
+            GpuComputeResult r = runComputeSharpen(engine, mode, opt.frames, w, h);
+            bool pass = r.maxDiff <= kComputeTolerance;
+            failed = failed || !pass;
+            fprintf(stderr, "compute sharpen %-8s %4dx%-4d used compute %d  frame %7.2f ms  texels/pixel %5.2f  diff %d  %s\n",
+                    computeModeName(r.mode), w, h, r.usedCompute ? 1 : 0, r.avgFrameMs, r.texelsPerPixel, r.maxDiff,
+                    pass ? "pass" : "FAIL");
+            root["compute"].push_back({{"filter", "sharpen"},
+                                       {"mode", computeModeName(r.mode)},
+                                       {"used_compute", r.usedCompute},
+                                       {"width", r.width},
+                                       {"height", r.height},
+                                       {"frames", r.frames},
+                                       {"avg_frame_ms", r.avgFrameMs},
+                                       {"texels_per_pixel", r.texelsPerPixel},
+                                       {"max_diff", r.maxDiff},
+                                       {"tolerance", kComputeTolerance},
+                                       {"pass", pass}});
+        }
+    }
+
+    // 每帧只有一个方块变化: 整帧渲染 / 只渲染变化的区域, 结果必须与整帧渲染完全相同
+    root["damage"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        int w = opt.sizes.front().first, h = opt.sizes.front().second;
+        for (bool damage : {false, true}) {
+            GpuDamageResult r = runDamageRender(engine, damage, opt.frames, w, h, 64);
+            bool pass = r.maxDiff == 0;
+            failed = failed || !pass;
+            fprintf(stderr, "damage %-7s %4dx%-4d rect %d  frame %7.2f ms  rendered %9.0f px  %8.1f Mpix/s  mem %.2f mb  diff %d  %s\n",
+                    damage ? "partial" : "full", w, h, r.rectSize, r.avgFrameMs, r.renderedPixels, r.mpixPerSec,
+                    (double)r.graphBytes / 1024.0 / 1024.0, r.maxDiff, pass ? "pass" : "FAIL");
+            root["damage"].push_back({{"mode", damage ? "partial" : "full"},
+                                      {"width", r.width},
+                                      {"height", r.height},
+                                      {"frames", r.frames},
+                                      {"rect_size", r.rectSize},
+                                      {"avg_frame_ms", r.avgFrameMs},
+                                      {"rendered_pixels", r.renderedPixels},
+                                      {"mpix_per_sec", r.mpixPerSec},
+                                      {"graph_bytes", r.graphBytes},
+                                      {"max_diff", r.maxDiff},
+                                      {"pass", pass}});
+        }
+    }
+
+    // 预览 + 编码 + 缩略图三个 surface: 每个 surface 各自渲染滤镜链 / 渲染一次后输出到所有 surface
+    root["multi_present"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        for (int once = 0; once < 2; ++once) {
+            GpuPresentResult r = runMultiPresent(once == 1, 60);
+            fprintf(stderr, "present %-11s surfaces %d  frame %7.2f ms  presented %lld/%lld/%lld  sample diff %d\n",
+                    r.renderOnce ? "render_once" : "per_surface", r.surfaces, r.avgFrameMs,
+                    (long long)r.presented[0], (long long)r.presented[1], (long long)r.presented[2], r.maxSampleDiff);
+            root["multi_present"].push_back({{"path", r.renderOnce ? "render_once" : "per_surface"},
+                                             {"frames", r.frames},
+                                             {"surfaces", r.surfaces},
+                                             {"avg_frame_ms", r.avgFrameMs},
+                                             {"presented", r.presented},
+                                             {"max_sample_diff", r.maxSampleDiff}});
+        }
+    }
+
+    // fence: 非阻塞查询 / 带超时等待 / 跨 context 的 GPU 等待 / fd 导出导入
+    root["fence"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        GpuFenceResult r = runFence(engine, 30, 1280, 720);
+        fprintf(stderr, "fence  native %d  poll %6.2f us  pending %2d/%d  bounded timeouts %2d  signal %7.3f ms"
+                        "  server wait mismatches %d  fd %s\n",
+                r.native ? 1 : 0, r.pollUs, r.pendingPolls, r.iterations, r.boundedTimeouts, r.signalMs,
+                r.serverWaitMismatches, r.fdRoundTrip ? "ok" : "fail");
+        root["fence"].push_back({{"native", r.native},
+                                 {"iterations", r.iterations},
+                                 {"poll_us", r.pollUs},
+                                 {"pending_polls", r.pendingPolls},
+                                 {"bounded_timeouts", r.boundedTimeouts},
+                                 {"signal_ms", r.signalMs},
+                                 {"server_wait_mismatches", r.serverWaitMismatches},
+                                 {"fd_round_trip", r.fdRoundTrip}});
+    }
+
+    // 共享 context 之间传递帧, 消费者每帧占用 8ms: ShareFramebuffer 单缓冲加锁 / FrameMailbox 三缓冲
+    root["mailbox"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        for (int mailbox = 0; mailbox < 2; ++mailbox) {
+            GpuMailboxResult r = runMailbox(engine, mailbox == 1, 300, 1280, 720, 8);
+            fprintf(stderr, "mailbox %-7s %4dx%-4d producer %8.1f fps  consumed %4lld  dropped %4lld  mismatches %lld\n",
+                    r.mailbox ? "mailbox" : "shared", r.width, r.height, r.producerFps, (long long)r.consumed,
+                    (long long)r.dropped, (long long)r.mismatches);
+            root["mailbox"].push_back({{"path", r.mailbox ? "mailbox" : "shared"},
+                                       {"width", r.width},
+                                       {"height", r.height},
+                                       {"frames", r.frames},
+                                       {"consumer_ms", r.consumerMs},
+                                       {"producer_fps", r.producerFps},
+                                       {"consumed", r.consumed},
+                                       {"dropped", r.dropped},
+                                       {"mismatches", r.mismatches}});
+        }
+    }
+
+    // 4K 图片上传时渲染线程的卡顿: ImageTexture 同步上传 / TextureUploader 后台上传
+    root["texture_hitch"] = nlohmann::json::array();
+    if (!opt.skipPerf) {
+        for (int async = 0; async < 2; ++async) {
+            GpuHitchResult r = runTextureHitch(engine, async == 1, 40, 3840, 2160);
+            fprintf(stderr, "hitch  %-5s %4dx%-4d baseline %7.3f ms  max frame %7.3f ms  ready after %2d frames"
+                            "  latency %7.2f ms\n",
+                    r.async ? "async" : "sync", r.width, r.height, r.baselineMs, r.maxFrameMs, r.readyFrame,
+                    r.latencyMs);
+            root["texture_hitch"].push_back({{"path", r.async ? "async" : "sync"},
+                                             {"width", r.width},
+                                             {"height", r.height},
+                                             {"frames", r.frames},
+                                             {"baseline_ms", r.baselineMs},
+                                             {"max_frame_ms", r.maxFrameMs},
+                                             {"ready_frame", r.readyFrame},
+                                             {"latency_ms", r.latencyMs}});
+        }
+    }
+
+    // 渲染结果到 NV21/NV12/I420: 读回 RGBA 后 CPU 转换 / GPU 转换 (RGBA8 打包或 R8) 后读回, 与 YuvUtils 的差值超出容差时失败
+    root["yuv_readback"] = nlohmann::json::array();
+    if (!opt.skipPerf && !opt.sizes.empty()) {
+        for (auto &size : opt.sizes) {
+            for (int layout : {YUV_LAYOUT_NV21, YUV_LAYOUT_NV12, YUV_LAYOUT_I420}) {
+                for (int path = 0; path < 3; ++path) {
+                    bool gpu = path > 0;
+                    FramebufferFormat format = path == 2 ? FB_FORMAT_R8 : FB_FORMAT_RGBA8;
+                    GpuYuvReadbackResult r;
+                    engine.sync([&]() {
+                        r = runYuvReadback(gpu, layout, format, opt.frames, size.first, size.second);
+                    });
+                    bool pass = r.maxDiff <= kYuvReadbackTolerance;
+                    failed = failed || !pass;
+                    const char *pathName = !r.gpu ? "cpu" : r.format == FB_FORMAT_R8 ? "gpu_r8" : "gpu";
+                    fprintf(stderr, "yuv    %-6s %s %4dx%-4d %7.3f ms/frame  read %6.2f mb/frame  max diff %d  %s\n",
+                            pathName, yuvLayoutName(r.layout), r.width, r.height, r.msPerFrame,
+                            (double)r.bytesRead / 1024.0 / 1024.0, r.maxDiff, pass ? "pass" : "FAIL");
+                    root["yuv_readback"].push_back({{"path", pathName},
+                                                    {"format", yuvLayoutName(r.layout)},
+                                                    {"width", r.width},
+                                                    {"height", r.height},
+                                                    {"frames", r.frames},
+                                                    {"ms_per_frame", r.msPerFrame},
+                                                    {"bytes_read", r.bytesRead},
+                                                    {"max_diff", r.maxDiff},
+                                                    {"tolerance", kYuvReadbackTolerance},
+                                                    {"pass", pass}});
+                }
+            }
+        }
+    }
+
+    // 单次绘制的 CPU 开销: glUniform / uniform block, 参数不变 / 每次都变
+    root["draw_calls"] = nlohmann::json::array();
+    if (!opt.skipPerf && opt.drawCalls > 0) {
+        for (int block = 0; block < 2; ++block) {
+            for (int animate = 0; animate < 2; ++animate) {
+                GpuDrawCallResult r;
+                engine.sync([&]() { r = runDrawCalls(block == 1, animate == 1, opt.drawCalls); });
+                fprintf(stderr, "draw   color_adjust ubo=%d animate=%d  cpu %7.2f us/draw  gl calls %5.1f  uniforms %5.1f"
+                                "  blocks %4.2f\n",
+                        block, animate, r.cpuUsPerDraw, r.glCallsPerDraw, r.uniformUploadsPerDraw,
+                        r.blockUploadsPerDraw);
+                root["draw_calls"].push_back({{"filter", "color_adjust"},
+                                              {"uniform_block", r.uniformBlock},
+                                              {"animate", r.animate},
+                                              {"draws", r.draws},
+                                              {"cpu_us_per_draw", r.cpuUsPerDraw},
+                                              {"gl_calls_per_draw", r.glCallsPerDraw},
+                                              {"uniform_uploads_per_draw", r.uniformUploadsPerDraw},
+                                              {"uniform_skips_per_draw", r.uniformSkipsPerDraw},
+                                              {"block_uploads_per_draw", r.blockUploadsPerDraw}});
+            }
+        }
+    }
+    engine.destroy();
+
+    // 冷启动首帧, 有无预编译交替运行取中位数, 减少驱动内部缓存带来的顺序偏差
+    root["startup"] = nlohmann::json::array();
+    if (opt.startupRuns > 0 && !opt.sizes.empty()) {
+        GpuInput input;
+        input.generate(opt.sizes.back().first, opt.sizes.back().second);
+        std::vector<GpuStartupResult> results[2];
+        for (int i = 0; i < opt.startupRuns; ++i) {
+            for (int warm = 0; warm < 2; ++warm) {
+                bool w = (i % 2 == 0) == (warm == 0);
+                results[w ? 1 : 0].push_back(runStartup(opt.eglMode, w, input));
+            }
+        }
+        for (int warm = 0; warm < 2; ++warm) {
+            auto &v = results[warm];
+            auto median = [&v](double GpuStartupResult::*field) {
+                std::vector<double> values;
+                for (auto &r : v) {
+                    values.push_back(r.*field);
+                }
+                std::sort(values.begin(), values.end());
+                return values[values.size() / 2];
+            };
+            nlohmann::json r = {
+                {"warm_up", warm == 1},
+                {"width", input.width},
+                {"height", input.height},
+                {"runs", v.size()},
+                {"first_frame_ms", median(&GpuStartupResult::firstFrameMs)},
+                {"full_frame_ms", median(&GpuStartupResult::fullFrameMs)},
+                {"full_frame_render_ms", median(&GpuStartupResult::fullFrameRenderMs)},
+                {"passthrough_frames", v[v.size() / 2].passthroughFrames},
+            };
+            fprintf(stderr, "startup warm_up=%d %4dx%-4d first frame %8.3f ms  full frame %8.3f ms  render %8.3f ms\n",
+                    warm, input.width, input.height, r["first_frame_ms"].get<double>(),
+                    r["full_frame_ms"].get<double>(), r["full_frame_render_ms"].get<double>());
+            root["startup"].push_back(r);
+        }
+    }
+
+    GLProgramCacheStat cache = GLProgramCache::instance().stat();
+    root["context"]["program_cache"] = {{"dir", opt.programCacheDir}, {"hits", cache.hits}, {"misses", cache.misses},
+                                        {"rejects", cache.rejects}, {"compile_ms", cache.compileMs},
+                                        {"load_ms", cache.loadMs}, {"saved_ms", cache.savedMs}};
+    fprintf(stderr, "program cache: %lld hits, %lld misses, %lld rejects, compile %.2f ms, load %.2f ms, saved %.2f ms\n",
+            (long long)cache.hits, (long long)cache.misses, (long long)cache.rejects, cache.compileMs, cache.loadMs,
+            cache.savedMs);
+
+    std::string str = root.dump(2);
+    if (opt.out.empty()) {
+        std::cout << str << std::endl;
+    } else {
+        std::ofstream os(opt.out);
+        os << str << std::endl;
+    }
+    return failed ? 2 : 0;
+}
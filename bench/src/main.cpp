@@ -0,0 +1,187 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "Bench.h"
+
+#include "common/Log.h"
+#include <nlohmann/json.hpp>
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace znative;
+
+struct BenchOptions {
+    std::string filter;
+    std::string out;
+    std::string log;
+    int minTimeMs = 200;
+    int repetitions = 3;
+    bool list = false;
+};
+
+static void printUsage() {
+    fprintf(stderr, "usage: znative-bench [--filter=<substr>] [--min-time-ms=200] [--repetitions=3]\n"
+                    "                     [--out=<file.json>] [--log=<file>] [--list]\n");
+}
+
+static bool parseArgs(int argc, char **argv, BenchOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char *key) -> const char * {
+            size_t len = strlen(key);
+            if (arg.compare(0, len, key) == 0 && arg.size() > len && arg[len] == '=') {
+                return arg.c_str() + len + 1;
+            }
+            return nullptr;
+        };
+
+        const char *v;
+        if ((v = value("--filter"))) {
+            opt.filter = v;
+        } else if ((v = value("--out"))) {
+            opt.out = v;
+        } else if ((v = value("--log"))) {
+            opt.log = v;
+        } else if ((v = value("--min-time-ms"))) {
+            opt.minTimeMs = std::max(1, atoi(v));
+        } else if ((v = value("--repetitions"))) {
+            opt.repetitions = std::max(1, atoi(v));
+        } else if (arg == "--list") {
+            opt.list = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string nowStr() {
+    time_t t = time(nullptr);
+    char buf[64] = {0};
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    return buf;
+}
+
+/**
+ * 先用 1 次迭代估算单次耗时, 再把迭代次数放大到至少跑 minTimeMs, 重复 repetitions 次取中位数
+ */
+static nlohmann::json runCase(const BenchCase &c, const BenchOptions &opt) {
+    nlohmann::json result;
+    result["name"] = c.name;
+
+    int64_t iterations = 1;
+    int64_t minNs = (int64_t)opt.minTimeMs * 1000000;
+    while (true) {
+        BenchState state(iterations);
+        c.func(state);
+        if (!state.skipReason().empty()) {
+            result["skipped"] = state.skipReason();
+            return result;
+        }
+        if (state.elapsedNs() >= minNs / 10 || iterations >= 1000000000) {
+            double perOp = std::max<double>(1.0, (double)state.elapsedNs() / (double)iterations);
+            iterations = std::max<int64_t>(1, (int64_t)((double)minNs / perOp));
+            break;
+        }
+        iterations *= 10;
+    }
+
+    std::vector<double> samples;
+    int64_t bytesPerOp = 0;
+    int64_t itemsPerOp = 0;
+    for (int r = 0; r < opt.repetitions; ++r) {
+        BenchState state(iterations);
+        c.func(state);
+        samples.push_back((double)state.elapsedNs() / (double)iterations);
+        bytesPerOp = state.bytesPerOp();
+        itemsPerOp = state.itemsPerOp();
+    }
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+
+    result["iterations"] = iterations;
+    result["repetitions"] = opt.repetitions;
+    result["ns_per_op"] = median;
+    result["ns_per_op_min"] = samples.front();
+    result["ns_per_op_max"] = samples.back();
+    if (bytesPerOp > 0) {
+        result["bytes_per_second"] = (double)bytesPerOp * 1e9 / median;
+    }
+    if (itemsPerOp > 0) {
+        result["items_per_second"] = (double)itemsPerOp * 1e9 / median;
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+
+    const auto &cases = BenchRegistry::instance().cases();
+    if (opt.list) {
+        for (auto &c : cases) {
+            printf("%s\n", c.name.c_str());
+        }
+        return 0;
+    }
+
+    // 日志默认输出到 stdout, 结果写到 stdout 时把日志重定向, 保证输出是合法的 json
+    if (!opt.log.empty()) {
+        setLogFile(opt.log.c_str());
+    } else if (opt.out.empty()) {
+#ifdef _WIN32
+        setLogFile("NUL");
+#else
+        setLogFile("/dev/null");
+#endif
+    }
+
+    nlohmann::json root;
+    root["context"] = {
+        {"date", nowStr()},
+        {"num_cpus", std::thread::hardware_concurrency()},
+#ifdef NDEBUG
+        {"build_type", "release"},
+#else
+        {"build_type", "debug"},
+#endif
+        {"min_time_ms", opt.minTimeMs},
+        {"repetitions", opt.repetitions},
+    };
+    root["benchmarks"] = nlohmann::json::array();
+
+    for (auto &c : cases) {
+        if (!opt.filter.empty() && c.name.find(opt.filter) == std::string::npos) {
+            continue;
+        }
+        nlohmann::json r = runCase(c, opt);
+        if (r.contains("skipped")) {
+            fprintf(stderr, "%-40s skipped: %s\n", c.name.c_str(), r["skipped"].get<std::string>().c_str());
+        } else {
+            fprintf(stderr, "%-40s %14.1f ns/op %12lld iterations\n", c.name.c_str(), r["ns_per_op"].get<double>(),
+                    (long long)r["iterations"].get<int64_t>());
+        }
+        root["benchmarks"].push_back(r);
+    }
+
+    std::string str = root.dump(2);
+    if (opt.out.empty()) {
+        std::cout << str << std::endl;
+    } else {
+        std::ofstream os(opt.out);
+        if (!os) {
+            fprintf(stderr, "failed to open %s\n", opt.out.c_str());
+            return 1;
+        }
+        os << str << std::endl;
+    }
+    return 0;
+}
@@ -1,3 +1,19 @@
+# Linux 上默认使用桌面 OpenGL, 开启 ZNATIVE_LINUX_EGL_ENABLE 之后改为 EGL + GLES3,
+# EGLCtx/GLEngine 以及 headless gpu bench 都需要 EGL, 找到 EGL 和 GLES3 头文件时默认开启
+find_path(ZNATIVE_EGL_INCLUDE_DIR EGL/egl.h)
+find_path(ZNATIVE_GLES3_INCLUDE_DIR GLES3/gl3.h)
+if (ZNATIVE_EGL_INCLUDE_DIR AND ZNATIVE_GLES3_INCLUDE_DIR)
+    option(ZNATIVE_LINUX_EGL_ENABLE "Use EGL/GLES3 instead of desktop OpenGL" ON)
+else ()
+    option(ZNATIVE_LINUX_EGL_ENABLE "Use EGL/GLES3 instead of desktop OpenGL" OFF)
+endif ()
+
+if (ZNATIVE_ENABLE_GL AND ZNATIVE_LINUX_EGL_ENABLE)
+    message(STATUS "Linux use EGL/GLES3")
+    set(ALL_DEFINITIONS ${ALL_DEFINITIONS} "-D__ZNATIVE_WITH_EGL__")
+    set(PLATFORM_LIBS EGL GLESv2)
+endif ()
+
 set(PLATFORM_SOURCES
         ${PLATFORM_SOURCES}
 )
@@ -2,18 +2,29 @@ set(LOCAL_SAMPLE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/samples/local)
 set(SAMPLE_LIBS_DIR ${LOCAL_SAMPLE_DIR}/libs)
 set(SAMPLE_SRC_DIR ${LOCAL_SAMPLE_DIR}/src)
 
-set(GLFW_INSTALL OFF)
-set(GLFW_BUILD_DOCS OFF)
-set(GLFW_BUILD_TESTS OFF)
-add_subdirectory(${SAMPLE_LIBS_DIR}/glfw-3.4)
-set(SAMPLE_LIBS glfw)
-
+# 先检查 libusb, 缺少时在添加 glfw 之前跳过 sample
 set(LIBUSB_DIR ${SAMPLE_LIBS_DIR}/libusb-1.0.27)
 if(WIN32)
     set(LIBUSB ${LIBUSB_DIR}/libs/${ZPLATFORM}/${ZTARGET_ARCH}/libusb-1.0.lib)
 else()
     set(LIBUSB ${LIBUSB_DIR}/libs/${ZPLATFORM}/${ZTARGET_ARCH}/libusb-1.0.a)
 endif()
+if (NOT EXISTS ${LIBUSB})
+    # 只有 win32 和 macos 的预编译库, 其他平台使用系统安装的 libusb-1.0
+    find_library(LIBUSB_SYSTEM NAMES usb-1.0)
+    if (NOT LIBUSB_SYSTEM)
+        message(WARNING "libusb-1.0 not found for ${ZPLATFORM}/${ZTARGET_ARCH}, skip local sample")
+        return()
+    endif ()
+    set(LIBUSB ${LIBUSB_SYSTEM})
+endif ()
+
+set(GLFW_INSTALL OFF)
+set(GLFW_BUILD_DOCS OFF)
+set(GLFW_BUILD_TESTS OFF)
+add_subdirectory(${SAMPLE_LIBS_DIR}/glfw-3.4)
+set(SAMPLE_LIBS glfw)
+
 set(SAMPLE_LIBS ${SAMPLE_LIBS} ${LIBUSB})
 
 if (WIN32)
@@ -8,7 +8,7 @@
 #include "common/gles/Texture.h"
 #include "common/gles/filter/TextureFilter.h"
 #include "common/gles/filter/SharpenFilter.h"
-#include "common/gles/FramebufferPool.h"
+#include "common/gles/RenderGraph.h"
 #include "common/AppContext.h"
 #include "common/gles/filter/ColorAdjustFilter.h"
 
@@ -39,7 +39,10 @@ TextureFilter texFilter;
 SharpenFilter sharpenFilter;
 ColorAdjustFilter colorAdjustFilter;
 
-FramebufferPool framebufferPool;
+RenderGraph renderGraph("GLTestWindow");
+RenderGraph::ResId graphSource = RenderGraph::INVALID_RES;
+RenderGraph::ResId graphSharpen = RenderGraph::INVALID_RES;
+RenderGraph::ResId graphOutput = RenderGraph::INVALID_RES;
 
 ImageTexture imageTexture;
 GLRect vertexRect;
@@ -59,45 +62,41 @@ void GLTestWindow::onPreRender(int viewWidth, int viewHeight) {
 
     Texture2D &tex = imageTexture.textureNonnull();
 
-    FramebufferRef outputFb;
-    if (guiVars.enable_sharpen) {
-        auto sharpenFb= framebufferPool.obtain(tex.width(), tex.height());
-        // sharpen filter
-        sharpenFilter.setFullVertexCoord().setFullTextureCoord();
-        sharpenFilter.viewport()
-                .set(sharpenFb->texWidth(), sharpenFb->texHeight());
-        sharpenFilter.inputTexture(tex);
-        sharpenFilter.setStrength(guiVars.sharpen_strength);
-        sharpenFilter.setResolution((float) tex.width()/2.f, (float) tex.height()/2.f);
-        sharpenFilter.render(sharpenFb.get());
-
-        outputFb = sharpenFb;
+    if (graphOutput == RenderGraph::INVALID_RES) {
+        // 锐化 -> 调色, 关闭的 pass 直接透传输入, 中间结果由 RenderGraph 分配和复用
+        graphSource = renderGraph.importTexture("image");
+        graphSharpen = renderGraph.addPass("sharpen", &sharpenFilter, {graphSource},
+            [](const std::vector<const Texture2D *> &in, int w, int h) {
+                sharpenFilter.setFullVertexCoord().setFullTextureCoord();
+                sharpenFilter.viewport().set(w, h);
+                sharpenFilter.inputTexture((int)in[0]->id());
+                sharpenFilter.setStrength(guiVars.sharpen_strength);
+                sharpenFilter.setResolution((float) in[0]->width()/2.f, (float) in[0]->height()/2.f);
+            });
+        graphOutput = renderGraph.addPass("color_adjust", &colorAdjustFilter, {graphSharpen},
+            [](const std::vector<const Texture2D *> &in, int w, int h) {
+                colorAdjustFilter.setFullVertexCoord().setFullTextureCoord();
+                colorAdjustFilter.viewport().set(w, h);
+                colorAdjustFilter.inputTexture((int)in[0]->id());
+                colorAdjustFilter.setBrightness(guiVars.brightness_strength);
+                colorAdjustFilter.setContrast(guiVars.contrast_strength);
+                colorAdjustFilter.setSaturation(guiVars.saturation_strength);
+                colorAdjustFilter.setWhiteBalanceTemperature(guiVars.wb_temperature_strength);
+                colorAdjustFilter.setWhiteBalanceTint(guiVars.wb_tint_strength);
+                colorAdjustFilter.setExposure(guiVars.exposure_strength);
+                colorAdjustFilter.setHighlights(guiVars.highlights_strength);
+                colorAdjustFilter.setShadows(guiVars.shadows_strength);
+                colorAdjustFilter.setFilmGrain(guiVars.film_grain_strength);
+            });
+        renderGraph.setOutput(graphOutput);
     }
+    renderGraph.setPassEnabled(graphSharpen, guiVars.enable_sharpen);
+    renderGraph.setPassEnabled(graphOutput, guiVars.enable_color_adjust);
+    renderGraph.setImport(graphSource, &tex);
+    renderGraph.execute();
 
-    if (guiVars.enable_color_adjust) {
-        const Texture2D &inTex = outputFb.get() == nullptr ? tex : outputFb->textureNonnull();
-
-        auto colorFb = framebufferPool.obtain(inTex.width(), inTex.height());
-        // color adjust filter
-        colorAdjustFilter.setFullVertexCoord().setFullTextureCoord();
-        colorAdjustFilter.viewport()
-                .set(colorFb->texWidth(), colorFb->texHeight());
-        colorAdjustFilter.inputTexture((int)inTex.id());
-        colorAdjustFilter.setBrightness(guiVars.brightness_strength);
-        colorAdjustFilter.setContrast(guiVars.contrast_strength);
-        colorAdjustFilter.setSaturation(guiVars.saturation_strength);
-        colorAdjustFilter.setWhiteBalanceTemperature(guiVars.wb_temperature_strength);
-        colorAdjustFilter.setWhiteBalanceTint(guiVars.wb_tint_strength);
-        colorAdjustFilter.setExposure(guiVars.exposure_strength);
-        colorAdjustFilter.setHighlights(guiVars.highlights_strength);
-        colorAdjustFilter.setShadows(guiVars.shadows_strength);
-        colorAdjustFilter.setFilmGrain(guiVars.film_grain_strength);
-        colorAdjustFilter.render(colorFb.get());
-
-        outputFb = colorFb;
-    }
-
-    const Texture2D &finalTex = outputFb.get() == nullptr ? tex : outputFb->textureNonnull();
+    const Texture2D *graphTex = renderGraph.outputTexture(graphOutput);
+    const Texture2D &finalTex = graphTex == nullptr ? tex : *graphTex;
     // 最后渲染到屏幕
     vertexRect = GLRect::fitCenter((float) finalTex.width(), (float) finalTex.height(),
                                    (float) viewWidth, (float) viewHeight);
@@ -162,5 +161,5 @@ void GLTestWindow::onAppExit() {
     texFilter.release();
     sharpenFilter.release();
     colorAdjustFilter.release();
-    framebufferPool.release();
+    renderGraph.release();
 }
\ No newline at end of file
@@ -5,29 +5,167 @@
 // please include "napi/native_api.h".
 
 #include "EGLCtx.h"
+#include "common/gles/FramebufferPool.h"
+#include "common/gles/GLResTracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
 
 #ifdef EGL_VERSION_1_0
 
 NAMESPACE_DEFAULT
 
-EGLCtx::EGLCtx(const char *name, int version) : m_name(name), m_gl_version(version) {
+namespace {
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef EGLDisplay (*GetPlatformDisplayFunc)(EGLenum platform, void *nativeDisplay, const EGLint *attribList);
+
+bool hasExtension(const char *extensions, const char *name) {
+    if (extensions == nullptr) {
+        return false;
+    }
+    size_t len = strlen(name);
+    for (const char *p = extensions; (p = strstr(p, name)) != nullptr; p += len) {
+        if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 进程内所有 context 共用 EGLDisplay, 最后一个 context 销毁时才 eglTerminate.
+ * 同一个 native display 得到的 EGLDisplay 是同一个, 各自 eglTerminate 会让其他 context 失效.
+ * 引用计数按 EGLDisplay 句柄统计: 没有 surfaceless 平台时离屏 context 回退到默认 display, 与窗口 context 共用一个计数
+ */
+class EGLDisplayPool {
+public:
+    static EGLDisplayPool &instance() {
+        static EGLDisplayPool pool;
+        return pool;
+    }
+
+    EGLDisplay acquire(bool offscreen, int &major, int &minor) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EGLDisplay display = offscreen ? getSurfacelessDisplay() : EGL_NO_DISPLAY;
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        _ERROR_RETURN_IF(display == EGL_NO_DISPLAY, EGL_NO_DISPLAY, "EGLCtx: Unable to get egl display")
+        Entry &entry = m_entries[display];
+        if (entry.refs == 0) {
+            if (eglInitialize(display, &entry.major, &entry.minor) != EGL_TRUE) {
+                _ERROR("EGLCtx: Unable to initialize egl display: %d", eglGetError());
+                m_entries.erase(display);
+                return EGL_NO_DISPLAY;
+            }
+            _INFO("EGLCtx: initialize egl display: %p, offscreen: %d, version: %d.%d", display, offscreen,
+                  entry.major, entry.minor);
+        }
+        entry.refs += 1;
+        major = entry.major;
+        minor = entry.minor;
+        return display;
+    }
+
+    void release(EGLDisplay display) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(display);
+        _WARN_RETURN_IF(it == m_entries.end(), void(), "EGLCtx: release unknown display: %p", display)
+        it->second.refs -= 1;
+        if (it->second.refs == 0) {
+            if (!eglTerminate(display)) {
+                _WARN("EGLCtx: destroy display failed = %d", eglGetError());
+            }
+            _INFO("EGLCtx: terminate egl display: %p", display);
+            m_entries.erase(it);
+        }
+    }
+
+private:
+    /**
+     * mesa 的 surfaceless 平台不需要 X11/Wayland/GBM, 没有时使用默认 display
+     */
+    static EGLDisplay getSurfacelessDisplay() {
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (!hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") ||
+            !hasExtension(clientExtensions, "EGL_EXT_platform_base")) {
+            return EGL_NO_DISPLAY;
+        }
+        auto getPlatformDisplay = (GetPlatformDisplayFunc)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay == nullptr) {
+            return EGL_NO_DISPLAY;
+        }
+        return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+private:
+    struct Entry {
+        int major = 0, minor = 0;
+        int refs = 0;
+    };
+
+    std::mutex m_mutex;
+    std::map<EGLDisplay, Entry> m_entries;
+};
+
+} // namespace
+
+bool EGLCtx::hasExtension(EGLDisplay display, const char *name) {
+    return DEFAULT_NAMESPACE::hasExtension(eglQueryString(display, EGL_EXTENSIONS), name);
+}
+
+EGLCtx::EGLCtx(const char *name, int version, EGLSurfaceMode mode)
+        : m_name(name), m_gl_version(version), m_mode(mode) {
     initialize(version, nullptr);
 }
 
-EGLCtx::EGLCtx(const char *name, EGLCtx &shared) : m_name(name), m_gl_version(shared.m_gl_version) {
+EGLCtx::EGLCtx(const char *name, EGLCtx &shared)
+        : m_name(name), m_gl_version(shared.m_gl_version), m_mode(shared.m_mode) {
+    m_res_group = shared.m_res_group;
     initialize(shared.m_gl_version, shared.m_context);
 }
 
 void EGLCtx::initialize(int version, EGLContext sharedCtx) {
-    m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    _FATAL_IF(m_display == EGL_NO_DISPLAY, "EGLCtx: Unable to get egl display")
+    m_display = EGLDisplayPool::instance().acquire(m_mode != SURFACE_WINDOW, m_major, m_minor);
+    _FATAL_IF(m_display == EGL_NO_DISPLAY, "EGLCtx: Unable to initialize egl display")
 
-    EGLBoolean result = eglInitialize(m_display, &m_major, &m_minor);
-    _FATAL_IF(result != EGL_TRUE, "EGLCtx: Unable to initialize egl display")
+    m_surfaceless_supported = hasExtension(m_display, "EGL_KHR_surfaceless_context");
+    bool result = chooseConfig(version);
+    _FATAL_IF(!result, "EGLCtx: Unable to choose config, version: %d, mode: %d", version, m_mode)
+
+    /* Create EGLContext from */
+    int attrib_list[] = {EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE};
+
+    m_context = eglCreateContext(m_display, m_configs, sharedCtx, attrib_list);
+    _FATAL_IF(m_context == EGL_NO_CONTEXT, "EGLCtx: Unable to create egl context, version: %d", version)
+
+    if (m_res_group == nullptr) {
+        m_res_group = m_context;
+    }
+    GLResTracker::instance().attachGroup(m_res_group);
+
+    _INFO("create (%s) egl context success! context: %p, version: %d, shared ctx: %p, mode: %d, surfaceless: %d",
+          m_name, m_context, version, sharedCtx, m_mode, m_surfaceless_supported);
+}
+
+bool EGLCtx::chooseConfig(int version) {
+    // 不支持 surfaceless 时, 没有 surface 的情况需要用 pbuffer 代替
+    int surfaceType = m_surfaceless_supported ? 0 : EGL_PBUFFER_BIT;
+    if (m_mode == SURFACE_WINDOW) {
+        surfaceType |= EGL_WINDOW_BIT;
+    } else if (m_mode == SURFACE_PBUFFER) {
+        surfaceType |= EGL_PBUFFER_BIT;
+    }
 
     int renderType = version == 2 ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_ES3_BIT;
     int attribList[] = {
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+            EGL_SURFACE_TYPE, surfaceType,
             EGL_RED_SIZE, 8,
             EGL_GREEN_SIZE, 8,
             EGL_BLUE_SIZE, 8,
@@ -36,16 +174,13 @@ void EGLCtx::initialize(int version, EGLContext sharedCtx) {
             EGL_NONE
     };
 
-    result = eglChooseConfig(m_display, attribList, &m_configs, 1, &m_configs_size);
-    _FATAL_IF(result != EGL_TRUE, "EGLCtx: Unable to choose config, version: %d", version)
-
-    /* Create EGLContext from */
-    int attrib_list[] = {EGL_CONTEXT_CLIENT_VERSION, version, EGL_NONE};
-
-    m_context = eglCreateContext(m_display, m_configs, sharedCtx, attrib_list);
-    _FATAL_IF(m_context == EGL_NO_CONTEXT, "EGLCtx: Unable to create egl context, version: %d", version)
-
-    _INFO("create (%s) egl context success! context: %p, version: %d, shared ctx: %p", m_name, m_context, version, sharedCtx);
+    EGLBoolean result = eglChooseConfig(m_display, attribList, &m_configs, 1, &m_configs_size);
+    if ((result != EGL_TRUE || m_configs_size == 0) && m_mode == SURFACE_WINDOW && !m_surfaceless_supported) {
+        // 部分设备没有同时支持 window 和 pbuffer 的 config
+        attribList[1] = EGL_WINDOW_BIT;
+        result = eglChooseConfig(m_display, attribList, &m_configs, 1, &m_configs_size);
+    }
+    return result == EGL_TRUE && m_configs_size > 0;
 }
 
 EGLCtx::~EGLCtx() {
@@ -53,23 +188,22 @@ EGLCtx::~EGLCtx() {
 }
 
 bool EGLCtx::makeCurrent(void *window) {
-    if (m_surface != EGL_NO_SURFACE && m_surface_window == window) {
-        return true;
-    }
-    if (m_surface != EGL_NO_SURFACE) {
-        _INFO("destroy egl surface: %p", window);
-        if (!eglDestroySurface(m_display, m_surface)) {
-            _WARN("EGLCtx: destroy egl surface failed: %d", eglGetError());
+    GLResTracker::setCurrentGroup(m_res_group);
+    if (m_mode != SURFACE_WINDOW) {
+        _WARN_IF(window != nullptr, "EGLCtx(%s): offscreen mode(%d) ignore window: %p", m_name, m_mode, window);
+        if (m_mode == SURFACE_PBUFFER) {
+            return makeCurrentPbuffer(std::max(m_pbuffer_width, 1), std::max(m_pbuffer_height, 1));
         }
-        m_surface = EGL_NO_SURFACE;
+        return makeCurrentNoSurface();
     }
     if (window == nullptr) {
-        m_surface_window = nullptr;
-        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context);
-        _INFO("EGLCtx: makeCurrent on NO SURFACE");
+        return makeCurrentNoSurface();
+    }
+    if (m_surface != EGL_NO_SURFACE && m_surface_window == window) {
         return true;
     }
-    
+    destroySurface();
+
     auto eglWindow = reinterpret_cast<EGLNativeWindowType>(window);
     
     // 此处启用SRGB模式会导致颜色发白
@@ -80,8 +214,7 @@ bool EGLCtx::makeCurrent(void *window) {
 
     if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
         _WARN("EGLCtx: eglMakeCurrent error: %d", eglGetError());
-        eglDestroySurface(m_display, m_surface);
-        m_surface = EGL_NO_SURFACE;
+        destroySurface();
         return false;
     }
     m_surface_window = window;
@@ -89,8 +222,73 @@ bool EGLCtx::makeCurrent(void *window) {
     return true;
 }
 
+bool EGLCtx::makeCurrentPbuffer(int width, int height) {
+    _ERROR_RETURN_IF(m_mode != SURFACE_PBUFFER, false, "EGLCtx(%s): makeCurrentPbuffer in mode: %d", m_name, m_mode)
+    _ERROR_RETURN_IF(width <= 0 || height <= 0, false, "EGLCtx(%s): invalid pbuffer size(%d x %d)", m_name, width, height)
+
+    GLResTracker::setCurrentGroup(m_res_group);
+    if (m_surface != EGL_NO_SURFACE && m_pbuffer_width == width && m_pbuffer_height == height) {
+        return true;
+    }
+    destroySurface();
+
+    EGLint attribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    m_surface = eglCreatePbufferSurface(m_display, m_configs, attribs);
+    _ERROR_RETURN_IF(m_surface == EGL_NO_SURFACE, false, "EGLCtx: Unable to create pbuffer surface: %d", eglGetError())
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        _WARN("EGLCtx: eglMakeCurrent error: %d", eglGetError());
+        destroySurface();
+        return false;
+    }
+    m_pbuffer_width = width;
+    m_pbuffer_height = height;
+    _INFO("EGLCtx: makeCurrent on pbuffer(%d x %d)", width, height);
+    return true;
+}
+
+bool EGLCtx::makeCurrentNoSurface() {
+    if (m_surfaceless_supported) {
+        destroySurface();
+        if (!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+            _WARN("EGLCtx: eglMakeCurrent on NO SURFACE error: %d", eglGetError());
+            return false;
+        }
+        _INFO("EGLCtx: makeCurrent on NO SURFACE");
+        return true;
+    }
+
+    if (!m_dummy_surface) {
+        destroySurface();
+        EGLint attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        m_surface = eglCreatePbufferSurface(m_display, m_configs, attribs);
+        _ERROR_RETURN_IF(m_surface == EGL_NO_SURFACE, false, "EGLCtx: Unable to create dummy pbuffer: %d", eglGetError())
+        m_dummy_surface = true;
+    }
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        _WARN("EGLCtx: eglMakeCurrent on dummy pbuffer error: %d", eglGetError());
+        destroySurface();
+        return false;
+    }
+    _INFO("EGLCtx: makeCurrent on dummy pbuffer");
+    return true;
+}
+
+void EGLCtx::destroySurface() {
+    if (m_surface == EGL_NO_SURFACE) {
+        return;
+    }
+    _INFO("destroy egl surface: %p, window: %p", m_surface, m_surface_window);
+    if (!eglDestroySurface(m_display, m_surface)) {
+        _WARN("EGLCtx: destroy egl surface failed: %d", eglGetError());
+    }
+    m_surface = EGL_NO_SURFACE;
+    m_surface_window = nullptr;
+    m_dummy_surface = false;
+}
+
 bool EGLCtx::swapBuffers() {
-    _ERROR_RETURN_IF(m_surface == EGL_NO_SURFACE, false, "EGLCtx: eglSwapBuffers error: NO_SURFACE")
+    _ERROR_RETURN_IF(!isRenderable(), false, "EGLCtx: eglSwapBuffers error: NO_SURFACE")
     
     if (!eglSwapBuffers(m_display, m_surface)) {
         _WARN("EGLCtx: eglSwapBuffers error: %d", eglGetError());
@@ -99,7 +297,72 @@ bool EGLCtx::swapBuffers() {
     return true;
 }
 
-void EGLCtx::setPtNs(int64_t ptNs) {
+int EGLCtx::createOutputSurface(void *window, int width, int height) {
+    EGLSurface surface;
+    if (window != nullptr) {
+        EGLint winAttribs[] = {EGL_NONE};
+        surface = eglCreateWindowSurface(m_display, m_configs, reinterpret_cast<EGLNativeWindowType>(window), winAttribs);
+    } else {
+        _ERROR_RETURN_IF(width <= 0 || height <= 0, -1, "EGLCtx(%s): invalid output pbuffer size(%d x %d)", m_name,
+                         width, height)
+        EGLint attribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+        surface = eglCreatePbufferSurface(m_display, m_configs, attribs);
+    }
+    _ERROR_RETURN_IF(surface == EGL_NO_SURFACE, -1, "EGLCtx(%s): Unable to create output surface: %d, mode: %d", m_name,
+                     eglGetError(), m_mode)
+    int id = m_next_output_id++;
+    m_outputs[id] = surface;
+    _INFO("EGLCtx(%s): create output surface(%d): %p, window: %p", m_name, id, surface, window);
+    return id;
+}
+
+bool EGLCtx::makeCurrentOutput(int id) {
+    auto it = m_outputs.find(id);
+    _ERROR_RETURN_IF(it == m_outputs.end(), false, "EGLCtx(%s): output surface(%d) not found", m_name, id)
+    if (!eglMakeCurrent(m_display, it->second, it->second, m_context)) {
+        _WARN("EGLCtx: eglMakeCurrent on output(%d) error: %d", id, eglGetError());
+        return false;
+    }
+    return true;
+}
+
+bool EGLCtx::swapOutput(int id) {
+    auto it = m_outputs.find(id);
+    _ERROR_RETURN_IF(it == m_outputs.end(), false, "EGLCtx(%s): output surface(%d) not found", m_name, id)
+    if (!eglSwapBuffers(m_display, it->second)) {
+        _WARN("EGLCtx: eglSwapBuffers on output(%d) error: %d", id, eglGetError());
+        return false;
+    }
+    return true;
+}
+
+void EGLCtx::destroyOutputSurface(int id) {
+    auto it = m_outputs.find(id);
+    if (it == m_outputs.end()) {
+        return;
+    }
+    if (eglGetCurrentSurface(EGL_DRAW) == it->second) {
+        makeCurrentMain();
+    }
+    if (!eglDestroySurface(m_display, it->second)) {
+        _WARN("EGLCtx: destroy output surface(%d) failed: %d", id, eglGetError());
+    }
+    m_outputs.erase(it);
+    _INFO("EGLCtx(%s): destroy output surface(%d)", m_name, id);
+}
+
+bool EGLCtx::makeCurrentMain() {
+    if (m_surface == EGL_NO_SURFACE && !m_surfaceless_supported) {
+        return makeCurrentNoSurface();
+    }
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        _WARN("EGLCtx: eglMakeCurrent on main surface error: %d", eglGetError());
+        return false;
+    }
+    return true;
+}
+
+void EGLCtx::setPtNs(int64_t /*ptNs*/) {
     //PFNEGLPRESENTATIONTIMEANDROIDPROC(m_display, m_surface, ptNs);
 }
 
@@ -107,19 +370,25 @@ void EGLCtx::destroy() {
     if (m_context == EGL_NO_CONTEXT) {
         return;
     }
-    if (m_surface != EGL_NO_SURFACE) {
-        if (!eglDestroySurface(m_display, m_surface)) {
-            _WARN("EGLCtx: destroy egl surface failed: %d", eglGetError());
-        }
-        m_surface = EGL_NO_SURFACE;
+    // FramebufferPool 中属于这个 context 的 FBO 在解绑之前删除, 之后这个地址可能被新的 context 复用
+    FramebufferPool::onContextDestroy(m_context, eglGetCurrentContext() == m_context);
+    // 解除当前线程的绑定, 否则 context 和 surface 会延迟到线程退出才真正释放
+    if (eglGetCurrentContext() == m_context) {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
+    destroySurface();
+    for (auto &it : m_outputs) {
+        eglDestroySurface(m_display, it.second);
+    }
+    m_outputs.clear();
+    int leaks = GLResTracker::instance().detachGroup(m_res_group);
+    _WARN_IF(leaks > 0, "EGLCtx(%s): %d gl objects leaked", m_name, leaks);
+
     EGLContext ctx = m_context;
     if (!eglDestroyContext(m_display, m_context)) {
         _WARN("EGLCtx: destroy egl context failed: %d", eglGetError());
     }
-    if (!eglTerminate(m_display)) {
-        _WARN("EGLCtx: destroy display failed = %d", eglGetError());
-    }
+    EGLDisplayPool::instance().release(m_display);
     _INFO("EGLCtx(%s): destroyed: %p", m_name, ctx);
     m_context = EGL_NO_CONTEXT;
     m_display = EGL_NO_DISPLAY;
@@ -6,7 +6,7 @@
 
 #pragma once
 
-#if defined(__ANDROID__) || defined(__HARMONYOS__)
+#if defined(__ANDROID__) || defined(__HARMONYOS__) || defined(__ZNATIVE_WITH_EGL__)
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #endif
@@ -18,12 +18,27 @@
 #include "common/Log.h"
 
 #include <cstdint>
+#include <map>
 
 NAMESPACE_DEFAULT
 
+/**
+ * context 默认绘制的目标
+ * SURFACE_WINDOW: 绑定 native window, 没有 window 时以 no surface 方式 make current
+ * SURFACE_PBUFFER: 离屏的 pbuffer surface, 默认帧缓冲可以直接 glReadPixels
+ * SURFACE_SURFACELESS: 没有默认帧缓冲, 只能渲染到 FBO, 适合批处理/服务端渲染
+ *
+ * 离屏模式下优先使用 EGL_MESA_platform_surfaceless 的 display, 不依赖任何窗口系统
+ */
+enum EGLSurfaceMode {
+    SURFACE_WINDOW = 0,
+    SURFACE_PBUFFER,
+    SURFACE_SURFACELESS
+};
+
 class EGLCtx {
 public:
-    explicit EGLCtx(const char *name, int version = 3);
+    explicit EGLCtx(const char *name, int version = 3, EGLSurfaceMode mode = SURFACE_WINDOW);
 
     explicit EGLCtx(const char *name, EGLCtx &shared);
     
@@ -31,10 +46,17 @@ public:
 
 public:
     bool makeCurrent(void *window);
-    
+
+    /**
+     * 仅 SURFACE_PBUFFER 模式可用, 尺寸变化时重建 pbuffer
+     */
+    bool makeCurrentPbuffer(int width, int height);
+
     inline int version() const { return m_gl_version;}
+
+    inline EGLSurfaceMode mode() const { return m_mode; }
     
-    inline bool isRenderable() const { return m_surface != EGL_NO_SURFACE; }
+    inline bool isRenderable() const { return m_surface != EGL_NO_SURFACE && !m_dummy_surface; }
     
     bool swapBuffers();
     
@@ -42,12 +64,43 @@ public:
 
     void destroy();
 
+    /**
+     * 额外的输出 surface, 与主 surface 共用 context 和 config, 渲染一次之后依次 make current 到每个 surface 绘制.
+     * window 为 nullptr 时创建 width x height 的 pbuffer (需要 SURFACE_PBUFFER 模式的 config),
+     * 否则创建 window surface (需要 SURFACE_WINDOW 模式的 config)
+     * @return 输出 id, 失败时返回 -1
+     */
+    int createOutputSurface(void *window, int width, int height);
+
+    bool makeCurrentOutput(int id);
+
+    bool swapOutput(int id);
+
+    void destroyOutputSurface(int id);
+
+    /**
+     * 绘制完输出 surface 之后回到主 surface (或者 no surface)
+     */
+    bool makeCurrentMain();
+
+    /**
+     * display 为 EGL_NO_DISPLAY 时查询 client extension
+     */
+    static bool hasExtension(EGLDisplay display, const char *name);
+
 private:
     void initialize(int version, EGLContext sharedCtx);
 
+    bool chooseConfig(int version);
+
+    bool makeCurrentNoSurface();
+
+    void destroySurface();
+
 private:
     const std::string m_name;
     const int m_gl_version;
+    const EGLSurfaceMode m_mode;
 
     EGLDisplay m_display = EGL_NO_DISPLAY;
     int m_major = 0, m_minor = 0;
@@ -55,10 +108,21 @@ private:
     EGLConfig m_configs = nullptr;
     int m_configs_size = 0;
 
+    // 不支持 EGL_KHR_surfaceless_context 时用 1x1 的 pbuffer 代替 no surface
+    bool m_surfaceless_supported = false;
+
     EGLContext m_context = EGL_NO_CONTEXT;
+    // share group 的根 context, 用于 GL 对象统计
+    const void *m_res_group = nullptr;
     
     void *m_surface_window = nullptr;
+    int m_pbuffer_width = 0, m_pbuffer_height = 0;
     EGLSurface m_surface = EGL_NO_SURFACE;
+    // m_surface 是代替 no surface 的 1x1 pbuffer
+    bool m_dummy_surface = false;
+
+    std::map<int, EGLSurface> m_outputs;
+    int m_next_output_id = 0;
 };
 
 NAMESPACE_END
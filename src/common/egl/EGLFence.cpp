@@ -0,0 +1,168 @@
+//
+// Created on 2026/10/19.
+//
+
+#include "EGLFence.h"
+
+#ifdef EGL_VERSION_1_0
+
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+NAMESPACE_DEFAULT
+
+namespace {
+
+#ifndef EGL_SYNC_NATIVE_FENCE_ANDROID
+#define EGL_SYNC_NATIVE_FENCE_ANDROID 0x3144
+#define EGL_SYNC_NATIVE_FENCE_FD_ANDROID 0x3145
+#define EGL_NO_NATIVE_FENCE_FD_ANDROID (-1)
+#endif
+
+typedef EGLSyncKHR (*CreateSyncFunc)(EGLDisplay dpy, EGLenum type, const EGLint *attribList);
+typedef EGLBoolean (*DestroySyncFunc)(EGLDisplay dpy, EGLSyncKHR sync);
+typedef EGLint (*ClientWaitSyncFunc)(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeKHR timeout);
+typedef EGLint (*WaitSyncFunc)(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags);
+typedef EGLint (*DupNativeFenceFDFunc)(EGLDisplay dpy, EGLSyncKHR sync);
+
+/**
+ * 扩展函数在 Android/HarmonyOS 的头文件中不一定有声明, 统一通过 eglGetProcAddress 获取
+ */
+struct EGLSyncFuncs {
+    CreateSyncFunc createSync = nullptr;
+    DestroySyncFunc destroySync = nullptr;
+    ClientWaitSyncFunc clientWaitSync = nullptr;
+    WaitSyncFunc waitSync = nullptr;
+    DupNativeFenceFDFunc dupNativeFenceFD = nullptr;
+
+    EGLSyncFuncs() {
+        createSync = (CreateSyncFunc)eglGetProcAddress("eglCreateSyncKHR");
+        destroySync = (DestroySyncFunc)eglGetProcAddress("eglDestroySyncKHR");
+        clientWaitSync = (ClientWaitSyncFunc)eglGetProcAddress("eglClientWaitSyncKHR");
+        waitSync = (WaitSyncFunc)eglGetProcAddress("eglWaitSyncKHR");
+        dupNativeFenceFD = (DupNativeFenceFDFunc)eglGetProcAddress("eglDupNativeFenceFDANDROID");
+    }
+};
+
+const EGLSyncFuncs &syncFuncs() {
+    static EGLSyncFuncs funcs;
+    return funcs;
+}
+
+} // namespace
+
+bool EGLFence::nativeSupported() {
+    EGLDisplay display = eglGetCurrentDisplay();
+    const EGLSyncFuncs &funcs = syncFuncs();
+    return display != EGL_NO_DISPLAY && funcs.createSync && funcs.destroySync && funcs.clientWaitSync &&
+           funcs.dupNativeFenceFD && EGLCtx::hasExtension(display, "EGL_ANDROID_native_fence_sync");
+}
+
+bool EGLFence::create(bool flush) {
+    release();
+    if (nativeSupported()) {
+        m_display = eglGetCurrentDisplay();
+        EGLint attribs[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID, EGL_NONE};
+        m_egl_sync = syncFuncs().createSync(m_display, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+        if (m_egl_sync != EGL_NO_SYNC_KHR) {
+            if (flush) {
+                glFlush();
+            }
+            m_egl_flushed = flush;
+            return true;
+        }
+        _WARN("EGLFence: create native fence failed: 0x%x, fallback to GL sync", eglGetError());
+    }
+    m_gl_fence.create(flush);
+    return m_gl_fence.valid();
+}
+
+bool EGLFence::importNativeFd(int fd) {
+    release();
+    _ERROR_RETURN_IF(fd < 0, false, "EGLFence::importNativeFd invalid fd: %d", fd)
+    if (nativeSupported()) {
+        m_display = eglGetCurrentDisplay();
+        EGLint attribs[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fd, EGL_NONE};
+        m_egl_sync = syncFuncs().createSync(m_display, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+        if (m_egl_sync != EGL_NO_SYNC_KHR) {
+            // 导入成功后 fd 归 EGL 所有
+            m_egl_flushed = true;
+            return true;
+        }
+        _WARN("EGLFence: import fd(%d) failed: 0x%x, wait on CPU", fd, eglGetError());
+    }
+    m_fd = fd;
+    return true;
+}
+
+int EGLFence::dupNativeFd() const {
+    if (isNative()) {
+        int fd = syncFuncs().dupNativeFenceFD(m_display, m_egl_sync);
+        _ERROR_IF(fd == EGL_NO_NATIVE_FENCE_FD_ANDROID, "EGLFence: dup native fence fd failed: 0x%x", eglGetError());
+        return fd;
+    }
+    return m_fd >= 0 ? dup(m_fd) : -1;
+}
+
+FenceStatus EGLFence::waitFor(int64_t timeoutNs) {
+    if (isNative()) {
+        EGLint flags = m_egl_flushed ? 0 : EGL_SYNC_FLUSH_COMMANDS_BIT_KHR;
+        m_egl_flushed = true;
+        EGLTimeKHR timeout = timeoutNs < 0 ? EGL_FOREVER_KHR : (EGLTimeKHR)timeoutNs;
+        EGLint result = syncFuncs().clientWaitSync(m_display, m_egl_sync, flags, timeout);
+        if (result == EGL_CONDITION_SATISFIED_KHR) {
+            return FENCE_SIGNALED;
+        }
+        if (result == EGL_TIMEOUT_EXPIRED_KHR) {
+            return FENCE_PENDING;
+        }
+        _ERROR("EGLFence: client wait failed: 0x%x", eglGetError());
+        return FENCE_ERROR;
+    }
+    if (m_fd >= 0) {
+        // sync file 完成后可读
+        struct pollfd pfd = {m_fd, POLLIN, 0};
+        int timeoutMs = timeoutNs < 0 ? -1 : (int)((timeoutNs + 999999) / 1000000);
+        int result;
+        do {
+            result = ::poll(&pfd, 1, timeoutMs);
+        } while (result < 0 && (errno == EINTR || errno == EAGAIN));
+        if (result > 0) {
+            return (pfd.revents & (POLLERR | POLLNVAL)) ? FENCE_ERROR : FENCE_SIGNALED;
+        }
+        return result == 0 ? FENCE_PENDING : FENCE_ERROR;
+    }
+    return m_gl_fence.waitFor(timeoutNs);
+}
+
+bool EGLFence::waitServer() {
+    if (isNative()) {
+        if (syncFuncs().waitSync != nullptr && EGLCtx::hasExtension(m_display, "EGL_KHR_wait_sync")) {
+            return syncFuncs().waitSync(m_display, m_egl_sync, 0) == EGL_TRUE;
+        }
+        return waitFor(-1) == FENCE_SIGNALED;
+    }
+    if (m_fd >= 0) {
+        return waitFor(-1) == FENCE_SIGNALED;
+    }
+    return m_gl_fence.waitServer();
+}
+
+void EGLFence::release() {
+    if (m_egl_sync != EGL_NO_SYNC_KHR) {
+        syncFuncs().destroySync(m_display, m_egl_sync);
+        m_egl_sync = EGL_NO_SYNC_KHR;
+    }
+    m_display = EGL_NO_DISPLAY;
+    m_egl_flushed = false;
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_gl_fence.release();
+}
+
+NAMESPACE_END
+
+#endif
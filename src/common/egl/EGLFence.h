@@ -0,0 +1,89 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "EGLCtx.h"
+
+#ifdef EGL_VERSION_1_0
+
+#include "common/gles/GLFenceSyncer.h"
+
+NAMESPACE_DEFAULT
+
+/**
+ * 可以跨进程/跨 API 传递的 fence.
+ *
+ * 当前 display 支持 EGL_ANDROID_native_fence_sync 时创建 native fence, 可以导出为 sync file fd 交给
+ * 其他进程、MediaCodec、Vulkan 等, 也可以导入其他来源的 fd 让 GL 在 GPU 上等待;
+ * 不支持时 (如 Mesa 的 surfaceless/llvmpipe) 退回到 GL sync object, 只能在同一个 share group 内使用,
+ * 导入的 fd 通过 poll(2) 在 CPU 上等待.
+ * 所有等待都可以不阻塞查询 (poll) 或者带超时 (waitFor), 需要在有 current context 的线程调用
+ */
+class EGLFence {
+public:
+    EGLFence() = default;
+
+    EGLFence(const EGLFence &) = delete;
+
+    EGLFence &operator=(const EGLFence &) = delete;
+
+    ~EGLFence() {
+        _WARN_IF(valid(), "EGLFence not released before delete!");
+    }
+
+    /**
+     * 当前 display 是否支持 native fence
+     */
+    static bool nativeSupported();
+
+    /**
+     * 在当前 context 的命令流中插入 fence. native fence 需要 flush 之后才能导出 fd
+     */
+    bool create(bool flush = true);
+
+    /**
+     * 导入 sync file fd, 调用后 fd 归 EGLFence 所有, 由 release() 关闭
+     */
+    bool importNativeFd(int fd);
+
+    /**
+     * 导出新的 sync file fd, 由调用方 close. 退回到 GL sync object 时返回 -1
+     */
+    int dupNativeFd() const;
+
+    inline bool isNative() const { return m_egl_sync != EGL_NO_SYNC_KHR; }
+
+    inline bool valid() const { return isNative() || m_fd >= 0 || m_gl_fence.valid(); }
+
+    /**
+     * 不阻塞地查询
+     */
+    FenceStatus poll() { return waitFor(0); }
+
+    /**
+     * 最多阻塞 timeoutNs 纳秒, 超时返回 FENCE_PENDING; timeoutNs < 0 时不超时
+     */
+    FenceStatus waitFor(int64_t timeoutNs);
+
+    /**
+     * 让当前 context 之后提交的命令在 GPU 上等待 fence, 不阻塞调用线程.
+     * 不支持 EGL_KHR_wait_sync 或者 fd 无法导入时退回到 CPU 上等待
+     */
+    bool waitServer();
+
+    void release();
+
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLSyncKHR m_egl_sync = EGL_NO_SYNC_KHR;
+    bool m_egl_flushed = false;
+    // 无法导入为 EGLSync 的 fd
+    int m_fd = -1;
+    GLFenceSyncer m_gl_fence;
+};
+
+NAMESPACE_END
+
+#endif
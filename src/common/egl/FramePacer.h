@@ -0,0 +1,286 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "common/utils/EventThread.h"
+#include "common/utils/TimeUtils.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+NAMESPACE_DEFAULT
+
+struct FramePacingStat {
+    // requestRender 的次数
+    int64_t requested = 0;
+    int64_t rendered = 0;
+    // 被更新的请求替换, 没有渲染的次数
+    int64_t coalesced = 0;
+    // 渲染结束时超过 帧开始时间 + frame budget 的次数
+    int64_t missed = 0;
+    // 从请求到渲染结束的延迟
+    double avgLatencyMs = 0;
+    double maxLatencyMs = 0;
+    // 单帧渲染的耗时
+    double avgRenderMs = 0;
+};
+
+struct FrameInfo {
+    int64_t requestUs = 0;
+    int64_t tickUs = 0;
+    int64_t startUs = 0;
+    int64_t endUs = 0;
+    int64_t budgetUs = 0;
+};
+
+typedef std::function<void(const FrameInfo &info)> DeadlineMissListener;
+
+/**
+ * GLEngine 的帧节奏控制: 只保留最新的一个渲染请求, 按目标帧率或者 vsync 触发, 同一时间最多一帧在渲染.
+ *
+ * 三种触发方式:
+ * 1. 默认 (帧率为 0, 不使用 vsync): 上一帧渲染完成后立即渲染最新的请求
+ * 2. setFrameRate(fps): 内部的 ticker 线程按帧间隔对齐触发
+ * 3. setVsyncEnabled(true): 只在 onVsync 时触发, 由平台的 vsync 回调驱动
+ * 触发时 tickHandler 把一帧投递到 GL 线程, GL 线程通过 take 取出最新的请求, 渲染后调用 onFrameDone
+ */
+class FramePacer {
+public:
+    explicit FramePacer(const Runnable &tickHandler) : m_tick_handler(tickHandler) {}
+
+    ~FramePacer() {
+        _WARN_IF(m_ticker.joinable(), "FramePacer not stopped before delete!");
+        stop();
+    }
+
+    /**
+     * @param fps <= 0 时不限制帧率
+     */
+    void setFrameRate(float fps) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_interval_us = fps > 0 ? (int64_t)(1000000.0f / fps) : 0;
+        m_cond.notify_all();
+    }
+
+    void setVsyncEnabled(bool enable) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_vsync = enable;
+        m_vsync_interval_us = 0;
+        m_last_vsync_ns = 0;
+        m_cond.notify_all();
+    }
+
+    /**
+     * 每帧的时间预算, 渲染结束超过 帧开始时间 + budget 计为错过. <= 0 时使用帧间隔 (vsync 时为测得的 vsync 间隔)
+     */
+    void setFrameBudget(float ms) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budget_us = ms > 0 ? (int64_t)(ms * 1000.0f) : 0;
+    }
+
+    void setDeadlineMissListener(const DeadlineMissListener &listener) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_miss_listener = listener;
+    }
+
+    /**
+     * 替换还没有渲染的请求
+     */
+    void request(const Runnable &frame) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped) {
+            return;
+        }
+        if (m_pending) {
+            m_stat.coalesced += 1;
+        }
+        m_pending = frame;
+        m_pending_request_us = TimeUtils::nowUs();
+        m_stat.requested += 1;
+        if (!m_vsync && !m_ticker.joinable()) {
+            m_ticker = std::thread(&FramePacer::tickLoop, this);
+        }
+        m_cond.notify_all();
+    }
+
+    /**
+     * 平台的 vsync 回调, 只用 frameTimeNs 估计 vsync 间隔, 帧的开始时间为调用的时刻
+     */
+    void onVsync(int64_t frameTimeNs) {
+        Runnable handler;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_vsync || m_stopped) {
+                return;
+            }
+            if (m_last_vsync_ns > 0 && frameTimeNs > m_last_vsync_ns) {
+                int64_t interval = (frameTimeNs - m_last_vsync_ns) / 1000;
+                // 平滑, 偶尔丢一个 vsync 时不会让预算翻倍
+                m_vsync_interval_us = m_vsync_interval_us == 0 ? interval : (m_vsync_interval_us * 7 + interval) / 8;
+            }
+            m_last_vsync_ns = frameTimeNs;
+            if (m_pending && !m_in_flight) {
+                handler = tickLocked(TimeUtils::nowUs());
+            }
+        }
+        if (handler) {
+            handler();
+        }
+    }
+
+    /**
+     * GL 线程: 取出最新的请求, 没有时返回 false
+     */
+    bool take(Runnable &frame, FrameInfo &info) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pending) {
+            m_in_flight = false;
+            m_cond.notify_all();
+            return false;
+        }
+        frame = std::move(m_pending);
+        m_pending = nullptr;
+        info.requestUs = m_pending_request_us;
+        info.tickUs = m_tick_us;
+        info.budgetUs = budgetLocked();
+        return true;
+    }
+
+    /**
+     * GL 线程: 渲染完成, 允许触发下一帧
+     */
+    void onFrameDone(const FrameInfo &info) {
+        DeadlineMissListener listener;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_in_flight = false;
+            m_stat.rendered += 1;
+            double latencyMs = (double)(info.endUs - info.requestUs) / 1000.0;
+            m_latency_sum_ms += latencyMs;
+            m_render_sum_ms += (double)(info.endUs - info.startUs) / 1000.0;
+            m_stat.maxLatencyMs = std::max(m_stat.maxLatencyMs, latencyMs);
+            if (info.budgetUs > 0 && info.endUs > info.tickUs + info.budgetUs) {
+                m_stat.missed += 1;
+                listener = m_miss_listener;
+            }
+            m_cond.notify_all();
+        }
+        if (listener) {
+            listener(info);
+        }
+    }
+
+    FramePacingStat stat() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FramePacingStat stat = m_stat;
+        if (stat.rendered > 0) {
+            stat.avgLatencyMs = m_latency_sum_ms / (double)stat.rendered;
+            stat.avgRenderMs = m_render_sum_ms / (double)stat.rendered;
+        }
+        return stat;
+    }
+
+    void resetStat() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stat = FramePacingStat();
+        m_latency_sum_ms = 0;
+        m_render_sum_ms = 0;
+    }
+
+    /**
+     * 停止 ticker 线程, 丢弃还没有渲染的请求
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+            m_pending = nullptr;
+            m_cond.notify_all();
+        }
+        if (m_ticker.joinable()) {
+            m_ticker.join();
+        }
+    }
+
+private:
+    int64_t budgetLocked() const {
+        if (m_budget_us > 0) {
+            return m_budget_us;
+        }
+        return m_vsync ? m_vsync_interval_us : m_interval_us;
+    }
+
+    /**
+     * 标记一帧开始, 返回 tickHandler 由调用者在释放 m_mutex 之后调用,
+     * 否则 handler 里同步调用 take/onFrameDone 或者 GL 线程回调时会死锁
+     */
+    Runnable tickLocked(int64_t tickUs) {
+        m_in_flight = true;
+        m_tick_us = tickUs;
+        m_last_tick_us = tickUs;
+        return m_tick_handler;
+    }
+
+    void tickLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped) {
+            if (m_vsync || !m_pending || m_in_flight) {
+                m_cond.wait(lock);
+                continue;
+            }
+            int64_t now = TimeUtils::nowUs();
+            int64_t next = now;
+            if (m_interval_us > 0 && m_last_tick_us > 0) {
+                // 对齐到帧间隔的网格上, 错过的帧不补
+                next = m_last_tick_us + m_interval_us;
+                if (next < now) {
+                    next += (now - next) / m_interval_us * m_interval_us;
+                    if (next < now) {
+                        next += m_interval_us;
+                    }
+                }
+            }
+            if (next > now) {
+                m_cond.wait_for(lock, std::chrono::microseconds(next - now));
+                // 等待期间可能修改了帧率/停止, 重新检查
+                if (TimeUtils::nowUs() < next) {
+                    continue;
+                }
+            }
+            Runnable handler = tickLocked(next);
+            lock.unlock();
+            handler();
+            lock.lock();
+        }
+    }
+
+private:
+    const Runnable m_tick_handler;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_ticker;
+    bool m_stopped = false;
+
+    int64_t m_interval_us = 0;
+    int64_t m_budget_us = 0;
+    bool m_vsync = false;
+    int64_t m_vsync_interval_us = 0;
+    int64_t m_last_vsync_ns = 0;
+
+    Runnable m_pending = nullptr;
+    int64_t m_pending_request_us = 0;
+    bool m_in_flight = false;
+    int64_t m_tick_us = 0;
+    int64_t m_last_tick_us = 0;
+
+    DeadlineMissListener m_miss_listener = nullptr;
+    FramePacingStat m_stat;
+    double m_latency_sum_ms = 0;
+    double m_render_sum_ms = 0;
+};
+
+NAMESPACE_END
@@ -4,24 +4,54 @@
 
 #include "GLEngine.h"
 
+#include <algorithm>
+
 #ifdef EGL_VERSION_1_0
 
 NAMESPACE_DEFAULT
 
-GLEngine::GLEngine(const char *name, int glVersion)
-        : m_name(name), m_ctx(name, glVersion), m_event_thread(name) {
-    post([this]() { onUpdateSurface(nullptr, 0, 0); });
+GLEngine::GLEngine(const char *name, int glVersion, EGLSurfaceMode mode)
+        : m_name(name), m_ctx(name, glVersion, mode), m_event_thread(name),
+          m_pacer([this]() { m_event_thread.post([this]() { doPacedFrame(); }); }) {
+    post([this]() {
+        GLGeometryCache::makeCurrent(&m_geometry_cache);
+        GLStateCache::makeCurrent(&m_state_cache);
+        onUpdateSurface(nullptr, 0, 0);
+    });
 }
 
 GLEngine::GLEngine(const char *name, GLEngine &sharedCtx)
-        : m_name(name), m_ctx(name, sharedCtx.m_ctx), m_event_thread(name) {
-    post([this]() { onUpdateSurface(nullptr, 0, 0); });
+        : m_name(name), m_ctx(name, sharedCtx.m_ctx), m_event_thread(name),
+          m_pacer([this]() { m_event_thread.post([this]() { doPacedFrame(); }); }) {
+    post([this]() {
+        GLGeometryCache::makeCurrent(&m_geometry_cache);
+        GLStateCache::makeCurrent(&m_state_cache);
+        onUpdateSurface(nullptr, 0, 0);
+    });
 }
 
 void GLEngine::updateSurface(void *surface, int width, int height) {
     sync([this, surface, width, height]() { onUpdateSurface(surface, width, height); });
 }
 
+void GLEngine::updateOffscreenSize(int width, int height) {
+    sync([this, width, height]() {
+        bool result = false;
+        if (m_ctx.mode() == SURFACE_PBUFFER) {
+            result = m_ctx.makeCurrentPbuffer(width, height);
+        } else if (m_ctx.mode() == SURFACE_SURFACELESS) {
+            result = m_ctx.makeCurrent(nullptr);
+        }
+        m_surf_width = result ? width : 0;
+        m_surf_height = result ? height : 0;
+        if (m_surface_change_listener != nullptr) {
+            m_surface_change_listener(nullptr, m_surf_width, m_surf_height);
+        }
+        _INFO("GLEngine(%s) update offscreen size(%d x %d) result: %s", m_name.c_str(), width, height,
+              (result ? "success" : "fail"));
+    });
+}
+
 void GLEngine::onUpdateSurface(void *surface, int width, int height) {
     m_surface = surface;
     m_surf_width = width;
@@ -45,29 +75,229 @@ void GLEngine::onUpdateSurface(void *surface, int width, int height) {
           (result ? "success" : "fail"), m_surf_width, m_surf_height);
 }
 
+void GLEngine::doRender(const RenderRunnable &runnable) {
+    beginJob();
+    bool swap;
+    int64_t start = TimeUtils::nowUs();
+    {
+        GLGpuTimerScope gpuTimerScope(m_name);
+        swap = runnable(m_surf_width, m_surf_height);
+    }
+    if (m_resolution_enabled.load()) {
+        double frameMs = (double)(TimeUtils::nowUs() - start) / 1000.0;
+        // GPU 计时滞后几帧, 只在有新结果时使用
+        GpuTimeStat gpuStat;
+        if (m_gpu_timer.stat(m_name, gpuStat) && gpuStat.count != m_last_gpu_count) {
+            m_last_gpu_count = gpuStat.count;
+            frameMs = std::max(frameMs, gpuStat.lastMs);
+        }
+        if (m_resolution.onFrame(frameMs)) {
+            _INFO("GLEngine(%s) render scale: %.2f, frame: %.2f ms", m_name.c_str(), m_resolution.scale(), frameMs);
+        }
+    }
+    if (swap) {
+        m_ctx.swapBuffers();
+    }
+}
+
+int GLEngine::addOutputSurface(const OutputSurfaceConfig &config) {
+    int id = -1;
+    sync([this, &config, &id]() {
+        id = m_ctx.createOutputSurface(config.window, config.width, config.height);
+        if (id >= 0) {
+            OutputSurface output;
+            output.id = id;
+            output.config = config;
+            m_outputs.push_back(output);
+        }
+    });
+    return id;
+}
+
+void GLEngine::removeOutputSurface(int id) {
+    sync([this, id]() {
+        m_outputs.erase(std::remove_if(m_outputs.begin(), m_outputs.end(),
+                                       [id](const OutputSurface &output) { return output.id == id; }),
+                        m_outputs.end());
+        m_ctx.destroyOutputSurface(id);
+    });
+}
+
+bool GLEngine::outputSurfaceStat(int id, OutputSurfaceStat &out) {
+    bool found = false;
+    sync([this, id, &out, &found]() {
+        for (auto &output : m_outputs) {
+            if (output.id == id) {
+                out = output.stat;
+                found = true;
+            }
+        }
+    });
+    return found;
+}
+
+void GLEngine::syncRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs, int timeoutMs) {
+    m_event_thread.sync([this, runnable, ptsUs]() { doRenderOutputs(runnable, ptsUs); }, timeoutMs);
+}
+
+bool GLEngine::postRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs) {
+    return m_event_thread.post([this, runnable, ptsUs]() { doRenderOutputs(runnable, ptsUs); });
+}
+
+void GLEngine::doRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs) {
+    beginJob();
+    const Texture2D *texture;
+    {
+        GLGpuTimerScope gpuTimerScope(m_name);
+        texture = runnable();
+    }
+    if (texture == nullptr || m_outputs.empty()) {
+        return;
+    }
+    int64_t now = ptsUs >= 0 ? ptsUs : TimeUtils::nowUs();
+    bool switched = false;
+    for (auto &output : m_outputs) {
+        const OutputSurfaceConfig &config = output.config;
+        if (config.maxFps > 0) {
+            // 允许提前 1/8 个间隔, 避免帧时间的抖动让 60 -> 30 这样整除的抽帧错位,
+            // 也不会让 60 -> 15 时提前一帧的输入满足条件
+            auto interval = (int64_t)(1000000.0f / config.maxFps);
+            if (output.nextPresentUs != INT64_MIN && now + interval / 8 < output.nextPresentUs) {
+                output.stat.skipped += 1;
+                continue;
+            }
+            output.nextPresentUs = output.nextPresentUs == INT64_MIN ? now + interval : output.nextPresentUs + interval;
+            if (output.nextPresentUs <= now) {
+                output.nextPresentUs = now + interval;
+            }
+        }
+        if (!m_ctx.makeCurrentOutput(output.id)) {
+            continue;
+        }
+        switched = true;
+        // 要画到 surface 上, 不能用 unbindFramebuffer: 缓存开启时解绑是延迟的
+        GLStateCache::bindFramebuffer(0);
+        m_present_filter.viewport().set(config.width, config.height).enableClearColor(0, 0, 0, 1);
+        m_present_filter.setTextureCoord(config.rotation, false, false).setFullVertexCoord();
+        m_present_filter.inputTexture(*texture).blend(false).render();
+        m_ctx.swapOutput(output.id);
+        output.stat.presented += 1;
+    }
+    if (switched) {
+        m_ctx.makeCurrentMain();
+    }
+}
+
+bool GLEngine::readOutputPixels(int id, std::vector<uint8_t> &rgba) {
+    bool result = false;
+    sync([this, id, &rgba, &result]() {
+        for (auto &output : m_outputs) {
+            if (output.id != id || !m_ctx.makeCurrentOutput(id)) {
+                continue;
+            }
+            GLStateCache::bindFramebuffer(0);
+            rgba.resize((size_t)output.config.width * output.config.height * 4);
+            glReadPixels(0, 0, output.config.width, output.config.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+            m_ctx.makeCurrentMain();
+            result = true;
+        }
+    });
+    return result;
+}
+
+void GLEngine::setDynamicResolution(bool enable, const DynamicResolutionConfig &config) {
+    sync([this, enable, config]() {
+        m_resolution.setConfig(config);
+        m_resolution_enabled.store(enable);
+        _INFO("GLEngine(%s) dynamic resolution enabled: %d, scale: [%.2f, %.2f], target: %.2f ms", m_name.c_str(),
+              enable, m_resolution.config().minScale, m_resolution.config().maxScale, m_resolution.config().targetMs);
+    });
+}
+
 void GLEngine::syncRender(const RenderRunnable &runnable, int timeoutMs) {
-    m_event_thread.sync(
-            [this, runnable]() {
-                bool swap = runnable(m_surf_width, m_surf_height);
-                if (swap) {
-                    m_ctx.swapBuffers();
-                }
-            },
-            timeoutMs);
+    m_event_thread.sync([this, runnable]() { doRender(runnable); }, timeoutMs);
 }
 
 bool GLEngine::postRender(const RenderRunnable &runnable) {
-    return m_event_thread.post([this, runnable]() {
-        bool swap = runnable(m_surf_width, m_surf_height);
-        if (swap) {
-            m_ctx.swapBuffers();
+    return m_event_thread.post([this, runnable]() { doRender(runnable); });
+}
+
+void GLEngine::requestRender(const RenderRunnable &runnable) {
+    m_pacer.request([this, runnable]() { doRender(runnable); });
+}
+
+void GLEngine::doPacedFrame() {
+    Runnable frame;
+    FrameInfo info;
+    if (!m_pacer.take(frame, info)) {
+        return;
+    }
+    info.startUs = TimeUtils::nowUs();
+    frame();
+    info.endUs = TimeUtils::nowUs();
+    m_pacer.onFrameDone(info);
+}
+
+void GLEngine::setGpuTimerEnabled(bool enable) {
+    post([this, enable]() {
+        if (enable) {
+            GLGpuTimer::makeCurrent(&m_gpu_timer);
+        } else {
+            m_gpu_timer.release();
         }
+        _INFO("GLEngine(%s) gpu timer enabled: %d, available: %d", m_name.c_str(), enable, m_gpu_timer.available());
+    });
+}
+
+void GLEngine::warmUp(const std::vector<BaseFilter *> &filters) {
+    std::vector<GLProgramWarmer::Source> sources;
+    for (auto *filter : filters) {
+        sources.push_back(filter->programSource());
+    }
+    std::lock_guard<std::mutex> lock(m_warmup_mutex);
+    _WARN_RETURN_IF(m_warmup_closed, void(), "GLEngine(%s) warmUp after destroy", m_name.c_str());
+    if (m_warmup_engine == nullptr) {
+        m_warmup_engine.reset(new GLEngine((m_name + "_warmup").c_str(), *this));
+    }
+    m_warmup_engine->post([this, sources]() {
+        GLResTracker::TagScope tag("warmup");
+        GLProgramWarmer::instance().compile(sources, this);
+    });
+}
+
+void GLEngine::setStateCacheEnabled(bool enable) {
+    post([this, enable]() {
+        m_state_cache.setEnabled(enable);
+        _INFO("GLEngine(%s) state cache enabled: %d", m_name.c_str(), enable);
+    });
+}
+
+void GLEngine::setDeferUnbind(bool defer) {
+    post([this, defer]() {
+        m_state_cache.setDeferUnbind(defer);
+        _INFO("GLEngine(%s) state cache defer unbind: %d", m_name.c_str(), defer);
     });
 }
 
 void GLEngine::destroy() {
+    m_pacer.stop();
+    std::unique_ptr<GLEngine> warmup;
+    {
+        std::lock_guard<std::mutex> lock(m_warmup_mutex);
+        m_warmup_closed = true;
+        warmup = std::move(m_warmup_engine);
+    }
+    if (warmup != nullptr) {
+        warmup->sync([this]() { GLProgramWarmer::instance().release(this); });
+        warmup->destroy();
+    }
     if (m_event_thread.isRunning()) {
         m_event_thread.sync([this]() {
+            m_present_filter.release();
+            m_outputs.clear();
+            m_gpu_timer.release();
+            m_geometry_cache.release();
+            GLStateCache::makeCurrent(nullptr);
             m_ctx.destroy();
         });
         m_event_thread.quit();
@@ -10,17 +10,48 @@
 
 #ifdef EGL_VERSION_1_0
 
+#include "FramePacer.h"
+#include "ResolutionController.h"
 #include "common/utils/EventThread.h"
+#include "common/gles/GLGeometryCache.h"
+#include "common/gles/GLGpuTimer.h"
+#include "common/gles/GLStateCache.h"
+#include "common/gles/filter/BaseFilter.h"
+#include "common/gles/filter/TextureFilter.h"
 #include <cstdint>
+#include <memory>
+#include <mutex>
 
 NAMESPACE_DEFAULT
 
 typedef std::function<bool(int width, int height)> RenderRunnable;
 typedef std::function<void(void *surface, int width, int height)> SurfaceChangeListener;
 
+/**
+ * 渲染到离屏 framebuffer, 返回要输出到各个 surface 的纹理, 返回 nullptr 时这一帧不输出
+ */
+typedef std::function<const Texture2D *()> OffscreenRunnable;
+
+struct OutputSurfaceConfig {
+    // 为 nullptr 时创建 width x height 的 pbuffer, 用于离屏模式和测试
+    void *window = nullptr;
+    int width = 0;
+    int height = 0;
+    // 纹理旋转的角度: 0, 90, 180, 270
+    int rotation = 0;
+    // 最大帧率, 按帧时间抽帧, <= 0 时每帧都输出
+    float maxFps = 0;
+};
+
+struct OutputSurfaceStat {
+    int64_t presented = 0;
+    // 按帧率抽掉的帧
+    int64_t skipped = 0;
+};
+
 class GLEngine {
 public:
-    explicit GLEngine(const char *name, int glVersion = 3);
+    explicit GLEngine(const char *name, int glVersion = 3, EGLSurfaceMode mode = SURFACE_WINDOW);
 
     GLEngine(const char *name, GLEngine &sharedCtx);
 public:
@@ -32,13 +63,25 @@ public:
 
     void updateSurface(void *surface, int width, int height);
     
+    /**
+     * 离屏模式 (SURFACE_PBUFFER / SURFACE_SURFACELESS) 下设置渲染尺寸, 即 RenderRunnable 收到的宽高
+     * pbuffer 模式会按该尺寸重建 pbuffer, surfaceless 模式需要自行渲染到 FBO
+     */
+    void updateOffscreenSize(int width, int height);
+
+    inline EGLSurfaceMode surfaceMode() const { return m_ctx.mode(); }
+
     void setSurfaceChangeListener(SurfaceChangeListener listener) {
         m_surface_change_listener = listener;
     }
 
-    void sync(const Runnable &runnable, int timeoutMs = -1) { m_event_thread.sync(runnable, timeoutMs); }
+    void sync(const Runnable &runnable, int timeoutMs = -1) {
+        m_event_thread.sync([this, runnable]() { beginJob(); runnable(); }, timeoutMs);
+    }
 
-    bool post(const Runnable &runnable) { return m_event_thread.post(runnable); }
+    bool post(const Runnable &runnable) {
+        return m_event_thread.post([this, runnable]() { beginJob(); runnable(); });
+    }
 
     inline void swapBuffers() { m_ctx.swapBuffers(); }
 
@@ -46,11 +89,127 @@ public:
 
     bool postRender(const RenderRunnable &runnable);
 
+    /**
+     * 与 postRender 不同, 还没有开始的请求会被新的请求替换, 只渲染最新的一个, 同一时间最多一帧在渲染.
+     * 触发的时机见 setFrameRate / setVsyncEnabled, 默认上一帧完成后立即渲染
+     */
+    void requestRender(const RenderRunnable &runnable);
+
+    /**
+     * requestRender 的目标帧率, 按帧间隔对齐触发, <= 0 时不限制
+     */
+    void setFrameRate(float fps) { m_pacer.setFrameRate(fps); }
+
+    /**
+     * 开启后 requestRender 只在 onVsync 时触发
+     */
+    void setVsyncEnabled(bool enable) { m_pacer.setVsyncEnabled(enable); }
+
+    /**
+     * 平台的 vsync 回调 (如 Choreographer / OH_NativeVSync), 可以在任意线程调用
+     */
+    void onVsync(int64_t frameTimeNs) { m_pacer.onVsync(frameTimeNs); }
+
+    /**
+     * 每帧的时间预算, <= 0 时为帧间隔. 超过预算时回调 listener, 在 GL 线程执行
+     */
+    void setFrameBudget(float ms) { m_pacer.setFrameBudget(ms); }
+
+    void setDeadlineMissListener(const DeadlineMissListener &listener) { m_pacer.setDeadlineMissListener(listener); }
+
+    FramePacingStat framePacingStat() const { return m_pacer.stat(); }
+
+    void resetFramePacingStat() { m_pacer.resetStat(); }
+
+    /**
+     * 添加输出 surface (如预览 + 编码器), 与主 surface 共用 context.
+     * syncRenderOutputs/postRenderOutputs 渲染一次滤镜链后, 按各自的尺寸/旋转/帧率绘制到每个 surface
+     * @return 输出 id, 失败时返回 -1
+     */
+    int addOutputSurface(const OutputSurfaceConfig &config);
+
+    void removeOutputSurface(int id);
+
+    bool outputSurfaceStat(int id, OutputSurfaceStat &out);
+
+    /**
+     * @param ptsUs 帧时间, 用于按帧率抽帧, < 0 时使用当前时间
+     */
+    void syncRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs = -1, int timeoutMs = -1);
+
+    bool postRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs = -1);
+
+    /**
+     * 读回 pbuffer 输出的内容 (RGBA, 第一行为底部), 用于测试和调试
+     */
+    bool readOutputPixels(int id, std::vector<uint8_t> &rgba);
+
+    /**
+     * 动态分辨率: 每次 render 之后按这一帧的耗时 (CPU 耗时, GPU 计时开启时取两者的较大值) 调整 renderScale.
+     * RenderRunnable 需要把 renderScale 设置给滤镜链 (如 RenderGraph::setRenderScale), 最后输出到 surface 时放大
+     */
+    void setDynamicResolution(bool enable, const DynamicResolutionConfig &config = DynamicResolutionConfig());
+
+    /**
+     * 当前的渲染比例, 没有开启动态分辨率时为 1
+     */
+    float renderScale() const { return m_resolution_enabled.load() ? m_resolution.scale() : 1.0f; }
+
+    /**
+     * 需要在 GL 线程调用
+     */
+    int renderScaleChanges() const { return m_resolution.changes(); }
+
+    /**
+     * 开启之后统计每次 render 以及其中每个滤镜的 GPU 耗时, 结果在几帧之后异步读取
+     * 不支持 GL_EXT_disjoint_timer_query 时没有任何统计结果
+     */
+    void setGpuTimerEnabled(bool enable);
+
+    /**
+     * 每次 render 的耗时统计名为 engine 的名字, 滤镜的统计名为滤镜的名字
+     */
+    std::vector<GpuTimeStat> gpuTimeStats() { return m_gpu_timer.stats(); }
+
+    bool gpuTimeStat(const std::string &name, GpuTimeStat &out) { return m_gpu_timer.stat(name, out); }
+
+    /**
+     * 在后台的共享 context 上预编译这些滤镜的 program, 不阻塞调用线程和渲染线程.
+     * 源码在调用线程生成, 滤镜的参数 (如 YUV 标准) 需要先设置好.
+     * 渲染时通过 BaseFilter::programReady 查询, 预编译完成的 program 会被直接使用.
+     * 可以在任意线程调用. 节省的是渲染线程上编译 program 的阻塞 (bench 中 startup 的 full frame render),
+     * 创建 engine 后立即渲染时, 首帧的总耗时主要是创建 context 和上传纹理, 不会明显缩短
+     */
+    void warmUp(const std::vector<BaseFilter *> &filters);
+
+    /**
+     * GL 线程上的状态缓存, 默认开启. 关闭后每个状态调用都会发出, 用于对比和排查问题.
+     * RenderRunnable 中直接调用 GL 修改了绑定等状态时, 需要调用 GLStateCache::current()->invalidate()
+     */
+    void setStateCacheEnabled(bool enable);
+
+    /**
+     * 状态缓存的解绑延迟到下一次绑定, 默认关闭, 见 GLStateCache::setDeferUnbind.
+     * 开启后 Framebuffer::unbind() 等不会真正解绑, RenderRunnable 中直接调用 GL 绘制之前需要自己绑定 framebuffer
+     */
+    void setDeferUnbind(bool defer);
+
     void destroy();
 
 protected:
     virtual void onUpdateSurface(void *surface, int width, int height);
 
+    void doRender(const RenderRunnable &runnable);
+
+    void doPacedFrame();
+
+    void doRenderOutputs(const OffscreenRunnable &runnable, int64_t ptsUs);
+
+    /**
+     * 每个任务开始时调用: 共享 context 可能删除/修改了纹理等对象, 缓存中这些对象的绑定不再可信
+     */
+    void beginJob() { m_state_cache.invalidateShared(); }
+
 protected:
     std::string m_name;
 
@@ -60,6 +219,37 @@ protected:
 
     EGLCtx m_ctx;
     EventThread m_event_thread;
+
+    GLGpuTimer m_gpu_timer;
+
+    // 这个 context 上所有滤镜共享的固定坐标 VBO/VAO
+    GLGeometryCache m_geometry_cache;
+
+    // 这个 context 的状态缓存, 跳过滤镜之间重复的绑定
+    GLStateCache m_state_cache;
+
+    // 预编译使用的共享 context, 第一次 warmUp 时创建, 由 m_warmup_mutex 保护
+    std::mutex m_warmup_mutex;
+    std::unique_ptr<GLEngine> m_warmup_engine;
+    // destroy 之后不再创建
+    bool m_warmup_closed = false;
+
+    FramePacer m_pacer;
+
+    std::atomic<bool> m_resolution_enabled{false};
+    ResolutionController m_resolution;
+    int64_t m_last_gpu_count = 0;
+
+    struct OutputSurface {
+        int id = -1;
+        OutputSurfaceConfig config;
+        // 下一次输出的帧时间
+        int64_t nextPresentUs = INT64_MIN;
+        OutputSurfaceStat stat;
+    };
+    // 只在 GL 线程访问
+    std::vector<OutputSurface> m_outputs;
+    TextureFilter m_present_filter;
 };
 
 NAMESPACE_END
@@ -0,0 +1,131 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "ZNamespace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+NAMESPACE_DEFAULT
+
+struct DynamicResolutionConfig {
+    // 渲染分辨率相对输出的比例范围
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // 比例按 step 量化, 每次提高一个 step
+    float step = 0.1f;
+    // 单帧耗时的目标
+    float targetMs = 16.0f;
+    // 窗口平均耗时超过 targetMs * highRatio 时降低分辨率
+    float highRatio = 0.9f;
+    // 窗口平均耗时低于 targetMs * lowRatio, 并且预计提高一个 step 后不会超过 highRatio 时提高分辨率
+    float lowRatio = 0.6f;
+    // 取平均的帧数
+    int windowFrames = 8;
+    // 调整之后等待的帧数, 跳过重新分配 framebuffer 的帧和滞后的 GPU 计时
+    int cooldownFrames = 8;
+};
+
+/**
+ * 动态分辨率的控制器: 根据每帧的渲染耗时调整渲染比例.
+ *
+ * 耗时近似与像素数 (比例的平方) 成正比. 超过上限时按比例一次降到预计满足目标的 step;
+ * 提高时每次只升一个 step, 且预计的耗时要低于上限, 降低和提高之间留有间隔, 不会来回振荡.
+ * onFrame 需要在同一个线程调用, scale 可以在任意线程读取
+ */
+class ResolutionController {
+public:
+    explicit ResolutionController(const DynamicResolutionConfig &config = DynamicResolutionConfig()) {
+        setConfig(config);
+    }
+
+    void setConfig(const DynamicResolutionConfig &config) {
+        m_config = config;
+        m_config.step = std::max(config.step, 0.01f);
+        m_config.minScale = std::min(std::max(config.minScale, m_config.step), 1.0f);
+        m_config.maxScale = std::min(std::max(config.maxScale, m_config.minScale), 1.0f);
+        m_config.windowFrames = std::max(config.windowFrames, 1);
+        m_config.cooldownFrames = std::max(config.cooldownFrames, 0);
+        m_scale.store(m_config.maxScale);
+        reset();
+    }
+
+    inline const DynamicResolutionConfig &config() const { return m_config; }
+
+    inline float scale() const { return m_scale.load(); }
+
+    /**
+     * 调整的次数
+     */
+    inline int changes() const { return m_changes; }
+
+    /**
+     * 一帧渲染完成
+     * @return 比例是否变化
+     */
+    bool onFrame(double frameMs) {
+        if (m_cooldown > 0) {
+            m_cooldown -= 1;
+            return false;
+        }
+        m_sum_ms += frameMs;
+        m_count += 1;
+        if (m_count < m_config.windowFrames) {
+            return false;
+        }
+        double avg = m_sum_ms / m_count;
+        m_sum_ms = 0;
+        m_count = 0;
+
+        float scale = m_scale.load();
+        float next = scale;
+        double high = m_config.targetMs * m_config.highRatio;
+        double low = m_config.targetMs * m_config.lowRatio;
+        if (avg > high && scale > m_config.minScale) {
+            // 按耗时与比例平方成正比估计, 至少降低一个 step
+            float wanted = scale * (float)std::sqrt(high / avg);
+            next = std::min(quantizeDown(wanted), scale - m_config.step);
+        } else if (avg < low && scale < m_config.maxScale) {
+            float up = std::min(scale + m_config.step, m_config.maxScale);
+            double predicted = avg * (up / scale) * (up / scale);
+            if (predicted < high) {
+                next = up;
+            }
+        }
+        next = std::min(std::max(next, m_config.minScale), m_config.maxScale);
+        if (std::fabs(next - scale) < 1e-4f) {
+            return false;
+        }
+        m_scale.store(next);
+        m_changes += 1;
+        m_cooldown = m_config.cooldownFrames;
+        return true;
+    }
+
+    void reset() {
+        m_sum_ms = 0;
+        m_count = 0;
+        m_cooldown = 0;
+        m_changes = 0;
+    }
+
+private:
+    float quantizeDown(float scale) const {
+        return std::floor(scale / m_config.step + 1e-4f) * m_config.step;
+    }
+
+private:
+    DynamicResolutionConfig m_config;
+    std::atomic<float> m_scale{1.0f};
+
+    double m_sum_ms = 0;
+    int m_count = 0;
+    int m_cooldown = 0;
+    int m_changes = 0;
+};
+
+NAMESPACE_END
@@ -0,0 +1,340 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLEngine.h"
+
+#ifdef EGL_VERSION_1_0
+
+#include "common/gles/Texture.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * TextureUploader 返回的纹理, 在后台 context 上传, 渲染线程通过 ready() 不阻塞地查询是否可以使用
+ */
+class AsyncTexture {
+public:
+    AsyncTexture(int width, int height, GLenum format) : m_width(width), m_height(height), m_format(format) {}
+
+    ~AsyncTexture() {
+        _WARN_IF(m_texture != nullptr, "AsyncTexture not released before delete!");
+    }
+
+    inline int width() const { return m_width; }
+
+    inline int height() const { return m_height; }
+
+    /**
+     * 需要在共享 context 的 GL 线程调用, 不阻塞: 检查上传完成后插入的 fence
+     */
+    bool ready() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state == STATE_UPLOADED) {
+            GLenum result = glClientWaitSync(m_fence, 0, 0);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+                glDeleteSync(m_fence);
+                m_fence = nullptr;
+                m_state = STATE_READY;
+                m_ready_us = TimeUtils::nowUs();
+                // 纹理由上传的 context 写入, 当前 context 需要重新绑定才能看到
+                GLStateCache::forgetTexture(m_texture->id());
+            } else if (result == GL_WAIT_FAILED) {
+                _ERROR("AsyncTexture: wait fence failed");
+            }
+        }
+        return m_state == STATE_READY;
+    }
+
+    bool failed() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_state == STATE_FAILED;
+    }
+
+    /**
+     * ready() 之前返回 nullptr. 纹理在其他 context 上修改过, 使用前需要重新绑定, ready() 中已经让 GLStateCache 不跳过下一次绑定
+     */
+    const Texture2D *texture() {
+        return ready() ? m_texture : nullptr;
+    }
+
+    /**
+     * 从 upload 到 ready() 第一次返回 true 的耗时
+     */
+    int64_t latencyUs() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_state == STATE_READY ? m_ready_us - m_request_us : -1;
+    }
+
+    /**
+     * 需要在共享 context 的 GL 线程调用. 还没有上传完成时取消上传, 纹理由后台线程删除
+     */
+    void release() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state == STATE_PENDING) {
+            m_state = STATE_CANCELLED;
+            return;
+        }
+        deleteLocked();
+    }
+
+private:
+    friend class TextureUploader;
+
+    enum State {
+        // 后台还在上传
+        STATE_PENDING = 0,
+        // 上传完成, 等待 fence
+        STATE_UPLOADED,
+        STATE_READY,
+        STATE_CANCELLED,
+        STATE_FAILED,
+    };
+
+    void deleteLocked() {
+        if (m_fence != nullptr) {
+            glDeleteSync(m_fence);
+            m_fence = nullptr;
+        }
+        if (m_texture != nullptr) {
+            m_texture->release();
+        }
+        DELETE_TO_NULL(m_texture);
+    }
+
+private:
+    const int m_width;
+    const int m_height;
+    const GLenum m_format;
+
+    mutable std::mutex m_mutex;
+    State m_state = STATE_PENDING;
+    Texture2D *m_texture = nullptr;
+    GLsync m_fence = nullptr;
+    int64_t m_request_us = 0;
+    int64_t m_ready_us = 0;
+
+    // 只在后台线程访问
+    std::shared_ptr<const std::vector<uint8_t>> m_pixels;
+    int m_next_row = 0;
+};
+
+/**
+ * 在后台共享 context 上上传纹理, 渲染线程不需要等待.
+ *
+ * 大图按 tileBytes 分成多段, 每段写入两个交替的 PBO 之一后 glTexSubImage2D, 上传完一段再把下一段
+ * 放到任务队列的末尾, 多张图片交替进行, 先提交的小图不会被大图阻塞. 最后一段之后插入 fence 并 glFlush,
+ * 渲染线程通过 AsyncTexture::ready() 查询.
+ */
+class TextureUploader {
+public:
+    explicit TextureUploader(GLEngine &renderEngine, int tileBytes = 1 << 20)
+        : m_tile_bytes(std::max(tileBytes, 4096)) {
+        m_engine.reset(new GLEngine((renderEngine.name() + "_uploader").c_str(), renderEngine));
+    }
+
+    ~TextureUploader() {
+        _WARN_IF(m_engine != nullptr, "TextureUploader not destroyed before delete!");
+    }
+
+    /**
+     * 可以在任意线程调用, 数据不复制, 上传完成前不能修改
+     * @param format GL_RGBA / GL_RGB / GL_ALPHA (GLES2 的 1 通道) 等 glTexImage2D 的 format
+     */
+    std::shared_ptr<AsyncTexture> upload(std::shared_ptr<const std::vector<uint8_t>> pixels, int width, int height,
+                                         GLenum format = GL_RGBA) {
+        auto tex = std::make_shared<AsyncTexture>(width, height, format);
+        tex->m_request_us = TimeUtils::nowUs();
+        int channels = channelsOf(format);
+        if (channels == 0 || pixels == nullptr || (int64_t)pixels->size() < (int64_t)width * height * channels) {
+            _ERROR("TextureUploader: invalid image(%d x %d), format: 0x%x", width, height, format);
+            tex->m_state = AsyncTexture::STATE_FAILED;
+            return tex;
+        }
+        if (m_destroying.load()) {
+            _ERROR("TextureUploader: upload after destroy, image(%d x %d)", width, height);
+            tex->m_state = AsyncTexture::STATE_FAILED;
+            return tex;
+        }
+        tex->m_pixels = std::move(pixels);
+        m_pending += 1;
+        m_engine->post([this, tex]() { uploadTile(tex); });
+        return tex;
+    }
+
+    /**
+     * 复制一份数据后上传, 调用返回后就可以修改 pixels
+     */
+    std::shared_ptr<AsyncTexture> upload(const uint8_t *pixels, int width, int height, GLenum format = GL_RGBA) {
+        size_t size = (size_t)width * height * channelsOf(format);
+        auto copy = std::make_shared<std::vector<uint8_t>>(pixels, pixels + size);
+        return upload(copy, width, height, format);
+    }
+
+    /**
+     * 还没有上传完成的图片数量
+     */
+    int pending() const { return m_pending.load(); }
+
+    /**
+     * 还没有上传完成的图片在这里取消并删除纹理, 之后 ready() 不会再返回 true (failed() 为 true, 已经 release 的直接删除).
+     * 不能与 upload 同时调用
+     */
+    void destroy() {
+        if (m_engine == nullptr) {
+            return;
+        }
+        m_destroying = true;
+        // 队列中已有的 uploadTile 在这之前执行, 看到 m_destroying 后删除纹理且不再放回队列
+        m_engine->sync([this]() {
+            _WARN_IF(m_pending.load() != 0, "TextureUploader: %d uploads still pending after destroy", m_pending.load());
+            for (GLuint &pbo : m_pbos) {
+                if (pbo != 0) {
+                    glDeleteBuffers(1, &pbo);
+                    GLResTracker::instance().onDelete(RES_BUFFER, pbo);
+                    pbo = 0;
+                }
+            }
+        });
+        m_engine->destroy();
+        m_engine.reset();
+    }
+
+private:
+    static int channelsOf(GLenum format) {
+        switch (format) {
+            case GL_RGBA: return 4;
+            case GL_RGB: return 3;
+            case GL_RG: return 2;
+            case GL_RED:
+            case GL_ALPHA: return 1;
+            default: return 0;
+        }
+    }
+
+    /**
+     * GLES3 的 GL_RED/GL_RG 需要 sized internal format, 其他格式与 format 相同
+     */
+    static GLint internalFormatOf(GLenum format) {
+        switch (format) {
+            case GL_RED: return GL_R8;
+            case GL_RG: return GL_RG8;
+            default: return (GLint)format;
+        }
+    }
+
+    /**
+     * 后台线程: 上传 tex 的下一段, 没有上传完时把剩下的放回队列
+     */
+    void uploadTile(const std::shared_ptr<AsyncTexture> &tex) {
+        GLResTracker::TagScope tag("TextureUploader");
+        // 渲染线程会删除纹理, GL 可能复用这个名字, 之前缓存的绑定都不可信
+        if (GLStateCache *cache = GLStateCache::current()) {
+            cache->invalidateShared();
+        }
+        int channels = channelsOf(tex->m_format);
+        int rowBytes = tex->m_width * channels;
+        {
+            std::lock_guard<std::mutex> lock(tex->m_mutex);
+            if (tex->m_state == AsyncTexture::STATE_CANCELLED || m_destroying.load()) {
+                if (tex->m_state != AsyncTexture::STATE_CANCELLED) {
+                    tex->m_state = AsyncTexture::STATE_FAILED;
+                }
+                tex->deleteLocked();
+                tex->m_pixels.reset();
+                m_pending -= 1;
+                return;
+            }
+            if (tex->m_texture == nullptr) {
+                TexParams params;
+                params.format = tex->m_format;
+                params.internalFormat = internalFormatOf(tex->m_format);
+                tex->m_texture = new Texture2D(tex->m_width, tex->m_height, params);
+                tex->m_texture->update(nullptr);
+            }
+        }
+
+        int rows = std::min(std::max(1, m_tile_bytes / rowBytes), tex->m_height - tex->m_next_row);
+        int64_t size = (int64_t)rowBytes * rows;
+        m_pbo_index = (m_pbo_index + 1) % 2;
+        GLuint &pbo = m_pbos[m_pbo_index];
+        int64_t &capacity = m_pbo_sizes[m_pbo_index];
+        if (pbo == 0) {
+            glGenBuffers(1, &pbo);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        if (capacity < size) {
+            if (capacity > 0) {
+                GLResTracker::instance().onDelete(RES_BUFFER, pbo);
+            }
+            capacity = size;
+            GLResTracker::instance().onCreate(RES_BUFFER, pbo, capacity);
+        }
+        // 重新分配存储, 不需要等待上一次使用这块存储的上传完成
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)capacity, nullptr, GL_STREAM_DRAW);
+        auto *dst = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        bool success = dst != nullptr;
+        if (success) {
+            memcpy(dst, tex->m_pixels->data() + (size_t)tex->m_next_row * rowBytes, (size_t)size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            GLStateCache::bindTexture2D(tex->m_texture->id());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, tex->m_next_row, tex->m_width, rows, tex->m_format, GL_UNSIGNED_BYTE,
+                            nullptr);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            GLStateCache::unbindTexture2D();
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        tex->m_next_row += rows;
+
+        if (success && tex->m_next_row < tex->m_height) {
+            m_engine->post([this, tex]() { uploadTile(tex); });
+            return;
+        }
+
+        GLsync fence = success ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : nullptr;
+        // fence 需要提交之后其他 context 才能等到
+        glFlush();
+        std::lock_guard<std::mutex> lock(tex->m_mutex);
+        tex->m_pixels.reset();
+        m_pending -= 1;
+        if (tex->m_state == AsyncTexture::STATE_CANCELLED) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+            }
+            tex->deleteLocked();
+            return;
+        }
+        if (!success) {
+            _ERROR("TextureUploader: map unpack buffer failed, image(%d x %d)", tex->m_width, tex->m_height);
+            tex->deleteLocked();
+            tex->m_state = AsyncTexture::STATE_FAILED;
+            return;
+        }
+        tex->m_fence = fence;
+        tex->m_state = AsyncTexture::STATE_UPLOADED;
+    }
+
+private:
+    const int m_tile_bytes;
+    std::unique_ptr<GLEngine> m_engine;
+    std::atomic<int> m_pending{0};
+    std::atomic<bool> m_destroying{false};
+
+    // 只在后台线程访问
+    GLuint m_pbos[2] = {0, 0};
+    int64_t m_pbo_sizes[2] = {0, 0};
+    int m_pbo_index = 0;
+};
+
+NAMESPACE_END
+
+#endif // EGL_VERSION_1_0
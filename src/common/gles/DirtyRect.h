@@ -0,0 +1,84 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "ZNamespace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 帧中变化的区域, 像素坐标, 与 glViewport/glScissor 一致 (左下角为原点). 多个区域合并为外接矩形
+ */
+class DirtyRect {
+public:
+    static DirtyRect full(int width, int height) { return DirtyRect(0, 0, width, height); }
+
+public:
+    DirtyRect() = default;
+
+    DirtyRect(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+
+    inline bool empty() const { return width <= 0 || height <= 0; }
+
+    inline int64_t area() const { return empty() ? 0 : (int64_t)width * height; }
+
+    inline bool covers(int w, int h) const { return x <= 0 && y <= 0 && x + width >= w && y + height >= h; }
+
+    DirtyRect &unite(const DirtyRect &o) {
+        if (o.empty()) {
+            return *this;
+        }
+        if (empty()) {
+            *this = o;
+            return *this;
+        }
+        int x1 = std::max(x + width, o.x + o.width), y1 = std::max(y + height, o.y + o.height);
+        x = std::min(x, o.x);
+        y = std::min(y, o.y);
+        width = x1 - x;
+        height = y1 - y;
+        return *this;
+    }
+
+    /**
+     * 每个方向扩大 padding 个像素, 并裁剪到 [0, w) x [0, h)
+     */
+    DirtyRect expanded(int padding, int w, int h) const {
+        if (empty()) {
+            return DirtyRect();
+        }
+        int x0 = std::max(0, x - padding), y0 = std::max(0, y - padding);
+        int x1 = std::min(w, x + width + padding), y1 = std::min(h, y + height + padding);
+        return x1 > x0 && y1 > y0 ? DirtyRect(x0, y0, x1 - x0, y1 - y0) : DirtyRect();
+    }
+
+    /**
+     * 从 srcW x srcH 的坐标换算到 dstW x dstH, 向外取整. 尺寸不同时采样是双线性的, 再扩大 1 个像素
+     */
+    DirtyRect mapped(int srcW, int srcH, int dstW, int dstH) const {
+        if (empty() || srcW <= 0 || srcH <= 0) {
+            return DirtyRect();
+        }
+        if (srcW == dstW && srcH == dstH) {
+            return expanded(0, dstW, dstH);
+        }
+        float sx = (float)dstW / (float)srcW, sy = (float)dstH / (float)srcH;
+        int x0 = (int)std::floor((float)x * sx), y0 = (int)std::floor((float)y * sy);
+        int x1 = (int)std::ceil((float)(x + width) * sx), y1 = (int)std::ceil((float)(y + height) * sy);
+        return DirtyRect(x0, y0, x1 - x0, y1 - y0).expanded(1, dstW, dstH);
+    }
+
+public:
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+NAMESPACE_END
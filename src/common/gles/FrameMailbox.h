@@ -0,0 +1,268 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "Framebuffer.h"
+
+#include <atomic>
+#include <memory>
+
+NAMESPACE_DEFAULT
+
+struct FrameMailboxStat {
+    // 生产者提交的帧数
+    int64_t published = 0;
+    // 消费者拿到的新帧数
+    int64_t consumed = 0;
+    // 没有被消费者拿到就被覆盖或跳过的帧数
+    int64_t dropped = 0;
+};
+
+/**
+ * 共享 context 之间传递帧的 N 缓冲邮箱 (默认 3 个), 替代单缓冲加锁的 ShareFramebuffer.
+ *
+ * 生产者总能拿到一个空闲的 slot, 不等待消费者: 没有空闲 slot 时覆盖最旧的未读帧并计为丢帧;
+ * 消费者总是拿到最新完成的一帧, 更旧的未读帧直接丢弃. slot 的状态和帧序号打包在一个原子变量中, 用 CAS 切换, 没有锁.
+ * GPU 上的先后关系由每个 slot 的两个 fence 保证: 生产者渲染完插入 write fence, 消费者使用前等待它;
+ * 消费者用完插入 read fence, 生产者再次写入这个 slot 之前在 GPU 上等待它 (glWaitSync, 不阻塞 CPU).
+ *
+ * beginWrite/endWrite 只能在生产者的 GL 线程调用, acquire/releaseRead 只能在消费者的 GL 线程调用.
+ * framebuffer 对象不能跨 context 共享, 消费者只能使用其中的纹理. 需要 GLES3 的 fence sync.
+ * acquire 拿到新帧时让消费者的 GLStateCache 忘记这个纹理的绑定, 下一次采样前一定会重新绑定
+ */
+class FrameMailbox {
+public:
+    explicit FrameMailbox(int slots = 3) : m_slot_count(std::max(slots, 3)) {
+        m_slots.reset(new Slot[m_slot_count]);
+    }
+
+    ~FrameMailbox() {
+        _WARN_IF(m_released == false, "FrameMailbox not released before delete!");
+    }
+
+    inline int slots() const { return m_slot_count; }
+
+    /**
+     * 生产者: 取一个 slot 开始渲染, 返回的 framebuffer 已经按尺寸和格式创建好, 之后必须调用 endWrite
+     */
+    Framebuffer *beginWrite(int width, int height, FramebufferFormat format = FB_FORMAT_RGBA8) {
+        _ERROR_RETURN_IF(m_writing >= 0, nullptr, "FrameMailbox::beginWrite() previous frame not ended")
+        int index = claimWriteSlot();
+        Slot &slot = m_slots[index];
+        if (slot.readFence != nullptr) {
+            // 消费者在 GPU 上可能还在采样这个 slot 的纹理
+            glWaitSync(slot.readFence, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(slot.readFence);
+            slot.readFence = nullptr;
+        }
+        if (slot.writeFence != nullptr) {
+            glDeleteSync(slot.writeFence);
+            slot.writeFence = nullptr;
+        }
+        slot.framebuffer.create(width, height, format);
+        m_writing = index;
+        return &slot.framebuffer;
+    }
+
+    /**
+     * 生产者: 提交 beginWrite 之后渲染的帧
+     */
+    void endWrite() {
+        _ERROR_RETURN_IF(m_writing < 0, void(), "FrameMailbox::endWrite() without beginWrite")
+        Slot &slot = m_slots[m_writing];
+        slot.writeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // fence 需要提交之后其他 context 才能等到
+        glFlush();
+        uint64_t seq = ++m_write_seq;
+        slot.state.store(pack(seq, SLOT_READY), std::memory_order_release);
+        m_published.fetch_add(1);
+        m_writing = -1;
+    }
+
+    /**
+     * 消费者: 拿到最新完成的一帧. 没有新帧时返回上一次拿到的帧, 从来没有帧时返回 nullptr.
+     * 上一次拿到的帧自动归还给生产者
+     * @param serverWait true: 在 GPU 上等待生产者完成 (glWaitSync), 不阻塞 CPU; false: 阻塞到生产者完成
+     */
+    const Texture2D *acquire(bool serverWait = true) {
+        while (true) {
+            int newest = -1;
+            uint64_t newestValue = 0;
+            for (int i = 0; i < m_slot_count; ++i) {
+                uint64_t value = m_slots[i].state.load(std::memory_order_acquire);
+                if (stateOf(value) == SLOT_READY && (newest < 0 || seqOf(value) > seqOf(newestValue))) {
+                    newest = i;
+                    newestValue = value;
+                }
+            }
+            if (newest < 0) {
+                break;
+            }
+            uint64_t reading = pack(seqOf(newestValue), SLOT_READING);
+            if (!m_slots[newest].state.compare_exchange_strong(newestValue, reading, std::memory_order_acq_rel)) {
+                // 生产者刚好覆盖了这个 slot, 重新查找
+                continue;
+            }
+            releaseRead();
+            dropStale(seqOf(newestValue));
+            m_reading = newest;
+            m_read_seq = seqOf(newestValue);
+            m_consumed.fetch_add(1);
+
+            GLsync fence = m_slots[newest].writeFence;
+            if (fence != nullptr) {
+                if (serverWait) {
+                    glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+                } else if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED) == GL_WAIT_FAILED) {
+                    _ERROR("FrameMailbox: wait fence failed");
+                }
+            }
+            // 纹理由生产者写入 (可能刚被 Framebuffer::create 重新创建, id 与消费者缓存中已删除的纹理相同),
+            // 需要重新绑定才能看到, 不能被 GLStateCache 跳过
+            const Texture2D *texture = m_slots[newest].framebuffer.texture();
+            if (texture != nullptr) {
+                GLStateCache::forgetTexture(texture->id());
+            }
+            break;
+        }
+        return m_reading >= 0 ? m_slots[m_reading].framebuffer.texture() : nullptr;
+    }
+
+    /**
+     * 消费者当前帧的序号, 从 1 开始递增, 没有帧时为 0
+     */
+    inline uint64_t frameSeq() const { return m_reading >= 0 ? m_read_seq : 0; }
+
+    /**
+     * 消费者: 归还当前帧, 之后不能再使用 acquire 返回的纹理
+     */
+    void releaseRead() {
+        if (m_reading < 0) {
+            return;
+        }
+        Slot &slot = m_slots[m_reading];
+        // 生产者只会在 slot 空闲时访问 readFence
+        slot.readFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        slot.state.store(pack(m_read_seq, SLOT_FREE), std::memory_order_release);
+        m_reading = -1;
+    }
+
+    FrameMailboxStat stat() const {
+        FrameMailboxStat stat;
+        stat.published = m_published.load();
+        stat.consumed = m_consumed.load();
+        stat.dropped = m_dropped.load();
+        return stat;
+    }
+
+    /**
+     * 在生产者的 GL 线程调用, 消费者需要先 releaseRead
+     */
+    void release() {
+        _WARN_IF(m_reading >= 0, "FrameMailbox::release() consumer still holds a frame");
+        for (int i = 0; i < m_slot_count; ++i) {
+            Slot &slot = m_slots[i];
+            if (slot.readFence != nullptr) {
+                glDeleteSync(slot.readFence);
+                slot.readFence = nullptr;
+            }
+            if (slot.writeFence != nullptr) {
+                glDeleteSync(slot.writeFence);
+                slot.writeFence = nullptr;
+            }
+            slot.framebuffer.release();
+            slot.state.store(pack(0, SLOT_FREE));
+        }
+        m_writing = -1;
+        m_reading = -1;
+        m_released = true;
+    }
+
+private:
+    enum SlotState {
+        SLOT_FREE = 0,
+        SLOT_WRITING,
+        SLOT_READY,
+        SLOT_READING,
+    };
+
+    struct Slot {
+        // 高位为帧序号, 低 2 位为 SlotState
+        std::atomic<uint64_t> state{0};
+        Framebuffer framebuffer;
+        GLsync writeFence = nullptr;
+        GLsync readFence = nullptr;
+    };
+
+    static inline uint64_t pack(uint64_t seq, SlotState state) { return (seq << 2) | (uint64_t)state; }
+
+    static inline SlotState stateOf(uint64_t value) { return (SlotState)(value & 3); }
+
+    static inline uint64_t seqOf(uint64_t value) { return value >> 2; }
+
+    /**
+     * 优先取空闲的 slot, 没有时覆盖最旧的未读帧. 消费者最多占用一个 slot, 至少 3 个 slot 时总能取到
+     */
+    int claimWriteSlot() {
+        while (true) {
+            for (int i = 0; i < m_slot_count; ++i) {
+                uint64_t value = m_slots[i].state.load(std::memory_order_acquire);
+                if (stateOf(value) == SLOT_FREE &&
+                    m_slots[i].state.compare_exchange_strong(value, pack(seqOf(value), SLOT_WRITING),
+                                                             std::memory_order_acq_rel)) {
+                    return i;
+                }
+            }
+            int oldest = -1;
+            uint64_t oldestValue = 0;
+            for (int i = 0; i < m_slot_count; ++i) {
+                uint64_t value = m_slots[i].state.load(std::memory_order_acquire);
+                if (stateOf(value) == SLOT_READY && (oldest < 0 || seqOf(value) < seqOf(oldestValue))) {
+                    oldest = i;
+                    oldestValue = value;
+                }
+            }
+            if (oldest >= 0 && m_slots[oldest].state.compare_exchange_strong(
+                                   oldestValue, pack(seqOf(oldestValue), SLOT_WRITING), std::memory_order_acq_rel)) {
+                m_dropped.fetch_add(1);
+                return oldest;
+            }
+        }
+    }
+
+    /**
+     * 消费者: 比 seq 旧的未读帧不会再被读取, 归还给生产者
+     */
+    void dropStale(uint64_t seq) {
+        for (int i = 0; i < m_slot_count; ++i) {
+            uint64_t value = m_slots[i].state.load(std::memory_order_acquire);
+            if (stateOf(value) == SLOT_READY && seqOf(value) < seq &&
+                m_slots[i].state.compare_exchange_strong(value, pack(seqOf(value), SLOT_FREE),
+                                                         std::memory_order_acq_rel)) {
+                m_dropped.fetch_add(1);
+            }
+        }
+    }
+
+private:
+    const int m_slot_count;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // 只在生产者线程访问
+    int m_writing = -1;
+    uint64_t m_write_seq = 0;
+
+    // 只在消费者线程访问
+    int m_reading = -1;
+    uint64_t m_read_seq = 0;
+
+    std::atomic<int64_t> m_published{0};
+    std::atomic<int64_t> m_consumed{0};
+    std::atomic<int64_t> m_dropped{0};
+    bool m_released = false;
+};
+
+NAMESPACE_END
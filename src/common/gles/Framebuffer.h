@@ -7,29 +7,130 @@
 #pragma once
 
 #include "GLReader.h"
+#include "GLStateCache.h"
 #include "GLUtil.h"
 #include "Texture.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
 NAMESPACE_DEFAULT
 
+/**
+ * Framebuffer 颜色纹理的格式
+ */
+enum FramebufferFormat {
+    FB_FORMAT_RGBA8 = 0,
+    // 单通道, 亮度/遮罩, 采样结果为 (r, 0, 0, 1)
+    FB_FORMAT_R8,
+    // 双通道, 色度 (UV), 采样结果为 (r, g, 0, 1)
+    FB_FORMAT_RG8,
+    // 半精度浮点, 可以保存超出 [0, 1] 的中间结果
+    FB_FORMAT_RGBA16F,
+    // 与 RGBA8 同样大小, 颜色精度 10 bit, alpha 只有 2 bit
+    FB_FORMAT_RGB10_A2,
+    // 与 RGBA8 相同, 颜色纹理不可变 (glTexStorage2D), 可以作为 compute shader 的 image 输出
+    FB_FORMAT_RGBA8_IMAGE,
+};
+
 class Framebuffer {
 public:
-    void create(GLint width, GLint height) {
-        if (m_texture == nullptr || m_texture->width() != width || m_texture->height() != height) {
-            _INFO("Framebuffer::create(%d, %d)", width, height);
-            auto *ntex = new Texture2D(width, height);
-            ntex->update(nullptr);
-            attachColorTexture(ntex, true);
+    typedef std::function<void(Framebuffer *fb)> Recycler;
+
+    static TexParams texParams(FramebufferFormat format) {
+        TexParams params;
+        switch (format) {
+            case FB_FORMAT_R8:
+                params.internalFormat = GL_R8;
+                params.format = GL_RED;
+                break;
+            case FB_FORMAT_RG8:
+                params.internalFormat = GL_RG8;
+                params.format = GL_RG;
+                break;
+            case FB_FORMAT_RGBA16F:
+                params.internalFormat = GL_RGBA16F;
+                params.type = GL_HALF_FLOAT;
+                break;
+            case FB_FORMAT_RGB10_A2:
+                params.internalFormat = GL_RGB10_A2;
+                params.type = GL_UNSIGNED_INT_2_10_10_10_REV;
+                break;
+            case FB_FORMAT_RGBA8_IMAGE:
+                params.internalFormat = GL_RGBA8;
+                params.immutable = true;
+                break;
+            default:
+                break;
+        }
+        return params;
+    }
+
+    static const char *formatName(FramebufferFormat format) {
+        switch (format) {
+            case FB_FORMAT_R8: return "R8";
+            case FB_FORMAT_RG8: return "RG8";
+            case FB_FORMAT_RGBA16F: return "RGBA16F";
+            case FB_FORMAT_RGB10_A2: return "RGB10_A2";
+            case FB_FORMAT_RGBA8_IMAGE: return "RGBA8_IMAGE";
+            default: return "RGBA8";
+        }
+    }
+
+    /**
+     * 尺寸或者格式变化时重新创建颜色纹理. 驱动不支持渲染到这个格式时 (例如 GLES 3.0 没有
+     * EXT_color_buffer_half_float 时的 RGBA16F) 回退到 RGBA8, 通过 format() 获取实际的格式
+     */
+    void create(GLint width, GLint height, FramebufferFormat format = FB_FORMAT_RGBA8) {
+        if (m_texture != nullptr && m_texture->width() == width && m_texture->height() == height &&
+            m_format == format) {
+            return;
+        }
+        _INFO("Framebuffer::create(%d, %d, %s)", width, height, formatName(format));
+        auto *ntex = new Texture2D(width, height, texParams(format));
+        ntex->update(nullptr);
+        attachColorTexture(ntex, true);
+        m_format = format;
+        if (format != FB_FORMAT_RGBA8 && !complete()) {
+            _WARN("Framebuffer(%d): format %s is not color-renderable, fallback to RGBA8", m_fb_id, formatName(format));
+            create(width, height, FB_FORMAT_RGBA8);
         }
     }
 
-    inline bool available() const { return m_ref_count == 0 && valid(); }
+    inline FramebufferFormat format() const { return m_format; }
+
+    inline bool available() const { return m_ref_count.load() == 0 && valid(); }
 
-    inline void ref() { m_ref_count += 1; }
+    // 引用计数可以在任意线程修改, 例如把 FramebufferRef 交给共享 context 的线程使用
+    inline void ref() { m_ref_count.fetch_add(1); }
 
     inline void unref() {
-        _WARN_RETURN_IF(m_ref_count == 0, void(), "Framebuffer::unref() ref count == 0, can't unref")
-        m_ref_count -= 1;
+        int count = m_ref_count.load();
+        do {
+            _WARN_RETURN_IF(count == 0, void(), "Framebuffer::unref() ref count == 0, can't unref")
+        } while (!m_ref_count.compare_exchange_weak(count, count - 1));
+        if (count == 1 && m_recycler) {
+            m_recycler(this);
+        }
+    }
+
+    /**
+     * 引用计数减到 0 时回调, 在调用 unref 的线程执行, 不能在回调中调用 GL
+     */
+    void setRecycler(const Recycler &recycler) { m_recycler = recycler; }
+
+    /**
+     * 颜色纹理占用的显存
+     */
+    inline int64_t byteSize() const {
+        if (m_texture == nullptr) {
+            return 0;
+        }
+        const TexParams &params = m_texture->params();
+        return (int64_t)m_texture->width() * m_texture->height() *
+               GLUtil::bytesPerPixel(params.internalFormat, params.type);
     }
 
     inline bool valid() const { return m_texture != nullptr && m_fb_id != INVALID_GL_ID; }
@@ -49,41 +150,64 @@ public:
 
     inline GLint texHeight() const { return m_texture == nullptr ? 0 : m_texture->height(); }
     
+    /**
+     * 目标纹理的格式需要与当前格式兼容 (glCopyTexSubImage2D 的限制), 不确定时使用 copyTo
+     */
     bool copyTexTo(GLuint dstId) {
         _ERROR_RETURN_IF(!valid(), false, "source frame buffer bind failed!")
         
-        glBindFramebuffer(GL_FRAMEBUFFER, m_fb_id);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, dstId);
+        GLStateCache::bindFramebuffer(m_fb_id);
+        GLStateCache::bindTexture2D(0, dstId);
         glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, texWidth(), texHeight());
         
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLStateCache::unbindTexture2D();
+        GLStateCache::unbindFramebuffer();
         return true;
     }
     
+    /**
+     * dst 按当前的尺寸和格式重新创建, 使用 glBlitFramebuffer 复制, 所有格式都可以使用
+     */
     bool copyTo(Framebuffer& dst) {
         _ERROR_RETURN_IF(!valid(), false, "source frame buffer invalid!")
-        dst.create(texWidth(), texHeight());
-        return this->copyTexTo(dst.texID());
+        dst.create(texWidth(), texHeight(), m_format);
+        _ERROR_RETURN_IF(!dst.valid() || dst.format() != m_format, false, "Framebuffer::copyTo() create dst failed")
+
+        GLStateCache::bindFramebuffers(m_fb_id, dst.id());
+        glBlitFramebuffer(0, 0, texWidth(), texHeight(), 0, 0, texWidth(), texHeight(), GL_COLOR_BUFFER_BIT,
+                          GL_NEAREST);
+        GLStateCache::unbindFramebuffer();
+        return true;
     }
 
     bool bind() const {
         if (valid()) {
-            glBindFramebuffer(GL_FRAMEBUFFER, m_fb_id);
+            GLStateCache::bindFramebuffer(m_fb_id);
             return true;
         }
         return false;
     }
 
-    void unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+    void unbind() { GLStateCache::unbindFramebuffer(); }
 
+    /**
+     * 所有格式都读取为 RGBA8: R8/RG8 缺少的通道为 0, alpha 为 255; RGBA16F 截断到 [0, 1]
+     */
     uint8_t *readPixels() {
         if (bind()) {
             GLint width = m_texture->width();
             GLint height = m_texture->height();
             auto *pixels = new uint8_t[width * height * 4];
-            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            if (m_format == FB_FORMAT_RGBA16F) {
+                // 浮点格式只保证支持 GL_RGBA + GL_FLOAT 的读取
+                std::vector<float> data((size_t)width * height * 4);
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, data.data());
+                for (size_t i = 0; i < data.size(); ++i) {
+                    pixels[i] = (uint8_t)(std::min(std::max(data[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+            } else {
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            }
             unbind();
 
             return pixels;
@@ -91,7 +215,37 @@ public:
         return nullptr;
     }
 
+    /**
+     * 读取为 RGBA float, RGBA16F 保留超出 [0, 1] 的值, 其他格式转换自 RGBA8
+     */
+    bool readFloatPixels(std::vector<float> &out) {
+        _ERROR_RETURN_IF(!valid(), false, "Framebuffer::readFloatPixels() invalid framebuffer")
+        size_t size = (size_t)texWidth() * texHeight() * 4;
+        out.resize(size);
+        if (m_format == FB_FORMAT_RGBA16F) {
+            bind();
+            glReadPixels(0, 0, texWidth(), texHeight(), GL_RGBA, GL_FLOAT, out.data());
+            unbind();
+            return true;
+        }
+        uint8_t *pixels = readPixels();
+        for (size_t i = 0; i < size; ++i) {
+            out[i] = (float)pixels[i] / 255.0f;
+        }
+        delete[] pixels;
+        return true;
+    }
+
     void fastReadPixels(GLReader &reader, const std::function<void(GLubyte *pixels, int width, int height)>& callback) {
+        if (m_format == FB_FORMAT_RGBA16F) {
+            // GLReader 以 RGBA8 读取, 浮点格式不支持, 直接同步读取并转换
+            uint8_t *pixels = readPixels();
+            if (pixels) {
+                callback(pixels, texWidth(), texHeight());
+                delete[] pixels;
+            }
+            return;
+        }
         if (bind()) {
             GLint width = m_texture->width();
             GLint height = m_texture->height();
@@ -100,20 +254,48 @@ public:
         }
     }
 
+    /**
+     * 通过 reader 的 PBO 环异步读取 (x, y, width, height) 区域, 结果在 reader.poll() 之后由工作线程回调.
+     * R8/RG8 按原格式读取 (1/2 通道), 其他格式读取为 RGBA8, RGBA16F 不支持
+     * @return 这次读取的序号, 失败或环已满时返回 -1
+     */
+    int64_t readPixelsAsync(GLReader &reader, int x, int y, int width, int height, const GLReadCallback &callback) {
+        _WARN_RETURN_IF(m_format == FB_FORMAT_RGBA16F, -1, "Framebuffer::readPixelsAsync() RGBA16F not supported, use readFloatPixels")
+        _ERROR_RETURN_IF(!bind(), -1, "Framebuffer::readPixelsAsync() invalid framebuffer")
+        GLenum format = m_format == FB_FORMAT_R8 ? GL_RED : (m_format == FB_FORMAT_RG8 ? GL_RG : GL_RGBA);
+        int64_t id = reader.readAsync(x, y, width, height, format, callback);
+        unbind();
+        return id;
+    }
+
+    int64_t readPixelsAsync(GLReader &reader, const GLReadCallback &callback) {
+        return readPixelsAsync(reader, 0, 0, texWidth(), texHeight(), callback);
+    }
+
     void release() {
         _INFO("Framebuffer(%d)::release()", m_fb_id);
         detachColorTexture();
         if (m_fb_id != INVALID_GL_ID) {
             glDeleteFramebuffers(1, &m_fb_id);
+            GLStateCache::onDeleteFramebuffer(m_fb_id);
+            GLResTracker::instance().onDelete(RES_FRAMEBUFFER, m_fb_id);
             m_fb_id = INVALID_GL_ID;
         }
-        _WARN_IF(m_ref_count > 0, "Framebuffer(%d)::release() ref count: %d > 0", m_fb_id, m_ref_count);
+        _WARN_IF(m_ref_count.load() > 0, "Framebuffer(%d)::release() ref count: %d > 0", m_fb_id, m_ref_count.load());
     }
 
 private:
+    bool complete() {
+        GLStateCache::bindFramebuffer(m_fb_id);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        GLStateCache::unbindFramebuffer();
+        return status == GL_FRAMEBUFFER_COMPLETE;
+    }
+
     GLuint createFbId() {
         if (m_fb_id == INVALID_GL_ID) {
             glGenFramebuffers(1, &m_fb_id);
+            GLResTracker::instance().onCreate(RES_FRAMEBUFFER, m_fb_id, 0);
         }
         return m_fb_id;
     }
@@ -126,14 +308,12 @@ private:
             detachColorTexture();
         }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fbId);
-        glBindTexture(GL_TEXTURE_2D, texture->id());
+        GLStateCache::bindFramebuffer(fbId);
         // set texture as colour attachment
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->id(), 0);
 
         // unbind
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLStateCache::unbindFramebuffer();
 
         this->m_texture = texture;
         this->m_owning_texture = own;
@@ -148,9 +328,9 @@ private:
 
         _INFO("Framebuffer(%d)e::detachColorTexture(%d), own: %d", m_fb_id, m_texture->id(), m_owning_texture);
         if (m_fb_id != INVALID_GL_ID) {
-            glBindFramebuffer(GL_FRAMEBUFFER, m_fb_id);
+            GLStateCache::bindFramebuffer(m_fb_id);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLStateCache::unbindFramebuffer();
         }
         if (m_owning_texture) {
             m_texture->release();
@@ -162,10 +342,12 @@ private:
 private:
     Texture2D *m_texture = nullptr;
     bool m_owning_texture = false;
+    FramebufferFormat m_format = FB_FORMAT_RGBA8;
 
     GLuint m_fb_id = INVALID_GL_ID;
 
-    int m_ref_count = 0;
+    std::atomic<int> m_ref_count{0};
+    Recycler m_recycler;
 };
 
 NAMESPACE_END
\ No newline at end of file
@@ -8,8 +8,18 @@
 
 #include "GLUtil.h"
 #include "Framebuffer.h"
+#include "common/utils/TimeUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
-#include <map>
+
+#if defined(__ANDROID__) || defined(__HARMONYOS__) || defined(__ZNATIVE_WITH_EGL__)
+#include <EGL/egl.h>
+#endif
 
 NAMESPACE_DEFAULT
 
@@ -63,141 +73,436 @@ private:
     Framebuffer *m_fb;
 };
 
-class FbArrayList {
+struct FramebufferPoolStat {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    // 超出内存上限或者空闲超时被释放的个数
+    int64_t evictions = 0;
+    int count = 0;
+    int freeCount = 0;
+    int64_t bytes = 0;
+    int64_t freeBytes = 0;
+};
+
+/**
+ * Framebuffer 缓存池, 以 (所属 context, 宽, 高, 格式) 为 key, 每个 key 一个空闲列表, obtain 和回收都是 O(1).
+ *
+ * FBO 不能在 context 之间共享, 每个 Framebuffer 只会分配给创建它的 EGLContext (没有 EGL 时按线程区分);
+ * 多个共享 context 的线程可以同时使用同一个池. 引用计数减到 0 时 Framebuffer 自动回到空闲列表,
+ * 可以在任意线程发生. 超出内存上限时按 LRU 淘汰空闲的 Framebuffer, 空闲超过 maxIdleMs 的也会淘汰;
+ * 淘汰只在 obtain/trimMem 中进行, 属于其他 context 的会延迟到那个 context 下次调用时删除.
+ *
+ * 所属 context 以代号区分: EGLContext 销毁后地址可能被新的 context 复用, 销毁时 (onContextDestroy,
+ * EGLCtx::destroy 会调用) 丢弃它的代号, 新的 context 拿到新的代号, 不会分到其他 context 的 FBO;
+ * 同时所有池中属于它的 Framebuffer 和等待删除的都在这个 context 上删除.
+ */
+class FramebufferPool {
 public:
-    FbArrayList(int w, int h) : m_width(w), m_height(h) {}
+    /**
+     * @param maxIdleMs 空闲超过这个时间就释放, <= 0 时只按内存上限淘汰
+     */
+    explicit FramebufferPool(int maxCacheMb = 50, int64_t maxIdleMs = 0)
+        : m_max_bytes((int64_t)maxCacheMb * 1024 * 1024), m_max_idle_us(maxIdleMs * 1000) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.pools.insert(this);
+    }
 
-    FramebufferRef obtain() {
-        for (auto &it : m_fb_list) {
-            if (it->available()) {
-                return FramebufferRef(it);
-            }
+    ~FramebufferPool() {
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.pools.erase(this);
         }
-        auto *fb = new Framebuffer();
-        fb->create(m_width, m_height);
-
-        m_fb_list.push_back(fb);
-        return FramebufferRef(fb);
+        _WARN_IF(!m_entries.empty() || !m_orphans.empty(),
+                 "FramebufferPool not released before delete! %d framebuffers, %d orphans", (int)m_entries.size(),
+                 (int)m_orphans.size());
     }
 
-    int allSize() const { return (int)m_fb_list.size(); }
-
-    int avSize() {
-        int size = 0;
-        for (auto &it : m_fb_list) {
-            if (it->available()) {
-                size++;
-            }
+    /**
+     * context 销毁之前调用, 丢弃它的代号, 并删除所有池中属于它的 Framebuffer (包括等待删除的).
+     * current 为 true 时 context 是当前线程的 context, 在这里删除 GL 对象; 否则 GL 对象随 context 一起释放.
+     * 还有引用的 Framebuffer 不再属于任何 context, 最后一个引用释放时只删除对象本身
+     */
+    static void onContextDestroy(const void *context, bool current) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.owners.find(context);
+        if (it == r.owners.end()) {
+            return;
+        }
+        Owner owner = it->second;
+        r.owners.erase(it);
+        r.epoch.fetch_add(1);
+        for (auto *pool : r.pools) {
+            pool->dropOwner(owner, current);
         }
-        return size;
     }
 
-    bool trimMem(bool once=true) {
-        bool trimmed = false;
-        for (auto it = m_fb_list.begin(); it != m_fb_list.end();) {
-            if ((*it)->available()) {
-                (*it)->release();
-                delete (*it);
-                it = m_fb_list.erase(it);
-                
-                trimmed = true;
-                if (once) {
-                    return true;
-                }
+    /**
+     * 需要在 GL 线程调用
+     */
+    FramebufferRef obtain(int w, int h, FramebufferFormat format = FB_FORMAT_RGBA8) {
+        Key key{currentOwner(), w, h, format};
+        std::vector<Entry *> dead;
+        FramebufferRef fb(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            takePending(key.owner, dead);
+            auto it = m_buckets.find(key);
+            if (it != m_buckets.end() && !it->second.free.empty()) {
+                // 最近回收的优先使用, 最久未用的留在队首等待淘汰
+                Entry *entry = it->second.free.back();
+                removeFree(entry);
+                fb = FramebufferRef(&entry->fb);
+                m_stat.hits += 1;
             } else {
-                it++;
+                m_stat.misses += 1;
             }
+            evict(key.owner, 0, dead);
+        }
+        destroy(dead);
+        if (fb.get() != nullptr) {
+            return fb;
+        }
+
+        auto *entry = new Entry();
+        entry->key = key;
+        {
+            GLResTracker::TagScope tag("FramebufferPool");
+            entry->fb.create(w, h, format);
         }
-        return trimmed;
+        entry->bytes = entry->fb.byteSize();
+        entry->fb.setRecycler([this, entry](Framebuffer *) { recycle(entry); });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.insert(entry);
+        m_buckets[key].count += 1;
+        m_stat.count += 1;
+        m_stat.bytes += entry->bytes;
+        return FramebufferRef(&entry->fb);
+    }
+
+    int allSize() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stat.count;
+    }
+
+    int avSize() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stat.freeCount;
+    }
+
+    int memSizeMb() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return (int)(m_stat.bytes / 1024 / 1024);
     }
 
-    int memSizeMb() { return (int) ((uint64_t)m_width * m_height * 4 * m_fb_list.size() / 1024 / 1024); }
+    FramebufferPoolStat stat() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stat;
+    }
 
+    /**
+     * 淘汰超出内存上限和空闲超时的 Framebuffer, 需要在 GL 线程调用
+     * @param force 释放所有空闲的 Framebuffer
+     */
+    void trimMem(bool force = false) {
+        Owner owner = currentOwner();
+        std::vector<Entry *> dead;
+        int64_t before, after;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            before = m_stat.bytes;
+            takePending(owner, dead);
+            evict(owner, force ? -1 : 0, dead);
+            after = m_stat.bytes;
+        }
+        destroy(dead);
+        _INFO_IF(before != after, "FramebufferPool::trimMem, force=%d: %.2f mb -> %.2f mb", force,
+                 (double)before / 1024 / 1024, (double)after / 1024 / 1024);
+    }
+
+    /**
+     * 释放当前 context 创建的所有 Framebuffer, 每个用过这个池的 context 都需要在销毁前调用.
+     * 还有引用的 Framebuffer 不会删除, 最后一个引用释放后等待这个 context 下一次调用 release/obtain/trimMem 时删除,
+     * 或者在 context 销毁时 (onContextDestroy) 删除
+     */
     void release() {
-        for (auto &it : m_fb_list) {
-            it->release();
-            delete it;
+        Owner owner = currentOwner();
+        std::vector<Entry *> dead;
+        int inUse = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            takePending(owner, dead);
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                Entry *entry = *it;
+                if (entry->key.owner != owner) {
+                    it++;
+                    continue;
+                }
+                if (!entry->free && !entry->fb.available()) {
+                    entry->detached = true;
+                    inUse += 1;
+                    it++;
+                    continue;
+                }
+                if (entry->free) {
+                    removeFree(entry);
+                }
+                removeEntry(entry);
+                dead.push_back(entry);
+                it = m_entries.erase(it);
+            }
         }
-        m_fb_list.clear();
+        destroy(dead);
+        _ERROR_IF(inUse > 0, "FramebufferPool::release: %d framebuffers still referenced, deleted after the last unref",
+                  inUse);
     }
 
 private:
-    std::vector<Framebuffer *> m_fb_list;
-    const int m_width, m_height;
-};
+    // context 的代号, 从 1 开始, 不会复用
+    typedef uint64_t Owner;
 
-class FramebufferPool {
-public:
-    explicit FramebufferPool(int maxCacheMb = 50) : m_max_mem_cache_mb(maxCacheMb) {}
-    
-    FramebufferRef obtain(int w, int h) {
-        std::string key = std::to_string(w) + "x" + std::to_string(h);
-        
-        FramebufferRef fb(nullptr);
-        auto it = m_fb_map.find(key);
-        if (it != m_fb_map.end()) {
-            fb = it->second->obtain();
-        } else {
-            auto *list = new FbArrayList(w, h);
-            m_fb_map[key] = list;
-            fb = list->obtain();
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_map<const void *, Owner> owners;
+        Owner next = 0;
+        // 每次有 context 销毁时加 1, 线程缓存的代号随之失效
+        std::atomic<uint64_t> epoch{0};
+        std::unordered_set<FramebufferPool *> pools;
+    };
+
+    static Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    /**
+     * 当前线程的 EGLContext, 没有 EGL 时按线程区分. 线程退出之后 id 可能被新线程复用, 不能作为 key
+     */
+    static const void *currentContext() {
+#ifdef EGL_VERSION_1_0
+        EGLContext ctx = eglGetCurrentContext();
+        if (ctx != EGL_NO_CONTEXT) {
+            return ctx;
         }
-        trimMem();
-        return fb;
+#endif
+        static thread_local char tag;
+        return &tag;
     }
-    
-    int allSize() {
-        int size = 0;
-        for (auto &it : m_fb_map) {
-            size += it.second->allSize();
+
+    /**
+     * 当前 context 的代号, 线程内缓存, 只在 context 切换或者有 context 销毁之后查询 registry
+     */
+    static Owner currentOwner() {
+        struct Cached {
+            const void *context = nullptr;
+            uint64_t epoch = 0;
+            Owner owner = 0;
+        };
+        static thread_local Cached cached;
+        const void *context = currentContext();
+        Registry &r = registry();
+        uint64_t epoch = r.epoch.load();
+        if (cached.owner != 0 && cached.context == context && cached.epoch == epoch) {
+            return cached.owner;
+        }
+        std::lock_guard<std::mutex> lock(r.mutex);
+        Owner &owner = r.owners[context];
+        if (owner == 0) {
+            owner = ++r.next;
         }
-        return size;
+        cached.context = context;
+        cached.epoch = epoch;
+        cached.owner = owner;
+        return owner;
     }
-    
-    int avSize() {
-        int size = 0;
-        for (auto &it : m_fb_map) {
-            size += it.second->avSize();
+
+    struct Key {
+        Owner owner;
+        int width;
+        int height;
+        FramebufferFormat format;
+
+        bool operator==(const Key &o) const {
+            return owner == o.owner && width == o.width && height == o.height && format == o.format;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            size_t h = std::hash<Owner>()(k.owner);
+            size_t v = (size_t)(uint32_t)k.width << 20 ^ (size_t)(uint32_t)k.height << 4 ^ (size_t)k.format;
+            h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct Entry {
+        Framebuffer fb;
+        Key key;
+        int64_t bytes = 0;
+        bool free = false;
+        // 所属 context 已经 release, 还有引用, 最后一个引用释放后删除
+        bool detached = false;
+        int64_t freeSinceUs = 0;
+        std::list<Entry *>::iterator lru;
+        // 在 bucket 空闲列表中的位置, 移除时不需要查找
+        std::list<Entry *>::iterator freePos;
+    };
+
+    struct Bucket {
+        // 按回收时间排序, 队首最久未使用
+        std::list<Entry *> free;
+        int count = 0;
+    };
+
+    void recycle(Entry *entry) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_orphans.count(entry) > 0) {
+            // 所属 context 已经销毁, GL 对象随 context 释放, 只删除对象本身
+            if (entry->fb.available()) {
+                m_orphans.erase(entry);
+                delete entry;
+            }
+            return;
         }
-        return size;
+        if (m_entries.count(entry) == 0 || entry->free || !entry->fb.available()) {
+            return;
+        }
+        if (entry->detached) {
+            removeEntry(entry);
+            m_entries.erase(entry);
+            m_pending[entry->key.owner].push_back(entry);
+            return;
+        }
+        entry->free = true;
+        entry->freeSinceUs = TimeUtils::nowUs();
+        entry->lru = m_lru.insert(m_lru.end(), entry);
+        auto &free = m_buckets[entry->key].free;
+        entry->freePos = free.insert(free.end(), entry);
+        m_stat.freeCount += 1;
+        m_stat.freeBytes += entry->bytes;
     }
-    
-    int memSizeMb() {
-        int size = 0;
-        for (auto &it : m_fb_map) {
-            size += it.second->memSizeMb();
+
+    void unlinkFree(Entry *entry) {
+        m_lru.erase(entry->lru);
+        entry->free = false;
+        m_stat.freeCount -= 1;
+        m_stat.freeBytes -= entry->bytes;
+    }
+
+    // 从 bucket 的空闲列表和全局 LRU 中移除, O(1)
+    void removeFree(Entry *entry) {
+        m_buckets[entry->key].free.erase(entry->freePos);
+        unlinkFree(entry);
+    }
+
+    void removeEntry(Entry *entry) {
+        auto it = m_buckets.find(entry->key);
+        it->second.count -= 1;
+        if (it->second.count == 0) {
+            m_buckets.erase(it);
         }
-        return size;
+        m_stat.count -= 1;
+        m_stat.bytes -= entry->bytes;
     }
-    
-    void trimMem(bool force = false) {
-        int curMemSizeMb = memSizeMb();
-        if (curMemSizeMb <= m_max_mem_cache_mb && !force) {
-            return;
+
+    /**
+     * @param limit -1: 淘汰所有空闲的; 0: 按内存上限和空闲时间淘汰
+     */
+    void evict(Owner owner, int limit, std::vector<Entry *> &dead) {
+        int64_t now = TimeUtils::nowUs();
+        while (!m_lru.empty()) {
+            Entry *entry = m_lru.front();
+            bool idle = m_max_idle_us > 0 && now - entry->freeSinceUs > m_max_idle_us;
+            if (limit == 0 && m_stat.bytes <= m_max_bytes && !idle) {
+                break;
+            }
+            removeFree(entry);
+            removeEntry(entry);
+            m_entries.erase(entry);
+            m_stat.evictions += 1;
+            if (entry->key.owner == owner) {
+                dead.push_back(entry);
+            } else {
+                m_pending[entry->key.owner].push_back(entry);
+            }
         }
-        do {
-            for (auto& list : m_fb_map) {
-                if (list.second->trimMem() && !force) {
-                    break;
+    }
+
+    /**
+     * context 销毁: 它的 Framebuffer 全部移出池, 没有引用的删除, 还有引用的变为 orphan
+     */
+    void dropOwner(Owner owner, bool current) {
+        std::vector<Entry *> dead;
+        int orphans = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            takePending(owner, dead);
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                Entry *entry = *it;
+                if (entry->key.owner != owner) {
+                    it++;
+                    continue;
+                }
+                if (entry->free) {
+                    removeFree(entry);
                 }
+                removeEntry(entry);
+                it = m_entries.erase(it);
+                if (entry->fb.available()) {
+                    dead.push_back(entry);
+                } else {
+                    m_orphans.insert(entry);
+                    orphans += 1;
+                }
+            }
+        }
+        if (current) {
+            destroy(dead);
+        } else {
+            for (auto *entry : dead) {
+                delete entry;
             }
-        } while (memSizeMb() > m_max_mem_cache_mb && avSize() > 0);
-        
-        int memSize = memSizeMb();
-        _INFO("FramebufferPool::trimMem, force=%d: %d mb -> %d mb", force, curMemSizeMb, memSize);
+        }
+        _WARN_IF(orphans > 0, "FramebufferPool: %d framebuffers still referenced when their context is destroyed",
+                 orphans);
     }
-    
-    void release() {
-        for (auto &it : m_fb_map) {
-            it.second->release();
-            delete it.second;
+
+    void takePending(Owner owner, std::vector<Entry *> &dead) {
+        auto it = m_pending.find(owner);
+        if (it != m_pending.end()) {
+            dead.insert(dead.end(), it->second.begin(), it->second.end());
+            m_pending.erase(it);
         }
-        m_fb_map.clear();
+    }
+
+    // 在所属 context 的线程调用, 不持有锁
+    static void destroy(std::vector<Entry *> &dead) {
+        for (auto *entry : dead) {
+            entry->fb.setRecycler(nullptr);
+            entry->fb.release();
+            delete entry;
+        }
+        dead.clear();
     }
 
 private:
-    std::map<std::string, FbArrayList *> m_fb_map;
-    const int m_max_mem_cache_mb;
+    std::mutex m_mutex;
+    const int64_t m_max_bytes;
+    const int64_t m_max_idle_us;
+
+    std::unordered_map<Key, Bucket, KeyHash> m_buckets;
+    std::unordered_set<Entry *> m_entries;
+    // 所有空闲的 Framebuffer, 按回收时间排序
+    std::list<Entry *> m_lru;
+    // 其他线程淘汰的, 等待所属 context 删除
+    std::unordered_map<Owner, std::vector<Entry *>> m_pending;
+    // 所属 context 已经销毁, 还有引用的
+    std::unordered_set<Entry *> m_orphans;
+    FramebufferPoolStat m_stat;
 };
 
 
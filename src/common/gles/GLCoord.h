@@ -211,6 +211,17 @@ private:
     bool flipH = false, flipV = false;    // 翻转
 };
 
+/**
+ * 常用的固定坐标, GLGeometryCache 以此为 key 缓存不可变的 VBO/VAO
+ */
+enum CoordShape {
+    COORD_SHAPE_CUSTOM = -1,
+    // 全屏的顶点坐标
+    COORD_SHAPE_VERTEX_FULL = 0,
+    // 全屏的纹理坐标, 加上 rotation / 90 * 4 + flipH * 2 + flipV
+    COORD_SHAPE_TEXTURE_FULL = 16,
+};
+
 class GLCoord {
 public:
     virtual ~GLCoord() {
@@ -236,6 +247,7 @@ public:
         m_size = size;
         m_draw_mode = drawMode;
         m_draw_count = drawCount;
+        onCoordsChanged();
     }
 
     const float *get(int &size) {
@@ -247,6 +259,21 @@ public:
         return m_coords;
     }
 
+    /**
+     * 当前坐标对应的 CoordShape, 不是常用的固定坐标时返回 COORD_SHAPE_CUSTOM
+     * @param version 坐标的修改次数, 用于判断是否需要重新上传
+     */
+    int shape(uint32_t &version) {
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        version = m_version;
+        if (m_coords == nullptr) {
+            int size = 0;
+            const float *coords = getDefault(size);
+            return matchShape(coords, size);
+        }
+        return m_shape;
+    }
+
     GLenum drawMode() const {
         return m_draw_mode;
     }
@@ -258,6 +285,16 @@ public:
 protected:
     virtual const float *getDefault(int &size) = 0;
 
+    virtual int matchShape(const float *coords, int size) = 0;
+
+    /**
+     * 修改坐标之后调用, 需要持有 m_update_mutex
+     */
+    void onCoordsChanged() {
+        m_version += 1;
+        m_shape = matchShape(m_coords, m_size);
+    }
+
     float *obtainCoords(int size) {
         if (m_coords == nullptr || m_cap < size) {
             delete[] m_coords;
@@ -275,6 +312,9 @@ protected:
     int m_size = 0;
     GLenum m_draw_mode = GL_TRIANGLE_STRIP;
     int m_draw_count = 4;
+
+    int m_shape = COORD_SHAPE_CUSTOM;
+    uint32_t m_version = 0;
 };
 
 class TextureCoord : public GLCoord {
@@ -284,6 +324,19 @@ public:
         std::lock_guard<std::mutex> lock(m_update_mutex);
         int size = TEX_COORD_SIZE;
         float *coords = obtainCoords(size);
+        fullCoord(rot, flipH, flipV, coords);
+        m_size = size;
+        m_draw_mode = GL_TRIANGLE_STRIP;
+        m_draw_count = 4;
+        onCoordsChanged();
+        return coords;
+    }
+
+    /**
+     * 旋转和翻转之后的全屏纹理坐标
+     */
+    void fullCoord(int rot, bool flipH, bool flipV, float *coords) const {
+        int size = TEX_COORD_SIZE;
         const float *srcCoords;
         rot = rot % 360;
         if (rot == 90) {
@@ -310,10 +363,6 @@ public:
             coords[5] = flip(coords[5]);
             coords[7] = flip(coords[7]);
         }
-        m_size = size;
-        m_draw_mode = GL_TRIANGLE_STRIP;
-        m_draw_count = 4;
-        return coords;
     }
 
     const float *centerCrop(float texW, float texH, float viewW, float viewH, bool flipH, bool flipV) {
@@ -365,6 +414,7 @@ public:
         m_size = size;
         m_draw_mode = GL_TRIANGLE_STRIP;
         m_draw_count = 4;
+        onCoordsChanged();
         return coords;
     }
 
@@ -381,6 +431,7 @@ public:
         float *coords = obtainCoords(size);
         rect.toTextureCoords(texW, texH, coords);
         m_size = size;
+        onCoordsChanged();
         return coords;
     }
 
@@ -390,8 +441,22 @@ protected:
         return ROTATED_0;
     }
 
+    int matchShape(const float *coords, int size) override {
+        if (size != TEX_COORD_SIZE) {
+            return COORD_SHAPE_CUSTOM;
+        }
+        float full[TEX_COORD_SIZE];
+        for (int i = 0; i < 16; ++i) {
+            fullCoord(i / 4 * 90, (i & 2) != 0, (i & 1) != 0, full);
+            if (memcmp(coords, full, sizeof(full)) == 0) {
+                return COORD_SHAPE_TEXTURE_FULL + i;
+            }
+        }
+        return COORD_SHAPE_CUSTOM;
+    }
+
 private:
-    float flip(float i) { return 1.0f - i; }
+    static float flip(float i) { return 1.0f - i; }
 
     const float ROTATED_0[TEX_COORD_SIZE] = {
             0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
@@ -429,6 +494,7 @@ public:
         float *coords = obtainCoords(size);
         rect.toVertexCoords(viewW, viewH, coords);
         m_size = size;
+        onCoordsChanged();
         return coords;
     }
 
@@ -438,6 +504,13 @@ protected:
         return DEFAULT_COORDS;
     }
 
+    int matchShape(const float *coords, int size) override {
+        if (size == VERTEX_COORD_SIZE && memcmp(coords, DEFAULT_COORDS, sizeof(DEFAULT_COORDS)) == 0) {
+            return COORD_SHAPE_VERTEX_FULL;
+        }
+        return COORD_SHAPE_CUSTOM;
+    }
+
 private:
     const float DEFAULT_COORDS[VERTEX_COORD_SIZE] = {
             -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
@@ -10,11 +10,22 @@
 
 NAMESPACE_DEFAULT
 
+enum FenceStatus {
+    FENCE_SIGNALED = 0,
+    // 还没有完成 (poll 或等待超时)
+    FENCE_PENDING,
+    // fence 无效或等待失败
+    FENCE_ERROR,
+};
+
+/**
+ * GL sync object, 同一个 share group 的 context 之间可以互相等待
+ */
 class GLFenceSyncer {
 public:
     GLFenceSyncer() : m_gl_sync(nullptr) {}
     
-    GLFenceSyncer(const GLFenceSyncer& other) : m_gl_sync(other.m_gl_sync) {}
+    GLFenceSyncer(const GLFenceSyncer& other) : m_gl_sync(other.m_gl_sync), m_flushed(other.m_flushed) {}
     
 public:
     void create(bool flush = true) {
@@ -26,10 +37,14 @@ public:
         if (flush) {
             glFlush();
         }
+        m_flushed = flush;
     }
     
     bool valid() const { return m_gl_sync != nullptr; }
     
+    /**
+     * 阻塞到 fence 完成, 没有超时
+     */
     bool wait(GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT) {
         _WARN_RETURN_IF(!m_gl_sync, false, "fence sync == nullptr");
         
@@ -43,6 +58,41 @@ public:
         }
         return true;
     }
+
+    /**
+     * 不阻塞地查询. 第一次查询时提交当前 context 的命令, 避免 fence 一直不被执行
+     */
+    FenceStatus poll() { return waitFor(0); }
+
+    /**
+     * 最多阻塞 timeoutNs 纳秒, 超时返回 FENCE_PENDING; timeoutNs < 0 时不超时
+     */
+    FenceStatus waitFor(int64_t timeoutNs) {
+        if (!m_gl_sync) {
+            return FENCE_ERROR;
+        }
+        GLbitfield flags = m_flushed ? 0 : GL_SYNC_FLUSH_COMMANDS_BIT;
+        m_flushed = true;
+        GLenum result = glClientWaitSync(m_gl_sync, flags, timeoutNs < 0 ? GL_TIMEOUT_IGNORED : (GLuint64)timeoutNs);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            return FENCE_SIGNALED;
+        }
+        if (result == GL_TIMEOUT_EXPIRED) {
+            return FENCE_PENDING;
+        }
+        _ERROR("GLFenceSyncer::waitFor failed: 0x%x", glGetError());
+        return FENCE_ERROR;
+    }
+
+    /**
+     * 让当前 context 之后提交的命令在 GPU 上等待 fence, 不阻塞调用线程.
+     * fence 由其他 context 创建时, 需要它已经 glFlush
+     */
+    bool waitServer() {
+        _WARN_RETURN_IF(!m_gl_sync, false, "fence sync == nullptr");
+        glWaitSync(m_gl_sync, 0, GL_TIMEOUT_IGNORED);
+        return true;
+    }
     
     void release() {
         if (m_gl_sync) {
@@ -53,6 +103,7 @@ public:
     
 private:
     GLsync m_gl_sync;
+    bool m_flushed = false;
 };
 
 NAMESPACE_END
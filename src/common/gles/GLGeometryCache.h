@@ -0,0 +1,141 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLCoord.h"
+#include "GLResTracker.h"
+#include "GLStateCache.h"
+#include "GLUtil.h"
+
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 一个 VAO 中的一个 attribute: 绑定在 location 上的固定坐标
+ */
+struct GLGeometryBinding {
+    int location = -1;
+    int shape = COORD_SHAPE_CUSTOM;
+    int vecSize = 2;
+    bool normalized = false;
+
+    // 只在第一次创建 VBO 时使用
+    const float *coords = nullptr;
+    int size = 0;
+
+    bool operator==(const GLGeometryBinding &o) const {
+        return location == o.location && shape == o.shape && vecSize == o.vecSize && normalized == o.normalized;
+    }
+};
+
+/**
+ * 常用固定坐标 (全屏顶点坐标, 各种旋转和翻转的全屏纹理坐标) 的 VBO/VAO 缓存.
+ *
+ * VBO 以 CoordShape 为 key, 创建后不再修改; VAO 以 (location, shape) 的组合为 key,
+ * attribute location 相同的 program 共用同一个 VAO, 每次绘制只需要 glBindVertexArray.
+ * VAO 不能在 context 之间共享, 每个 context 一份, 由 GLEngine 在 GL 线程上设置为 current.
+ */
+class GLGeometryCache {
+public:
+    ~GLGeometryCache() {
+        _WARN_IF(!m_buffers.empty() || !m_arrays.empty(), "GLGeometryCache not released before delete!");
+    }
+
+    static GLGeometryCache *current() { return currentRef(); }
+
+    static void makeCurrent(GLGeometryCache *cache) { currentRef() = cache; }
+
+    /**
+     * 需要在 GL 线程调用, 返回的 VAO 由缓存持有, 调用方不能修改和删除
+     */
+    GLuint vertexArray(const std::vector<GLGeometryBinding> &bindings) {
+        for (auto &array : m_arrays) {
+            if (array.bindings == bindings) {
+                return array.vao;
+            }
+        }
+
+        VertexArray array;
+        array.bindings = bindings;
+        glGenVertexArrays(1, &array.vao);
+        GLResTracker::instance().onCreate(RES_VERTEX_ARRAY, array.vao, 0, "geometry_cache");
+        GLStateCache::bindVertexArray(array.vao);
+        for (auto &b : bindings) {
+            GLStateCache::bindArrayBuffer(buffer(b.shape, b.coords, b.size));
+            glVertexAttribPointer(b.location, b.vecSize, GL_FLOAT, b.normalized, 0, nullptr);
+            glEnableVertexAttribArray(b.location);
+        }
+        GLStateCache::unbindVertexArray();
+        GLStateCache::unbindArrayBuffer();
+        m_arrays.push_back(array);
+        _INFO("GLGeometryCache: create vao(%d) with %d attributes, total: %d", array.vao, (int)bindings.size(),
+              (int)m_arrays.size());
+        return array.vao;
+    }
+
+    int bufferCount() const { return (int)m_buffers.size(); }
+
+    int vertexArrayCount() const { return (int)m_arrays.size(); }
+
+    /**
+     * 需要在所属 context 的 GL 线程调用
+     */
+    void release() {
+        for (auto &array : m_arrays) {
+            glDeleteVertexArrays(1, &array.vao);
+            GLStateCache::onDeleteVertexArray(array.vao);
+            GLResTracker::instance().onDelete(RES_VERTEX_ARRAY, array.vao);
+        }
+        m_arrays.clear();
+        for (auto &buffer : m_buffers) {
+            glDeleteBuffers(1, &buffer.vbo);
+            GLStateCache::onDeleteBuffer(buffer.vbo);
+            GLResTracker::instance().onDelete(RES_BUFFER, buffer.vbo);
+        }
+        m_buffers.clear();
+        if (current() == this) {
+            makeCurrent(nullptr);
+        }
+    }
+
+private:
+    struct Buffer {
+        int shape = COORD_SHAPE_CUSTOM;
+        GLuint vbo = 0;
+    };
+
+    struct VertexArray {
+        std::vector<GLGeometryBinding> bindings;
+        GLuint vao = 0;
+    };
+
+    GLuint buffer(int shape, const float *coords, int size) {
+        for (auto &buffer : m_buffers) {
+            if (buffer.shape == shape) {
+                return buffer.vbo;
+            }
+        }
+        Buffer buffer;
+        buffer.shape = shape;
+        glGenBuffers(1, &buffer.vbo);
+        GLStateCache::bindArrayBuffer(buffer.vbo);
+        glBufferData(GL_ARRAY_BUFFER, size * (int)sizeof(float), coords, GL_STATIC_DRAW);
+        GLResTracker::instance().onCreate(RES_BUFFER, buffer.vbo, size * (int)sizeof(float), "geometry_cache");
+        m_buffers.push_back(buffer);
+        return buffer.vbo;
+    }
+
+    static GLGeometryCache *&currentRef() {
+        static thread_local GLGeometryCache *cache = nullptr;
+        return cache;
+    }
+
+private:
+    std::vector<Buffer> m_buffers;
+    std::vector<VertexArray> m_arrays;
+};
+
+NAMESPACE_END
@@ -0,0 +1,342 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__ANDROID__) || defined(__HARMONYOS__) || defined(__ZNATIVE_WITH_EGL__)
+#include <EGL/egl.h>
+#endif
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+NAMESPACE_DEFAULT
+
+struct GpuTimeStat {
+    std::string name;
+    // 有效的帧数
+    int64_t count = 0;
+    double lastMs = 0;
+    double avgMs = 0;
+    double minMs = 0;
+    double maxMs = 0;
+};
+
+/**
+ * 基于 GL_TIME_ELAPSED 查询的 GPU 计时器, 一个 GL context (线程) 对应一个
+ *
+ * begin/end 可以嵌套, 但是 GL_TIME_ELAPSED 查询本身不能嵌套, 所以进入子区间时会结束父区间当前的查询,
+ * 子区间结束后再为父区间开一个新的查询, 最后父区间的耗时 = 自身所有分段 + 所有子区间.
+ * 最外层的 end() 表示一组查询结束, 结果会在几帧之后非阻塞地读取, 不会让 pipeline 停顿.
+ *
+ * 不支持 GL_EXT_disjoint_timer_query 时 (或者 GLES2), 所有调用都是空操作.
+ */
+class GLGpuTimer {
+public:
+    /**
+     * @param maxPendingFrames 最多允许多少组查询等待结果, 超出之后丢弃最旧的一组, 避免查询无限堆积
+     */
+    explicit GLGpuTimer(int maxPendingFrames = 6) : m_max_pending(maxPendingFrames) {}
+
+    ~GLGpuTimer() {
+        _WARN_IF(!m_free_queries.empty() || !m_pending.empty(), "GLGpuTimer not released before delete!");
+    }
+
+    /**
+     * 当前线程绑定的计时器, BaseFilter 和 GLEngine 通过它来计时
+     */
+    static GLGpuTimer *current() { return currentRef(); }
+
+    static void makeCurrent(GLGpuTimer *timer) { currentRef() = timer; }
+
+public:
+    /**
+     * 需要在 GL 线程调用
+     */
+    bool available() {
+        if (m_support < 0) {
+#ifdef GL_GLES_PROTOTYPES
+            m_support = GLUtil::glMajorVersion() >= 3 && GLUtil::hasExtension("GL_EXT_disjoint_timer_query") ? 1 : 0;
+            if (m_support == 1) {
+                // 结果是 64 位的纳秒, 扩展函数在头文件中不一定有声明, 通过 eglGetProcAddress 获取
+                m_get_query_ui64 = (GetQueryObjectui64vFunc)eglGetProcAddress("glGetQueryObjectui64vEXT");
+                m_support = m_get_query_ui64 != nullptr ? 1 : 0;
+            }
+#else
+            m_support = 1;
+#endif
+            _INFO_IF(m_support == 0, "GLGpuTimer: GL_EXT_disjoint_timer_query not supported, gpu timing disabled");
+        }
+        return m_support == 1;
+    }
+
+    void begin(const std::string &name) {
+        if (!available()) {
+            return;
+        }
+        if (!m_scope_stack.empty()) {
+            glEndQuery(GL_TIME_ELAPSED);
+        }
+        m_frame.scopes.push_back({name, m_scope_stack.empty() ? -1 : m_scope_stack.back(), 0});
+        m_scope_stack.push_back((int)m_frame.scopes.size() - 1);
+        startSegment();
+    }
+
+    void end() {
+        if (!available()) {
+            return;
+        }
+        _WARN_RETURN_IF(m_scope_stack.empty(), void(), "GLGpuTimer::end() without begin()");
+        glEndQuery(GL_TIME_ELAPSED);
+        m_scope_stack.pop_back();
+
+        if (!m_scope_stack.empty()) {
+            startSegment();
+            return;
+        }
+
+        m_pending.push_back(std::move(m_frame));
+        m_frame = Frame();
+        while ((int)m_pending.size() > m_max_pending) {
+            recycle(m_pending.front());
+            m_pending.pop_front();
+            m_dropped_frames += 1;
+        }
+        collect();
+    }
+
+    /**
+     * 非阻塞读取已经完成的查询结果, end() 里面也会调用
+     */
+    void collect() {
+        while (!m_pending.empty()) {
+            Frame &frame = m_pending.front();
+            if (!resultAvailable(frame)) {
+                break;
+            }
+
+            bool disjoint = false;
+#ifdef GL_GLES_PROTOTYPES
+            GLint d = 0;
+            glGetIntegerv(GL_GPU_DISJOINT_EXT, &d);
+            disjoint = d != 0;
+#endif
+            if (disjoint) {
+                m_dropped_frames += 1;
+            } else {
+                resolve(frame);
+            }
+            recycle(frame);
+            m_pending.pop_front();
+        }
+    }
+
+    std::vector<GpuTimeStat> stats() {
+        std::lock_guard<std::mutex> lock(m_stat_mutex);
+        std::vector<GpuTimeStat> out;
+        for (auto &it : m_stats) {
+            out.push_back(it.second);
+        }
+        return out;
+    }
+
+    bool stat(const std::string &name, GpuTimeStat &out) {
+        std::lock_guard<std::mutex> lock(m_stat_mutex);
+        auto it = m_stats.find(name);
+        if (it == m_stats.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    int64_t droppedFrames() const { return m_dropped_frames.load(); }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(m_stat_mutex);
+        m_stats.clear();
+        m_dropped_frames.store(0);
+    }
+
+    /**
+     * 需要在 GL 线程调用
+     */
+    void release() {
+        if (!m_scope_stack.empty()) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_scope_stack.clear();
+        }
+        recycle(m_frame);
+        m_frame = Frame();
+        for (auto &f : m_pending) {
+            recycle(f);
+        }
+        m_pending.clear();
+        if (!m_free_queries.empty()) {
+            glDeleteQueries((GLsizei)m_free_queries.size(), m_free_queries.data());
+            m_free_queries.clear();
+        }
+        if (current() == this) {
+            makeCurrent(nullptr);
+        }
+    }
+
+private:
+    struct Scope {
+        std::string name;
+        int parent;
+        uint64_t ns;
+    };
+
+    struct Segment {
+        GLuint query;
+        int scope;
+    };
+
+    struct Frame {
+        std::vector<Scope> scopes;
+        std::vector<Segment> segments;
+    };
+
+    static GLGpuTimer *&currentRef() {
+        static thread_local GLGpuTimer *timer = nullptr;
+        return timer;
+    }
+
+    void startSegment() {
+        if (m_free_queries.empty()) {
+            GLuint queries[8];
+            glGenQueries(8, queries);
+            m_free_queries.insert(m_free_queries.end(), queries, queries + 8);
+        }
+        GLuint query = m_free_queries.back();
+        m_free_queries.pop_back();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        m_frame.segments.push_back({query, m_scope_stack.back()});
+    }
+
+    void recycle(Frame &frame) {
+        for (auto &seg : frame.segments) {
+            m_free_queries.push_back(seg.query);
+        }
+        frame.segments.clear();
+    }
+
+    static bool resultAvailable(const Frame &frame) {
+        // 从最后一个开始检查, 通常最后一个完成了前面的也都完成了
+        for (auto it = frame.segments.rbegin(); it != frame.segments.rend(); ++it) {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(it->query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void resolve(Frame &frame) {
+        for (auto &seg : frame.segments) {
+            GLuint64 ns = 0;
+#ifdef GL_GLES_PROTOTYPES
+            m_get_query_ui64(seg.query, GL_QUERY_RESULT, &ns);
+#else
+            glGetQueryObjectui64v(seg.query, GL_QUERY_RESULT, &ns);
+#endif
+            frame.scopes[seg.scope].ns += ns;
+        }
+        // 子区间的下标一定大于父区间, 倒序累加得到包含子区间的耗时
+        for (int i = (int)frame.scopes.size() - 1; i >= 0; --i) {
+            int parent = frame.scopes[i].parent;
+            if (parent >= 0) {
+                frame.scopes[parent].ns += frame.scopes[i].ns;
+            }
+        }
+
+        // 同一组里面同名的区间 (比如同一个滤镜渲染了两次) 合并成一个样本
+        std::map<std::string, uint64_t> frameNs;
+        for (int i = 0; i < (int)frame.scopes.size(); ++i) {
+            auto &scope = frame.scopes[i];
+            bool nestedInSame = false;
+            for (int p = scope.parent; p >= 0; p = frame.scopes[p].parent) {
+                if (frame.scopes[p].name == scope.name) {
+                    nestedInSame = true;
+                    break;
+                }
+            }
+            if (!nestedInSame) {
+                frameNs[scope.name] += scope.ns;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_stat_mutex);
+        for (auto &it : frameNs) {
+            double ms = (double)it.second / 1000000.0;
+            GpuTimeStat &s = m_stats[it.first];
+            if (s.count == 0) {
+                s.name = it.first;
+                s.minMs = ms;
+                s.maxMs = ms;
+            }
+            s.count += 1;
+            s.lastMs = ms;
+            s.avgMs += (ms - s.avgMs) / (double)s.count;
+            s.minMs = std::min(s.minMs, ms);
+            s.maxMs = std::max(s.maxMs, ms);
+        }
+    }
+
+private:
+    const int m_max_pending;
+    int m_support = -1;
+
+    std::vector<GLuint> m_free_queries;
+    std::vector<int> m_scope_stack;
+    Frame m_frame;
+    std::deque<Frame> m_pending;
+    // GL 线程写, 其他线程读
+    std::atomic<int64_t> m_dropped_frames{0};
+#ifdef GL_GLES_PROTOTYPES
+    typedef void (GL_APIENTRYP GetQueryObjectui64vFunc)(GLuint id, GLenum pname, GLuint64 *params);
+    GetQueryObjectui64vFunc m_get_query_ui64 = nullptr;
+#endif
+
+    std::mutex m_stat_mutex;
+    std::map<std::string, GpuTimeStat> m_stats;
+};
+
+/**
+ * 对当前线程绑定的 GLGpuTimer 计时, 没有绑定时什么也不做
+ */
+class GLGpuTimerScope {
+public:
+    explicit GLGpuTimerScope(const std::string &name) : m_timer(GLGpuTimer::current()) {
+        if (m_timer) {
+            m_timer->begin(name);
+        }
+    }
+
+    ~GLGpuTimerScope() {
+        if (m_timer) {
+            m_timer->end();
+        }
+    }
+
+private:
+    GLGpuTimer *m_timer;
+};
+
+NAMESPACE_END
@@ -0,0 +1,367 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLUtil.h"
+#include "common/utils/FileUtils.h"
+#include "common/utils/TimeUtils.h"
+
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+NAMESPACE_DEFAULT
+
+struct GLProgramCacheStat {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    // 驱动拒绝了缓存的 binary (驱动升级等), 已经回退到重新编译
+    int64_t rejects = 0;
+    // 未命中时实际编译链接的总耗时
+    double compileMs = 0;
+    // 命中时加载 binary 的总耗时
+    double loadMs = 0;
+    // 命中的 program 当初编译的耗时 - 加载耗时
+    double savedMs = 0;
+};
+
+/**
+ * program binary 缓存, 以 shader 源码 + 驱动信息 (vendor/renderer/version) 的 hash 为 key,
+ * 通过 glGetProgramBinary/glProgramBinary 持久化到缓存目录, 下次启动时跳过编译和链接.
+ *
+ * 同一进程内已经加载过的 binary 会保留在内存中, 其他 context 再创建相同的 program 时不需要读文件.
+ * 驱动不支持 program binary (GL_NUM_PROGRAM_BINARY_FORMATS == 0) 或者没有设置缓存目录时, 等同于 GLUtil::loadProgram.
+ */
+class GLProgramCache {
+public:
+    static GLProgramCache &instance() {
+        static GLProgramCache cache;
+        return cache;
+    }
+
+    /**
+     * @param dir 为空时关闭缓存
+     */
+    void setCacheDir(const std::string &dir) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dir = dir;
+        if (!m_dir.empty()) {
+            FileUtils::mkDir(m_dir.c_str());
+        }
+        _INFO("GLProgramCache: cache dir: %s", m_dir);
+    }
+
+    std::string cacheDir() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dir;
+    }
+
+    /**
+     * 需要在 GL 线程调用, 返回的 program 与 GLUtil::loadProgram 的一样, 由调用方释放
+     */
+    GLuint load(const char *vs, const char *fs) {
+        if (!enabled()) {
+            return GLUtil::loadProgram(vs, fs);
+        }
+        GLuint program = loadCached(vs, fs);
+        if (program != INVALID_GL_ID) {
+            return program;
+        }
+
+        int64_t start = TimeUtils::nowUs();
+        program = GLUtil::loadProgram(vs, fs, true);
+        if (program != INVALID_GL_ID) {
+            store(vs, fs, program, (double)(TimeUtils::nowUs() - start) / 1000.0);
+        }
+        return program;
+    }
+
+    /**
+     * 设置了缓存目录并且驱动支持 program binary, 需要在 GL 线程调用
+     */
+    bool enabled() { return !cacheDir().empty() && supported(); }
+
+    /**
+     * 只从缓存加载, 未命中或者驱动拒绝时返回 INVALID_GL_ID
+     */
+    GLuint loadCached(const char *vs, const char *fs) {
+        std::string driver = driverInfo();
+        uint64_t hash = 0;
+        std::string path = pathOf(vs, fs, driver, hash);
+        if (path.empty()) {
+            return INVALID_GL_ID;
+        }
+
+        Entry entry;
+        if (!findEntry(hash, path, driver, entry)) {
+            return INVALID_GL_ID;
+        }
+        int64_t start = TimeUtils::nowUs();
+        GLuint program = loadBinary(entry);
+        double ms = (double)(TimeUtils::nowUs() - start) / 1000.0;
+        if (program != INVALID_GL_ID) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stat.hits += 1;
+            m_stat.loadMs += ms;
+            m_stat.savedMs += entry.compileMs - ms;
+            return program;
+        }
+        _WARN("GLProgramCache: binary(%016llx) rejected by driver, recompile", (unsigned long long)hash);
+        FileUtils::deleteFile(path.c_str());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.erase(hash);
+        m_stat.rejects += 1;
+        return INVALID_GL_ID;
+    }
+
+    /**
+     * 保存一个已经链接成功的 program, 链接前需要设置 GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+     * @param compileMs 编译链接的耗时, 用于统计命中时节省的时间
+     */
+    void store(const char *vs, const char *fs, GLuint program, double compileMs) {
+        std::string driver = driverInfo();
+        uint64_t hash = 0;
+        std::string path = pathOf(vs, fs, driver, hash);
+        if (path.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stat.misses += 1;
+            m_stat.compileMs += compileMs;
+        }
+        storeBinary(program, hash, path, driver, (float)compileMs);
+    }
+
+    GLProgramCacheStat stat() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stat;
+    }
+
+    /**
+     * 清空内存和磁盘上的缓存
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        if (!m_dir.empty()) {
+            for (auto &file : FileUtils::listFiles(m_dir.c_str())) {
+                if (FileUtils::fileExtension(file.c_str()) == ".bin") {
+                    FileUtils::deleteFile(file.c_str());
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        GLenum format = 0;
+        std::vector<uint8_t> binary;
+        float compileMs = 0;
+    };
+
+    // 文件格式: Header + driver 字符串 + binary
+    struct Header {
+        char magic[4];
+        uint32_t format;
+        uint32_t binaryLength;
+        uint32_t driverLength;
+        float compileMs;
+    };
+
+    static uint64_t fnv1a(const char *str, uint64_t hash = 14695981039346656037ULL) {
+        for (const char *p = str; *p; ++p) {
+            hash ^= (uint8_t)*p;
+            hash *= 1099511628211ULL;
+        }
+        // 分隔符, 避免 "ab" + "c" 与 "a" + "bc" 冲突
+        hash ^= 0xFF;
+        hash *= 1099511628211ULL;
+        return hash;
+    }
+
+    std::string pathOf(const char *vs, const char *fs, const std::string &driver, uint64_t &hash) {
+        std::string dir = cacheDir();
+        if (dir.empty()) {
+            return "";
+        }
+        hash = fnv1a(vs, fnv1a(fs, fnv1a(driver.c_str())));
+        return tfm::format("%s/%016llx.bin", dir, (unsigned long long)hash);
+    }
+
+    static std::string driverInfo() {
+        auto str = [](GLenum name) {
+            const char *s = (const char *)glGetString(name);
+            return std::string(s ? s : "");
+        };
+        return str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+    }
+
+    static bool supported() {
+        static thread_local int support = -1;
+        if (support < 0) {
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            support = formats > 0 ? 1 : 0;
+            _INFO_IF(support == 0, "GLProgramCache: program binary not supported");
+        }
+        return support == 1;
+    }
+
+    bool findEntry(uint64_t hash, const std::string &path, const std::string &driver, Entry &out) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(hash);
+            if (it != m_entries.end()) {
+                out = it->second;
+                return true;
+            }
+        }
+        std::vector<uint8_t> data;
+        if (!readFile(path, data)) {
+            return false;
+        }
+
+        Header header{};
+        if (data.size() >= sizeof(Header)) {
+            memcpy(&header, data.data(), sizeof(Header));
+        }
+        bool valid = data.size() >= sizeof(Header) && memcmp(header.magic, "ZPB1", 4) == 0 &&
+                     data.size() == sizeof(Header) + header.driverLength + header.binaryLength &&
+                     driver.compare(0, std::string::npos, (const char *)data.data() + sizeof(Header),
+                                    header.driverLength) == 0;
+        if (!valid) {
+            _WARN("GLProgramCache: invalid cache file: %s", path);
+            FileUtils::deleteFile(path.c_str());
+            return false;
+        }
+
+        const uint8_t *binary = data.data() + sizeof(Header) + header.driverLength;
+        out.format = header.format;
+        out.binary.assign(binary, binary + header.binaryLength);
+        out.compileMs = header.compileMs;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[hash] = out;
+        return true;
+    }
+
+    // FileUtils 以文本模式读写, 这里需要二进制模式
+    static bool readFile(const std::string &path, std::vector<uint8_t> &out) {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        long length = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        out.resize(length > 0 ? (size_t)length : 0);
+        size_t read = out.empty() ? 0 : fread(out.data(), 1, out.size(), file);
+        fclose(file);
+        return length > 0 && read == out.size();
+    }
+
+    static bool writeFile(const std::string &path, const std::vector<uint8_t> &data) {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        size_t written = fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+        return written == data.size();
+    }
+
+    static GLuint loadBinary(const Entry &entry) {
+        GLuint program = glCreateProgram();
+        _ERROR_RETURN_IF(program == 0, INVALID_GL_ID, "GLProgramCache: create program error")
+
+        glProgramBinary(program, entry.format, entry.binary.data(), (GLsizei)entry.binary.size());
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            // 驱动拒绝时会产生 GL_INVALID_ENUM 等错误, 这里清掉避免影响后续的错误检查
+            while (glGetError() != GL_NO_ERROR) {}
+            glDeleteProgram(program);
+            return INVALID_GL_ID;
+        }
+        return program;
+    }
+
+    void storeBinary(GLuint program, uint64_t hash, const std::string &path, const std::string &driver,
+                     float compileMs) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        _WARN_RETURN_IF(length <= 0, void(), "GLProgramCache: program(%d) binary not retrievable", program)
+
+        Entry entry;
+        entry.binary.resize(length);
+        entry.compileMs = compileMs;
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &entry.format, entry.binary.data());
+        _WARN_RETURN_IF(written <= 0, void(), "GLProgramCache: get program(%d) binary failed", program)
+        entry.binary.resize(written);
+
+        Header header{};
+        memcpy(header.magic, "ZPB1", 4);
+        header.format = entry.format;
+        header.binaryLength = (uint32_t)written;
+        header.driverLength = (uint32_t)driver.size();
+        header.compileMs = compileMs;
+
+        std::vector<uint8_t> file(sizeof(Header) + driver.size() + written);
+        memcpy(file.data(), &header, sizeof(Header));
+        memcpy(file.data() + sizeof(Header), driver.data(), driver.size());
+        memcpy(file.data() + sizeof(Header) + driver.size(), entry.binary.data(), written);
+
+        // 先写临时文件再改名, 多个进程同时写时不会读到写了一半的文件. 临时文件名对每个写入者唯一,
+        // 否则两个写入者会写同一个临时文件, 改名后的内容可能是交错的
+        std::string tmp = tempPath(path);
+        if (writeFile(tmp, file) && std::rename(tmp.c_str(), path.c_str()) == 0) {
+            _INFO("GLProgramCache: store program binary: %s, %d bytes", path, written);
+        } else {
+            _WARN("GLProgramCache: write cache file failed: %s", path);
+            FileUtils::deleteFile(tmp.c_str());
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[hash] = std::move(entry);
+    }
+
+private:
+    /**
+     * 同一目录下的临时文件: 进程 id + 线程 id + 随机数
+     */
+    static std::string tempPath(const std::string &path) {
+#ifdef _WIN32
+        long pid = (long)_getpid();
+#else
+        long pid = (long)getpid();
+#endif
+        static thread_local std::mt19937_64 random(std::random_device{}());
+        size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+        char suffix[96];
+        snprintf(suffix, sizeof(suffix), ".%ld.%zx.%llx.tmp", pid, tid, (unsigned long long)random());
+        return path + suffix;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::string m_dir;
+    std::map<uint64_t, Entry> m_entries;
+    GLProgramCacheStat m_stat;
+};
+
+NAMESPACE_END
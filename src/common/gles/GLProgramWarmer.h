@@ -0,0 +1,232 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLProgramCache.h"
+#include "GLResTracker.h"
+#include "GLUtil.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+NAMESPACE_DEFAULT
+
+/**
+ * 在后台共享 context 上预编译 program, 渲染线程创建相同源码的 Program 时直接接管, 不再编译
+ *
+ * program 属于 share group, 以 (group, vs, fs) 区分. 支持 KHR_parallel_shader_compile 时
+ * 先提交所有的编译和链接, 再轮询 GL_COMPLETION_STATUS_KHR, 由驱动并行编译; 否则按顺序编译.
+ * 开启了 GLProgramCache 时优先从缓存加载, 新编译的也会写入缓存.
+ * 每个 program 记录发起预编译的 owner (GLEngine), release 只删除这个 owner 没有被取走的 program,
+ * 同一个 share group 中其他 owner 的预编译结果不受影响.
+ */
+class GLProgramWarmer {
+public:
+    static GLProgramWarmer &instance() {
+        static GLProgramWarmer warmer;
+        return warmer;
+    }
+
+    struct Source {
+        std::string vs;
+        std::string fs;
+    };
+
+public:
+    /**
+     * 需要在后台共享 context 的线程调用, 所有 program 编译完成后返回
+     * @param owner 发起预编译的对象, release 时使用
+     * @return 成功的个数
+     */
+    int compile(const std::vector<Source> &sources, const void *owner) {
+        const void *group = GLResTracker::currentGroup();
+        bool parallel = GLUtil::hasExtension("GL_KHR_parallel_shader_compile");
+        bool cacheEnabled = GLProgramCache::instance().enabled();
+        int64_t start = TimeUtils::nowUs();
+
+        std::vector<Job> jobs;
+        for (auto &src : sources) {
+            Key key(group, src.vs + '\0' + src.fs);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_entries.count(key) > 0) {
+                    continue;
+                }
+                m_entries[key].owner = owner;
+            }
+
+            Job job;
+            job.key = key;
+            job.src = &src;
+            if (cacheEnabled) {
+                job.program = GLProgramCache::instance().loadCached(src.vs.c_str(), src.fs.c_str());
+                if (job.program != INVALID_GL_ID) {
+                    publish(key, job.program);
+                    continue;
+                }
+            }
+            job.start = TimeUtils::nowUs();
+            submit(job, cacheEnabled);
+            jobs.push_back(job);
+        }
+        glFlush();
+
+        int success = (int)(sources.size() - jobs.size());
+        size_t remain = jobs.size();
+        while (remain > 0) {
+            for (auto &job : jobs) {
+                if (job.done) {
+                    continue;
+                }
+                if (parallel) {
+                    GLint complete = 0;
+                    glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &complete);
+                    if (!complete) {
+                        continue;
+                    }
+                }
+                job.done = true;
+                remain -= 1;
+                if (finish(job, cacheEnabled)) {
+                    success += 1;
+                }
+            }
+            if (remain > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+
+        _INFO("GLProgramWarmer: %d/%d programs ready in %.2f ms, parallel: %d", success, (int)sources.size(),
+              (double)(TimeUtils::nowUs() - start) / 1000.0, parallel);
+        return success;
+    }
+
+    /**
+     * 当前 share group 中, 这份源码已经预编译完成
+     */
+    bool ready(const std::string &vs, const std::string &fs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(Key(GLResTracker::currentGroup(), vs + '\0' + fs));
+        return it != m_entries.end() && it->second.ready;
+    }
+
+    /**
+     * 取走预编译好的 program, 之后由调用方释放; 没有或者还没编译完成时返回 INVALID_GL_ID
+     */
+    GLuint take(const std::string &vs, const std::string &fs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(Key(GLResTracker::currentGroup(), vs + '\0' + fs));
+        if (it == m_entries.end() || !it->second.ready) {
+            return INVALID_GL_ID;
+        }
+        GLuint program = it->second.program;
+        m_entries.erase(it);
+        return program;
+    }
+
+    /**
+     * 删除当前 share group 中这个 owner 预编译的, 没有被取走的 program, 需要在 GL 线程调用
+     */
+    void release(const void *owner) {
+        const void *group = GLResTracker::currentGroup();
+        std::vector<GLuint> programs;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                if (it->first.first != group || it->second.owner != owner) {
+                    it++;
+                    continue;
+                }
+                if (it->second.ready) {
+                    programs.push_back(it->second.program);
+                }
+                it = m_entries.erase(it);
+            }
+        }
+        for (GLuint program : programs) {
+            glDeleteProgram(program);
+        }
+        _INFO_IF(!programs.empty(), "GLProgramWarmer: release %d unused programs", (int)programs.size());
+    }
+
+private:
+    typedef std::pair<const void *, std::string> Key;
+
+    struct Entry {
+        const void *owner = nullptr;
+        GLuint program = INVALID_GL_ID;
+        bool ready = false;
+    };
+
+    struct Job {
+        Key key;
+        const Source *src = nullptr;
+        GLuint vertex = INVALID_GL_ID;
+        GLuint fragment = INVALID_GL_ID;
+        GLuint program = INVALID_GL_ID;
+        int64_t start = 0;
+        bool done = false;
+    };
+
+    static void submit(Job &job, bool retrievable) {
+        const char *vs = job.src->vs.c_str();
+        const char *fs = job.src->fs.c_str();
+        job.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(job.vertex, 1, &vs, nullptr);
+        glCompileShader(job.vertex);
+        job.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(job.fragment, 1, &fs, nullptr);
+        glCompileShader(job.fragment);
+
+        job.program = glCreateProgram();
+        glAttachShader(job.program, job.vertex);
+        glAttachShader(job.program, job.fragment);
+        if (retrievable) {
+            glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glLinkProgram(job.program);
+    }
+
+    bool finish(Job &job, bool cacheEnabled) {
+        GLint linked = 0;
+        glGetProgramiv(job.program, GL_LINK_STATUS, &linked);
+        glDeleteShader(job.vertex);
+        glDeleteShader(job.fragment);
+        if (!linked) {
+            // 失败时不保留记录, 渲染线程会自己编译并打印错误信息
+            _WARN("GLProgramWarmer: link program failed, fallback to render thread");
+            glDeleteProgram(job.program);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.erase(job.key);
+            return false;
+        }
+        if (cacheEnabled) {
+            double ms = (double)(TimeUtils::nowUs() - job.start) / 1000.0;
+            GLProgramCache::instance().store(job.src->vs.c_str(), job.src->fs.c_str(), job.program, ms);
+        }
+        publish(job.key, job.program);
+        return true;
+    }
+
+    void publish(const Key &key, GLuint program) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry &entry = m_entries[key];
+        entry.program = program;
+        entry.ready = true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<Key, Entry> m_entries;
+};
+
+NAMESPACE_END
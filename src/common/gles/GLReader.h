@@ -6,14 +6,63 @@
 #define GLREADER_H
 
 #include <common/Common.h>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "GLUtil.h"
+#include "GLResTracker.h"
 
 NAMESPACE_DEFAULT
 
-// 双buffer实现快速 glReadPixels
+/**
+ * 异步读取完成的一帧, 按行从下到上 (与 glReadPixels 一致), 每行紧密排列
+ */
+struct GLReadFrame {
+    // 来自 GLReader 的缓存池, 最后一个引用释放后回到池中, 可以在回调之外继续持有
+    std::shared_ptr<std::vector<uint8_t>> buffer;
+    int width = 0;
+    int height = 0;
+    // GL_RGBA / GL_RG / GL_RED
+    GLenum format = GL_RGBA;
+    int channels = 4;
+    // readAsync 返回的序号
+    int64_t id = 0;
+    // 从 readAsync 到回调开始的耗时
+    int64_t latencyUs = 0;
+
+    const uint8_t *pixels() const { return buffer ? buffer->data() : nullptr; }
+};
+
+typedef std::function<void(const GLReadFrame &frame)> GLReadCallback;
+
+struct GLReaderStat {
+    int64_t submitted = 0;
+    int64_t completed = 0;
+    // 环已满时丢弃的读取
+    int64_t dropped = 0;
+    // 驱动不支持直接读取 GL_RED/GL_RG, 以 RGBA 读取后在工作线程提取通道
+    int64_t converted = 0;
+};
+
+/**
+ * 通过 PBO 读取当前绑定的 framebuffer.
+ *
+ * readPixels: 两个 PBO 交替, 每次同步映射上一次的结果, 返回的是上一帧.
+ * readAsync/poll: N 个 PBO 组成的环, 每次读取后插入 fence, poll 时不阻塞地检查 fence,
+ * 完成的 PBO 映射后由工作线程复制到缓存池的内存中并回调, 复制完成后在下一次 poll 时解除映射.
+ * 支持 GL_RGBA/GL_RG/GL_RED 和任意子区域.
+ */
 class GLReader {
 public:
+    explicit GLReader(int depth = 3) : m_depth(std::max(depth, 1)), m_buffer_pool(std::make_shared<BufferPool>()) {}
+
+    ~GLReader() {
+        _WARN_IF(!m_slots.empty() || m_width > 0, "GLReader not released before delete!");
+    }
+
     void readPixels(const int width, const int height, const std::function<void(GLubyte *pixels, int width, int height)>& callback) {
         initialize(width, height);
 
@@ -36,19 +85,308 @@ public:
         m_cur_pbo_index = nextPBO;
     }
 
+    /**
+     * 把当前绑定的 framebuffer 的 (x, y, width, height) 区域读取到环中下一个 PBO, 不等待 GPU.
+     * 下一个 PBO 还没有回收时先 poll 一次, 依然没有空闲的则丢弃这次读取. 需要在 GL 线程调用
+     * @param format GL_RGBA / GL_RG / GL_RED
+     * @return 这次读取的序号, 丢弃时返回 -1
+     */
+    int64_t readAsync(int x, int y, int width, int height, GLenum format, const GLReadCallback &callback) {
+        int channels = channelsOf(format);
+        _ERROR_RETURN_IF(channels == 0 || width <= 0 || height <= 0, -1,
+                         "GLReader::readAsync invalid format(0x%x) or size(%d x %d)", format, width, height)
+        if (m_slots.empty()) {
+            for (int i = 0; i < m_depth; ++i) {
+                m_slots.emplace_back(new Slot());
+            }
+            m_worker.reset(new EventThread("gl_reader"));
+        }
+
+        Slot &slot = *m_slots[m_next_slot];
+        if (slot.state.load() != SLOT_FREE) {
+            poll();
+        }
+        if (slot.state.load() != SLOT_FREE) {
+            m_stat.dropped += 1;
+            return -1;
+        }
+        m_next_slot = (m_next_slot + 1) % (int)m_slots.size();
+
+        GLenum readFormat = format;
+        if (format != GL_RGBA && !directReadSupported(format)) {
+            readFormat = GL_RGBA;
+            m_stat.converted += 1;
+        }
+        int rowBytes = width * channelsOf(readFormat);
+        int64_t size = (int64_t)rowBytes * height;
+        if (slot.pbo == 0) {
+            glGenBuffers(1, &slot.pbo);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.capacity < size) {
+            if (slot.capacity > 0) {
+                GLResTracker::instance().onDelete(RES_BUFFER, slot.pbo);
+            }
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_READ);
+            GLResTracker::instance().onCreate(RES_BUFFER, slot.pbo, size, "GLReader");
+            slot.capacity = size;
+        }
+        if (rowBytes % 4 != 0) {
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        }
+        glReadPixels(x, y, width, height, readFormat, GL_UNSIGNED_BYTE, nullptr);
+        if (rowBytes % 4 != 0) {
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        slot.id = m_next_id++;
+        slot.width = width;
+        slot.height = height;
+        slot.format = format;
+        slot.readFormat = readFormat;
+        slot.size = size;
+        slot.submitUs = TimeUtils::nowUs();
+        slot.callback = callback;
+        slot.state.store(SLOT_READING);
+        m_stat.submitted += 1;
+        return slot.id;
+    }
+
+    /**
+     * 不阻塞地回收: 解除已经复制完成的 PBO 的映射, 把 fence 已经完成的 PBO 映射后交给工作线程.
+     * 按读取的顺序回调. 需要在 GL 线程调用
+     * @return 这次交给工作线程的个数
+     */
+    int poll() {
+        int dispatched = 0;
+        for (auto &slot : m_slots) {
+            if (slot->state.load() == SLOT_COPIED) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                slot->state.store(SLOT_FREE);
+            }
+        }
+        // 从最早的读取开始, fence 按提交顺序完成, 遇到没有完成的就可以停止
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            Slot &slot = *m_slots[(m_next_slot + i) % m_slots.size()];
+            if (slot.state.load() != SLOT_READING) {
+                continue;
+            }
+            GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+            _ERROR_IF(result == GL_WAIT_FAILED, "GLReader: wait fence failed, read(%lld)", (long long)slot.id);
+            dispatch(slot);
+            dispatched += 1;
+        }
+        return dispatched;
+    }
+
+    /**
+     * 等待所有的读取完成并回调, 需要在 GL 线程调用
+     */
+    void flush() {
+        while (pending() > 0) {
+            poll();
+            bool copying = false;
+            for (auto &slot : m_slots) {
+                int state = slot->state.load();
+                if (state == SLOT_READING) {
+                    glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+                    break;
+                }
+                copying = copying || state == SLOT_COPYING;
+            }
+            if (copying) {
+                m_worker->sync([]() {});
+            }
+        }
+        // 最后一个回调可能还在执行
+        if (m_worker) {
+            m_worker->sync([]() {});
+        }
+    }
+
+    /**
+     * 还没有回收的读取个数
+     */
+    int pending() const {
+        int count = 0;
+        for (auto &slot : m_slots) {
+            count += slot->state.load() != SLOT_FREE ? 1 : 0;
+        }
+        return count;
+    }
+
+    int depth() const { return m_depth; }
+
+    GLReaderStat stat() const { return m_stat; }
+
     void release() {
         if (m_width > 0) {
             glDeleteBuffers(2, m_pbos);
+            GLResTracker::instance().onDelete(RES_BUFFER, m_pbos[0]);
+            GLResTracker::instance().onDelete(RES_BUFFER, m_pbos[1]);
         }
         m_width = 0;
         m_height = 0;
         m_cur_pbo_index = 0;
+
+        if (!m_slots.empty()) {
+            flush();
+            for (auto &slot : m_slots) {
+                if (slot->pbo != 0) {
+                    glDeleteBuffers(1, &slot->pbo);
+                    GLResTracker::instance().onDelete(RES_BUFFER, slot->pbo);
+                }
+            }
+            m_slots.clear();
+            m_next_slot = 0;
+            m_worker->quit();
+            m_worker.reset();
+        }
     }
 
 private:
+    enum SlotState {
+        SLOT_FREE = 0,
+        // glReadPixels 已提交, 等待 fence
+        SLOT_READING,
+        // 已映射, 工作线程复制中
+        SLOT_COPYING,
+        // 复制完成, 等待 GL 线程解除映射
+        SLOT_COPIED,
+    };
+
+    struct Slot {
+        GLuint pbo = 0;
+        int64_t capacity = 0;
+        GLsync fence = nullptr;
+        std::atomic<int> state{SLOT_FREE};
+
+        int64_t id = 0;
+        int width = 0;
+        int height = 0;
+        GLenum format = GL_RGBA;
+        GLenum readFormat = GL_RGBA;
+        int64_t size = 0;
+        int64_t submitUs = 0;
+        GLReadCallback callback;
+    };
+
+    struct BufferPool {
+        std::mutex mutex;
+        std::vector<std::vector<uint8_t> *> free;
+
+        ~BufferPool() {
+            for (auto *b : free) {
+                delete b;
+            }
+        }
+    };
+
+    static int channelsOf(GLenum format) {
+        switch (format) {
+            case GL_RGBA: return 4;
+            case GL_RG: return 2;
+            case GL_RED: return 1;
+            default: return 0;
+        }
+    }
+
+    /**
+     * GLES 只保证 GL_RGBA + GL_UNSIGNED_BYTE, 另外支持一组由驱动决定的格式.
+     * 这组格式取决于当前绑定的 Framebuffer 的格式 (RGBA8/R8/RG8/RGB10_A2 等), 不能跨读取缓存, 每次读取时查询
+     */
+    static bool directReadSupported(GLenum format) {
+#ifdef GL_GLES_PROTOTYPES
+        GLint implFormat = 0, implType = 0;
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &implFormat);
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &implType);
+        return (GLenum)implFormat == format && (GLenum)implType == GL_UNSIGNED_BYTE;
+#else
+        return true;
+#endif
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> obtainBuffer(size_t size) {
+        std::vector<uint8_t> *buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_buffer_pool->mutex);
+            if (!m_buffer_pool->free.empty()) {
+                buffer = m_buffer_pool->free.back();
+                m_buffer_pool->free.pop_back();
+            }
+        }
+        if (buffer == nullptr) {
+            buffer = new std::vector<uint8_t>();
+        }
+        buffer->resize(size);
+        std::shared_ptr<BufferPool> pool = m_buffer_pool;
+        return std::shared_ptr<std::vector<uint8_t>>(buffer, [pool](std::vector<uint8_t> *b) {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->free.push_back(b);
+        });
+    }
+
+    void dispatch(Slot &slot) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        auto *mapped = (const uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot.size, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (mapped == nullptr) {
+            _ERROR("GLReader: map pbo failed, read(%lld) dropped", (long long)slot.id);
+            slot.state.store(SLOT_FREE);
+            m_stat.dropped += 1;
+            return;
+        }
+        slot.state.store(SLOT_COPYING);
+        m_stat.completed += 1;
+        Slot *s = &slot;
+        m_worker->post([this, s, mapped]() {
+            GLReadFrame frame;
+            frame.width = s->width;
+            frame.height = s->height;
+            frame.format = s->format;
+            frame.channels = channelsOf(s->format);
+            frame.id = s->id;
+            size_t size = (size_t)s->width * s->height * frame.channels;
+            frame.buffer = obtainBuffer(size);
+            if (s->readFormat == s->format) {
+                memcpy(frame.buffer->data(), mapped, size);
+            } else {
+                // 以 RGBA 读取, 只保留前几个通道
+                uint8_t *dst = frame.buffer->data();
+                size_t pixels = (size_t)s->width * s->height;
+                for (size_t i = 0; i < pixels; ++i) {
+                    for (int c = 0; c < frame.channels; ++c) {
+                        dst[i * frame.channels + c] = mapped[i * 4 + c];
+                    }
+                }
+            }
+            GLReadCallback callback = s->callback;
+            s->callback = nullptr;
+            frame.latencyUs = TimeUtils::nowUs() - s->submitUs;
+            // 之后 GL 线程可以复用这个 slot, 不能再访问 s
+            s->state.store(SLOT_COPIED);
+            if (callback) {
+                callback(frame);
+            }
+        });
+    }
+
     void initialize(const int width, const int height) {
         if (width != m_width || m_height != height) {
-            release();
+            if (m_width > 0) {
+                glDeleteBuffers(2, m_pbos);
+                GLResTracker::instance().onDelete(RES_BUFFER, m_pbos[0]);
+                GLResTracker::instance().onDelete(RES_BUFFER, m_pbos[1]);
+            }
 
             m_width = width;
             m_height = height;
@@ -57,6 +395,7 @@ private:
                 glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[i]);
                 // 分配足够的空间存储像素数据
                 glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4 * sizeof(GLubyte), nullptr, GL_DYNAMIC_COPY);
+                GLResTracker::instance().onCreate(RES_BUFFER, m_pbos[i], (int64_t)width * height * 4, "GLReader");
             }
             glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
         }
@@ -68,6 +407,15 @@ private:
     // 两个 PBO
     GLuint m_pbos[2] = {0};
     int m_cur_pbo_index = 0;
+
+    // 异步读取的 PBO 环
+    const int m_depth;
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    int m_next_slot = 0;
+    int64_t m_next_id = 0;
+    GLReaderStat m_stat;
+    std::unique_ptr<EventThread> m_worker;
+    std::shared_ptr<BufferPool> m_buffer_pool;
 };
 
 NAMESPACE_END
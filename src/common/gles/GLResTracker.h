@@ -0,0 +1,211 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLUtil.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+enum GLResType {
+    RES_TEXTURE = 0,
+    RES_FRAMEBUFFER,
+    RES_PROGRAM,
+    RES_BUFFER,
+    RES_VERTEX_ARRAY,
+    RES_TYPE_COUNT
+};
+
+struct GLResStat {
+    int count = 0;
+    int64_t bytes = 0;
+};
+
+/**
+ * 统计所有存活的 GL 对象, 按类型和创建者 tag 汇总数量以及估算的显存大小
+ *
+ * GL 对象的 id 只在同一个 share group 内唯一, 所以每条记录都带上当前线程的 group,
+ * group 由 EGLCtx 在 makeCurrent 时设置, 没有 EGL 的平台默认为 nullptr.
+ * 一个 group 的最后一个 context 销毁时, 还存活的对象会作为泄漏打印出来.
+ */
+class GLResTracker {
+public:
+    static GLResTracker &instance() {
+        static GLResTracker tracker;
+        return tracker;
+    }
+
+    static const char *typeName(int type) {
+        switch (type) {
+            case RES_TEXTURE: return "texture";
+            case RES_FRAMEBUFFER: return "framebuffer";
+            case RES_PROGRAM: return "program";
+            case RES_BUFFER: return "buffer";
+            case RES_VERTEX_ARRAY: return "vertex_array";
+            default: return "unknown";
+        }
+    }
+
+    static void setCurrentGroup(const void *group) { currentGroupRef() = group; }
+
+    static const void *currentGroup() { return currentGroupRef(); }
+
+    /**
+     * 在这个作用域内创建的, 没有显式指定 tag 的对象, 都记为这个 tag
+     */
+    class TagScope {
+    public:
+        explicit TagScope(const std::string &tag) { tagStack().push_back(tag); }
+
+        ~TagScope() { tagStack().pop_back(); }
+    };
+
+public:
+    void attachGroup(const void *group) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_group_refs[group] += 1;
+    }
+
+    /**
+     * @return 这个 group 最后一个 context 销毁时泄漏的对象数量
+     */
+    int detachGroup(const void *group) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ref = m_group_refs.find(group);
+        if (ref != m_group_refs.end() && --ref->second > 0) {
+            return 0;
+        }
+        if (ref != m_group_refs.end()) {
+            m_group_refs.erase(ref);
+        }
+
+        int leaks = 0;
+        for (auto it = m_objects.begin(); it != m_objects.end();) {
+            if (std::get<0>(it->first) != group) {
+                it++;
+                continue;
+            }
+            int type = std::get<1>(it->first);
+            _WARN("GLResTracker: leaked %s(%d), tag: %s, bytes: %lld", typeName(type), std::get<2>(it->first),
+                  it->second.tag.c_str(), (long long)it->second.bytes);
+            m_totals[type].count -= 1;
+            m_totals[type].bytes -= it->second.bytes;
+            it = m_objects.erase(it);
+            leaks += 1;
+        }
+        _INFO_IF(leaks == 0, "GLResTracker: group(%p) destroyed without leaks", group);
+        return leaks;
+    }
+
+    void onCreate(GLResType type, GLuint id, int64_t bytes, const char *tag = nullptr) {
+        std::string t = tag ? tag : (tagStack().empty() ? typeName(type) : tagStack().back());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &obj = m_objects[Key(currentGroup(), type, id)];
+        if (obj.tag.empty()) {
+            m_totals[type].count += 1;
+        } else {
+            // 同一个 id 重复创建, 说明之前的删除没有被记录
+            m_totals[type].bytes -= obj.bytes;
+        }
+        obj.tag = t;
+        obj.bytes = bytes;
+        m_totals[type].bytes += bytes;
+    }
+
+    void onResize(GLResType type, GLuint id, int64_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_objects.find(Key(currentGroup(), type, id));
+        if (it != m_objects.end()) {
+            m_totals[type].bytes += bytes - it->second.bytes;
+            it->second.bytes = bytes;
+        }
+    }
+
+    void onDelete(GLResType type, GLuint id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_objects.find(Key(currentGroup(), type, id));
+        if (it != m_objects.end()) {
+            m_totals[type].count -= 1;
+            m_totals[type].bytes -= it->second.bytes;
+            m_objects.erase(it);
+        }
+    }
+
+public:
+    GLResStat stat(GLResType type) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_totals[type];
+    }
+
+    GLResStat totalStat() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        GLResStat total;
+        for (auto &s : m_totals) {
+            total.count += s.count;
+            total.bytes += s.bytes;
+        }
+        return total;
+    }
+
+    /**
+     * 某个类型按 tag 汇总, type < 0 时汇总所有类型
+     */
+    std::map<std::string, GLResStat> tagStats(int type = -1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<std::string, GLResStat> stats;
+        for (auto &it : m_objects) {
+            if (type >= 0 && std::get<1>(it.first) != type) {
+                continue;
+            }
+            auto &s = stats[it.second.tag];
+            s.count += 1;
+            s.bytes += it.second.bytes;
+        }
+        return stats;
+    }
+
+    std::string dump() {
+        std::string str = "GLResTracker:";
+        for (int i = 0; i < RES_TYPE_COUNT; ++i) {
+            GLResStat s = stat((GLResType)i);
+            str += tfm::format("\n  %s: %d, %.2f mb", typeName(i), s.count, (double)s.bytes / 1024.0 / 1024.0);
+        }
+        for (auto &it : tagStats()) {
+            str += tfm::format("\n  [%s]: %d, %.2f mb", it.first, it.second.count,
+                               (double)it.second.bytes / 1024.0 / 1024.0);
+        }
+        return str;
+    }
+
+private:
+    typedef std::tuple<const void *, int, GLuint> Key;
+
+    struct Entry {
+        std::string tag;
+        int64_t bytes = 0;
+    };
+
+    static const void *&currentGroupRef() {
+        static thread_local const void *group = nullptr;
+        return group;
+    }
+
+    static std::vector<std::string> &tagStack() {
+        static thread_local std::vector<std::string> tags;
+        return tags;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<Key, Entry> m_objects;
+    GLResStat m_totals[RES_TYPE_COUNT];
+    std::map<const void *, int> m_group_refs;
+};
+
+NAMESPACE_END
@@ -0,0 +1,465 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "GLUtil.h"
+
+#include <cstring>
+
+NAMESPACE_DEFAULT
+
+struct GLStateStat {
+    // 实际发出的状态调用
+    int64_t issued = 0;
+    // 与当前状态相同的调用, 开启时被跳过, 关闭时依然发出
+    int64_t redundant = 0;
+    // 开启延迟解绑时延迟到下一次绑定的解绑调用
+    int64_t deferred = 0;
+};
+
+/**
+ * 一个 context 的 GL 状态缓存: program, framebuffer, viewport, 纹理单元和绑定的纹理, VAO, array buffer, 开关状态.
+ *
+ * gles 下的类都通过这里的静态方法修改状态, 与当前状态相同的调用直接跳过. 解绑 (绑定 0) 默认和其他绑定一样,
+ * 只有缓存确定已经绑定 0 时才跳过, 因此 Framebuffer::unbind() 之后直接调用 GL 依然画到默认的帧缓冲.
+ * setDeferUnbind(true) 时解绑延迟到下一次绑定, 只适合所有绘制都经过 gles 下的类 (用之前总是会绑定自己需要的对象) 的场景.
+ * 当前线程没有 current 的缓存时, 所有方法直接调用 GL.
+ *
+ * 与外部代码交替使用同一个 context 时: 交出去之前调用 restoreDefaults() 恢复默认的绑定,
+ * 外部代码直接修改了状态之后调用 invalidate(), 下一次调用都会重新发出.
+ *
+ * 共享 context: onDelete* 只同步删除对象的线程的缓存. 其他 context 删除的纹理/FBO 在这里依然记为已绑定,
+ * GL 复用这个名字之后, 相同 id 的绑定会被跳过而作用在已经删除的对象上; 另外 GL 要求重新绑定之后
+ * 才能看到其他 context 对纹理的修改. 因此:
+ *   - GLEngine 在每个任务 (sync/post/渲染) 开始时调用 invalidateShared(), 纹理/framebuffer/buffer 的第一次绑定一定会发出;
+ *   - 任务中途使用其他 context 刚写入的纹理 (AsyncTexture, FrameMailbox) 时调用 forgetTexture(), 下一次绑定一定会发出.
+ * 不在 GLEngine 中运行的共享 context 需要自己在任务边界调用 invalidateShared().
+ */
+class GLStateCache {
+public:
+    static constexpr int MAX_TEXTURE_UNITS = 32;
+
+    static GLStateCache *current() { return currentRef(); }
+
+    static void makeCurrent(GLStateCache *cache) {
+        currentRef() = cache;
+        if (cache != nullptr) {
+            cache->invalidate();
+        }
+    }
+
+    /**
+     * 关闭时所有调用都会发出, 依然统计冗余的次数, 用于对比
+     */
+    void setEnabled(bool enable) {
+        m_enabled = enable;
+        invalidate();
+    }
+
+    bool enabled() const { return m_enabled; }
+
+    /**
+     * 解绑延迟到下一次绑定, 默认关闭. 开启后 unbind* 不再发出 GL 调用, 外部代码不能假设解绑之后的绑定是 0.
+     * 只在缓存开启时生效
+     */
+    void setDeferUnbind(bool defer) { m_defer_unbind = defer; }
+
+    bool deferUnbind() const { return m_defer_unbind; }
+
+    const GLStateStat &stat() const { return m_stat; }
+
+    /**
+     * 状态被外部代码修改过, 全部标记为未知
+     */
+    void invalidate() {
+        m_program = UNKNOWN;
+        m_framebuffer = UNKNOWN;
+        m_vertex_array = UNKNOWN;
+        m_array_buffer = UNKNOWN;
+        m_active_unit = UNKNOWN;
+        for (auto &tex : m_textures) {
+            tex = UNKNOWN;
+        }
+        m_viewport_known = false;
+        m_scissor_known = false;
+        for (auto &cap : m_caps) {
+            cap.state = -1;
+        }
+        m_blend_known = false;
+    }
+
+    /**
+     * 可能被其他共享 context 删除或修改的对象 (纹理, framebuffer, buffer) 的绑定标记为未知, 在每个任务开始时调用
+     */
+    void invalidateShared() {
+        m_framebuffer = UNKNOWN;
+        m_array_buffer = UNKNOWN;
+        for (auto &tex : m_textures) {
+            tex = UNKNOWN;
+        }
+    }
+
+    /**
+     * 纹理在其他 context 中修改过, 当前线程的缓存中绑定着它的纹理单元标记为未知, 下一次绑定一定会发出
+     */
+    static void forgetTexture(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr) {
+            return;
+        }
+        for (auto &tex : cache->m_textures) {
+            if (tex == id) {
+                tex = UNKNOWN;
+            }
+        }
+    }
+
+    /**
+     * 恢复默认的绑定 (全部绑定 0, 纹理单元 0), 在把 context 交给外部代码之前调用
+     */
+    void restoreDefaults() {
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+            if (m_textures[i] != 0) {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+        }
+        glActiveTexture(GL_TEXTURE0);
+        invalidate();
+        m_program = m_framebuffer = m_vertex_array = m_array_buffer = 0;
+        m_active_unit = 0;
+        for (auto &tex : m_textures) {
+            tex = 0;
+        }
+    }
+
+public:
+    static int useProgram(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr) {
+            glUseProgram(id);
+            return 1;
+        }
+        if (cache->skip(cache->m_program, id)) {
+            return 0;
+        }
+        glUseProgram(id);
+        return 1;
+    }
+
+    static int bindFramebuffer(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr || !cache->skip(cache->m_framebuffer, id)) {
+            glBindFramebuffer(GL_FRAMEBUFFER, id);
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * 分别绑定 read/draw framebuffer (glBlitFramebuffer), 之后 GL_FRAMEBUFFER 的绑定视为未知
+     */
+    static int bindFramebuffers(GLuint read, GLuint draw) {
+        GLStateCache *cache = current();
+        if (cache != nullptr) {
+            cache->m_framebuffer = read == draw ? read : UNKNOWN;
+            cache->m_stat.issued += 2;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw);
+        return 2;
+    }
+
+    static int bindVertexArray(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr || !cache->skip(cache->m_vertex_array, id)) {
+            glBindVertexArray(id);
+            return 1;
+        }
+        return 0;
+    }
+
+    static int bindArrayBuffer(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr || !cache->skip(cache->m_array_buffer, id)) {
+            glBindBuffer(GL_ARRAY_BUFFER, id);
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @param unit 纹理单元的序号, 不是 GL_TEXTURE0 + n
+     */
+    static int activeTexture(int unit) {
+        GLStateCache *cache = current();
+        if (cache == nullptr || !cache->skip(cache->m_active_unit, (GLuint)unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * 绑定到当前激活的纹理单元
+     */
+    static int bindTexture2D(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr) {
+            glBindTexture(GL_TEXTURE_2D, id);
+            return 1;
+        }
+        GLuint *slot = cache->textureSlot(cache->m_active_unit);
+        if (slot == nullptr) {
+            glBindTexture(GL_TEXTURE_2D, id);
+            cache->m_stat.issued += 1;
+            return 1;
+        }
+        if (cache->skip(*slot, id)) {
+            return 0;
+        }
+        glBindTexture(GL_TEXTURE_2D, id);
+        return 1;
+    }
+
+    /**
+     * 把纹理绑定到指定的纹理单元, 这个单元已经绑定了这个纹理时不需要切换纹理单元
+     */
+    static int bindTexture2D(int unit, GLuint id) {
+        GLStateCache *cache = current();
+        if (cache != nullptr && cache->m_enabled) {
+            GLuint *slot = cache->textureSlot((GLuint)unit);
+            if (slot != nullptr && *slot == id) {
+                // 同时省掉了 glActiveTexture, 只统计一次
+                cache->m_stat.redundant += 1;
+                return 0;
+            }
+        }
+        int calls = activeTexture(unit);
+        return calls + bindTexture2D(id);
+    }
+
+    static int viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        GLStateCache *cache = current();
+        GLint rect[4] = {x, y, width, height};
+        if (cache == nullptr || !cache->skipRect(cache->m_viewport, cache->m_viewport_known, rect)) {
+            glViewport(x, y, width, height);
+            return 1;
+        }
+        return 0;
+    }
+
+    static int scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        GLStateCache *cache = current();
+        GLint rect[4] = {x, y, width, height};
+        if (cache == nullptr || !cache->skipRect(cache->m_scissor, cache->m_scissor_known, rect)) {
+            glScissor(x, y, width, height);
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * 当前的 GL_SCISSOR_TEST 开关和 scissor 区域, 缓存中已知时不查询 GL, 用于临时修改后恢复
+     */
+    static void getScissor(bool &enabled, GLint box[4]) {
+        GLStateCache *cache = current();
+        Cap *c = cache == nullptr ? nullptr : cache->capOf(GL_SCISSOR_TEST);
+        if (c != nullptr && c->state != -1) {
+            enabled = c->state == 1;
+        } else {
+            enabled = glIsEnabled(GL_SCISSOR_TEST) == GL_TRUE;
+            if (c != nullptr) {
+                c->state = enabled ? 1 : 0;
+            }
+        }
+        if (cache != nullptr && cache->m_scissor_known) {
+            memcpy(box, cache->m_scissor, sizeof(GLint) * 4);
+        } else {
+            glGetIntegerv(GL_SCISSOR_BOX, box);
+            if (cache != nullptr) {
+                memcpy(cache->m_scissor, box, sizeof(GLint) * 4);
+                cache->m_scissor_known = true;
+            }
+        }
+    }
+
+    static int setCapability(GLenum cap, bool enable) {
+        GLStateCache *cache = current();
+        Cap *c = cache == nullptr ? nullptr : cache->capOf(cap);
+        if (c != nullptr) {
+            GLuint state = c->state == -1 ? UNKNOWN : (GLuint)c->state;
+            bool skipped = cache->skip(state, enable ? 1 : 0);
+            c->state = enable ? 1 : 0;
+            if (skipped) {
+                return 0;
+            }
+        } else if (cache != nullptr) {
+            cache->m_stat.issued += 1;
+        }
+        if (enable) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+        return 1;
+    }
+
+    static int blendFunc(GLenum src, GLenum dst) {
+        GLStateCache *cache = current();
+        if (cache != nullptr) {
+            bool same = cache->m_blend_known && cache->m_blend_src == src && cache->m_blend_dst == dst;
+            cache->m_blend_known = true;
+            cache->m_blend_src = src;
+            cache->m_blend_dst = dst;
+            if (same) {
+                cache->m_stat.redundant += 1;
+                if (cache->m_enabled) {
+                    return 0;
+                }
+            }
+            cache->m_stat.issued += 1;
+        }
+        glBlendFunc(src, dst);
+        return 1;
+    }
+
+public:
+    // 解绑: 缓存确定已经绑定 0 时跳过, 开启 setDeferUnbind 时延迟到下一次绑定
+
+    static int unbindProgram() { return unbind(useProgram); }
+
+    static int unbindFramebuffer() { return unbind(bindFramebuffer); }
+
+    static int unbindVertexArray() { return unbind(bindVertexArray); }
+
+    static int unbindArrayBuffer() { return unbind(bindArrayBuffer); }
+
+    static int unbindTexture2D() { return unbind(bindTexture2D); }
+
+public:
+    // 删除对象时 GL 会把当前 context 中的绑定恢复为 0, 缓存需要同步. 只同步当前线程的缓存, 其他共享 context 见类的说明
+
+    static void onDeleteProgram(GLuint id) {
+        // 正在使用的 program 删除后依然是 current, 但是 id 可能被新的 program 复用, 只能标记为未知
+        GLStateCache *cache = current();
+        if (cache != nullptr && cache->m_program == id) {
+            cache->m_program = UNKNOWN;
+        }
+    }
+
+    static void onDeleteFramebuffer(GLuint id) { onDelete(&GLStateCache::m_framebuffer, id); }
+
+    static void onDeleteVertexArray(GLuint id) { onDelete(&GLStateCache::m_vertex_array, id); }
+
+    static void onDeleteBuffer(GLuint id) { onDelete(&GLStateCache::m_array_buffer, id); }
+
+    static void onDeleteTexture(GLuint id) {
+        GLStateCache *cache = current();
+        if (cache == nullptr) {
+            return;
+        }
+        for (auto &tex : cache->m_textures) {
+            if (tex == id) {
+                tex = 0;
+            }
+        }
+    }
+
+private:
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+
+    struct Cap {
+        GLenum cap;
+        int state;
+    };
+
+    // 记录新的状态, 返回是否可以跳过这次调用
+    bool skip(GLuint &state, GLuint value) {
+        if (state == value) {
+            m_stat.redundant += 1;
+            if (m_enabled) {
+                return true;
+            }
+        }
+        state = value;
+        m_stat.issued += 1;
+        return false;
+    }
+
+    bool skipRect(GLint *state, bool &known, const GLint *rect) {
+        if (known && memcmp(state, rect, sizeof(GLint) * 4) == 0) {
+            m_stat.redundant += 1;
+            if (m_enabled) {
+                return true;
+            }
+        }
+        memcpy(state, rect, sizeof(GLint) * 4);
+        known = true;
+        m_stat.issued += 1;
+        return false;
+    }
+
+    GLuint *textureSlot(GLuint unit) { return unit < MAX_TEXTURE_UNITS ? &m_textures[unit] : nullptr; }
+
+    Cap *capOf(GLenum cap) {
+        for (auto &c : m_caps) {
+            if (c.cap == cap) {
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
+    static int unbind(int (*bind)(GLuint)) {
+        GLStateCache *cache = current();
+        if (cache != nullptr && cache->m_enabled && cache->m_defer_unbind) {
+            cache->m_stat.deferred += 1;
+            return 0;
+        }
+        return bind(0);
+    }
+
+    static void onDelete(GLuint GLStateCache::*member, GLuint id) {
+        GLStateCache *cache = current();
+        if (cache != nullptr && cache->*member == id) {
+            cache->*member = 0;
+        }
+    }
+
+    static GLStateCache *&currentRef() {
+        static thread_local GLStateCache *cache = nullptr;
+        return cache;
+    }
+
+private:
+    bool m_enabled = true;
+    bool m_defer_unbind = false;
+    GLStateStat m_stat;
+
+    GLuint m_program = UNKNOWN;
+    GLuint m_framebuffer = UNKNOWN;
+    GLuint m_vertex_array = UNKNOWN;
+    GLuint m_array_buffer = UNKNOWN;
+    GLuint m_active_unit = UNKNOWN;
+    GLuint m_textures[MAX_TEXTURE_UNITS] = {};
+
+    GLint m_viewport[4] = {};
+    bool m_viewport_known = false;
+    GLint m_scissor[4] = {};
+    bool m_scissor_known = false;
+
+    Cap m_caps[5] = {{GL_BLEND, -1}, {GL_SCISSOR_TEST, -1}, {GL_DEPTH_TEST, -1}, {GL_CULL_FACE, -1}, {GL_STENCIL_TEST, -1}};
+
+    bool m_blend_known = false;
+    GLenum m_blend_src = 0;
+    GLenum m_blend_dst = 0;
+};
+
+NAMESPACE_END
@@ -8,12 +8,17 @@
 #include "GLReader.h"
 #include "filter/TextureFilter.h"
 #include "filter/NV21Filter.h"
+#include "filter/NV12Filter.h"
+#include "filter/YUVFilter.h"
 #include "filter/SharpenFilter.h"
 #include "filter/ColorAdjustFilter.h"
 #include "Framebuffer.h"
 #include "FramebufferPool.h"
 #include "ShareFramebuffer.h"
 #include "GLFenceSyncer.h"
+#include "GLGpuTimer.h"
+#include "GLProgramCache.h"
+#include "GLResTracker.h"
 
 NAMESPACE_DEFAULT
 
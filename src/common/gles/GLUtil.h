@@ -6,17 +6,23 @@
 
 #pragma once
 
+#include <cstdio>
 #include <cstring>
 
 #include "common/Object.h"
 #include "common/utils/Base.h"
 #include "common/Log.h"
 
-#if defined(__ANDROID__) || defined(__HARMONYOS__)
-#include <GLES3/gl3.h>
+#if defined(__ANDROID__) || defined(__HARMONYOS__) || defined(__ZNATIVE_WITH_EGL__)
+// gl31.h 包含 gl3.h 的全部内容, compute shader 等 3.1 的接口在运行时确认版本后才会调用
+#include <GLES3/gl31.h>
 #else
 #ifdef _WIN32
 #include <GL/glew.h>
+#elif defined(__linux__)
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
 #else
 #define GL_DO_NOT_WARN_IF_MULTI_GL_VERSION_HEADERS_INCLUDED
 #include <OpenGL/gl.h>
@@ -37,9 +43,20 @@ NAMESPACE_DEFAULT
 #ifdef GL_GLES_PROTOTYPES
 #define CORRECT_VERTEX_SHADER(shader) shader
 #define CORRECT_FRAGMENT_SHADER(shader) shader
+#define CORRECT_VERTEX_SHADER_ES3(shader) GLUtil::simpleConvertGLESShaderToGLES3(shader, true)
+#define CORRECT_FRAGMENT_SHADER_ES3(shader) GLUtil::simpleConvertGLESShaderToGLES3(shader, false)
+#define CORRECT_COMPUTE_SHADER(shader) ("#version 310 es\n" + std::string(shader))
 #else
 #define CORRECT_VERTEX_SHADER(shader) GLUtil::simpleConvertGLESShaderToGL(shader, true)
 #define CORRECT_FRAGMENT_SHADER(shader) GLUtil::simpleConvertGLESShaderToGL(shader, false)
+#define CORRECT_VERTEX_SHADER_ES3(shader) GLUtil::simpleConvertGLESShaderToGL(shader, true)
+#define CORRECT_FRAGMENT_SHADER_ES3(shader) GLUtil::simpleConvertGLESShaderToGL(shader, false)
+#define CORRECT_COMPUTE_SHADER(shader) ("#version 430 core\n" + std::string(shader))
+#endif
+
+// 头文件中有 compute shader 的接口 (GLES 3.1 / GL 4.3), 是否可以使用还需要 GLUtil::computeSupported 确认
+#ifdef GL_COMPUTE_SHADER
+#define ZNATIVE_GL_COMPUTE 1
 #endif
 
 class GLUtil {
@@ -50,56 +67,135 @@ public:
     static std::string simpleConvertGLESShaderToGL(std::string glesShader,
                                                    bool vertexOrFragment,
                                                    const std::string& glCoreVersion = "330") {
-        std::size_t index = 0;
-        while ((index = glesShader.find("attribute", index)) != std::string::npos) {
-            glesShader.replace(index, 9, "in");
-            index += 2;
-        }
-        index = 0;
-        while ((index = glesShader.find("varying", index)) != std::string::npos) {
-            if (vertexOrFragment) {
-                glesShader.replace(index, 7, "out");
-            } else {
-                glesShader.replace(index, 7, "in");
-            }
-            index += 2;
-        }
-
-        // 将 precision highp float; 注释掉
+        glesShader = convertGLES2Keywords(glesShader, vertexOrFragment, "out vec4 fragColor;\n");
+        glesShader = "#version " + std::to_string(GL_CORE_VERSION) + " core\n" + glesShader;
+        return glesShader;
+    }
 
+    /**
+     * 与 simpleConvertGLESShaderToGL 相同的转换, 生成 GLSL ES 3.00 的 shader, 用于 uniform block 等 ES 2.0 不支持的特性
+     */
+    static std::string simpleConvertGLESShaderToGLES3(std::string glesShader, bool vertexOrFragment) {
+        // ES 3.00 的 fragment shader 中 float 没有默认精度, 输出需要显式声明精度
+        glesShader = convertGLES2Keywords(glesShader, vertexOrFragment, "out highp vec4 fragColor;\n");
+        glesShader = "#version 300 es\n" + glesShader;
+        return glesShader;
+    }
 
-        // texture2D -> texture
-        index = 0;
-        while ((index = glesShader.find("texture2D", index)) != std::string::npos) {
-            glesShader.replace(index, 9, "texture");
-            index += 7;
+    /**
+     * 从 GL_VERSION 解析: GLES 为 "OpenGL ES <major>.<minor> ...", 桌面 GL 为 "<major>.<minor> ...".
+     * GLES2 没有 GL_MAJOR_VERSION, 查询会产生 GL_INVALID_ENUM 并留在错误队列中, 因此不使用
+     */
+    static bool glVersionNumbers(int &major, int &minor) {
+        major = minor = 0;
+        const char *version = (const char *)glGetString(GL_VERSION);
+        if (version == nullptr) {
+            return false;
         }
-
-        if ((index = glesShader.find("gl_FragColor")) != std::string::npos) {
-            glesShader.replace(index, 12, "fragColor");
-            glesShader = "out vec4 fragColor;\n" + glesShader;
+        const char *p = version;
+        while (*p != '\0' && (*p < '0' || *p > '9')) {
+            p++;
         }
-
-        glesShader = "#version " + std::to_string(GL_CORE_VERSION) + " core\n" + glesShader;
-        return glesShader;
+        return sscanf(p, "%d.%d", &major, &minor) == 2;
     }
 
     static int glMajorVersion() {
-        int majorVersion;
-        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
-        return majorVersion;
+        int major, minor;
+        glVersionNumbers(major, minor);
+        return major;
     }
 
     static int glMinorVersion() {
-        int minorVersion;
-        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
-        return minorVersion;
+        int major, minor;
+        glVersionNumbers(major, minor);
+        return minor;
+    }
+
+    /**
+     * 当前 context 是否支持 compute shader 和 image load/store (GLES 3.1 / GL 4.3 以上), 需要在 GL 线程调用
+     */
+    static bool computeSupported() {
+#ifdef ZNATIVE_GL_COMPUTE
+        int major, minor;
+        glVersionNumbers(major, minor);
+#ifdef GL_GLES_PROTOTYPES
+        return major > 3 || (major == 3 && minor >= 1);
+#else
+        return major > 4 || (major == 4 && minor >= 3);
+#endif
+#else
+        return false;
+#endif
     }
 
     static std::string glVersion() {
         return (const char *)glGetString(GL_VERSION);
     }
 
+    /**
+     * 当前 context 是否支持某个扩展, 需要在 GL 线程调用
+     */
+    static bool hasExtension(const char *name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+            if (ext && strcmp(ext, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * 估算纹理每个像素占用的字节数, 未知格式按 4 字节计算
+     */
+    static int bytesPerPixel(GLint internalFormat, GLenum type = GL_UNSIGNED_BYTE) {
+        switch (internalFormat) {
+            case GL_R8: return 1;
+            case GL_RG8: return 2;
+            case GL_RGB8: return 3;
+            case GL_RGBA8: return 4;
+            case GL_RGB10_A2: return 4;
+            case GL_R16F: return 2;
+            case GL_RG16F: return 4;
+            case GL_RGBA16F: return 8;
+            case GL_R32F: return 4;
+            case GL_RGBA32F: return 16;
+            default: break;
+        }
+
+        int channels = 4;
+        switch (internalFormat) {
+#ifdef GL_LUMINANCE
+            case GL_LUMINANCE:
+            case GL_ALPHA:
+                channels = 1;
+                break;
+            case GL_LUMINANCE_ALPHA:
+                channels = 2;
+                break;
+#endif
+            case GL_RED:
+                channels = 1;
+                break;
+            case GL_RG:
+                channels = 2;
+                break;
+            case GL_RGB:
+                channels = 3;
+                break;
+            default:
+                break;
+        }
+        if (type == GL_FLOAT) {
+            return channels * 4;
+        } else if (type == GL_HALF_FLOAT) {
+            return channels * 2;
+        }
+        return channels;
+    }
+
     static GLuint loadShader(const char *str, int type) {
         GLuint shader = glCreateShader(type);
         _ERROR_RETURN_IF(shader == INVALID_GL_ID, INVALID_GL_ID, "GLUtil::loadShader create shader failed!");
@@ -129,7 +225,10 @@ public:
         return shader;
     }
 
-    static GLuint loadProgram(const char *vstr, const char *fstr) {
+    /**
+     * @param retrievable 链接前设置 GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 之后可以通过 glGetProgramBinary 缓存
+     */
+    static GLuint loadProgram(const char *vstr, const char *fstr, bool retrievable = false) {
         GLuint vertex = loadShader(vstr, GL_VERTEX_SHADER);
         _ERROR_RETURN_IF(vertex == INVALID_GL_ID, INVALID_GL_ID, "loadProgram vertex failed");
 
@@ -151,6 +250,9 @@ public:
         GLint linked;
         glAttachShader(program, vertex);
         glAttachShader(program, fragment);
+        if (retrievable) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
         glLinkProgram(program);
         glGetProgramiv(program, GL_LINK_STATUS, &linked);
 
@@ -175,6 +277,43 @@ public:
         return program;
     }
 
+    static GLuint loadComputeProgram(const char *cstr) {
+#ifdef ZNATIVE_GL_COMPUTE
+        GLuint compute = loadShader(cstr, GL_COMPUTE_SHADER);
+        _ERROR_RETURN_IF(compute == INVALID_GL_ID, INVALID_GL_ID, "loadComputeProgram compute failed");
+
+        GLuint program = glCreateProgram();
+        if (program == INVALID_GL_ID) {
+            _ERROR("loadComputeProgram: create program error");
+            glDeleteShader(compute);
+            return INVALID_GL_ID;
+        }
+
+        GLint linked;
+        glAttachShader(program, compute);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glDeleteShader(compute);
+        if (!linked) {
+            GLint infoLen = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLen);
+            if (infoLen > 1) {
+                char * infoLog = new char[infoLen+1];
+                memset(infoLog, 0, infoLen+1);
+                glGetProgramInfoLog(program, infoLen, nullptr, (GLchar *)infoLog);
+                _ERROR("Error linking compute program: %s", infoLog);
+                delete [] infoLog;
+            }
+            glDeleteProgram(program);
+            return INVALID_GL_ID;
+        }
+        return program;
+#else
+        _ERROR("loadComputeProgram: compute shader not supported by GL headers");
+        return INVALID_GL_ID;
+#endif
+    }
+
     static void clearColor(float r, float g, float b, float a) {
         glClearColor(r, g, b, a);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -202,5 +341,39 @@ public:
     static void deleteFenceSync(GLsync syncObj) {
         glDeleteSync(syncObj);
     }
+
+private:
+    static std::string convertGLES2Keywords(std::string glesShader, bool vertexOrFragment, const char *fragColorDecl) {
+        std::size_t index = 0;
+        while ((index = glesShader.find("attribute", index)) != std::string::npos) {
+            glesShader.replace(index, 9, "in");
+            index += 2;
+        }
+        index = 0;
+        while ((index = glesShader.find("varying", index)) != std::string::npos) {
+            if (vertexOrFragment) {
+                glesShader.replace(index, 7, "out");
+            } else {
+                glesShader.replace(index, 7, "in");
+            }
+            index += 2;
+        }
+
+        // 将 precision highp float; 注释掉
+
+
+        // texture2D -> texture
+        index = 0;
+        while ((index = glesShader.find("texture2D", index)) != std::string::npos) {
+            glesShader.replace(index, 9, "texture");
+            index += 7;
+        }
+
+        if ((index = glesShader.find("gl_FragColor")) != std::string::npos) {
+            glesShader.replace(index, 12, "fragColor");
+            glesShader = fragColorDecl + glesShader;
+        }
+        return glesShader;
+    }
 };
 NAMESPACE_END
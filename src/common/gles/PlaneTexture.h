@@ -0,0 +1,174 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "Texture.h"
+
+NAMESPACE_DEFAULT
+
+/**
+ * YUV 的一个平面 (Y / U / V 为 1 通道, UV 交错为 2 通道) 对应的纹理.
+ *
+ * 直接从调用方的内存上传, 支持每行有填充的数据 (stride > width * channels), 不需要先整理成紧密排列.
+ * GLES3/desktop GL 上使用 R8/RG8 纹理和 GL_UNPACK_ROW_LENGTH, 默认直接 glTexSubImage2D, 由驱动完成唯一的一次拷贝;
+ * 开启 PBO 时写入两个交替的 pixel unpack buffer 后上传, 写入下一个 PBO 时不需要等待上一次的纹理上传完成,
+ * 适合可以异步拷贝 PBO 的 GPU (软件渲染上只会多一次拷贝).
+ * GLES2 上退回到 GL_LUMINANCE/GL_LUMINANCE_ALPHA, 有填充时逐行上传. 需要在 GL 线程调用
+ */
+class PlaneTexture {
+public:
+    explicit PlaneTexture(int channels) : m_channels(channels) {}
+
+    ~PlaneTexture() {
+        _WARN_IF(m_texture != nullptr, "PlaneTexture not released before delete!");
+    }
+
+    /**
+     * 当前 context 支持 R8/RG8, GL_UNPACK_ROW_LENGTH 和 PBO. 解析 GL_VERSION, 不在每次上传时调用
+     */
+    static bool es3() { return GLUtil::glMajorVersion() >= 3; }
+
+    /**
+     * 2 通道纹理在 shader 中第二个通道的分量: RG8 为 g, GL_LUMINANCE_ALPHA 为 a
+     */
+    static const char *secondComponent() { return es3() ? "g" : "a"; }
+
+    void setPboEnabled(bool enable) { m_pbo_enabled = enable; }
+
+    /**
+     * @param stride 每行的字节数, 不小于 width * channels
+     */
+    bool upload(const uint8_t *data, int stride, int width, int height) {
+        int rowBytes = width * m_channels;
+        _ERROR_RETURN_IF(data == nullptr || width <= 0 || height <= 0 || stride < rowBytes, false,
+                         "PlaneTexture::upload invalid plane: %d x %d, stride: %d", width, height, stride)
+        if (m_es3 < 0) {
+            // 纹理属于创建它的 context, 只需要查询一次
+            m_es3 = PlaneTexture::es3() ? 1 : 0;
+        }
+        bool es3 = m_es3 == 1;
+        if (m_texture == nullptr || m_texture->width() != width || m_texture->height() != height) {
+            releaseTexture();
+            TexParams params;
+            if (es3) {
+                params.internalFormat = m_channels == 1 ? GL_R8 : GL_RG8;
+                params.format = m_channels == 1 ? GL_RED : GL_RG;
+            } else {
+#ifdef GL_LUMINANCE
+                params.internalFormat = m_channels == 1 ? GL_LUMINANCE : GL_LUMINANCE_ALPHA;
+                params.format = params.internalFormat;
+#endif
+            }
+            m_texture = new Texture2D(width, height, params);
+            m_texture->update(nullptr);
+        }
+
+        const TexParams &params = m_texture->params();
+        GLStateCache::bindTexture2D(m_texture->id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (!es3) {
+            if (stride == rowBytes) {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, params.format, params.type, data);
+            } else {
+                for (int row = 0; row < height; ++row) {
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width, 1, params.format, params.type,
+                                    data + (size_t)row * stride);
+                }
+            }
+        } else {
+            // stride 不是通道数的整数倍时无法用 GL_UNPACK_ROW_LENGTH 表示, 逐行拷贝到 PBO 中紧密排列
+            bool rowLength = stride % m_channels == 0;
+            if (rowLength) {
+                glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / m_channels);
+            }
+            if (m_pbo_enabled || !rowLength) {
+                uploadPbo(data, rowLength ? stride : rowBytes, stride, rowBytes, height);
+            } else {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, params.format, params.type, data);
+            }
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        GLStateCache::unbindTexture2D();
+        return true;
+    }
+
+    const Texture2D *texture() const { return m_texture; }
+
+    GLuint id() const { return m_texture ? m_texture->id() : INVALID_GL_ID; }
+
+    void release() {
+        releaseTexture();
+        for (int i = 0; i < 2; ++i) {
+            if (m_pbos[i] != 0) {
+                glDeleteBuffers(1, &m_pbos[i]);
+                GLResTracker::instance().onDelete(RES_BUFFER, m_pbos[i]);
+                m_pbos[i] = 0;
+            }
+            m_pbo_sizes[i] = 0;
+        }
+    }
+
+private:
+    /**
+     * 数据写入下一个 PBO 后从 PBO 上传, dstStride 为 PBO 中每行的字节数
+     */
+    void uploadPbo(const uint8_t *data, int dstStride, int srcStride, int rowBytes, int height) {
+        int64_t size = (int64_t)dstStride * (height - 1) + rowBytes;
+        m_pbo_index = (m_pbo_index + 1) % 2;
+        GLuint &pbo = m_pbos[m_pbo_index];
+        int64_t &capacity = m_pbo_sizes[m_pbo_index];
+        if (pbo == 0) {
+            glGenBuffers(1, &pbo);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        if (capacity < size) {
+            if (capacity > 0) {
+                GLResTracker::instance().onDelete(RES_BUFFER, pbo);
+            }
+            capacity = size;
+            GLResTracker::instance().onCreate(RES_BUFFER, pbo, capacity, "PlaneTexture");
+        }
+        // 每次重新分配存储, 驱动不需要等待上一次使用这块存储的上传完成
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)capacity, nullptr, GL_STREAM_DRAW);
+        auto *dst = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (dst != nullptr) {
+            if (dstStride == srcStride) {
+                memcpy(dst, data, (size_t)size);
+            } else {
+                for (int row = 0; row < height; ++row) {
+                    memcpy(dst + (size_t)row * dstStride, data + (size_t)row * srcStride, rowBytes);
+                }
+            }
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            const TexParams &params = m_texture->params();
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_texture->width(), height, params.format, params.type, nullptr);
+        } else {
+            _ERROR("PlaneTexture: map unpack buffer failed");
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void releaseTexture() {
+        if (m_texture != nullptr) {
+            m_texture->release();
+        }
+        DELETE_TO_NULL(m_texture);
+    }
+
+private:
+    const int m_channels;
+    bool m_pbo_enabled = false;
+    // -1: 还没有查询 context 的版本
+    int m_es3 = -1;
+    Texture2D *m_texture = nullptr;
+
+    GLuint m_pbos[2] = {0, 0};
+    int64_t m_pbo_sizes[2] = {0, 0};
+    int m_pbo_index = 0;
+};
+
+NAMESPACE_END
@@ -9,9 +9,17 @@
 #include "common/utils/Array.h"
 #include "GLUtil.h"
 #include "GLCoord.h"
+#include "GLGeometryCache.h"
+#include "GLProgramCache.h"
+#include "GLProgramWarmer.h"
+#include "GLResTracker.h"
+#include "GLStateCache.h"
+#include <atomic>
+#include <cstring>
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 NAMESPACE_DEFAULT
 
@@ -50,29 +58,34 @@ public:
         if (m_size != byteSize) {
             if (m_size != -1) {
                 glDeleteBuffers(1, &m_vbo);
+                GLStateCache::onDeleteBuffer(m_vbo);
+                GLResTracker::instance().onDelete(RES_BUFFER, m_vbo);
             }
             glGenBuffers(1, &m_vbo);
 
-            glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+            GLStateCache::bindArrayBuffer(m_vbo);
             glBufferData(GL_ARRAY_BUFFER, byteSize, points, m_usage);
             m_size = byteSize;
+            GLResTracker::instance().onCreate(RES_BUFFER, m_vbo, byteSize);
         } else {
-            glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+            GLStateCache::bindArrayBuffer(m_vbo);
             glBufferSubData(GL_ARRAY_BUFFER, 0, byteSize, points);
         }
     }
 
     void bind() const {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        GLStateCache::bindArrayBuffer(m_vbo);
     }
 
     static void unbind() {
-        glBindVertexArray(0);
+        GLStateCache::unbindArrayBuffer();
     }
 
     void release() {
         if (m_size != -1) {
             glDeleteBuffers(1, &m_vbo);
+            GLStateCache::onDeleteBuffer(m_vbo);
+            GLResTracker::instance().onDelete(RES_BUFFER, m_vbo);
             _INFO("delete vbo: %d", m_vbo);
             m_size = -1;
         }
@@ -96,17 +109,20 @@ public:
     void bind() const {
         if (m_vao == -1) {
             glGenVertexArrays(1, (GLuint *)&m_vao);
+            GLResTracker::instance().onCreate(RES_VERTEX_ARRAY, m_vao, 0);
         }
-        glBindVertexArray(m_vao);
+        GLStateCache::bindVertexArray(m_vao);
     }
 
     static void unbind() {
-        glBindVertexArray(0);
+        GLStateCache::unbindVertexArray();
     }
 
     void release() {
         if (m_vao != -1) {
             glDeleteVertexArrays(1, (GLuint *)&m_vao);
+            GLStateCache::onDeleteVertexArray(m_vao);
+            GLResTracker::instance().onDelete(RES_VERTEX_ARRAY, m_vao);
             _INFO("delete vao: %d", m_vao);
             m_vao = -1;
         }
@@ -118,10 +134,35 @@ private:
 
 class Program;
 
+/**
+ * Program 在当前线程发出的 GL 调用次数, 用于统计每帧提交 uniform/attribute 的开销
+ */
+struct ProgramCallStat {
+    // Program 发出的所有 GL 调用
+    int64_t glCalls = 0;
+    // glUniform* 的调用次数
+    int64_t uniformUploads = 0;
+    // 值没有变化, 跳过的 glUniform* 次数
+    int64_t uniformSkips = 0;
+    // uniform block 整块上传的次数
+    int64_t blockUploads = 0;
+    // glGetUniformLocation/glGetAttribLocation/glGetUniformBlockIndex 的调用次数
+    int64_t locationQueries = 0;
+    // 自定义顶点数据的上传次数, 使用 GLGeometryCache 的固定坐标不需要上传
+    int64_t vertexUploads = 0;
+
+    static ProgramCallStat &current() {
+        static thread_local ProgramCallStat stat;
+        return stat;
+    }
+};
+
 class ProgField {
 public:
     ProgField(const char *name, DataType type) : m_name(name), m_type(type) {}
 
+    virtual ~ProgField() = default;
+
     inline const char *name() const { return m_name.c_str(); }
 
     inline DataType type() const { return m_type; }
@@ -165,48 +206,107 @@ public:
 
 public:
     template<typename T>
-    void put(T *v) {
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        m_data.put(v, dataElements());
+    void put(const T *v) {
+        write(v, dataElements());
     }
 
     template<typename T>
     void set(T v) {
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        m_data.put(&v, 1);
+        write(&v, 1);
     }
 
     template<typename T>
     void set(T v, T v1) {
         T a[] = {v, v1};
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        m_data.put(a, sizeof(a));
+        write(a, 2);
     }
 
     template<typename T>
     void set(T v, T v1, T v2) {
         T a[] = {v, v1, v2};
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        m_data.put(a, sizeof(a));
+        write(a, 3);
     }
 
     template<typename T>
     void set(T v, T v1, T v2, T v3) {
         T a[] = {v, v1, v2, v3};
+        write(a, 4);
+    }
+
+    /**
+     * 值有变化时拷贝到 dst 并清除标记, dst 至少 dataByteSize() 字节
+     * 先清标记再拷贝, 与 set 并发时最多多上传一次, 不会丢失更新
+     */
+    bool takeDirty(void *dst) {
+        if (!m_dirty.exchange(false)) {
+            return false;
+        }
         std::lock_guard<std::mutex> lock(m_update_mutex);
-        m_data.put(a, sizeof(a));
+        memcpy(dst, m_value, dataByteSize());
+        return true;
+    }
+
+    /**
+     * 拷贝同类型字段的值, 值没有变化时不会标记为需要上传
+     */
+    bool copyFrom(ProgField &src) {
+        _ERROR_RETURN_IF(src.m_type != m_type, false, "ProgField(%s) copy from different type: %d -> %d", m_name.c_str(),
+                         src.m_type, m_type);
+        uint8_t value[sizeof(m_value)];
+        {
+            std::lock_guard<std::mutex> lock(src.m_update_mutex);
+            memcpy(value, src.m_value, sizeof(value));
+        }
+        write(value, src.dataByteSize());
+        return true;
+    }
+
+    /**
+     * program 重新创建后, location 需要重新查询, 值也需要重新上传
+     */
+    virtual void invalidate() {
+        m_location = -1;
+        m_location_resolved = false;
+        m_dirty = true;
     }
 
 protected:
-    int ivalue(int i) { return m_data.at<int>(i); }
+    template<typename T>
+    void write(const T *v, int count) {
+        size_t bytes = sizeof(T) * count;
+        _FATAL_IF(bytes > sizeof(m_value), "ProgField(%s) value overflow: %d bytes", m_name.c_str(), (int)bytes);
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        // 只有值变化时才需要重新上传
+        if (memcmp(m_value, v, bytes) != 0) {
+            memcpy(m_value, v, bytes);
+            m_dirty = true;
+        }
+    }
 
-    float fvalue(int i) { return m_data.at<float>(i); }
+    int ivalue(int i) const {
+        int v;
+        memcpy(&v, m_value + i * sizeof(int), sizeof(int));
+        return v;
+    }
+
+    float fvalue(int i) const {
+        float v;
+        memcpy(&v, m_value + i * sizeof(float), sizeof(float));
+        return v;
+    }
 
-    void setLocation(int loc) { m_location = loc; }
+    void setLocation(int loc) {
+        m_location = loc;
+        m_location_resolved = true;
+    }
 
 protected:
-    Array m_data;
+    // 最大为 mat4
+    uint8_t m_value[16 * sizeof(float)] = {0};
+    std::atomic<bool> m_dirty = {true};
+
     int m_location = -1;
+    bool m_location_resolved = false;
 
     const std::string m_name;
     const DataType m_type;
@@ -219,65 +319,258 @@ public:
     Uniform(const char *name, DataType type, int unitIndex = -1) : ProgField(name, type), m_tex_unit_index(unitIndex) {}
 
     void input(GLint progId) {
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        if (m_location < 0) {
-            m_location = glGetUniformLocation(progId, m_name.c_str());
+        ProgramCallStat &stat = ProgramCallStat::current();
+        if (!m_location_resolved) {
+            setLocation(glGetUniformLocation(progId, m_name.c_str()));
+            stat.glCalls += 1;
+            stat.locationQueries += 1;
             _ERROR_IF(m_location < 0, "Uniform(%s) location not found! ", m_name.c_str());
         }
-//        _INFO("Uniform(%s) location(%d), data type: %d", m_name.c_str(), m_location, m_type);
+        if (m_type == SAMPLER_2D) {
+            // 纹理单元的绑定是 context 的状态, 其他滤镜会修改, 每次都需要绑定, 与当前绑定相同时由 GLStateCache 跳过
+            _FATAL_IF(m_tex_unit_index < 0, "Error texture unit index: %d", m_tex_unit_index);
+            GLint texId;
+            {
+                std::lock_guard<std::mutex> lock(m_update_mutex);
+                texId = ivalue(0);
+            }
+            stat.glCalls += GLStateCache::bindTexture2D(m_tex_unit_index, (GLuint)texId);
+            // uniform 的值是纹理单元, 定义之后不变, 只需要设置一次
+            if (m_location >= 0 && !m_unit_uploaded) {
+                m_unit_uploaded = true;
+                glUniform1i(m_location, m_tex_unit_index);
+                stat.glCalls += 1;
+                stat.uniformUploads += 1;
+            } else {
+                stat.uniformSkips += 1;
+            }
+            return;
+        }
+
+        // uniform 的值保存在 program 中, 没有变化时不需要重新上传
+        float value[16];
+        if (m_location < 0 || !takeDirty(value)) {
+            stat.uniformSkips += 1;
+            return;
+        }
+        stat.glCalls += 1;
+        stat.uniformUploads += 1;
+
         GLint loc = m_location;
+        const GLint *ivalues = (const GLint *)value;
         switch (m_type) {
         case INT :
-            glUniform1i(loc, ivalue(0));
+            glUniform1i(loc, ivalues[0]);
             break;
         case IVEC2 :
-            glUniform2i(loc, ivalue(0), ivalue(1));
+            glUniform2i(loc, ivalues[0], ivalues[1]);
             break;
         case IVEC3 :
-            glUniform3i(loc, ivalue(0), ivalue(1), ivalue(2));
+            glUniform3i(loc, ivalues[0], ivalues[1], ivalues[2]);
             break;
         case IVEC4 :
-            glUniform4i(loc, ivalue(0), ivalue(1), ivalue(2), ivalue(3));
+            glUniform4i(loc, ivalues[0], ivalues[1], ivalues[2], ivalues[3]);
             break;
         case FLOAT :
-            glUniform1f(loc, fvalue(0));
+            glUniform1f(loc, value[0]);
             break;
         case FVEC2 :
-            glUniform2f(loc, fvalue(0), fvalue(1));
+            glUniform2f(loc, value[0], value[1]);
             break;
         case FVEC3 :
-            glUniform3f(loc, fvalue(0), fvalue(1), fvalue(2));
+            glUniform3f(loc, value[0], value[1], value[2]);
             break;
         case FVEC4 :
-            glUniform4f(loc, fvalue(0), fvalue(1), fvalue(2), fvalue(3));
+            glUniform4f(loc, value[0], value[1], value[2], value[3]);
             break;
         case FMAT2 :
-            glUniformMatrix2fv(loc, 1, GL_FALSE, m_data.data<float>());
+            glUniformMatrix2fv(loc, 1, GL_FALSE, value);
             break;
         case FMAT3 :
-            glUniformMatrix3fv(loc, 1, GL_FALSE, m_data.data<float>());
+            glUniformMatrix3fv(loc, 1, GL_FALSE, value);
             break;
         case FMAT4 :
-            glUniformMatrix4fv(loc, 1, GL_FALSE, m_data.data<float>());
+            glUniformMatrix4fv(loc, 1, GL_FALSE, value);
             break;
-        case SAMPLER_2D : {
-            _FATAL_IF(m_tex_unit_index < 0, "Error texture unit index: %d", m_tex_unit_index);
-            GLint texId = ivalue(0);
-            GLint unit = GL_TEXTURE0 + m_tex_unit_index;
-            glActiveTexture(unit);
-            glBindTexture(GL_TEXTURE_2D, texId);
-            glUniform1i(loc, m_tex_unit_index);
-            //_INFO("input texture(%d) unit index(%d)", texId, m_tex_unit_index);
-        } break;
-
         default :
             _FATAL("invalid uniform(%s) data type: %d", m_name.c_str(), m_type);
             return;
         }
     }
 
+    void invalidate() override {
+        ProgField::invalidate();
+        m_unit_uploaded = false;
+    }
+
 private:
     const int m_tex_unit_index;
+    bool m_unit_uploaded = false;
+};
+
+/**
+ * std140 布局的 uniform block, 参数较多的滤镜用一个 UBO 代替多次 glUniform* 调用.
+ * 成员需要按照 shader 中声明的顺序定义, 偏移按 std140 的规则计算; 任意成员变化时整块上传一次.
+ * 需要 GLSL 300 es / 330 以上的 shader
+ */
+class UniformBlock {
+public:
+    UniformBlock(const char *name, GLuint binding) : m_name(name), m_binding(binding) {}
+
+    ~UniformBlock() {
+        if (m_ubo != INVALID_GL_ID) {
+            _WARN("UniformBlock(%s) buffer(%d) not released before delete!", m_name.c_str(), m_ubo);
+            this->release();
+        }
+        for (auto &member : m_members) {
+            delete member.field;
+        }
+    }
+
+    inline const char *name() const { return m_name.c_str(); }
+
+    inline GLuint binding() const { return m_binding; }
+
+    /**
+     * 按 shader 中的声明顺序定义成员, 返回的指针在 Program 销毁前一直有效
+     */
+    ProgField *defMember(const char *name, DataType type) {
+        for (auto &member : m_members) {
+            if (member.field->name() == std::string(name)) {
+                return member.field;
+            }
+        }
+        int align = 4, size = 4;
+        switch (type) {
+        case FLOAT :
+        case INT :
+            break;
+        case FVEC2 :
+        case IVEC2 :
+            align = size = 8;
+            break;
+        case FVEC3 :
+        case IVEC3 :
+            align = 16;
+            size = 12;
+            break;
+        case FVEC4 :
+        case IVEC4 :
+            align = size = 16;
+            break;
+        case FMAT2 :
+        case FMAT3 :
+        case FMAT4 :
+            // 矩阵按列存储, 每列都按 vec4 对齐
+            align = 16;
+            size = 16 * (type == FMAT2 ? 2 : (type == FMAT3 ? 3 : 4));
+            break;
+        default :
+            _FATAL("Unsupported field type(%d) for UniformBlock(%s) member(%s)", type, m_name.c_str(), name);
+        }
+        Member member;
+        member.field = new ProgField(name, type);
+        member.offset = (m_size + align - 1) / align * align;
+        m_size = member.offset + size;
+        m_members.push_back(member);
+        // block 的大小是 vec4 的整数倍
+        m_data.resize((m_size + 15) / 16 * 16, 0);
+        return member.field;
+    }
+
+    void input(GLuint progId) {
+        ProgramCallStat &stat = ProgramCallStat::current();
+        if (!m_index_resolved) {
+            GLuint index = glGetUniformBlockIndex(progId, m_name.c_str());
+            stat.glCalls += 1;
+            stat.locationQueries += 1;
+            if (index == GL_INVALID_INDEX) {
+                _ERROR("UniformBlock(%s) not found!", m_name.c_str());
+            } else {
+                glUniformBlockBinding(progId, index, m_binding);
+                stat.glCalls += 1;
+            }
+            m_index_resolved = true;
+        }
+
+        if (m_ubo == INVALID_GL_ID) {
+            glGenBuffers(1, &m_ubo);
+            glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+            glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_data.size(), nullptr, GL_DYNAMIC_DRAW);
+            GLResTracker::instance().onCreate(RES_BUFFER, m_ubo, (int64_t)m_data.size());
+            stat.glCalls += 3;
+            for (auto &member : m_members) {
+                member.field->invalidate();
+            }
+        }
+
+        bool dirty = false;
+        for (auto &member : m_members) {
+            dirty |= pack(member);
+        }
+        if (dirty) {
+            glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)m_data.size(), m_data.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            stat.glCalls += 3;
+            stat.blockUploads += 1;
+        } else {
+            stat.uniformSkips += (int64_t)m_members.size();
+        }
+        // binding point 是 context 的状态, 其他 program 可能用了同一个
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ubo);
+        stat.glCalls += 1;
+    }
+
+    /**
+     * program 重新创建后需要重新查询 block index
+     */
+    void invalidate() { m_index_resolved = false; }
+
+    void release() {
+        if (m_ubo != INVALID_GL_ID) {
+            glDeleteBuffers(1, &m_ubo);
+            GLResTracker::instance().onDelete(RES_BUFFER, m_ubo);
+            _INFO("delete uniform block(%s) buffer: %d", m_name.c_str(), m_ubo);
+            m_ubo = INVALID_GL_ID;
+        }
+        m_index_resolved = false;
+    }
+
+private:
+    struct Member {
+        ProgField *field = nullptr;
+        int offset = 0;
+    };
+
+    bool pack(Member &member) {
+        float value[16];
+        if (!member.field->takeDirty(value)) {
+            return false;
+        }
+        uint8_t *dst = m_data.data() + member.offset;
+        DataType type = member.field->type();
+        if (type == FMAT2 || type == FMAT3) {
+            int n = type == FMAT2 ? 2 : 3;
+            for (int col = 0; col < n; ++col) {
+                memcpy(dst + col * 16, value + col * n, n * sizeof(float));
+            }
+        } else {
+            memcpy(dst, value, member.field->dataByteSize());
+        }
+        return true;
+    }
+
+private:
+    const std::string m_name;
+    const GLuint m_binding;
+
+    std::vector<Member> m_members;
+    std::vector<uint8_t> m_data;
+    int m_size = 0;
+
+    GLuint m_ubo = INVALID_GL_ID;
+    bool m_index_resolved = false;
 };
 
 class Attribute : public ProgField {
@@ -289,6 +582,7 @@ public:
         this->m_vec_size = vecSize;
         this->m_normalized = normalized;
         m_data.put(values, size);
+        m_data_version += 1;
     }
 
     void put(GLCoord &coords, int vecSize = 2, bool normalized = false) {
@@ -298,6 +592,7 @@ public:
         this->m_vec_size = vecSize;
         this->m_normalized = normalized;
         m_data.put(values, size);
+        m_data_version += 1;
     }
 
     void bind(GLCoord &coords, int vecSize = 2, bool normalized = false) {
@@ -305,30 +600,74 @@ public:
         this->m_vec_size = vecSize;
         this->m_normalized = normalized;
         m_bind_coord = &coords;
+        m_vbo_ready = false;
     }
 
-    void input(GLint progId, const VAO& vao) {
-        std::lock_guard<std::mutex> lock(m_update_mutex);
-        if (m_location < 0) {
-            m_location = glGetAttribLocation(progId, m_name.c_str());
+    int location(GLint progId) {
+        if (!m_location_resolved) {
+            setLocation(glGetAttribLocation(progId, m_name.c_str()));
+            ProgramCallStat &stat = ProgramCallStat::current();
+            stat.glCalls += 1;
+            stat.locationQueries += 1;
             _ERROR_IF(m_location < 0, "Attribute(%s) location not found! ", m_name.c_str());
         }
+        return m_location;
+    }
+
+    /**
+     * 绑定的坐标是常用的固定坐标时, 填充 GLGeometryCache 需要的信息
+     */
+    bool geometryBinding(GLint progId, GLGeometryBinding &out) {
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        if (m_type != FLOAT_POINTER || m_bind_coord == nullptr || location(progId) < 0) {
+            return false;
+        }
+        uint32_t version = 0;
+        out.shape = m_bind_coord->shape(version);
+        if (out.shape == COORD_SHAPE_CUSTOM) {
+            return false;
+        }
+        out.location = m_location;
+        out.vecSize = m_vec_size;
+        out.normalized = m_normalized;
+        out.coords = m_bind_coord->get(out.size);
+        return true;
+    }
+
+    /**
+     * 设置到当前绑定的 VAO 上, 顶点数据只在内容变化时上传
+     */
+    void input(GLint progId) {
+        std::lock_guard<std::mutex> lock(m_update_mutex);
+        ProgramCallStat &stat = ProgramCallStat::current();
+        GLint loc = location(progId);
 //        _INFO("Attribute(%s) location(%d), data type: %d", m_name.c_str(), m_location, m_type);
-        GLint loc = m_location;
         switch (m_type) {
         case FLOAT :
             glVertexAttrib1f(loc, fvalue(0));
+            stat.glCalls += 1;
             break;
         case FVEC2 :
             glVertexAttrib2f(loc, fvalue(0), fvalue(1));
+            stat.glCalls += 1;
             break;
         case FVEC3 :
             glVertexAttrib3f(loc, fvalue(0), fvalue(1), fvalue(2));
+            stat.glCalls += 1;
             break;
         case FVEC4 :
             glVertexAttrib4f(loc, fvalue(0), fvalue(1), fvalue(2), fvalue(3));
+            stat.glCalls += 1;
             break;
         case FLOAT_POINTER : {
+            uint32_t version = m_data_version;
+            if (m_bind_coord) {
+                m_bind_coord->shape(version);
+            }
+            if (m_vbo_ready && version == m_uploaded_version) {
+                break;
+            }
+
             int dataSize = 0;
             const float *d;
             if (m_bind_coord) {
@@ -340,12 +679,14 @@ public:
 
             int unitSize = sizeof(float);
             m_vbo.bind((const void *)d, dataSize*unitSize);
-            vao.bind();
             glVertexAttribPointer(loc, m_vec_size,
                                   GL_FLOAT, m_normalized,  0, nullptr);
             glEnableVertexAttribArray(loc);
-            VAO::unbind();
-            VBO::unbind();
+            int unbound = GLStateCache::unbindArrayBuffer();
+            m_vbo_ready = true;
+            m_uploaded_version = version;
+            stat.glCalls += 4 + unbound;
+            stat.vertexUploads += 1;
 //            CHECK_GL_ERROR
 //            _INFO("input(%d), [%f, %f, %f, %f, %f, %f, %f, %f]", dataSize, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
             break;
@@ -355,17 +696,29 @@ public:
         }
     }
 
+    void invalidate() override {
+        ProgField::invalidate();
+        m_vbo_ready = false;
+    }
+
     void release() {
         m_vbo.release();
+        m_vbo_ready = false;
     }
 
 private:
+    // FLOAT_POINTER 类型的顶点数据, 长度不固定
+    Array m_data;
+    uint32_t m_data_version = 0;
     // 这里的size不是数组的长度，而是 glVertexAttriPointer 的第二个参数，是 vecX 的维度
     int m_vec_size = 2;
     bool m_normalized = false;
     GLCoord *m_bind_coord = nullptr;
 
     VBO m_vbo;
+    // VBO 已经上传并设置到 program 的 VAO 上
+    bool m_vbo_ready = false;
+    uint32_t m_uploaded_version = 0;
 };
 
 class Program {
@@ -378,13 +731,23 @@ public:
             _WARN("GL program(%d) not released before delete!", m_id);
             this->release();
         }
+
+        for (auto *attr : m_attrs) {
+            delete attr;
+        }
+        for (auto *uni : m_uniforms) {
+            delete uni;
+        }
+        for (auto *block : m_blocks) {
+            delete block;
+        }
     }
 
     bool create() { return create(m_vertex_shader.c_str(), m_fragment_shader.c_str()); }
 
     bool create(const char *vs, const char *fs) {
         if (m_id == INVALID_GL_ID) {
-            m_id = GLUtil::loadProgram(vs, fs);
+            m_id = loadProgram(vs, fs);
             _ERROR_RETURN_IF(m_id == INVALID_GL_ID, false, "create gl program failed:\n%s\n---\n%s\n", vs, fs);
 
             m_vertex_shader = vs;
@@ -393,20 +756,53 @@ public:
             _WARN("recreate gl program!!");
             release();
 
-            m_id = GLUtil::loadProgram(vs, fs);
+            m_id = loadProgram(vs, fs);
             _ERROR_RETURN_IF(m_id == INVALID_GL_ID, false, "create gl program failed:\n%s\n---\n%s\n", vs, fs);
 
             m_vertex_shader = vs;
             m_fragment_shader = fs;
         }
+        // 新的 program 需要重新查询 location, 并上传所有的值
+        invalidateFields();
+        GLint binaryLength = 0;
+        glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+        GLResTracker::instance().onCreate(RES_PROGRAM, m_id, binaryLength);
         _INFO("gl program created successfully, id: %d", m_id);
         return true;
     }
 
+    /**
+     * 创建 compute program, 不经过预编译和 binary 缓存
+     */
+    bool createCompute(const char *cs) {
+        if (m_id != INVALID_GL_ID) {
+            if (m_compute_shader == cs) {
+                return true;
+            }
+            _WARN("recreate gl compute program!!");
+            release();
+        }
+        m_id = GLUtil::loadComputeProgram(cs);
+        _ERROR_RETURN_IF(m_id == INVALID_GL_ID, false, "create gl compute program failed:\n%s\n", cs);
+        m_compute_shader = cs;
+        invalidateFields();
+        GLResTracker::instance().onCreate(RES_PROGRAM, m_id, 0);
+        _INFO("gl compute program created successfully, id: %d", m_id);
+        return true;
+    }
+
     inline GLuint id() const { return m_id; }
 
     inline bool valid() const { return m_id != INVALID_GL_ID; }
 
+    /**
+     * 优先使用后台预编译好的 program, 其次是 program binary 缓存, 最后才在当前线程编译
+     */
+    static GLuint loadProgram(const char *vs, const char *fs) {
+        GLuint id = GLProgramWarmer::instance().take(vs, fs);
+        return id != INVALID_GL_ID ? id : GLProgramCache::instance().load(vs, fs);
+    }
+
     bool isAttached() const { return m_attached; }
 
     bool attach() {
@@ -417,7 +813,7 @@ public:
                     return false;
                 }
             }
-            glUseProgram(m_id);
+            GLStateCache::useProgram(m_id);
             m_attached = true;
         } else {
             _WARN("gl program(%d) already attached", m_id);
@@ -428,19 +824,26 @@ public:
     void input() {
         _FATAL_IF(!m_attached, "gl program(%d) not attached while input", m_id);
 
-        for (auto &kv : m_attr_map) {
-            kv.second->input(m_id, m_vao);
+        // compute program 没有 attribute, 不需要 VAO
+        if (!m_attrs.empty() && !bindSharedVertexArray()) {
+            m_vao.bind();
+            ProgramCallStat::current().glCalls += 1;
+            for (auto *attr : m_attrs) {
+                attr->input(m_id);
+            }
         }
-        for (auto &kv : m_uniform_map) {
-            kv.second->input(m_id);
+        for (auto *uni : m_uniforms) {
+            uni->input(m_id);
+        }
+        for (auto *block : m_blocks) {
+            block->input(m_id);
         }
-        m_vao.bind();
     }
 
     void detach() {
         if (m_attached) {
             VAO::unbind();
-            glUseProgram(0);
+            GLStateCache::unbindProgram();
             m_attached = false;
         } else {
             _WARN("gl program(%d) already detached", m_id);
@@ -454,6 +857,7 @@ public:
         }
         Attribute *attr = new Attribute(name, type);
         m_attr_map[name] = attr;
+        m_attrs.push_back(attr);
         return attr;
     }
 
@@ -473,6 +877,7 @@ public:
 
         Uniform *uni = type == SAMPLER_2D ? new Uniform(name, type, nextTexUnitIndex()) : new Uniform(name, type);
         m_uniform_map[name] = uni;
+        m_uniforms.push_back(uni);
         return uni;
     }
 
@@ -484,30 +889,86 @@ public:
         return nullptr;
     }
 
+    /**
+     * 按定义顺序的所有 uniform
+     */
+    inline const std::vector<Uniform *> &uniforms() const { return m_uniforms; }
+
+    /**
+     * 定义 std140 的 uniform block, 每个 block 占用一个 binding point
+     */
+    UniformBlock *defUniformBlock(const char *name) {
+        UniformBlock *block = uniformBlock(name);
+        if (block == nullptr) {
+            block = new UniformBlock(name, (GLuint)m_blocks.size());
+            m_blocks.push_back(block);
+        }
+        return block;
+    }
+
+    UniformBlock *uniformBlock(const char *name) {
+        for (auto *block : m_blocks) {
+            if (strcmp(block->name(), name) == 0) {
+                return block;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * 只释放 GL 资源, 定义的 attribute/uniform 保留, 之前拿到的指针依然有效, 下次 create 之后可以继续使用
+     */
     void release() {
         if (m_id != INVALID_GL_ID) {
             glDeleteProgram(m_id);
+            GLStateCache::onDeleteProgram(m_id);
+            GLResTracker::instance().onDelete(RES_PROGRAM, m_id);
             _INFO("release gl program(%d)", m_id);
             m_id = INVALID_GL_ID;
         }
 
-        // 释放 m_attr_map 中的指针内存
-        for (auto &pair : m_attr_map) {
-            pair.second->release();
-            delete pair.second;
+        for (auto *attr : m_attrs) {
+            attr->release();
         }
-        m_attr_map.clear();
-
-        // 释放 m_uniform_map 中的指针内存
-        for (auto &pair : m_uniform_map) {
-            delete pair.second;
+        for (auto *block : m_blocks) {
+            block->release();
         }
-        m_uniform_map.clear();
+        invalidateFields();
 
         m_vao.release();
     }
 
 private:
+    /**
+     * 所有 attribute 都是常用的固定坐标时, 使用当前 context 的 GLGeometryCache 中共享的 VAO
+     */
+    bool bindSharedVertexArray() {
+        GLGeometryCache *cache = GLGeometryCache::current();
+        if (cache == nullptr || m_attrs.empty()) {
+            return false;
+        }
+        m_geometry_bindings.resize(m_attrs.size());
+        for (size_t i = 0; i < m_attrs.size(); ++i) {
+            if (!m_attrs[i]->geometryBinding(m_id, m_geometry_bindings[i])) {
+                return false;
+            }
+        }
+        ProgramCallStat::current().glCalls += GLStateCache::bindVertexArray(cache->vertexArray(m_geometry_bindings));
+        return true;
+    }
+
+    void invalidateFields() {
+        for (auto *attr : m_attrs) {
+            attr->invalidate();
+        }
+        for (auto *uni : m_uniforms) {
+            uni->invalidate();
+        }
+        for (auto *block : m_blocks) {
+            block->invalidate();
+        }
+    }
+
     int nextTexUnitIndex() {
         int i = m_uniform_texture_count;
         m_uniform_texture_count += 1;
@@ -519,6 +980,7 @@ private:
 
     std::string m_vertex_shader;
     std::string m_fragment_shader;
+    std::string m_compute_shader;
 
     bool m_attached = false;
     int m_uniform_texture_count = 0;
@@ -526,6 +988,11 @@ private:
     VAO m_vao;
     std::map<std::string, Attribute *> m_attr_map;
     std::map<std::string, Uniform *> m_uniform_map;
+    // 按定义的顺序上传, 避免每次遍历 map
+    std::vector<Attribute *> m_attrs;
+    std::vector<Uniform *> m_uniforms;
+    std::vector<UniformBlock *> m_blocks;
+    std::vector<GLGeometryBinding> m_geometry_bindings;
 };
 
 NAMESPACE_END
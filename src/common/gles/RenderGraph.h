@@ -0,0 +1,567 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "Framebuffer.h"
+#include "GLResTracker.h"
+#include "filter/BaseFilter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 声明式的渲染图: 节点是 BaseFilter, 边是纹理
+ *
+ * 用法:
+ *   auto src = graph.importTexture("camera");
+ *   auto a = graph.addPass("sharpen", &sharpen, {src}, bindSharpen);
+ *   auto b = graph.addPass("color", &color, {a}, bindColor);
+ *   graph.setOutput(b, &screenFb);
+ *   // 每帧
+ *   graph.setImport(src, &cameraTex);
+ *   graph.execute();
+ *
+ * 编译时从输出反推, 没有被输出用到的 pass 不会执行; 中间纹理按生命周期分配,
+ * 生命周期不重叠且尺寸相同的中间结果共用同一个 Framebuffer.
+ * 只有图结构或者输入尺寸变化时才重新编译, 其他帧直接按编译结果执行.
+ * setRenderScale 按比例缩小所有中间结果 (动态分辨率), 渲染到外部 target 的 pass 保持 target 的尺寸, 采样时放大.
+ * 编译后不再使用的中间 Framebuffer 不会立即释放, 留作备用 (最多为使用中的两倍, 优先保留大的), 比例回到之前的 step
+ * 时直接复用, 不需要重新分配.
+ *
+ * setDamageTracking 开启后只重新渲染变化的区域: setImportDamage 标记输入中变化的区域, 沿着图传播,
+ * 每个 pass 按输入的变化 (换算到输出尺寸, 按滤镜的 damagePadding 扩大) 只更新输出的一部分, 输入没有变化的 pass 不执行.
+ * 此时每个 pass 的输出独占一个 Framebuffer, 保留上一帧的内容. 编译之后的第一帧, 以及 invalidateDamage 之后 (例如滤镜参数变化), 整帧渲染.
+ *
+ * 所有接口都需要在 GL 线程调用
+ */
+class RenderGraph {
+public:
+    typedef int ResId;
+    typedef int PassId;
+
+    static const ResId INVALID_RES = -1;
+
+    /**
+     * 设置滤镜的输入纹理和参数, 不需要调用 render, 也不需要设置 viewport 以外的输出
+     * @param inputs 与 addPass 的 inputs 一一对应
+     * @param width height 输出尺寸
+     */
+    typedef std::function<void(const std::vector<const Texture2D *> &inputs, int width, int height)> PassBinder;
+
+    explicit RenderGraph(const char *name = "RenderGraph") : m_name(name) {}
+
+    ~RenderGraph() {
+        _WARN_IF(!m_physical.empty() || !m_spare.empty(), "RenderGraph(%s) not released before destroyed!", m_name);
+    }
+
+public:
+    /**
+     * 外部输入的纹理, 每帧通过 setImport 更新
+     */
+    ResId importTexture(const char *name) {
+        Resource res;
+        res.name = name;
+        res.imported = true;
+        m_resources.push_back(res);
+        m_dirty = true;
+        return (ResId)m_resources.size() - 1;
+    }
+
+    void setImport(ResId id, const Texture2D *texture) {
+        _ERROR_RETURN_IF(!isImport(id), void(), "RenderGraph(%s): res(%d) is not an import", m_name, id)
+        Resource &res = m_resources[id];
+        int width = texture ? texture->width() : 0;
+        int height = texture ? texture->height() : 0;
+        if (width != res.width || height != res.height) {
+            m_dirty = true;
+        }
+        res.texture = texture;
+        res.width = width;
+        res.height = height;
+        res.damage = DirtyRect::full(width, height);
+    }
+
+    /**
+     * 本帧输入中变化的区域, 在 setImport 之后调用, 默认整个输入都变化了. 只在开启 damage tracking 时生效
+     */
+    void setImportDamage(ResId id, const DirtyRect &rect) {
+        _ERROR_RETURN_IF(!isImport(id), void(), "RenderGraph(%s): res(%d) is not an import", m_name, id)
+        Resource &res = m_resources[id];
+        res.damage = rect.expanded(0, res.width, res.height);
+    }
+
+    /**
+     * 开启后每个 pass 独占 Framebuffer (显存增加), 只渲染变化的区域. 修改后重新编译
+     */
+    void setDamageTracking(bool enable) {
+        if (m_damage_tracking != enable) {
+            m_damage_tracking = enable;
+            m_dirty = true;
+        }
+    }
+
+    inline bool damageTracking() const { return m_damage_tracking; }
+
+    /**
+     * 下一帧整帧渲染, 在 pass 的参数变化等图无法感知的变化之后调用
+     */
+    inline void invalidateDamage() { m_damage_valid = false; }
+
+    /**
+     * 最近一次 execute 中所有 pass 更新的像素数
+     */
+    inline int64_t renderedPixels() const { return m_rendered_pixels; }
+
+    /**
+     * 添加一个 pass, 输出尺寸为 inputs[0] 的尺寸乘以 scale, 没有输入时需要用 setPassSize 指定
+     * @return pass 的输出纹理
+     */
+    ResId addPass(const char *name, BaseFilter *filter, const std::vector<ResId> &inputs, const PassBinder &binder,
+                  float scale = 1.0f) {
+        for (ResId in : inputs) {
+            _ERROR_RETURN_IF(in < 0 || in >= (ResId)m_resources.size(), INVALID_RES,
+                             "RenderGraph(%s): pass(%s) invalid input: %d", m_name, name, in)
+        }
+
+        Resource res;
+        res.name = name;
+        res.producer = (PassId)m_passes.size();
+        m_resources.push_back(res);
+
+        Pass pass;
+        pass.name = name;
+        pass.filter = filter;
+        pass.binder = binder;
+        pass.inputs = inputs;
+        pass.output = (ResId)m_resources.size() - 1;
+        pass.scale = scale;
+        m_passes.push_back(pass);
+        m_dirty = true;
+        return pass.output;
+    }
+
+    void setPassSize(ResId output, int width, int height) {
+        Pass *pass = producerOf(output);
+        _ERROR_RETURN_IF(pass == nullptr, void(), "RenderGraph(%s): res(%d) has no producer", m_name, output)
+        if (pass->fixedWidth != width || pass->fixedHeight != height) {
+            pass->fixedWidth = width;
+            pass->fixedHeight = height;
+            m_dirty = true;
+        }
+    }
+
+    /**
+     * 关闭的 pass 不执行, 它的输出直接使用 inputs[0], 此时它在 setOutput 中指定的 target 不会被写入
+     */
+    void setPassEnabled(ResId output, bool enabled) {
+        Pass *pass = producerOf(output);
+        _ERROR_RETURN_IF(pass == nullptr, void(), "RenderGraph(%s): res(%d) has no producer", m_name, output)
+        if (pass->enabled != enabled) {
+            pass->enabled = enabled;
+            m_dirty = true;
+        }
+    }
+
+    /**
+     * 标记为图的输出, 只有输出依赖的 pass 才会执行
+     * @param target 渲染到外部 Framebuffer, 为 nullptr 时结果保存在图内部, 通过 outputTexture 获取
+     */
+    void setOutput(ResId id, Framebuffer *target = nullptr) {
+        _ERROR_RETURN_IF(id < 0 || id >= (ResId)m_resources.size(), void(), "RenderGraph(%s): invalid output: %d",
+                         m_name, id)
+        Resource &res = m_resources[id];
+        if (!res.output || res.target != target) {
+            res.output = true;
+            res.target = target;
+            m_dirty = true;
+        }
+    }
+
+    /**
+     * 图内部所有 pass 的输出尺寸乘以 scale, 输出到外部 target 的 pass 不受影响.
+     * 修改后下一次 execute 会重新编译, 中间 Framebuffer 优先复用之前的比例留下的备用 Framebuffer
+     */
+    void setRenderScale(float scale) {
+        scale = std::min(std::max(scale, 0.05f), 1.0f);
+        if (scale != m_render_scale) {
+            m_render_scale = scale;
+            m_dirty = true;
+        }
+    }
+
+    inline float renderScale() const { return m_render_scale; }
+
+    void removeOutput(ResId id) {
+        if (id >= 0 && id < (ResId)m_resources.size() && m_resources[id].output) {
+            m_resources[id].output = false;
+            m_resources[id].target = nullptr;
+            m_dirty = true;
+        }
+    }
+
+    /**
+     * 最近一次 execute 之后输出的纹理
+     */
+    const Texture2D *outputTexture(ResId id) const {
+        if (id < 0 || id >= (ResId)m_resources.size()) {
+            return nullptr;
+        }
+        return resolveTexture(resolveAlias(id));
+    }
+
+    bool execute() {
+        if (m_dirty && !compile()) {
+            return false;
+        }
+
+        bool partial = m_damage_tracking && m_damage_valid;
+        m_rendered_pixels = 0;
+        std::vector<const Texture2D *> inputs;
+        for (PassId pid : m_order) {
+            Pass &pass = m_passes[pid];
+            Resource &out = m_resources[pass.output];
+
+            inputs.clear();
+            for (ResId in : pass.inputs) {
+                const Texture2D *tex = resolveTexture(resolveAlias(in));
+                _ERROR_RETURN_IF(tex == nullptr, false, "RenderGraph(%s): pass(%s) input(%s) missing", m_name,
+                                 pass.name, m_resources[in].name)
+                inputs.push_back(tex);
+            }
+
+            Framebuffer *fb = out.target ? out.target : m_physical[out.physical].fb;
+            pass.binder(inputs, out.width, out.height);
+            if (partial) {
+                DirtyRect damage;
+                for (ResId in : pass.inputs) {
+                    Resource &r = m_resources[resolveAlias(in)];
+                    damage.unite(r.damage.mapped(r.width, r.height, out.width, out.height));
+                }
+                pass.filter->setDamage(damage);
+            }
+            pass.filter->render(fb);
+            out.damage = pass.filter->lastDamage();
+            m_rendered_pixels += out.damage.area();
+        }
+
+        for (auto &res : m_resources) {
+            if (res.imported) {
+                res.damage = DirtyRect::full(res.width, res.height);
+            }
+        }
+        m_damage_valid = m_damage_tracking;
+        return true;
+    }
+
+    /**
+     * 重新编译: 剔除无用 pass, 计算尺寸和生命周期, 分配并复用中间 Framebuffer
+     */
+    bool compile() {
+        GLResTracker::TagScope tag(m_name);
+        m_order.clear();
+
+        for (auto &res : m_resources) {
+            res.alias = INVALID_RES;
+            res.physical = -1;
+            res.lastUse = -1;
+            if (!res.imported) {
+                res.width = res.height = 0;
+            }
+            res.nomWidth = res.imported ? res.width : 0;
+            res.nomHeight = res.imported ? res.height : 0;
+        }
+
+        // 关闭的 pass 把输出转发到 inputs[0]
+        for (auto &pass : m_passes) {
+            if (!pass.enabled) {
+                _ERROR_RETURN_IF(pass.inputs.empty(), false, "RenderGraph(%s): disabled pass(%s) has no input", m_name,
+                                 pass.name)
+                m_resources[pass.output].alias = pass.inputs[0];
+            }
+        }
+
+        // 从输出反推需要执行的 pass, pass 按添加顺序即为拓扑序
+        std::vector<bool> needed(m_passes.size(), false);
+        std::vector<ResId> stack;
+        for (ResId i = 0; i < (ResId)m_resources.size(); ++i) {
+            if (m_resources[i].output) {
+                stack.push_back(resolveAlias(i));
+            }
+        }
+        while (!stack.empty()) {
+            ResId id = stack.back();
+            stack.pop_back();
+            PassId pid = m_resources[id].producer;
+            if (pid < 0 || needed[pid]) {
+                continue;
+            }
+            needed[pid] = true;
+            for (ResId in : m_passes[pid].inputs) {
+                stack.push_back(resolveAlias(in));
+            }
+        }
+
+        for (PassId pid = 0; pid < (PassId)m_passes.size(); ++pid) {
+            if (!needed[pid]) {
+                continue;
+            }
+            Pass &pass = m_passes[pid];
+            Resource &out = m_resources[pass.output];
+            // 先按不缩放的尺寸推导, 再乘以 render scale, 避免缩放在链路上累积
+            if (pass.fixedWidth > 0 && pass.fixedHeight > 0) {
+                out.nomWidth = pass.fixedWidth;
+                out.nomHeight = pass.fixedHeight;
+            } else if (!pass.inputs.empty()) {
+                Resource &in = m_resources[resolveAlias(pass.inputs[0])];
+                out.nomWidth = std::max(1, (int)((float)in.nomWidth * pass.scale + 0.5f));
+                out.nomHeight = std::max(1, (int)((float)in.nomHeight * pass.scale + 0.5f));
+            }
+            if (out.nomWidth > 0 && out.nomHeight > 0) {
+                out.width = std::max(1, (int)((float)out.nomWidth * m_render_scale + 0.5f));
+                out.height = std::max(1, (int)((float)out.nomHeight * m_render_scale + 0.5f));
+            }
+            if (out.target) {
+                if (!out.target->valid() && out.width > 0 && out.height > 0) {
+                    out.target->create(out.width, out.height);
+                }
+                out.width = out.target->texWidth();
+                out.height = out.target->texHeight();
+            }
+            _ERROR_RETURN_IF(out.width <= 0 || out.height <= 0, false, "RenderGraph(%s): pass(%s) has no size", m_name,
+                             pass.name)
+
+            int step = (int)m_order.size();
+            for (ResId in : pass.inputs) {
+                Resource &r = m_resources[resolveAlias(in)];
+                r.lastUse = std::max(r.lastUse, step);
+            }
+            m_order.push_back(pid);
+        }
+
+        // 按执行顺序分配, 输出到图内部的结果要保留到下次执行, 不参与复用
+        for (auto &p : m_physical) {
+            p.freeAt = -1;
+            p.used = false;
+        }
+        int step = 0;
+        for (PassId pid : m_order) {
+            Resource &out = m_resources[m_passes[pid].output];
+            if (out.target == nullptr) {
+                int keepUntil = out.output || m_damage_tracking ? INT32_MAX : std::max(out.lastUse, step);
+                out.physical = allocPhysical(out.width, out.height, step, keepUntil);
+            }
+            step++;
+        }
+
+        // 本次没有用到的 Framebuffer 放入备用列表, 超出数量时先释放面积最小的, 重新创建的代价最小,
+        // 回到原始比例时的 Framebuffer 也能保留下来
+        std::vector<int> remap(m_physical.size(), -1);
+        std::vector<Physical> kept;
+        for (int i = 0; i < (int)m_physical.size(); ++i) {
+            if (m_physical[i].used) {
+                remap[i] = (int)kept.size();
+                kept.push_back(m_physical[i]);
+            } else {
+                m_spare.push_back(m_physical[i].fb);
+            }
+        }
+        m_physical.swap(kept);
+        size_t maxSpare = m_physical.size() * 2;
+        while (m_spare.size() > maxSpare) {
+            auto smallest = std::min_element(m_spare.begin(), m_spare.end(), [](Framebuffer *a, Framebuffer *b) {
+                return (int64_t)a->texWidth() * a->texHeight() < (int64_t)b->texWidth() * b->texHeight();
+            });
+            (*smallest)->release();
+            delete *smallest;
+            m_spare.erase(smallest);
+        }
+        for (auto &res : m_resources) {
+            if (res.physical >= 0) {
+                res.physical = remap[res.physical];
+            }
+        }
+
+        m_dirty = false;
+        // Framebuffer 重新分配过, 内容不能保留
+        m_damage_valid = false;
+        _INFO("RenderGraph(%s) compiled: %d/%d passes, %d framebuffers, %d spare, %.2f mb, render scale: %.2f, "
+              "damage tracking: %d", m_name, (int)m_order.size(), (int)m_passes.size(), (int)m_physical.size(),
+              (int)m_spare.size(), (double)memBytes() / 1024.0 / 1024.0, m_render_scale, m_damage_tracking ? 1 : 0);
+        return true;
+    }
+
+    inline bool dirty() const { return m_dirty; }
+
+    inline void invalidate() { m_dirty = true; }
+
+    /**
+     * 实际执行的 pass 数量
+     */
+    inline int activePassCount() const { return (int)m_order.size(); }
+
+    inline int framebufferCount() const { return (int)m_physical.size(); }
+
+    /**
+     * 创建过的中间 Framebuffer 总数, 不包括复用的
+     */
+    inline int64_t framebufferAllocations() const { return m_allocations; }
+
+    /**
+     * 使用中和备用的中间 Framebuffer 的显存
+     */
+    int64_t memBytes() const {
+        int64_t bytes = 0;
+        for (auto &p : m_physical) {
+            bytes += p.fb->byteSize();
+        }
+        for (auto *fb : m_spare) {
+            bytes += fb->byteSize();
+        }
+        return bytes;
+    }
+
+    void release() {
+        for (auto &p : m_physical) {
+            p.fb->release();
+            delete p.fb;
+        }
+        m_physical.clear();
+        for (auto *fb : m_spare) {
+            fb->release();
+            delete fb;
+        }
+        m_spare.clear();
+        m_dirty = true;
+    }
+
+private:
+    struct Resource {
+        std::string name;
+        bool imported = false;
+        const Texture2D *texture = nullptr;
+
+        PassId producer = -1;
+        // 被关闭的 pass 的输出, 实际使用的资源
+        ResId alias = INVALID_RES;
+
+        bool output = false;
+        Framebuffer *target = nullptr;
+
+        int width = 0, height = 0;
+        // render scale 为 1 时的尺寸
+        int nomWidth = 0, nomHeight = 0;
+        int lastUse = -1;
+        int physical = -1;
+        // 最近一帧变化的区域
+        DirtyRect damage;
+    };
+
+    struct Pass {
+        std::string name;
+        BaseFilter *filter = nullptr;
+        PassBinder binder;
+        std::vector<ResId> inputs;
+        ResId output = INVALID_RES;
+
+        float scale = 1.0f;
+        int fixedWidth = 0, fixedHeight = 0;
+        bool enabled = true;
+    };
+
+    struct Physical {
+        Framebuffer *fb = nullptr;
+        // 在这一步之后可以被复用
+        int freeAt = -1;
+        bool used = false;
+    };
+
+    bool isImport(ResId id) const { return id >= 0 && id < (ResId)m_resources.size() && m_resources[id].imported; }
+
+    Pass *producerOf(ResId id) {
+        if (id < 0 || id >= (ResId)m_resources.size() || m_resources[id].producer < 0) {
+            return nullptr;
+        }
+        return &m_passes[m_resources[id].producer];
+    }
+
+    ResId resolveAlias(ResId id) const {
+        while (m_resources[id].alias != INVALID_RES) {
+            id = m_resources[id].alias;
+        }
+        return id;
+    }
+
+    const Texture2D *resolveTexture(ResId id) const {
+        const Resource &res = m_resources[id];
+        if (res.imported) {
+            return res.texture;
+        }
+        if (res.target) {
+            return res.target->texture();
+        }
+        if (res.physical >= 0 && res.physical < (int)m_physical.size()) {
+            return m_physical[res.physical].fb->texture();
+        }
+        return nullptr;
+    }
+
+    int allocPhysical(int width, int height, int step, int keepUntil) {
+        for (int i = 0; i < (int)m_physical.size(); ++i) {
+            Physical &p = m_physical[i];
+            bool free = !p.used || p.freeAt < step;
+            if (free && p.fb->texWidth() == width && p.fb->texHeight() == height) {
+                p.used = true;
+                p.freeAt = keepUntil;
+                return i;
+            }
+        }
+
+        Physical p;
+        // 优先使用最近放入备用列表的
+        for (auto it = m_spare.rbegin(); it != m_spare.rend(); ++it) {
+            if ((*it)->texWidth() == width && (*it)->texHeight() == height) {
+                p.fb = *it;
+                m_spare.erase(std::next(it).base());
+                break;
+            }
+        }
+        if (p.fb == nullptr) {
+            p.fb = new Framebuffer();
+            p.fb->create(width, height);
+            m_allocations += 1;
+        }
+        p.used = true;
+        p.freeAt = keepUntil;
+        m_physical.push_back(p);
+        return (int)m_physical.size() - 1;
+    }
+
+private:
+    const std::string m_name;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<PassId> m_order;
+    std::vector<Physical> m_physical;
+    // 其他 render scale 留下的 Framebuffer, 按放入的顺序
+    std::vector<Framebuffer *> m_spare;
+    int64_t m_allocations = 0;
+
+    bool m_dirty = true;
+    float m_render_scale = 1.0f;
+
+    bool m_damage_tracking = false;
+    // 每个 pass 的输出保留着上一帧的完整结果
+    bool m_damage_valid = false;
+    int64_t m_rendered_pixels = 0;
+};
+
+NAMESPACE_END
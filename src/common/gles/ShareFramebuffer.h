@@ -12,6 +12,9 @@
 
 NAMESPACE_DEFAULT
 
+/**
+ * 单个 framebuffer 加锁共享, 生产者和消费者互相等待. 不希望慢的一方拖住另一方时使用 FrameMailbox
+ */
 class ShareFramebuffer {
 public:
     /**
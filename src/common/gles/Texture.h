@@ -9,6 +9,8 @@
 #include <mutex>
 
 #include "GLUtil.h"
+#include "GLResTracker.h"
+#include "GLStateCache.h"
 #include "common/utils/Array.h"
 
 NAMESPACE_DEFAULT
@@ -26,6 +28,9 @@ struct TexParams {
     GLint border = 0;
     GLenum format = GL_RGBA;
     GLenum type = GL_UNSIGNED_BYTE;
+    // 使用 glTexStorage2D 分配, 尺寸和格式不可变, internalFormat 需要是 GL_RGBA8 这样的 sized 格式.
+    // GLES 3.1 中只有这样的纹理才可以作为 compute shader 的 image 绑定
+    bool immutable = false;
 };
 
 class Texture {
@@ -71,6 +76,8 @@ public:
     void release() {
         if (m_id != INVALID_GL_ID) {
             glDeleteTextures(1, &m_id);
+            GLStateCache::onDeleteTexture(m_id);
+            GLResTracker::instance().onDelete(RES_TEXTURE, m_id);
             m_id = INVALID_GL_ID;
         }
     }
@@ -85,22 +92,31 @@ public:
     }
 
     static void updateTexture2D(GLuint id, GLint width, GLint height, const TexParams &params, const void *pixels) {
-        glBindTexture(GL_TEXTURE_2D, id);
+        GLStateCache::bindTexture2D(id);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, params.format, params.type, pixels);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLStateCache::unbindTexture2D();
     }
 
     static GLuint genTexture2D(GLint width, GLint height, const TexParams &params, const void *pixels) {
         GLuint texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLStateCache::bindTexture2D(texture);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrapS);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrapT);
-        glTexImage2D(GL_TEXTURE_2D, params.level, params.internalFormat, width, height, params.border, params.format,
-                     params.type, pixels);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        if (params.immutable) {
+            glTexStorage2D(GL_TEXTURE_2D, params.level + 1, params.internalFormat, width, height);
+            if (pixels) {
+                glTexSubImage2D(GL_TEXTURE_2D, params.level, 0, 0, width, height, params.format, params.type, pixels);
+            }
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, params.level, params.internalFormat, width, height, params.border,
+                         params.format, params.type, pixels);
+        }
+        GLStateCache::unbindTexture2D();
+        GLResTracker::instance().onCreate(RES_TEXTURE, texture,
+                                          (int64_t)width * height * GLUtil::bytesPerPixel(params.internalFormat, params.type));
         return texture;
     }
 
@@ -167,6 +183,9 @@ public:
 
         std::lock_guard<std::mutex> lock(m_update_mutex);
         if (m_tex == nullptr || m_tex->width() != m_width || m_tex->height() != m_height || m_tex->params().format != m_format) {
+            if (m_tex) {
+                m_tex->release();
+            }
             DELETE_TO_NULL(m_tex);
             TexParams params;
             params.format = m_format;
@@ -174,6 +193,7 @@ public:
         }
 
         if (m_tex_need_update) {
+            GLResTracker::TagScope tag("ImageTexture");
             m_tex->update(m_img.bytes());
             m_tex_need_update = false;
         }
@@ -183,6 +203,9 @@ public:
 
     void release() {
         std::lock_guard<std::mutex> lock(m_update_mutex);
+        if (m_tex) {
+            m_tex->release();
+        }
         DELETE_TO_NULL(m_tex);
         m_width = 0;
         m_height = 0;
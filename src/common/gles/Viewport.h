@@ -6,6 +6,8 @@
 
 
 #pragma once
+#include "DirtyRect.h"
+#include "GLStateCache.h"
 #include "GLUtil.h"
 
 NAMESPACE_DEFAULT
@@ -14,9 +16,9 @@ class Viewport {
 public:
     static void viewport(int x, int y, int width, int height, bool scissor = false) {
         if (scissor) {
-            glScissor(x, y, width, height);
+            GLStateCache::scissor(x, y, width, height);
         } else {
-            glViewport(x, y, width, height);
+            GLStateCache::viewport(x, y, width, height);
         }
     }
 
@@ -67,18 +69,51 @@ public:
         m_clear_color[1] = v.m_clear_color[1];
         m_clear_color[2] = v.m_clear_color[2];
         m_clear_color[3] = v.m_clear_color[3];
+        m_clip = v.m_clip;
         return *this;
     }
 
+    /**
+     * 在 viewport 之内只更新 rect 区域 (开启 GL_SCISSOR_TEST), 清屏也只清除这个区域.
+     * 与构造时的 scissor 参数不同, viewport 依然是 set 设置的区域. 渲染完之后由调用方恢复 GL_SCISSOR_TEST 和 scissor 区域
+     */
+    Viewport& setClip(const DirtyRect &rect) {
+        m_clip = rect;
+        return *this;
+    }
+
+    Viewport& clearClip() {
+        m_clip = DirtyRect();
+        return *this;
+    }
+
+    inline bool hasClip() const { return !m_clip.empty(); }
+
+    inline int x() const { return m_x; }
+    inline int y() const { return m_y; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+
+    /**
+     * 视口覆盖整个 width x height 的输出, 没有裁剪
+     */
+    bool covers(int width, int height) const {
+        return m_x == 0 && m_y == 0 && m_width == width && m_height == height && !m_scissor && !hasClip();
+    }
+
     void apply() {
         //_INFO("viewport(%.2f, %.2f, %.2f, %.2f)", m_x, m_y, m_width, m_height);
         if (m_scissor && m_width > 0 && m_height > 0) {
-            glScissor(m_x, m_y, m_width, m_height);
+            GLStateCache::scissor(m_x, m_y, m_width, m_height);
         } else if (m_width > 0 && m_height > 0) {
-            glViewport(m_x, m_y, m_width, m_height);
+            GLStateCache::viewport(m_x, m_y, m_width, m_height);
         } else {
             _WARN("Viewport::apply() viewport not configure!");
         }
+        if (hasClip()) {
+            GLStateCache::setCapability(GL_SCISSOR_TEST, true);
+            GLStateCache::scissor(m_clip.x, m_clip.y, m_clip.width, m_clip.height);
+        }
         
         if (m_clear_color[0] >= 0 && m_clear_color[0] <= 1) {
             glClearColor(m_clear_color[0], m_clear_color[1], m_clear_color[2], m_clear_color[3]);
@@ -89,6 +124,7 @@ public:
 private:
     int m_x, m_y, m_width, m_height;
     bool m_scissor = false;
+    DirtyRect m_clip;
     
     float m_clear_color[4] = {-1000, 0, 0, 0};
 };
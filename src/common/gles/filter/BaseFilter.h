@@ -8,6 +8,7 @@
 #pragma once
 #include "../Framebuffer.h"
 #include "../GLCoord.h"
+#include "../GLGpuTimer.h"
 #include "../Program.h"
 #include "../Viewport.h"
 
@@ -78,56 +79,147 @@ public:
     }
 
     void render(Framebuffer *output = nullptr) {
-        onPreRender(output);
-        if (!m_program.valid()) {
-            std::string vs = vertexShader();
-            std::string fs = fragmentShader();
-            if (!m_program.create(vs.c_str(), fs.c_str())) {
-                return;
+        // 当前线程绑定了 GLGpuTimer 时, 统计这个滤镜的 GPU 耗时
+        GLGpuTimerScope gpuTimerScope(m_name);
+        // 渲染过程中创建的 GL 对象都记在这个滤镜名下
+        GLResTracker::TagScope resTag(m_name);
+
+        bool hasDamage = m_has_damage;
+        m_has_damage = false;
+        int width = output ? output->texWidth() : m_viewport.width();
+        int height = output ? output->texHeight() : m_viewport.height();
+        m_last_damage = DirtyRect::full(width, height);
+        if (hasDamage && output && mapsWholeOutput(width, height)) {
+            int padding = damagePadding(width, height);
+            if (padding >= 0) {
+                m_last_damage = m_damage.expanded(padding, width, height);
             }
-            onProgramCreated();
-        }
-
-        if (output) {
-            if (!output->bind()) {
-                _ERROR("Couldn't bind output framebuffer");
+            if (m_last_damage.empty()) {
+                // 影响的区域之外, 输出保持不变
                 return;
             }
-            output->ref();
         }
+        bool clip = !m_last_damage.covers(width, height);
+        // 只更新 damage 区域时借用 scissor, 渲染完恢复调用方的 scissor 开关和区域
+        bool scissorEnabled = false;
+        GLint scissorBox[4] = {};
+        if (clip) {
+            GLStateCache::getScissor(scissorEnabled, scissorBox);
+            m_viewport.setClip(m_last_damage);
+        }
+        renderPass(output);
+        if (clip) {
+            m_viewport.clearClip();
+            GLStateCache::scissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+            GLStateCache::setCapability(GL_SCISSOR_TEST, scissorEnabled);
+        }
+    }
 
-        onViewport();
+    /**
+     * 只有 damage 区域的输入变化了, 下一次 render 只更新受它影响的区域 (按 damagePadding 扩大), 输出中其他像素保留上一次的内容,
+     * 因此输出需要是同一个 Framebuffer 且没有被其他渲染覆盖. damage 为空时不渲染.
+     * 只对下一次 render 生效, 并且只在输出到 Framebuffer、视口覆盖整个输出、顶点/纹理坐标是默认的全屏坐标时生效 (输入与输出的像素一一对应),
+     * 否则整个输出重新渲染. 滤镜的参数变化时不能设置 damage.
+     * @param rect 变化的区域, 已经换算到输出的像素坐标
+     */
+    BaseFilter &setDamage(const DirtyRect &rect) {
+        m_damage = rect;
+        m_has_damage = true;
+        return *this;
+    }
 
-        if (!m_program.attach()) {
-            _ERROR("Couldn't attach filter(%s) program", m_name.c_str());
-            return;
-        }
+    /**
+     * 上一次 render 实际更新的区域, 没有渲染时为空
+     */
+    inline const DirtyRect &lastDamage() const { return m_last_damage; }
+
+    /**
+     * 输出的一个像素受输入中多远的像素影响 (卷积核的半径), 用于扩大 damage.
+     * 返回负数时每个像素都可能受整个输入影响, damage 不生效. 默认为 -1, 输入与输出逐像素对应的滤镜才覆盖这个方法
+     */
+    virtual int damagePadding(int width, int height) const { return -1; }
+
+    inline const std::string &name() const { return m_name; }
+
+    /**
+     * 优先使用 compute shader 渲染. 以下条件都满足时生效, 否则使用 fragment shader:
+     * 滤镜提供了 computeShader, context 支持 compute (GLES 3.1 / GL 4.3), 输出是 FB_FORMAT_RGBA8_IMAGE 的 Framebuffer,
+     * 视口覆盖整个输出, 顶点/纹理坐标是默认的全屏坐标
+     */
+    BaseFilter &setComputeEnabled(bool enable) {
+        m_compute_enabled = enable;
+        return *this;
+    }
 
-        onRender(output);
-        onDrawArrays();
+    inline bool computeEnabled() const { return m_compute_enabled; }
 
-        if (output) {
-            output->unbind();
-            output->unref();
-        }
+    /**
+     * 上一次 render 是否使用了 compute shader
+     */
+    inline bool lastRenderCompute() const { return m_last_compute; }
 
-        onPostRender(output);
-        m_program.detach();
+    /**
+     * 渲染时不需要在当前线程编译 program: 已经创建过, 或者已经由 GLEngine::warmUp 预编译完成.
+     * 返回 false 时可以先用直通的滤镜代替, 避免首帧卡顿. 需要在 GL 线程调用
+     */
+    bool programReady() {
+        return activeProgram().valid() || GLProgramWarmer::instance().ready(vertexShader(), fragmentShader());
     }
 
-    virtual void release() { m_program.release(); }
+    /**
+     * 当前参数下的 shader 源码, 用于预编译
+     */
+    GLProgramWarmer::Source programSource() { return {vertexShader(), fragmentShader()}; }
+
+    virtual void release() {
+        m_program.release();
+        m_compute_program.release();
+        m_compute_uniforms.clear();
+    }
 
 protected:
     virtual std::string vertexShader() = 0;
 
     virtual std::string fragmentShader() = 0;
 
+    /**
+     * compute shader 的源码 (不含 #version), 为空时没有 compute 路径.
+     * 输出绑定在 image unit 0: layout(rgba8, binding = 0) writeonly uniform highp image2D outputImage;
+     * 与 fragment shader 同名的 uniform 会在每次 dispatch 前从 m_program 同步
+     */
+    virtual std::string computeShader() { return ""; }
+
+    /**
+     * 工作组的大小, 与 computeShader 中的 local_size 一致
+     */
+    virtual void computeGroupSize(int &x, int &y) const {
+        x = 16;
+        y = 16;
+    }
+
+    /**
+     * computeShader 的源码变化, 下次 render 时在 GL 线程重新创建 compute program
+     */
+    void invalidateCompute() { m_compute_dirty = true; }
+
+    /**
+     * 当前参数下是否可以使用 compute shader, 滤镜可以追加自己的条件
+     */
+    virtual bool computeAvailable(const Framebuffer &output) { return true; }
+
     Program& program() { return m_program; }
 
+    /**
+     * 本次渲染使用的 program, 默认为 m_program. shader 随配置变化且需要保留多个 program 的滤镜 (FusedFilter) 重写
+     */
+    virtual Program &activeProgram() { return m_program; }
+
     Attribute *defAttribute(const char *name, DataType type) { return m_program.defAttribute(name, type); }
 
     Uniform *defUniform(const char *name, DataType type) { return m_program.defUniform(name, type); }
 
+    UniformBlock *defUniformBlock(const char *name) { return m_program.defUniformBlock(name); }
+
     VertexCoord &vertexCoord() { return m_vertex_coords; }
 
     TextureCoord &textureCoord() { return m_texture_coords; }
@@ -138,16 +230,127 @@ protected:
 
     virtual void onViewport() { m_viewport.apply(); }
 
-    virtual void onRender(Framebuffer *output) { m_program.input(); }
+    virtual void onRender(Framebuffer *output) { activeProgram().input(); }
 
     virtual void onDrawArrays() {
         glDrawArrays(m_vertex_coords.drawMode(), 0, m_vertex_coords.drawCount());
     }
 
     virtual void onPostRender(Framebuffer *output) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLStateCache::unbindTexture2D();
+        GLStateCache::unbindVertexArray();
+        GLStateCache::unbindArrayBuffer();
+    }
+
+private:
+    void renderPass(Framebuffer *output) {
+        onPreRender(output);
+        m_last_compute = false;
+        if (output && m_compute_enabled && renderCompute(*output)) {
+            m_last_compute = true;
+            return;
+        }
+        Program &program = activeProgram();
+        if (!program.valid()) {
+            std::string vs = vertexShader();
+            std::string fs = fragmentShader();
+            if (!program.create(vs.c_str(), fs.c_str())) {
+                return;
+            }
+            onProgramCreated();
+        }
+
+        if (output) {
+            if (!output->bind()) {
+                _ERROR("Couldn't bind output framebuffer");
+                return;
+            }
+            output->ref();
+        } else {
+            // 解绑是延迟的, 输出到屏幕时需要显式绑定默认的 framebuffer
+            GLStateCache::bindFramebuffer(0);
+        }
+
+        onViewport();
+
+        if (!program.attach()) {
+            _ERROR("Couldn't attach filter(%s) program", m_name.c_str());
+            return;
+        }
+
+        onRender(output);
+        onDrawArrays();
+
+        if (output) {
+            output->unbind();
+            output->unref();
+        }
+
+        onPostRender(output);
+        program.detach();
+    }
+
+    /**
+     * 视口覆盖整个输出, 顶点/纹理坐标是默认的全屏坐标, 输出的像素与输入一一对应
+     */
+    bool mapsWholeOutput(int width, int height) {
+        uint32_t version;
+        return m_viewport.covers(width, height) && m_vertex_coords.shape(version) == COORD_SHAPE_VERTEX_FULL &&
+               m_texture_coords.shape(version) == COORD_SHAPE_TEXTURE_FULL;
+    }
+
+    bool renderCompute(Framebuffer &output) {
+        if (m_compute_supported < 0) {
+            m_compute_supported = GLUtil::computeSupported() && !computeShader().empty() ? 1 : 0;
+        }
+        const Texture2D *texture = output.texture();
+        // 只更新 damage 区域时 viewport 有裁剪, 使用 fragment shader
+        if (m_compute_supported == 0 || texture == nullptr || !texture->params().immutable ||
+            texture->params().internalFormat != GL_RGBA8 || !mapsWholeOutput(texture->width(), texture->height()) ||
+            !computeAvailable(output)) {
+            return false;
+        }
+#ifdef ZNATIVE_GL_COMPUTE
+        if (m_compute_dirty.exchange(false)) {
+            m_compute_program.release();
+        }
+        if (!m_compute_program.valid()) {
+            std::string cs = CORRECT_COMPUTE_SHADER(computeShader());
+            if (!m_compute_program.createCompute(cs.c_str())) {
+                // 编译失败之后不再尝试
+                m_compute_supported = 0;
+                return false;
+            }
+            // 只同步 compute shader 中用到的 uniform
+            m_compute_uniforms.clear();
+            for (Uniform *uni : m_program.uniforms()) {
+                if (glGetUniformLocation(m_compute_program.id(), uni->name()) >= 0) {
+                    m_compute_uniforms.emplace_back(uni, m_compute_program.defUniform(uni->name(), uni->type()));
+                }
+            }
+        }
+        for (auto &it : m_compute_uniforms) {
+            it.second->copyFrom(*it.first);
+        }
+
+        if (!m_compute_program.attach()) {
+            return false;
+        }
+        m_compute_program.input();
+        glBindImageTexture(0, texture->id(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        int gx, gy;
+        computeGroupSize(gx, gy);
+        glDispatchCompute((GLuint)((texture->width() + gx - 1) / gx), (GLuint)((texture->height() + gy - 1) / gy), 1);
+        // 之后可能采样/渲染/读回输出的纹理
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                        GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        GLStateCache::unbindTexture2D();
+        m_compute_program.detach();
+        return true;
+#else
+        return false;
+#endif
     }
 
 protected:
@@ -158,6 +361,20 @@ protected:
 
     VertexCoord m_vertex_coords;
     TextureCoord m_texture_coords;
+
+private:
+    bool m_compute_enabled = false;
+    bool m_last_compute = false;
+    // -1: 还没有检查 context
+    int m_compute_supported = -1;
+    std::atomic<bool> m_compute_dirty{false};
+    Program m_compute_program;
+    // fragment program 的 uniform -> compute program 中同名的 uniform
+    std::vector<std::pair<Uniform *, Uniform *>> m_compute_uniforms;
+
+    bool m_has_damage = false;
+    DirtyRect m_damage;
+    DirtyRect m_last_damage;
 };
 
 NAMESPACE_END
@@ -7,6 +7,7 @@
 #include "ZNamespace.h"
 #include "common/Object.h"
 #include "BaseFilter.h"
+#include "FusableFilter.h"
 
 NAMESPACE_DEFAULT
 
@@ -15,26 +16,39 @@ NAMESPACE_DEFAULT
  * 亮度、对比度、饱和度、色温、色调、曝光、高光、阴影、胶片颗粒感
  *
  * 参考: https://github.com/yuki-koyama/enhancer/blob/master/shaders/enhancer.fs
+ *
+ * 逐像素的滤镜, 可以融合进 FusedFilter
  */
-class ColorAdjustFilter : public BaseFilter {
+class ColorAdjustFilter : public BaseFilter, public FusableFilter {
 public:
-    ColorAdjustFilter() : BaseFilter("color_adjust") {
+    /**
+     * @param uniformBlock 参数放在 std140 的 uniform block 中, 任意参数变化时只上传一次, 需要 GLES 3.0 以上
+     */
+    explicit ColorAdjustFilter(bool uniformBlock = false) : BaseFilter("color_adjust"), m_uniform_block(uniformBlock) {
         defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
         defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
-        defUniform("inputImageTexture", DataType::SAMPLER_2D);
-        defUniform("brightness_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("contrast_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("saturation_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("wb_temperature_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("wb_tint_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("exposure_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("highlights_strength", DataType::FLOAT)->set(1.0f);
-        defUniform("highlight_tint_color", DataType::FVEC3)->set(0.0f, 0.0f, 0.0f);
-        defUniform("shadows_strength", DataType::FLOAT)->set(0.0f);
-        defUniform("shadow_tint_color", DataType::FVEC3)->set(1.0f, 1.0f, 1.0f);
-        defUniform("film_grain_strength", DataType::FLOAT)->set(0.0f);
+        m_input_texture = defUniform("inputImageTexture", DataType::SAMPLER_2D);
+
+        UniformBlock *block = uniformBlock ? defUniformBlock(PARAM_BLOCK_NAME) : nullptr;
+        for (int i = 0; i < PARAM_COUNT; ++i) {
+            const ParamDef &def = paramDef(i);
+            m_params[i] = block ? block->defMember(def.name, def.type) : defUniform(def.name, def.type);
+        }
+        m_params[PARAM_BRIGHTNESS]->set(0.0f);
+        m_params[PARAM_CONTRAST]->set(0.0f);
+        m_params[PARAM_SATURATION]->set(0.0f);
+        m_params[PARAM_WB_TEMPERATURE]->set(0.0f);
+        m_params[PARAM_WB_TINT]->set(0.0f);
+        m_params[PARAM_EXPOSURE]->set(0.0f);
+        m_params[PARAM_HIGHLIGHTS]->set(1.0f);
+        m_params[PARAM_HIGHLIGHT_TINT_COLOR]->set(0.0f, 0.0f, 0.0f);
+        m_params[PARAM_SHADOWS]->set(0.0f);
+        m_params[PARAM_SHADOW_TINT_COLOR]->set(1.0f, 1.0f, 1.0f);
+        m_params[PARAM_FILM_GRAIN]->set(0.0f);
     }
 
+    inline bool uniformBlockEnabled() const { return m_uniform_block; }
+
     /**
      * 设置亮度正常范围 [-0.5, 0.5]
      * @param brightness 0.0为原始值
@@ -44,7 +58,7 @@ public:
         if (normalized) {
             brightness = brightness * 0.5f;
         }
-        uniform("brightness_strength")->set(brightness);
+        m_params[PARAM_BRIGHTNESS]->set(brightness);
     }
 
     /**
@@ -57,7 +71,7 @@ public:
             // 转换为 0 - 4
             contrast = contrast * 0.6f;
         }
-        uniform("contrast_strength")->set(contrast);
+        m_params[PARAM_CONTRAST]->set(contrast);
     }
 
     /**
@@ -65,7 +79,7 @@ public:
      * @param saturation [-1.0, 1.0], 0.0为原始值
      */
     void setSaturation(float saturation) {
-        uniform("saturation_strength")->set(saturation);
+        m_params[PARAM_SATURATION]->set(saturation);
     }
 
     /**
@@ -78,7 +92,7 @@ public:
             temperature = temperature < 0 ? 5000.0f+temperature*2000.0f : 5000.0f + temperature*3000.0f;
         }
         temperature = temperature < 5000.0f ? 0.0004f * (temperature - 5000.0f) : 0.00006f * (temperature - 5000.0f);
-        uniform("wb_temperature_strength")->set(temperature);
+        m_params[PARAM_WB_TEMPERATURE]->set(temperature);
     }
 
     /**
@@ -91,7 +105,7 @@ public:
             tint = tint * 200.0f;
         }
         tint = tint / 100.0f;
-        uniform("wb_tint_strength")->set(tint);
+        m_params[PARAM_WB_TINT]->set(tint);
     }
 
     /**
@@ -103,7 +117,7 @@ public:
         if (normalized) {
             exposure = exposure * 2.f;
         }
-        uniform("exposure_strength")->set(exposure);
+        m_params[PARAM_EXPOSURE]->set(exposure);
     }
 
     /**
@@ -115,11 +129,11 @@ public:
             highlights = highlights < 0 ? highlights * 0.3f : highlights * 3.0f;
         }
         highlights *= -1.0f;
-        uniform("highlights_strength")->set(highlights);
+        m_params[PARAM_HIGHLIGHTS]->set(highlights);
     }
 
     void setHighlightTintColor(float r, float g, float b) {
-        uniform("highlight_tint_color")->set(r, g, b);
+        m_params[PARAM_HIGHLIGHT_TINT_COLOR]->set(r, g, b);
     }
 
     /**
@@ -132,11 +146,11 @@ public:
         }
 
         shadows *= -1.0f;
-        uniform("shadows_strength")->set(shadows);
+        m_params[PARAM_SHADOWS]->set(shadows);
     }
 
     void setShadowTintColor(float r, float g, float b) {
-        uniform("shadow_tint_color")->set(r, g, b);
+        m_params[PARAM_SHADOW_TINT_COLOR]->set(r, g, b);
     }
 
     /**
@@ -147,15 +161,15 @@ public:
         if (normalized) {
             film_grain = film_grain * 0.3f;
         }
-        uniform("film_grain_strength")->set(film_grain);
+        m_params[PARAM_FILM_GRAIN]->set(film_grain);
     }
 
     void inputTexture(int id) {
-        uniform("inputImageTexture")->set(id);
+        m_input_texture->set(id);
     }
 
     void inputTexture(Texture2D &texture) {
-        uniform("inputImageTexture")->set((int)texture.id());
+        m_input_texture->set((int)texture.id());
     }
 
 protected:
@@ -168,7 +182,7 @@ void main() {
     gl_Position = position;
     textureCoordinate = inputTextureCoordinate;
 })";
-        return CORRECT_VERTEX_SHADER(vs);
+        return m_uniform_block ? CORRECT_VERTEX_SHADER_ES3(vs) : CORRECT_VERTEX_SHADER(vs);
     }
 
     std::string fragmentShader() override {
@@ -176,7 +190,29 @@ void main() {
 precision highp float;
 varying highp vec2 textureCoordinate;
 uniform sampler2D inputImageTexture;
+)";
+        fs += paramDeclarations("", m_uniform_block);
+        fs += fusedHelpers();
+        fs += withPrefix(stageFunction(), "");
+        fs += R"(
+void main() {
+    lowp vec4 textureColor = texture2D(inputImageTexture, textureCoordinate);
+    gl_FragColor = apply(textureColor, textureCoordinate);
+}
+        )";
+        return m_uniform_block ? CORRECT_FRAGMENT_SHADER_ES3(fs) : CORRECT_FRAGMENT_SHADER(fs);
+    }
+
+public:
+    /**
+     * 逐像素的颜色变换
+     */
+    int damagePadding(int width, int height) const override { return 0; }
+
+    const char *fusedName() const override { return "color_adjust"; }
 
+    std::string fusedHelpers() const override {
+        return R"(
 vec4 convert_to_linear(const vec4 color){
     return vec4(pow(color.rgb, vec3(2.2)), color.a);
 }
@@ -186,14 +222,12 @@ vec4 convert_to_normal(const vec4 color){
 }
 
 /// 亮度：-1.0 ~ 1.0, 0.0为原始值
-uniform lowp float brightness_strength;
 vec4 adjust_brightness(vec4 input_color, float strength) {
     vec3 rgb = pow(input_color.rgb, vec3(1.0 / (1.0 + 1.5 * strength)));
     return vec4(rgb, input_color.a);
 }
 
 /// 对比度：-1.0 - 1.0, 0.0为原始值
-uniform lowp float contrast_strength;
 vec4 adjust_contrast(vec4 input_color, float strength) {
     const float pi_4 = 3.14159265358979 * 0.25;
     float contrast_coef = tan((strength + 1.0) * pi_4);
@@ -201,7 +235,6 @@ vec4 adjust_contrast(vec4 input_color, float strength) {
 }
 
 /// 饱和度: -1.0 - 1.0, 0.0为原始值
-uniform lowp float saturation_strength;
 vec4 adjust_saturation(vec4 input_color, float strength) {
     strength = strength + 1.0;
     lowp float luminance = dot(input_color.rgb, vec3(0.2125, 0.7154, 0.0721));
@@ -211,8 +244,6 @@ vec4 adjust_saturation(vec4 input_color, float strength) {
 
 /// 色温: 4000k ~ 7000k, 5000为原始值
 /// 色调: -200 ~ 200, 0为原始值
-uniform lowp float wb_temperature_strength;
-uniform lowp float wb_tint_strength;
 
 const lowp vec3 warmFilter = vec3(0.93, 0.54, 0.0);
 const mediump mat3 RGBtoYIQ = mat3(0.299, 0.587, 0.114, 0.596, -0.274, -0.322, 0.212, -0.523, 0.311);
@@ -232,17 +263,12 @@ vec4 adjust_white_balance(vec4 input_color, float temperature, float tint) {
 }
 
 /// 曝光: -2.0 ~ 2.0, 0.0为原始值
-uniform lowp float exposure_strength;
 vec4 adjust_exposure(vec4 input_color, float strength) {
     return vec4(input_color.rgb * pow(2.0, strength), input_color.a);
 }
 
 /// 高光: -1.0 ~ 1.0, 0.0为原始值
 /// 阴影: -1.0 ~ 1.0, 0.0为原始值
-uniform lowp float highlights_strength;
-uniform highp vec3 highlight_tint_color;
-uniform lowp float shadows_strength;
-uniform highp vec3 shadow_tint_color;
 vec4 adjust_highlights_shadows(vec4 input_color, float highlightTintIntensity, vec3 highlightTintColor, float shadowTintIntensity, vec3 shadowTintColor) {
     highp float luminance = dot(input_color.rgb, vec3(0.2125, 0.7154, 0.0721));
 
@@ -253,50 +279,121 @@ vec4 adjust_highlights_shadows(vec4 input_color, float highlightTintIntensity, v
 }
 
 /// 调节胶片颗粒感: 0.0 ~ 0.5, 0.0为原始值
-uniform lowp float film_grain_strength;
-vec4 apply_film_grain(vec4 input_color, float grain) {
+vec4 apply_film_grain(vec4 input_color, float grain, highp vec2 uv) {
     vec3 rgb = convert_to_normal(input_color).rgb;
-    float noise = (fract(sin(dot(textureCoordinate, vec2(12.9898, 78.233) * 2.0)) * 43758.5453));
+    float noise = (fract(sin(dot(uv, vec2(12.9898, 78.233) * 2.0)) * 43758.5453));
     return convert_to_linear(vec4(rgb - noise * grain, input_color.a));
 }
+)";
+    }
 
-void main() {
-    lowp vec4 textureColor = texture2D(inputImageTexture, textureCoordinate);
-    vec4 result_color = convert_to_linear(textureColor);
+    std::string fusedStage() const override { return paramDeclarations("$", false) + stageFunction(); }
+
+    std::vector<ProgField *> fusedParams() override {
+        return std::vector<ProgField *>(m_params, m_params + PARAM_COUNT);
+    }
+
+private:
+    static std::string stageFunction() {
+        return R"(
+highp vec4 $apply(highp vec4 color, highp vec2 uv) {
+    vec4 result_color = convert_to_linear(color);
 
-    if (abs(wb_temperature_strength) > 0.00001 || abs(wb_tint_strength) > 0.00001) {
-        result_color = adjust_white_balance(result_color, wb_temperature_strength, wb_tint_strength);
+    if (abs($wb_temperature_strength) > 0.00001 || abs($wb_tint_strength) > 0.00001) {
+        result_color = adjust_white_balance(result_color, $wb_temperature_strength, $wb_tint_strength);
     }
 
-    if (abs(brightness_strength) > 0.00001) {
-        result_color = adjust_brightness(result_color, brightness_strength);
+    if (abs($brightness_strength) > 0.00001) {
+        result_color = adjust_brightness(result_color, $brightness_strength);
     }
 
-    if (abs(contrast_strength) > 0.00001) {
-        result_color = adjust_contrast(result_color, contrast_strength);
+    if (abs($contrast_strength) > 0.00001) {
+        result_color = adjust_contrast(result_color, $contrast_strength);
     }
 
-    if (abs(exposure_strength) > 0.00001) {
-        result_color = adjust_exposure(result_color, exposure_strength);
+    if (abs($exposure_strength) > 0.00001) {
+        result_color = adjust_exposure(result_color, $exposure_strength);
     }
 
-    if (abs(saturation_strength) > 0.00001) {
-        result_color = adjust_saturation(result_color, saturation_strength);
+    if (abs($saturation_strength) > 0.00001) {
+        result_color = adjust_saturation(result_color, $saturation_strength);
     }
 
-    if (abs(highlights_strength) > 0.00001 || abs(shadows_strength) > 0.00001) {
-        result_color = adjust_highlights_shadows(result_color, highlights_strength, highlight_tint_color, shadows_strength, shadow_tint_color);
+    if (abs($highlights_strength) > 0.00001 || abs($shadows_strength) > 0.00001) {
+        result_color = adjust_highlights_shadows(result_color, $highlights_strength, $highlight_tint_color, $shadows_strength, $shadow_tint_color);
     }
 
-    if (abs(film_grain_strength) > 0.00001) {
-        result_color = apply_film_grain(result_color, film_grain_strength);
+    if (abs($film_grain_strength) > 0.00001) {
+        result_color = apply_film_grain(result_color, $film_grain_strength, uv);
     }
 
-    gl_FragColor = clamp(convert_to_normal(result_color), 0.0, 1.0);
+    return clamp(convert_to_normal(result_color), 0.0, 1.0);
 }
-        )";
-        return CORRECT_FRAGMENT_SHADER(fs);
+)";
     }
+
+private:
+    // 与 shader 中的声明顺序一致, uniform block 的成员偏移依赖这个顺序
+    enum Param {
+        PARAM_BRIGHTNESS,
+        PARAM_CONTRAST,
+        PARAM_SATURATION,
+        PARAM_WB_TEMPERATURE,
+        PARAM_WB_TINT,
+        PARAM_EXPOSURE,
+        PARAM_HIGHLIGHTS,
+        PARAM_HIGHLIGHT_TINT_COLOR,
+        PARAM_SHADOWS,
+        PARAM_SHADOW_TINT_COLOR,
+        PARAM_FILM_GRAIN,
+        PARAM_COUNT
+    };
+
+    struct ParamDef {
+        const char *name;
+        DataType type;
+        const char *glslType;
+    };
+
+    static constexpr const char *PARAM_BLOCK_NAME = "ColorAdjustParams";
+
+    static const ParamDef &paramDef(int index) {
+        static const ParamDef defs[PARAM_COUNT] = {
+            {"brightness_strength", DataType::FLOAT, "lowp float"},
+            {"contrast_strength", DataType::FLOAT, "lowp float"},
+            {"saturation_strength", DataType::FLOAT, "lowp float"},
+            {"wb_temperature_strength", DataType::FLOAT, "lowp float"},
+            {"wb_tint_strength", DataType::FLOAT, "lowp float"},
+            {"exposure_strength", DataType::FLOAT, "lowp float"},
+            {"highlights_strength", DataType::FLOAT, "lowp float"},
+            {"highlight_tint_color", DataType::FVEC3, "highp vec3"},
+            {"shadows_strength", DataType::FLOAT, "lowp float"},
+            {"shadow_tint_color", DataType::FVEC3, "highp vec3"},
+            {"film_grain_strength", DataType::FLOAT, "lowp float"},
+        };
+        return defs[index];
+    }
+
+    static std::string paramDeclarations(const std::string &prefix, bool uniformBlock) {
+        std::string decl;
+        if (uniformBlock) {
+            decl += "layout(std140) uniform " + std::string(PARAM_BLOCK_NAME) + " {\n";
+        }
+        for (int i = 0; i < PARAM_COUNT; ++i) {
+            const ParamDef &def = paramDef(i);
+            decl += uniformBlock ? "    " : "uniform ";
+            decl += std::string(def.glslType) + " " + prefix + def.name + ";\n";
+        }
+        if (uniformBlock) {
+            decl += "};\n";
+        }
+        return decl;
+    }
+
+private:
+    const bool m_uniform_block;
+    Uniform *m_input_texture = nullptr;
+    ProgField *m_params[PARAM_COUNT] = {nullptr};
 };
 
 NAMESPACE_END
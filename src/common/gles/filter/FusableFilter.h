@@ -0,0 +1,64 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "ZNamespace.h"
+#include "../Program.h"
+
+#include <string>
+#include <vector>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 可以融合进 FusedFilter 的滤镜, 以 GLSL 函数的形式提供逐像素的处理.
+ *
+ * fusedStage 返回的源码中 '$' 是 stage 的前缀, 融合时替换为 "s<序号>_", 同一个滤镜可以在链中出现多次:
+ *   - 声明本滤镜的 uniform: uniform lowp float $strength;
+ *   - 定义入口函数, 采样邻域的滤镜 (只能是链的第一个):
+ *         highp vec4 $apply(highp vec2 uv)  通过 fused_sample(uv) 采样输入纹理
+ *     逐像素的滤镜:
+ *         highp vec4 $apply(highp vec4 color, highp vec2 uv)
+ * fusedHelpers 是不依赖 uniform 的公共函数, 不加前缀, 同一种滤镜在一个 shader 中只输出一次
+ */
+class FusableFilter {
+public:
+    virtual ~FusableFilter() = default;
+
+    /**
+     * 滤镜的类型名, 用于公共函数去重和 program 缓存的 key
+     */
+    virtual const char *fusedName() const = 0;
+
+    /**
+     * 是否需要采样相邻的像素, 这类滤镜只能作为链的第一个
+     */
+    virtual bool fusedNeedsNeighborhood() const { return false; }
+
+    virtual std::string fusedHelpers() const { return ""; }
+
+    virtual std::string fusedStage() const = 0;
+
+    /**
+     * 本滤镜的参数 (不包括输入纹理), 名字与 fusedStage 中 '$' 之后的名字一致.
+     * 融合后的 program 中定义同名加前缀的 uniform, 每次渲染前从这里同步
+     */
+    virtual std::vector<ProgField *> fusedParams() = 0;
+
+    static std::string withPrefix(const std::string &source, const std::string &prefix) {
+        std::string result;
+        result.reserve(source.size() + prefix.size() * 8);
+        for (char c : source) {
+            if (c == '$') {
+                result += prefix;
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+};
+
+NAMESPACE_END
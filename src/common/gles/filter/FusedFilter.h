@@ -0,0 +1,217 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "ZNamespace.h"
+#include "BaseFilter.h"
+#include "FusableFilter.h"
+
+#include <map>
+#include <memory>
+#include <set>
+
+NAMESPACE_DEFAULT
+
+/**
+ * 把多个逐像素的滤镜融合为一个 pass: 按链生成一个 shader, 中间结果不再写入/读取 Framebuffer.
+ *
+ * 第一个滤镜可以采样邻域 (如锐化), 直接读输入纹理; 之后的滤镜只能处理当前像素的颜色.
+ * 每条链 (按滤镜类型的顺序) 编译一个 program 并缓存, 切换回之前的链不需要重新编译.
+ * 滤镜由调用方持有, 参数仍然通过原滤镜的接口设置, 融合的 program 中每个参数是独立的 uniform (名字加 "s<序号>_" 前缀),
+ * 渲染前从原滤镜同步, 值没有变化时不会重新上传.
+ * 坐标变换 (viewport/顶点/纹理坐标) 使用 FusedFilter 自己的设置, 原滤镜的坐标和 TextureFilter 的 blend 不生效
+ */
+class FusedFilter : public BaseFilter {
+public:
+    FusedFilter() : BaseFilter("fused") {}
+
+    ~FusedFilter() override {
+        for (auto &it : m_variants) {
+            _WARN_IF(it.second->program.valid(), "FusedFilter(%s) not released before delete!", it.first.c_str());
+        }
+    }
+
+    /**
+     * @return 链不合法 (为空, 或者第一个之后有采样邻域的滤镜) 时返回 false, 保持之前的链
+     */
+    bool setChain(const std::vector<FusableFilter *> &stages) {
+        _ERROR_RETURN_IF(stages.empty(), false, "FusedFilter: empty chain");
+        for (size_t i = 0; i < stages.size(); ++i) {
+            _ERROR_RETURN_IF(stages[i] == nullptr, false, "FusedFilter: stage %d is null", (int)i);
+            _ERROR_RETURN_IF(i > 0 && stages[i]->fusedNeedsNeighborhood(), false,
+                             "FusedFilter: stage %d(%s) samples neighborhood, only the first stage can", (int)i,
+                             stages[i]->fusedName());
+        }
+
+        std::string key;
+        for (auto *stage : stages) {
+            key += key.empty() ? "" : "|";
+            key += stage->fusedName();
+        }
+        m_stages = stages;
+        m_sources.clear();
+        for (auto *stage : stages) {
+            m_sources.push_back(stage->fusedParams());
+        }
+
+        auto it = m_variants.find(key);
+        if (it == m_variants.end()) {
+            it = m_variants.emplace(key, std::unique_ptr<Variant>(new Variant())).first;
+            defineVariant(*it->second);
+        }
+        m_key = key;
+        m_current = it->second.get();
+        return true;
+    }
+
+    inline const std::string &chainKey() const { return m_key; }
+
+    inline int stageCount() const { return (int)m_stages.size(); }
+
+    /**
+     * 缓存的 program 数量, 每条不同的链一个
+     */
+    inline int programCount() const { return (int)m_variants.size(); }
+
+    FusedFilter &inputTexture(int id) {
+        m_input_texture = id;
+        return *this;
+    }
+
+    FusedFilter &inputTexture(const Texture &texture) {
+        m_input_texture = (int)texture.id();
+        return *this;
+    }
+
+    /**
+     * 当前链中第 stage 个滤镜的参数在融合 program 中对应的 uniform, 值由原滤镜同步, 用于查看
+     */
+    Uniform *stageUniform(int stage, const char *name) {
+        if (m_current == nullptr) {
+            return nullptr;
+        }
+        return m_current->program.uniform((stagePrefix(stage) + name).c_str());
+    }
+
+    /**
+     * 每个滤镜的范围之和, 不是 BaseFilter 的滤镜不支持 damage
+     */
+    int damagePadding(int width, int height) const override {
+        int padding = 0;
+        for (auto *stage : m_stages) {
+            auto *filter = dynamic_cast<const BaseFilter *>(stage);
+            int p = filter ? filter->damagePadding(width, height) : -1;
+            if (p < 0) {
+                return -1;
+            }
+            padding += p;
+        }
+        return padding;
+    }
+
+    void release() override {
+        for (auto &it : m_variants) {
+            it.second->program.release();
+        }
+        BaseFilter::release();
+    }
+
+protected:
+    Program &activeProgram() override { return m_current ? m_current->program : m_program; }
+
+    std::string vertexShader() override {
+        std::string vs = R"(
+attribute vec4 position;
+attribute vec2 inputTextureCoordinate;
+varying highp vec2 textureCoordinate;
+void main() {
+    gl_Position = position;
+    textureCoordinate = inputTextureCoordinate;
+})";
+        return CORRECT_VERTEX_SHADER(vs);
+    }
+
+    std::string fragmentShader() override {
+        std::string fs = R"(
+precision highp float;
+varying highp vec2 textureCoordinate;
+uniform sampler2D inputImageTexture;
+
+highp vec4 fused_sample(highp vec2 uv) {
+    return texture2D(inputImageTexture, uv);
+}
+)";
+        std::set<std::string> helpers;
+        for (auto *stage : m_stages) {
+            if (helpers.insert(stage->fusedName()).second) {
+                fs += stage->fusedHelpers();
+            }
+        }
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            fs += FusableFilter::withPrefix(m_stages[i]->fusedStage(), stagePrefix((int)i));
+        }
+
+        fs += "\nvoid main() {\n    highp vec2 uv = textureCoordinate;\n";
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            std::string prefix = stagePrefix((int)i);
+            if (i == 0) {
+                std::string arg = m_stages[i]->fusedNeedsNeighborhood() ? "uv" : "fused_sample(uv), uv";
+                fs += "    highp vec4 color = " + prefix + "apply(" + arg + ");\n";
+            } else {
+                fs += "    color = " + prefix + "apply(color, uv);\n";
+            }
+        }
+        fs += "    gl_FragColor = color;\n}\n";
+        return CORRECT_FRAGMENT_SHADER(fs);
+    }
+
+    void onRender(Framebuffer *output) override {
+        if (m_current) {
+            m_current->input->set(m_input_texture);
+            for (size_t i = 0; i < m_sources.size(); ++i) {
+                for (size_t j = 0; j < m_sources[i].size(); ++j) {
+                    m_current->params[i][j]->copyFrom(*m_sources[i][j]);
+                }
+            }
+        }
+        BaseFilter::onRender(output);
+    }
+
+private:
+    struct Variant {
+        Program program;
+        Uniform *input = nullptr;
+        // [stage][param], 与 m_sources 对应
+        std::vector<std::vector<Uniform *>> params;
+    };
+
+    static std::string stagePrefix(int stage) { return "s" + std::to_string(stage) + "_"; }
+
+    void defineVariant(Variant &variant) {
+        Program &program = variant.program;
+        program.defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
+        program.defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
+        variant.input = program.defUniform("inputImageTexture", DataType::SAMPLER_2D);
+        for (size_t i = 0; i < m_sources.size(); ++i) {
+            std::string prefix = stagePrefix((int)i);
+            variant.params.emplace_back();
+            for (ProgField *field : m_sources[i]) {
+                variant.params.back().push_back(program.defUniform((prefix + field->name()).c_str(), field->type()));
+            }
+        }
+    }
+
+private:
+    std::vector<FusableFilter *> m_stages;
+    // 原滤镜的参数, [stage][param]
+    std::vector<std::vector<ProgField *>> m_sources;
+    std::string m_key;
+
+    std::map<std::string, std::unique_ptr<Variant>> m_variants;
+    Variant *m_current = nullptr;
+    int m_input_texture = 0;
+};
+
+NAMESPACE_END
@@ -9,6 +9,7 @@
 
 #include "BaseFilter.h"
 #include "../GLUtil.h"
+#include "../PlaneTexture.h"
 #include <cstdint>
 #include <mutex>
 
@@ -19,8 +20,8 @@ public:
     NV12Filter() : BaseFilter("nv12") {
         defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
         defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
-        defUniform("yTexture", DataType::SAMPLER_2D);
-        defUniform("uvTexture", DataType::SAMPLER_2D);
+        m_y_sampler = defUniform("yTexture", DataType::SAMPLER_2D);
+        m_uv_sampler = defUniform("uvTexture", DataType::SAMPLER_2D);
     }
 
     std::string vertexShader() override {
@@ -47,23 +48,23 @@ uniform sampler2D uvTexture;
 void main() {
     float y = texture2D(yTexture, textureCoordinate).r;
     vec4 uv = texture2D(uvTexture, textureCoordinate);
-    float v = uv.a - 0.5;
+    float v = uv.)" + std::string(PlaneTexture::secondComponent()) + R"( - 0.5;
     float u = uv.r - 0.5;
 )";
         if (m_standard == BT601) {
-            fs = R"(
+            fs += R"(
     float r = y + 1.402 * v;
     float g = y - 0.344136 * u - 0.714136 * v;
     float b = y + 1.772 * u;
 )";
         } else if (m_standard == BT2020) {
-            fs = R"(
+            fs += R"(
     float r = y + 1.4746 * v;
     float g = y - 0.164553 * u - 0.571353 * v;
     float b = y + 1.8814 * u;
 )";
         } else {
-            fs = R"(
+            fs += R"(
     float r = y + 1.5748 * v;
     float g = y - 0.187324 * u - 0.468124 * v;
     float b = y + 1.8556 * u;
@@ -86,6 +87,9 @@ void main() {
         setTextureCoord(orientation, flipH, flipV);
     }
 
+    /**
+     * 可以在任意线程调用, 数据复制到内部的缓存中, 下次渲染时上传
+     */
     void putData(const uint8_t *nv12, int width, int height, YuvStandard standard = YuvStandard::BT709) {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_width = width;
@@ -94,65 +98,65 @@ void main() {
         uint8_t *dst = m_nv12_buffer.obtain<uint8_t>(dstSize);
         memcpy(dst, nv12, dstSize);
         m_next_std = standard;
+        m_staged = true;
+    }
+
+    /**
+     * 需要在 GL 线程调用, 直接从调用方的内存上传到纹理, 不经过内部缓存, 返回后调用方就可以复用这块内存.
+     * 每行可以有填充, 例如相机按对齐后的 stride 输出的数据
+     * @param yStride Y 平面每行的字节数
+     * @param uvStride UV 交错平面每行的字节数
+     */
+    bool uploadData(const uint8_t *y, int yStride, const uint8_t *uv, int uvStride, int width, int height,
+                    YuvStandard standard = YuvStandard::BT709) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next_std = standard;
+        // 之前 putData 的数据已经过时
+        m_staged = false;
+        return m_y_plane.upload(y, yStride, width, height) && m_uv_plane.upload(uv, uvStride, width / 2, height / 2);
+    }
+
+    /**
+     * 开启后 GLES3 上经过两个交替的 PBO 上传, 默认关闭
+     */
+    void setPboEnabled(bool enable) {
+        m_y_plane.setPboEnabled(enable);
+        m_uv_plane.setPboEnabled(enable);
     }
 
     void onPreRender(Framebuffer *output) override {
         if (m_standard != m_next_std) {
             m_standard = m_next_std;
+            // 只删除 GL program, 定义的 uniform 保留, 下次渲染时用新的 shader 重新创建
             m_program.release();
         }
     }
 
     void onRender(Framebuffer *output) override {
-        const uint8_t *nv12 = m_nv12_buffer.bytes();
-        if (nv12 == nullptr) {
-            return;
-        }
-        int width = m_width, height = m_height;
-
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            if (m_y_texture == nullptr || m_uv_texture == nullptr || m_y_texture->width() != width ||
-                m_y_texture->height() != height) {
-                if (m_y_texture) {
-                    m_y_texture->release();
-                    DELETE_TO_NULL(m_y_texture);
-                }
-
-                if (m_uv_texture) {
-                    m_uv_texture->release();
-                    DELETE_TO_NULL(m_uv_texture);
-                }
-
-                TexParams params;
-                params.internalFormat = GL_LUMINANCE;
-                params.format = GL_LUMINANCE;
-                m_y_texture = new Texture2D(width, height, params);
-
-                params.internalFormat = GL_LUMINANCE_ALPHA;
-                params.format = GL_LUMINANCE_ALPHA;
-                m_uv_texture = new Texture2D(width / 2, height / 2, params);
+            if (m_staged) {
+                const uint8_t *nv12 = m_nv12_buffer.bytes();
+                int width = m_width, height = m_height;
+                m_y_plane.upload(nv12, width, width, height);
+                m_uv_plane.upload(nv12 + width * height, width, width / 2, height / 2);
+                m_staged = false;
             }
-            m_y_texture->update((void *)nv12);
-            m_uv_texture->update((void *)(nv12 + width * height));
+        }
+        if (m_y_plane.id() == INVALID_GL_ID || m_uv_plane.id() == INVALID_GL_ID) {
+            return;
         }
 
-        uniform("yTexture")->set((int)m_y_texture->id());
-        uniform("uvTexture")->set((int)m_uv_texture->id());
+        m_y_sampler->set((int)m_y_plane.id());
+        m_uv_sampler->set((int)m_uv_plane.id());
 
         BaseFilter::onRender(output);
     }
 
     void release() override {
         BaseFilter::release();
-        if (m_y_texture != nullptr) {
-            m_y_texture->release();
-        }
-        DELETE_TO_NULL(m_y_texture);
-        if (m_uv_texture != nullptr) {
-            m_uv_texture->release();
-        }
-        DELETE_TO_NULL(m_uv_texture);
+        m_y_plane.release();
+        m_uv_plane.release();
     }
 
 private:
@@ -160,10 +164,15 @@ private:
     int m_width = 0;
     int m_height = 0;
     YuvStandard m_next_std = YuvStandard::BT709;
+    // putData 的数据还没有上传
+    bool m_staged = false;
     std::mutex m_mutex;
 
     YuvStandard m_standard = YuvStandard::BT709;
-    Texture2D *m_y_texture = nullptr;
-    Texture2D *m_uv_texture = nullptr;
+    PlaneTexture m_y_plane{1};
+    PlaneTexture m_uv_plane{2};
+
+    Uniform *m_y_sampler = nullptr;
+    Uniform *m_uv_sampler = nullptr;
 };
 NAMESPACE_END
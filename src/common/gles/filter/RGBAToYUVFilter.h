@@ -0,0 +1,211 @@
+//
+// Created on 2026/10/19.
+//
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "common/utils/YuvUtils.h"
+
+NAMESPACE_DEFAULT
+
+enum YuvLayout {
+    // Y 平面 + VU 交错
+    YUV_LAYOUT_NV21 = 0,
+    // Y 平面 + UV 交错
+    YUV_LAYOUT_NV12,
+    // Y, U, V 三个平面
+    YUV_LAYOUT_I420,
+};
+
+/**
+ * RGBA 纹理转换为 NV21/NV12/I420, 与 NV21Filter 相反.
+ *
+ * 输出的 framebuffer 按字节排列成和 CPU 内存完全一致的 YUV 数据, 读回后不需要再整理:
+ * FB_FORMAT_R8 时每个像素一个字节, 尺寸为 width x height*3/2;
+ * FB_FORMAT_RGBA8 时每个像素打包 4 个连续字节, 尺寸为 width/4 x height*3/2, 只需要 GL_RGBA 读取.
+ * 输入纹理的第 0 行对应 YUV 的第 0 行, 色度取 2x2 像素的平均值, 与 YuvUtils (libyuv) 一致.
+ * 宽高需要是偶数, RGBA8 打包时宽度需要是 4 的倍数. 使用整数运算和 texelFetch, 需要 GLES3
+ */
+class RGBAToYUVFilter : public BaseFilter {
+public:
+    RGBAToYUVFilter() : BaseFilter("rgba_to_yuv") {
+        defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
+        m_input_texture = defUniform("inputImageTexture", DataType::SAMPLER_2D);
+        m_image_size = defUniform("imageSize", DataType::IVEC2);
+        m_layout_uniform = defUniform("yuvLayout", DataType::INT);
+        m_texel_bytes = defUniform("texelBytes", DataType::INT);
+        m_y_coeff = defUniform("yCoeff", DataType::FVEC3);
+        m_u_coeff = defUniform("uCoeff", DataType::FVEC3);
+        m_v_coeff = defUniform("vCoeff", DataType::FVEC3);
+        m_range = defUniform("yuvRange", DataType::FVEC3);
+        setLayout(YUV_LAYOUT_NV21);
+        setStandard(BT601, false);
+    }
+
+    /**
+     * 输出 framebuffer 的尺寸
+     */
+    static int outputWidth(int width, FramebufferFormat format) {
+        return format == FB_FORMAT_RGBA8 ? width / 4 : width;
+    }
+
+    static int outputHeight(int height) { return height * 3 / 2; }
+
+    RGBAToYUVFilter &setLayout(YuvLayout layout) {
+        m_layout = layout;
+        m_layout_uniform->set((int)layout);
+        return *this;
+    }
+
+    /**
+     * @param fullRange true: Y/U/V 都是 [0, 255]; false: Y 为 [16, 235], U/V 为 [16, 240]
+     */
+    RGBAToYUVFilter &setStandard(YuvStandard standard, bool fullRange) {
+        float kr = 0.299f, kb = 0.114f;
+        if (standard == BT709) {
+            kr = 0.2126f;
+            kb = 0.0722f;
+        } else if (standard == BT2020) {
+            kr = 0.2627f;
+            kb = 0.0593f;
+        }
+        float kg = 1.0f - kr - kb;
+        float ud = 2.0f * (1.0f - kb), vd = 2.0f * (1.0f - kr);
+        m_y_coeff->set(kr, kg, kb);
+        m_u_coeff->set(-kr / ud, -kg / ud, (1.0f - kb) / ud);
+        m_v_coeff->set((1.0f - kr) / vd, -kg / vd, -kb / vd);
+        if (fullRange) {
+            m_range->set(255.0f, 0.0f, 255.0f);
+        } else {
+            m_range->set(219.0f, 16.0f, 224.0f);
+        }
+        return *this;
+    }
+
+    YuvLayout layout() const { return m_layout; }
+
+    /**
+     * 把 input 转换到 output, output 需要是 FB_FORMAT_R8 或 FB_FORMAT_RGBA8, 尺寸见 outputWidth/outputHeight
+     */
+    bool convert(const Texture &input, Framebuffer &output) {
+        int width = input.width(), height = input.height();
+        int texelBytes = output.format() == FB_FORMAT_RGBA8 ? 4 : 1;
+        _ERROR_RETURN_IF(width % 2 != 0 || height % 2 != 0 || width % texelBytes != 0, false,
+                         "RGBAToYUVFilter: unsupported size %d x %d, texel bytes: %d", width, height, texelBytes)
+        _ERROR_RETURN_IF(output.format() != FB_FORMAT_R8 && output.format() != FB_FORMAT_RGBA8, false,
+                         "RGBAToYUVFilter: unsupported output format: %s", Framebuffer::formatName(output.format()))
+        _ERROR_RETURN_IF(output.texWidth() != width / texelBytes || output.texHeight() != outputHeight(height), false,
+                         "RGBAToYUVFilter: output size %d x %d mismatch", output.texWidth(), output.texHeight())
+
+        m_input_texture->set((int)input.id());
+        m_image_size->set(width, height);
+        m_texel_bytes->set(texelBytes);
+        viewport().set(output.texWidth(), output.texHeight());
+        setFullVertexCoord();
+        render(&output);
+        return true;
+    }
+
+protected:
+    std::string vertexShader() override {
+        std::string vs = R"(
+attribute vec4 position;
+void main() {
+    gl_Position = position;
+})";
+        return CORRECT_VERTEX_SHADER_ES3(vs);
+    }
+
+    std::string fragmentShader() override {
+        std::string fs = R"(
+precision highp float;
+precision highp int;
+uniform sampler2D inputImageTexture;
+uniform ivec2 imageSize;
+uniform int yuvLayout;
+uniform int texelBytes;
+uniform vec3 yCoeff;
+uniform vec3 uCoeff;
+uniform vec3 vCoeff;
+// (Y 的比例, Y 的偏移, UV 的比例)
+uniform vec3 yuvRange;
+
+float quantize(float v) {
+    return clamp(floor(v + 0.5), 0.0, 255.0) / 255.0;
+}
+
+float luma(ivec2 p) {
+    return quantize(yuvRange.y + yuvRange.x * dot(texelFetch(inputImageTexture, p, 0).rgb, yCoeff));
+}
+
+// 色度位置 pos 对应的 2x2 像素的平均值
+vec3 chromaRgb(ivec2 pos) {
+    ivec2 p = pos * 2;
+    return (texelFetch(inputImageTexture, p, 0).rgb + texelFetch(inputImageTexture, p + ivec2(1, 0), 0).rgb +
+            texelFetch(inputImageTexture, p + ivec2(0, 1), 0).rgb + texelFetch(inputImageTexture, p + ivec2(1, 1), 0).rgb) * 0.25;
+}
+
+float chroma(vec3 rgb, bool isV) {
+    return quantize(128.0 + yuvRange.z * dot(rgb, isV ? vCoeff : uCoeff));
+}
+
+void main() {
+    // 每个 fragment 输出同一行中 texelBytes 个连续的字节, Y 平面每行对应一行像素
+    ivec2 frag = ivec2(gl_FragCoord.xy);
+    int w = imageSize.x;
+    int x0 = frag.x * texelBytes;
+    int row = frag.y - imageSize.y;
+    vec4 bytes = vec4(0.0, 0.0, 0.0, 1.0);
+    if (row < 0) {
+        for (int k = 0; k < 4; ++k) {
+            if (k < texelBytes) {
+                bytes[k] = luma(ivec2(x0 + k, frag.y));
+            }
+        }
+    } else if (yuvLayout != 2) {
+        // VU/UV 交错, 每一行对应一行色度, 两个字节共用一个色度位置
+        bool vFirst = yuvLayout == 0;
+        vec3 rgb = chromaRgb(ivec2(x0 / 2, row));
+        for (int k = 0; k < 4; ++k) {
+            if (k < texelBytes) {
+                int x = x0 + k;
+                if (k == 2) {
+                    rgb = chromaRgb(ivec2(x / 2, row));
+                }
+                bytes[k] = chroma(rgb, ((x % 2) == 0) == vFirst);
+            }
+        }
+    } else {
+        // U, V 两个平面依次排列, 平面的边界不一定在行首
+        int cw = w / 2;
+        int planeSize = cw * (imageSize.y / 2);
+        for (int k = 0; k < 4; ++k) {
+            if (k < texelBytes) {
+                int c = row * w + x0 + k;
+                bool isV = c >= planeSize;
+                c -= isV ? planeSize : 0;
+                int cy = c / cw;
+                bytes[k] = chroma(chromaRgb(ivec2(c - cy * cw, cy)), isV);
+            }
+        }
+    }
+    gl_FragColor = bytes;
+})";
+        return CORRECT_FRAGMENT_SHADER_ES3(fs);
+    }
+
+private:
+    YuvLayout m_layout = YUV_LAYOUT_NV21;
+
+    Uniform *m_input_texture = nullptr;
+    Uniform *m_image_size = nullptr;
+    Uniform *m_layout_uniform = nullptr;
+    Uniform *m_texel_bytes = nullptr;
+    Uniform *m_y_coeff = nullptr;
+    Uniform *m_u_coeff = nullptr;
+    Uniform *m_v_coeff = nullptr;
+    Uniform *m_range = nullptr;
+};
+
+NAMESPACE_END
@@ -7,25 +7,30 @@
 
 #pragma once
 #include "BaseFilter.h"
+#include "FusableFilter.h"
 
 NAMESPACE_DEFAULT
 
-class TextureFilter : public BaseFilter {
+/**
+ * 纹理绘制, 融合进 FusedFilter 时只保留 alpha, 坐标变换使用 FusedFilter 自己的顶点/纹理坐标
+ */
+class TextureFilter : public BaseFilter, public FusableFilter {
 public:
     TextureFilter() : BaseFilter("texture_filter") {
         defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
         defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
-        defUniform("inputImageTexture", DataType::SAMPLER_2D);
-        defUniform("alpha", DataType::FLOAT)->set(1.0f);
+        m_input_texture = defUniform("inputImageTexture", DataType::SAMPLER_2D);
+        m_alpha = defUniform("alpha", DataType::FLOAT);
+        m_alpha->set(1.0f);
     }
 
     TextureFilter &inputTexture(int id) {
-        uniform("inputImageTexture")->set(id);
+        m_input_texture->set(id);
         return *this;
     }
 
     TextureFilter &inputTexture(const Texture &texture) {
-        uniform("inputImageTexture")->set((int)texture.id());
+        m_input_texture->set((int)texture.id());
         return *this;
     }
 
@@ -35,10 +40,28 @@ public:
     }
 
     TextureFilter &alpha(float a) {
-        uniform("alpha")->set(a);
+        m_alpha->set(a);
         return *this;
     }
     
+    const char *fusedName() const override { return "texture_filter"; }
+
+    std::string fusedStage() const override {
+        return R"(
+uniform mediump float $alpha;
+highp vec4 $apply(highp vec4 color, highp vec2 uv) {
+    return vec4(color.rgb, color.a * $alpha);
+}
+)";
+    }
+
+    std::vector<ProgField *> fusedParams() override { return {m_alpha}; }
+
+    /**
+     * 只采样对应位置的像素
+     */
+    int damagePadding(int width, int height) const override { return 0; }
+
     void simpleRender(const Texture &tex, Framebuffer *output = nullptr) {
         simpleRender(tex.id(), tex.width(), tex.height(), output);
     }
@@ -76,10 +99,10 @@ public:
     
     void onRender(Framebuffer *output) override {
         if (m_blend) {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLStateCache::setCapability(GL_BLEND, true);
+            GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         } else {
-            glDisable(GL_BLEND);
+            GLStateCache::setCapability(GL_BLEND, false);
         }
         BaseFilter::onRender(output);
     }
@@ -87,7 +110,7 @@ public:
     void onPostRender(Framebuffer *output) override {
         BaseFilter::onPostRender(output);
         if (m_blend) {
-            glDisable(GL_BLEND);
+            GLStateCache::setCapability(GL_BLEND, false);
         }
     }
 
@@ -118,6 +141,9 @@ void main() {
 
 private:
     bool m_blend = false;
+
+    Uniform *m_input_texture = nullptr;
+    Uniform *m_alpha = nullptr;
 };
 
 NAMESPACE_END
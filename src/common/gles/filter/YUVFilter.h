@@ -9,19 +9,20 @@
 
 #include "BaseFilter.h"
 #include "../GLUtil.h"
+#include "../PlaneTexture.h"
 #include <cstdint>
 #include <mutex>
 
 NAMESPACE_DEFAULT
 
-class NV21Filter : public BaseFilter {
+class YUVFilter : public BaseFilter {
 public:
-    NV21Filter() : BaseFilter("yuv") {
+    YUVFilter() : BaseFilter("yuv") {
         defAttribute("position", DataType::FLOAT_POINTER)->bind(vertexCoord());
         defAttribute("inputTextureCoordinate", DataType::FLOAT_POINTER)->bind(textureCoord());
-        defUniform("yTexture", DataType::SAMPLER_2D);
-        defUniform("uTexture", DataType::SAMPLER_2D);
-        defUniform("vTexture", DataType::SAMPLER_2D);
+        m_y_sampler = defUniform("yTexture", DataType::SAMPLER_2D);
+        m_u_sampler = defUniform("uTexture", DataType::SAMPLER_2D);
+        m_v_sampler = defUniform("vTexture", DataType::SAMPLER_2D);
     }
 
     std::string vertexShader() override {
@@ -56,7 +57,6 @@ void main() {
     float r = y + 1.402 * v;
     float g = y - 0.344136 * u - 0.714136 * v;
     float b = y + 1.772 * u;
-}
 )";
         } else if (m_standard == BT2020) {
             fs += R"(
@@ -66,9 +66,9 @@ void main() {
 )";
         } else {
             fs += R"(
-    float r = y + 1.402 * v;
-    float g = y - 0.344136 * u - 0.714136 * v;
-    float b = y + 1.772 * u;
+    float r = y + 1.5748 * v;
+    float g = y - 0.187324 * u - 0.468124 * v;
+    float b = y + 1.8556 * u;
 )";
         }
         fs += R"(
@@ -88,6 +88,9 @@ void main() {
         setTextureCoord(orientation, flipH, flipV);
     }
 
+    /**
+     * 可以在任意线程调用, 数据复制到内部的缓存中, 下次渲染时上传
+     */
     void putData(const uint8_t *y, const uint8_t *u, const uint8_t *v,
                  int width, int height, YuvStandard standard = YuvStandard::BT709) {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -102,76 +105,68 @@ void main() {
         memcpy(dst + width * height + usize, v, vsize);
 
         m_next_std = standard;
+        m_staged = true;
+    }
+
+    /**
+     * 需要在 GL 线程调用, 直接从调用方的内存上传到纹理, 不经过内部缓存, 返回后调用方就可以复用这块内存.
+     * 每个平面的每行都可以有填充
+     */
+    bool uploadData(const uint8_t *y, int yStride, const uint8_t *u, int uStride, const uint8_t *v, int vStride,
+                    int width, int height, YuvStandard standard = YuvStandard::BT709) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_next_std = standard;
+        // 之前 putData 的数据已经过时
+        m_staged = false;
+        return m_y_plane.upload(y, yStride, width, height) && m_u_plane.upload(u, uStride, width / 2, height / 2) &&
+               m_v_plane.upload(v, vStride, width / 2, height / 2);
+    }
+
+    /**
+     * 开启后 GLES3 上经过两个交替的 PBO 上传, 默认关闭
+     */
+    void setPboEnabled(bool enable) {
+        m_y_plane.setPboEnabled(enable);
+        m_u_plane.setPboEnabled(enable);
+        m_v_plane.setPboEnabled(enable);
     }
 
     void onPreRender(Framebuffer *output) override {
         if (m_standard != m_next_std) {
             m_standard = m_next_std;
+            // 只删除 GL program, 定义的 uniform 保留, 下次渲染时用新的 shader 重新创建
             m_program.release();
         }
     }
 
     void onRender(Framebuffer *output) override {
-        const uint8_t *yuv = m_yuv_buffer.bytes();
-        if (yuv == nullptr) {
-            return;
-        }
-        int width = m_width, height = m_height;
-
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            if (m_y_texture == nullptr || m_u_texture == nullptr || m_v_texture == nullptr
-                || m_y_texture->width() != width || m_y_texture->height() != height) {
-
-                if (m_y_texture != nullptr) {
-                    m_y_texture->release();
-                }
-                DELETE_TO_NULL(m_y_texture);
-                if (m_u_texture != nullptr) {
-                    m_u_texture->release();
-                }
-                DELETE_TO_NULL(m_u_texture);
-                if (m_v_texture != nullptr) {
-                    m_v_texture->release();
-                }
-                DELETE_TO_NULL(m_v_texture);
-
-                TexParams params;
-                params.internalFormat = GL_LUMINANCE;
-                params.format = GL_LUMINANCE;
-                m_y_texture = new Texture2D(width, height, params);
-
-                params.internalFormat = GL_LUMINANCE;
-                params.format = GL_LUMINANCE;
-                m_u_texture = new Texture2D(width / 2, height / 2, params);
-                m_v_texture = new Texture2D(width / 2, height / 2, params);
+            if (m_staged) {
+                const uint8_t *yuv = m_yuv_buffer.bytes();
+                int width = m_width, height = m_height;
+                m_y_plane.upload(yuv, width, width, height);
+                m_u_plane.upload(yuv + width * height, width / 2, width / 2, height / 2);
+                m_v_plane.upload(yuv + width * height + width * height / 4, width / 2, width / 2, height / 2);
+                m_staged = false;
             }
-            m_y_texture->update((void *)yuv);
-            m_u_texture->update((void *)(yuv + width * height));
-            m_v_texture->update((void *)(yuv + width * height + width * height / 4));
+        }
+        if (m_y_plane.id() == INVALID_GL_ID || m_u_plane.id() == INVALID_GL_ID || m_v_plane.id() == INVALID_GL_ID) {
+            return;
         }
 
-        uniform("yTexture")->set((int)m_y_texture->id());
-        uniform("uTexture")->set((int)m_u_texture->id());
-        uniform("vTexture")->set((int)m_v_texture->id());
+        m_y_sampler->set((int)m_y_plane.id());
+        m_u_sampler->set((int)m_u_plane.id());
+        m_v_sampler->set((int)m_v_plane.id());
 
         BaseFilter::onRender(output);
     }
 
     void release() override {
         BaseFilter::release();
-        if (m_y_texture != nullptr) {
-            m_y_texture->release();
-        }
-        DELETE_TO_NULL(m_y_texture);
-        if (m_u_texture != nullptr) {
-            m_u_texture->release();
-        }
-        DELETE_TO_NULL(m_u_texture);
-        if (m_v_texture != nullptr) {
-            m_v_texture->release();
-        }
-        DELETE_TO_NULL(m_v_texture);
+        m_y_plane.release();
+        m_u_plane.release();
+        m_v_plane.release();
     }
 
 private:
@@ -179,11 +174,17 @@ private:
     int m_width = 0;
     int m_height = 0;
     YuvStandard m_next_std = YuvStandard::BT709;
+    // putData 的数据还没有上传
+    bool m_staged = false;
     std::mutex m_mutex;
 
     YuvStandard m_standard = YuvStandard::BT709;
-    Texture2D *m_y_texture = nullptr;
-    Texture2D *m_u_texture = nullptr;
-    Texture2D *m_v_texture = nullptr;
+    PlaneTexture m_y_plane{1};
+    PlaneTexture m_u_plane{1};
+    PlaneTexture m_v_plane{1};
+
+    Uniform *m_y_sampler = nullptr;
+    Uniform *m_u_sampler = nullptr;
+    Uniform *m_v_sampler = nullptr;
 };
 NAMESPACE_END
@@ -9,6 +9,7 @@
 #include "ZNamespace.h"
 #include "common/Object.h"
 #include "common/Log.h"
+#include <cstring>
 #ifdef __ZNATIVE_WITH_OPENCV__
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgproc.hpp>
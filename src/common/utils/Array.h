@@ -12,6 +12,7 @@
 #include "common/Log.h"
 
 #include <cstdint>
+#include <cstring>
 
 NAMESPACE_DEFAULT
 
@@ -28,12 +28,14 @@ public:
     explicit EventThread(const char *name = "_event_thread") : m_name(name) {
         m_event_queue.appendListener(NORM_EVENT, [&](const Runnable &func) { func(); });
         m_thread = std::thread(&EventThread::threadLoop, this);
-        m_thread.detach();
         _INFO("create event thread: %s", name);
     }
 
     ~EventThread() {
         _WARN_IF(isRunning(), "event thread(%s) not quit before delete!", m_name)
+        if (m_thread.joinable()) {
+            m_thread.detach();
+        }
     }
 
     ListenerID listenEvent(int event, const EventHandler &handler) {
@@ -104,6 +106,15 @@ public:
         sync([this]() {
             m_running_flag = false;
         }, timeoutMs);
+
+        // 等线程真正退出之后才能析构, 否则线程还会访问已经释放的 event queue
+        if (m_thread.joinable()) {
+            if (std::this_thread::get_id() == m_thread.get_id() || m_running_flag) {
+                m_thread.detach();
+            } else {
+                m_thread.join();
+            }
+        }
     }
 
 private:
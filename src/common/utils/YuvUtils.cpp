@@ -23,6 +23,18 @@ void YuvUtils::bgrToNV21(const uint8_t *src, int width, int height, uint8_t *dst
     libyuv::BGRToNV21(src, width*3, dst, width, dst+width*height, width, width, height);
 }
 
+void YuvUtils::rgbaToNV12(const uint8_t *src, int width, int height, uint8_t *dst) {
+    libyuv::ABGRToNV12(src, width*4, dst, width, dst+width*height, width, width, height);
+}
+
+void YuvUtils::rgbaToI420(const uint8_t *src, int width, int height, uint8_t *dst) {
+    int halfWidth = (width + 1) >> 1;
+    int halfHeight = (height + 1) >> 1;
+    uint8_t *u = dst + width * height;
+    uint8_t *v = u + halfWidth * halfHeight;
+    libyuv::ABGRToI420(src, width*4, dst, width, u, halfWidth, v, halfWidth, width, height);
+}
+
 // 缩放 nv21 数据
 // @param tempMem 是临时内存，用来存储临时的uv, 大小至少为 width*height/2 + dstWidth*dstHeight/2
 // @param filterType FilterMode::kFilterNone = 0, kFilterLinear = 1, kFilterBilinear = 2, kFilterBox = 3
@@ -28,6 +28,11 @@ public:
 
     static void bgrToNV21(const uint8_t *src, int width, int height, uint8_t *dst);
 
+    static void rgbaToNV12(const uint8_t *src, int width, int height, uint8_t *dst);
+
+    // dst 依次为 Y, U, V 三个平面
+    static void rgbaToI420(const uint8_t *src, int width, int height, uint8_t *dst);
+
 
     // 缩放 nv21 数据
     // @param tempMem 是临时内存，用来存储临时的uv, 大小至少为 width*height/2 + dstWidth*dstHeight/2